@@ -0,0 +1,312 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "../src/vm.h"
+#include "../src/utils.h"
+#include "../src/jit.h"
+#include "../src/profiler.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <time.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/resource.h>
+    #include <sys/wait.h>
+#endif
+
+// --- mylo_bench ---
+// Runs each program in benches/ for a few warmup rounds and then N timed
+// iterations, reporting median / p95 / min wall time, bytecode ops per second
+// and peak resident memory. One iteration is what `mylo file` does after
+// reading the file: parse, verify, run, clean up. --json writes the same
+// numbers in a form that can be diffed between commits.
+//
+// On POSIX every benchmark runs in its own forked process, so worker pools,
+// string pools and peak RSS never carry over from the one before it.
+
+void parse(VM* vm, char* source);
+void compiler_reset();
+
+#ifndef MYLO_BENCH_DIR
+    #define MYLO_BENCH_DIR "benches"
+#endif
+
+#define BENCH_MAX_ITERATIONS 1000
+
+static const char* bench_names[] = {
+    "fib", "loop", "map", "strings", "fstrings", "wordcount", "lines",
+    "typed_math", "raytracer", "frozen", "bus", "spawn", "workers", "par",
+};
+#define BENCH_COUNT (int)(sizeof(bench_names) / sizeof(bench_names[0]))
+
+typedef struct {
+    const char* name;
+    bool ok;
+    int iterations;
+    double ms[BENCH_MAX_ITERATIONS];
+    long ops;           // Bytecode instructions in one run (main VM only)
+    long peak_rss_kb;   // -1 where the platform cannot say
+} BenchResult;
+
+static double now_ms(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, t;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t);
+    return t.QuadPart * 1000.0 / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
+
+// One full run of source. With count_ops the interpreter is stepped by an
+// attached profiler (no timer) and only the op count is meaningful.
+static double run_once(const char* source, bool jit, bool count_ops, long* ops) {
+    char* code = strdup(source);
+    double start = now_ms();
+
+    VM vm;
+    memset(&vm, 0, sizeof(vm));
+    vm_init(&vm);
+    compiler_reset();
+    vm.source_code = code;
+    parse(&vm, code);
+    vm_verify(&vm, NULL, 0);
+
+    if (count_ops) profiler_start(&vm, 0);
+    else if (jit) jit_attach(&vm, JIT_HOT_THRESHOLD);
+
+    run_vm(&vm, false);
+
+    if (vm.profile) {
+        if (ops) *ops = vm.profile->steps;
+        profiler_stop(&vm);
+        profiler_free(&vm);
+    }
+    vm_cleanup(&vm);
+
+    double elapsed = now_ms() - start;
+    free(code);
+    return elapsed;
+}
+
+static void run_iterations(BenchResult* r, const char* source, int warmup, bool jit) {
+    for (int i = 0; i < warmup; i++) run_once(source, jit, false, NULL);
+    for (int i = 0; i < r->iterations; i++) r->ms[i] = run_once(source, jit, false, NULL);
+    run_once(source, jit, true, &r->ops);
+    r->ok = true;
+}
+
+#ifndef _WIN32
+// Runs the benchmark in a child with stdout silenced and the working directory
+// in TMPDIR (some benches write scratch files). Timings come back over a pipe,
+// peak RSS from the child's rusage.
+static void run_bench(BenchResult* r, const char* source, int warmup, bool jit) {
+    int fds[2];
+    if (pipe(fds) != 0) return;
+    fflush(stdout);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0) dup2(devnull, STDOUT_FILENO);
+        const char* tmp = getenv("TMPDIR");
+        if (chdir(tmp ? tmp : "/tmp") != 0) _exit(2);
+
+        run_iterations(r, source, warmup, jit);
+        fflush(stdout);
+        ssize_t n = write(fds[1], r, sizeof(*r));
+        _exit(n == (ssize_t)sizeof(*r) ? 0 : 2);
+    }
+
+    close(fds[1]);
+    BenchResult child;
+    size_t got = 0;
+    while (got < sizeof(child)) {
+        ssize_t n = read(fds[0], (char*)&child + got, sizeof(child) - got);
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+    close(fds[0]);
+
+    int status = 0;
+    struct rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    wait4(pid, &status, 0, &usage);
+    if (got != sizeof(child) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) return;
+
+    const char* name = r->name;
+    *r = child;
+    r->name = name;
+#ifdef __APPLE__
+    r->peak_rss_kb = usage.ru_maxrss / 1024; // Bytes on macOS
+#else
+    r->peak_rss_kb = usage.ru_maxrss;
+#endif
+}
+#else
+// No fork on Windows: runs in-process, so a runtime error ends the whole run
+// and peak memory is the runner's so far rather than the benchmark's.
+static void run_bench(BenchResult* r, const char* source, int warmup, bool jit) {
+    run_iterations(r, source, warmup, jit);
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) r->peak_rss_kb = (long)(pmc.PeakWorkingSetSize / 1024);
+}
+#endif
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Nearest-rank percentile of a sorted sample
+static double percentile(const double* sorted, int n, double p) {
+    int rank = (int)(p * n + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return sorted[rank - 1];
+}
+
+static bool write_json(const char* path, BenchResult* results, int count, int iterations, int warmup, bool jit) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) return false;
+    fprintf(fp, "{\n  \"iterations\": %d,\n  \"warmup\": %d,\n  \"jit\": %s,\n  \"benchmarks\": [\n",
+            iterations, warmup, jit ? "true" : "false");
+    for (int i = 0; i < count; i++) {
+        BenchResult* r = &results[i];
+        fprintf(fp, "    {\"name\": \"%s\", \"ok\": %s", r->name, r->ok ? "true" : "false");
+        if (r->ok) {
+            double sorted[BENCH_MAX_ITERATIONS];
+            memcpy(sorted, r->ms, r->iterations * sizeof(double));
+            qsort(sorted, r->iterations, sizeof(double), cmp_double);
+            double median = percentile(sorted, r->iterations, 0.5);
+            fprintf(fp, ", \"median_ms\": %.3f, \"p95_ms\": %.3f, \"min_ms\": %.3f, \"ops\": %ld, \"ops_per_sec\": %.0f, \"peak_rss_kb\": %ld, \"samples_ms\": [",
+                    median, percentile(sorted, r->iterations, 0.95), sorted[0], r->ops,
+                    median > 0 ? r->ops / (median / 1000.0) : 0.0, r->peak_rss_kb);
+            for (int j = 0; j < r->iterations; j++) fprintf(fp, "%s%.3f", j ? ", " : "", r->ms[j]);
+            fprintf(fp, "]");
+        }
+        fprintf(fp, "}%s\n", i + 1 < count ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    fclose(fp);
+    return true;
+}
+
+static void print_usage(void) {
+    printf("Usage: mylo_bench [--iterations N] [--warmup N] [--jit] [--json path] [--dir path] [name ...]\n");
+    printf("Benchmarks:");
+    for (int i = 0; i < BENCH_COUNT; i++) printf(" %s", bench_names[i]);
+    printf("\n");
+}
+
+int main(int argc, char** argv) {
+    int iterations = 10;
+    int warmup = 2;
+    bool jit = false;
+    const char* json_path = NULL;
+    const char* dir = MYLO_BENCH_DIR;
+    const char* filters[BENCH_COUNT];
+    int filter_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) iterations = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) warmup = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) json_path = argv[++i];
+        else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) dir = argv[++i];
+        else if (strcmp(argv[i], "--jit") == 0) jit = true;
+        else if (strcmp(argv[i], "--help") == 0) {
+            print_usage();
+            return 0;
+        }
+        else if (argv[i][0] == '-' || filter_count == BENCH_COUNT) {
+            print_usage();
+            return 1;
+        }
+        else filters[filter_count++] = argv[i];
+    }
+    for (int f = 0; f < filter_count; f++) {
+        bool known = false;
+        for (int b = 0; b < BENCH_COUNT; b++) {
+            if (strcmp(filters[f], bench_names[b]) == 0) known = true;
+        }
+        if (!known) {
+            printf("Unknown benchmark '%s'.\n", filters[f]);
+            print_usage();
+            return 1;
+        }
+    }
+    if (iterations < 1) iterations = 1;
+    if (iterations > BENCH_MAX_ITERATIONS) iterations = BENCH_MAX_ITERATIONS;
+    if (warmup < 0) warmup = 0;
+    if (jit && !jit_supported()) {
+        printf("Note: --jit is not supported on this platform, interpreting.\n");
+        jit = false;
+    }
+
+    static BenchResult results[BENCH_COUNT];
+    int count = 0;
+    bool all_ok = true;
+
+    printf("%-12s %10s %10s %10s %14s %12s\n", "benchmark", "median ms", "p95 ms", "min ms", "ops/sec", "peak RSS KB");
+    for (int b = 0; b < BENCH_COUNT; b++) {
+        bool selected = filter_count == 0;
+        for (int f = 0; f < filter_count; f++) {
+            if (strcmp(filters[f], bench_names[b]) == 0) selected = true;
+        }
+        if (!selected) continue;
+
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s.mylo", dir, bench_names[b]);
+        BenchResult* r = &results[count++];
+        memset(r, 0, sizeof(*r));
+        r->name = bench_names[b];
+        r->iterations = iterations;
+        r->peak_rss_kb = -1;
+
+        char* source = read_file(path);
+        if (!source) {
+            printf("%-12s cannot read %s\n", r->name, path);
+            all_ok = false;
+            continue;
+        }
+        run_bench(r, source, warmup, jit);
+        free(source);
+
+        if (!r->ok) {
+            printf("%-12s FAILED (run `mylo %s` to see the error)\n", r->name, path);
+            all_ok = false;
+            continue;
+        }
+        double sorted[BENCH_MAX_ITERATIONS];
+        memcpy(sorted, r->ms, iterations * sizeof(double));
+        qsort(sorted, iterations, sizeof(double), cmp_double);
+        double median = percentile(sorted, iterations, 0.5);
+        printf("%-12s %10.2f %10.2f %10.2f %14.0f %12ld\n", r->name, median, percentile(sorted, iterations, 0.95),
+               sorted[0], median > 0 ? r->ops / (median / 1000.0) : 0.0, r->peak_rss_kb);
+    }
+
+    if (count == 0) {
+        print_usage();
+        return 1;
+    }
+    if (json_path) {
+        if (write_json(json_path, results, count, iterations, warmup, jit)) printf("\nResults written to %s\n", json_path);
+        else printf("\nError: cannot write %s\n", json_path);
+    }
+    return all_ok ? 0 : 1;
+}
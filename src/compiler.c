@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <math.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include "mylolib.h"
@@ -40,7 +41,8 @@ typedef enum {
     TK_MONITOR,
     TK_DEBUGGER,
     TK_OR,
-    TK_AND
+    TK_AND,
+    TK_AT
 } MyloTokenType;
 
 // Token Names for pretty printing
@@ -56,7 +58,7 @@ const char *TOKEN_NAMES[] = {
     "break", "continue", "enum", "module_path",
     "true", "false", "*", "/", "%",
     "embed", "Type Definition", "region", "clear", "monitor",
-    "debugger","||","&&",
+    "debugger","||","&&","@",
 };
 
 // Mylo Exit Function
@@ -65,7 +67,7 @@ extern void mylo_exit(int code);
 void match(MyloTokenType t);
 
 const char *get_token_name(MyloTokenType t) {
-    if (t < 0 || t > TK_DEBUGGER) return "Unknown";
+    if (t < 0 || t > TK_AT) return "Unknown";
     return TOKEN_NAMES[t];
 }
 
@@ -162,6 +164,7 @@ void parse_struct_literal(int struct_idx);
 void parse_map_literal();
 void expression();
 void statement();
+void block_body();
 void range_expr();
 
 void print_line_slice(char *start, char *end) {
@@ -260,14 +263,180 @@ void error(const char *fmt, ...) {
     mylo_exit(1);
 }
 
+// String literals (and enum names) are pinned so the runtime string collector never frees them
+static int intern_literal(VM* vm, const char* s) {
+    int id = make_string(vm, s);
+    vm_pin_string(vm, id);
+    return id;
+}
+
+// --- Peephole / Superinstructions ---
+// emit_op() remembers where the last few instructions start so that common
+// sequences can be folded into a single fused opcode as they are emitted.
+// Any jump target must be taken through code_label(): it forgets that history,
+// so nothing is ever fused across a place another instruction can jump to.
+#define PEEP_HISTORY 3
+static int peep_ops[PEEP_HISTORY]; // Start offsets of the most recent instructions (oldest first)
+static int peep_count = 0;
+static int peep_store_at = -1; // Start of an LVAR/GET, ADD_C, SVAR/SET run awaiting its slot operand
+static int expr_line = 0; // Line of the expression tree node being lowered (0: the current token's)
+
+static void fuse_store(int slot);
+static void facts_clear();
+static void inline_reset();
+static void fact_kill(int slot);
+static bool fact_store_pending = false; // The next operand is the slot of an SVAR
+
 void emit(int op) {
     if (compiling_vm->code_size >= MAX_CODE) {
         fprintf(stderr, "Error: Code overflow\n");
         mylo_exit(1);
     }
     compiling_vm->bytecode[compiling_vm->code_size] = op;
-    compiling_vm->lines[compiling_vm->code_size] = curr.line > 0 ? curr.line : line;
+    compiling_vm->lines[compiling_vm->code_size] = expr_line > 0 ? expr_line : (curr.line > 0 ? curr.line : line);
     compiling_vm->code_size++;
+
+    if (fact_store_pending) {
+        fact_store_pending = false;
+        fact_kill(op);
+    }
+    if (peep_store_at != -1 && compiling_vm->code_size == peep_store_at + 6) {
+        fuse_store(op);
+    }
+}
+
+static void peep_reset() {
+    peep_count = 0;
+    peep_store_at = -1;
+}
+
+static void peep_push(int pos) {
+    if (peep_count == PEEP_HISTORY) {
+        memmove(peep_ops, peep_ops + 1, sizeof(int) * (PEEP_HISTORY - 1));
+        peep_count--;
+    }
+    peep_ops[peep_count++] = pos;
+}
+
+// Opcode of the n-th most recent instruction (1 = last), or -1 if unknown.
+static int peep_op(int n) {
+    if (n > peep_count) return -1;
+    return compiling_vm->bytecode[peep_ops[peep_count - n]];
+}
+
+static int peep_pos(int n) {
+    return peep_ops[peep_count - n];
+}
+
+int code_label() {
+    peep_reset();
+    facts_clear();
+    return compiling_vm->code_size;
+}
+
+static int fused_branch(int cmp) {
+    switch (cmp) {
+        case OP_LT: return OP_LT_JZ;
+        case OP_GT: return OP_GT_JZ;
+        case OP_LE: return OP_LE_JZ;
+        case OP_GE: return OP_GE_JZ;
+        case OP_EQ: return OP_EQ_JZ;
+        case OP_NEQ: return OP_NEQ_JZ;
+        default: return -1;
+    }
+}
+
+// Tries to fold `op` into the instructions just emitted. Returns true if the
+// opcode was absorbed; the caller still emits its operands as usual.
+static bool peephole(int op) {
+    int size = compiling_vm->code_size;
+    int *code = compiling_vm->bytecode;
+
+    // PSH_NUM c, ADD / SUB  ->  ADD_C c / SUB_C c
+    if ((op == OP_ADD || op == OP_SUB) && peep_op(1) == OP_PSH_NUM && peep_pos(1) == size - 2) {
+        code[size - 2] = (op == OP_ADD) ? OP_ADD_C : OP_SUB_C;
+        return true;
+    }
+
+    // <cmp>, JZ  ->  <cmp>_JZ
+    if (op == OP_JZ && peep_count > 0 && fused_branch(peep_op(1)) != -1 && peep_pos(1) == size - 1) {
+        code[size - 1] = fused_branch(peep_op(1));
+        return true;
+    }
+
+    // LVAR x, HGET off type  ->  LVAR_HGET x off type
+    if (op == OP_HGET && peep_op(1) == OP_LVAR && peep_pos(1) == size - 2) {
+        code[size - 2] = OP_LVAR_HGET;
+        return true;
+    }
+
+    // LVAR x, ADD_C c, SVAR x  ->  INC_LVAR x c (and the GET/SET equivalent).
+    // The slot operand isn't known yet, so arm fuse_store() to check it.
+    if ((op == OP_SVAR || op == OP_SET) && peep_count >= 2 && peep_pos(1) == size - 2 && peep_pos(2) == size - 4 &&
+        peep_op(1) == OP_ADD_C && peep_op(2) == (op == OP_SVAR ? OP_LVAR : OP_GET)) {
+        peep_store_at = size - 4;
+    }
+    return false;
+}
+
+// Called once the operand of an armed SVAR/SET is emitted.
+static void fuse_store(int slot) {
+    int start = peep_store_at;
+    int *code = compiling_vm->bytecode;
+    peep_store_at = -1;
+    if (code[start + 1] != slot) return;
+
+    code[start] = (code[start] == OP_LVAR) ? OP_INC_LVAR : OP_INC_GVAR;
+    code[start + 2] = code[start + 3];
+    compiling_vm->code_size = start + 3;
+
+    peep_count -= 3;
+    peep_push(start);
+}
+
+void emit_op(int op) {
+    int pos = compiling_vm->code_size;
+    if (peephole(op)) return;
+    emit(op);
+    peep_push(pos);
+    if (op == OP_SVAR) fact_store_pending = true;
+}
+
+// --- Local Facts (copy propagation) ---
+// In straight-line code a local declared as `var x = <number>` or
+// `var x = <other local>` is read through that fact, which lets constants
+// fold into the expressions that use them. A fact is dropped at every jump
+// target (code_label), when either slot is stored to, and when the slot is
+// taken by a new declaration.
+typedef enum { FACT_NONE, FACT_CONST, FACT_COPY } LocalFactKind;
+
+typedef struct {
+    LocalFactKind kind;
+    double num; // FACT_CONST
+    int slot;   // FACT_COPY: the local this one is a copy of
+} LocalFact;
+
+static LocalFact local_facts[MAX_GLOBALS];
+static int fact_limit = 0; // Slots at or above this hold no facts
+
+static void facts_clear() {
+    for (int i = 0; i < fact_limit; i++) local_facts[i].kind = FACT_NONE;
+    fact_limit = 0;
+    fact_store_pending = false;
+}
+
+static void fact_kill(int slot) {
+    for (int i = 0; i < fact_limit; i++) {
+        if (i == slot || (local_facts[i].kind == FACT_COPY && local_facts[i].slot == slot)) local_facts[i].kind = FACT_NONE;
+    }
+}
+
+static void fact_set(int slot, LocalFactKind kind, double num, int source) {
+    if (slot < 0 || slot >= MAX_GLOBALS) return;
+    local_facts[slot].kind = kind;
+    local_facts[slot].num = num;
+    local_facts[slot].slot = source;
+    if (slot >= fact_limit) fact_limit = slot + 1;
 }
 
 int find_local(char *name) {
@@ -418,16 +587,16 @@ void emit_break() {
 
     // Unwind nested memory scopes
     int scopes_to_pop = current_scope_depth - loop->scope_depth;
-    for (int i = 0; i < scopes_to_pop; i++) emit(OP_SCOPE_EXIT);
+    for (int i = 0; i < scopes_to_pop; i++) emit_op(OP_SCOPE_EXIT);
 
     // Unwind nested local variables
     if (inside_function) {
         int locals_to_pop = local_count - loop->local_count;
-        for (int i = 0; i < locals_to_pop; i++) emit(OP_POP);
+        for (int i = 0; i < locals_to_pop; i++) emit_op(OP_POP);
     }
 
     if (loop->break_count >= MAX_JUMPS_PER_LOOP) error("Too many 'break' statements");
-    emit(OP_JMP);
+    emit_op(OP_JMP);
     loop->break_patches[loop->break_count++] = compiling_vm->code_size;
     emit(0);
 }
@@ -437,15 +606,15 @@ void emit_continue() {
     LoopControl *loop = &loop_stack[loop_depth - 1];
 
     int scopes_to_pop = current_scope_depth - loop->scope_depth;
-    for (int i = 0; i < scopes_to_pop; i++) emit(OP_SCOPE_EXIT);
+    for (int i = 0; i < scopes_to_pop; i++) emit_op(OP_SCOPE_EXIT);
 
     if (inside_function) {
         int locals_to_pop = local_count - loop->local_count;
-        for (int i = 0; i < locals_to_pop; i++) emit(OP_POP);
+        for (int i = 0; i < locals_to_pop; i++) emit_op(OP_POP);
     }
 
     if (loop->continue_count >= MAX_JUMPS_PER_LOOP) error("Too many 'continue' statements");
-    emit(OP_JMP);
+    emit_op(OP_JMP);
     loop->continue_patches[loop->continue_count++] = compiling_vm->code_size;
     emit(0);
 }
@@ -630,6 +799,7 @@ void next_token() {
         case ',': curr.type = TK_COMMA; break;
         case '.': curr.type = TK_DOT; break;
         case '?': curr.type = TK_QUESTION; break;
+        case '@': curr.type = TK_AT; break;
         case '<': if (*src == '=') { src++; curr.type = TK_LE; } else curr.type = TK_LT; break;
         case '>': if (*src == '=') { src++; curr.type = TK_GE; } else curr.type = TK_GT; break;
         case '!': if (*src == '=') { src++; curr.type = TK_NEQ; } else error("Unexpected char '!'"); break;
@@ -697,6 +867,9 @@ void compiler_reset() {
     c_header_count = 0;
     line = 1;
     inside_function = false;
+    peep_reset();
+    facts_clear();
+    inline_reset();
 }
 
 TypeInfo parse_type_spec() {
@@ -855,10 +1028,10 @@ static void c_gen_ffi_wrappers(FILE *fp) {
                 for (int s = 0; s < struct_count; s++) if (strcmp(struct_defs[s].name, ret_type) == 0) st_idx = s;
                 if (st_idx != -1) {
                     fprintf(fp, "    double ptr = heap_alloc(vm, %d + HEAP_HEADER_STRUCT);\n", struct_defs[st_idx].field_count);
-                    fprintf(fp, "    double* base = vm_resolve_ptr(vm, ptr);\n");
-                    fprintf(fp, "    base[HEAP_OFFSET_TYPE] = %d.0;\n", st_idx);
+                    fprintf(fp, "    Value* base = vm_resolve_ptr(vm, ptr);\n");
+                    fprintf(fp, "    base[HEAP_OFFSET_TYPE] = %d;\n", st_idx);
                     for (int f = 0; f < struct_defs[st_idx].field_count; f++) fprintf(
-                        fp, "    base[HEAP_HEADER_STRUCT + %d] = res.%s;\n", f, struct_defs[st_idx].fields[f]);
+                        fp, "    base[HEAP_HEADER_STRUCT + %d] = VAL_NUM(res.%s);\n", f, struct_defs[st_idx].fields[f]);
                     fprintf(fp, "    vm_push(vm, ptr, T_OBJ);\n");
                 } else {
                     fprintf(fp, "    vm_push(vm, 0.0, T_OBJ);\n");
@@ -873,28 +1046,28 @@ static void c_gen_ffi_wrappers(FILE *fp) {
 void factor() {
     if (curr.type == TK_NUM) {
         int idx = make_const(compiling_vm, curr.val_float);
-        emit(OP_PSH_NUM); emit(idx);
+        emit_op(OP_PSH_NUM); emit(idx);
         match(TK_NUM);
     } else if (curr.type == TK_STR) {
-        int id = make_string(compiling_vm, curr.text);
-        emit(OP_PSH_STR); emit(id);
+        int id = intern_literal(compiling_vm, curr.text);
+        emit_op(OP_PSH_STR); emit(id);
         match(TK_STR);
     } else if (curr.type == TK_TRUE) {
-        emit(OP_PSH_NUM); emit(make_const(compiling_vm, 1.0));
+        emit_op(OP_PSH_NUM); emit(make_const(compiling_vm, 1.0));
         match(TK_TRUE);
     } else if (curr.type == TK_FALSE) {
-        emit(OP_PSH_NUM); emit(make_const(compiling_vm, 0.0));
+        emit_op(OP_PSH_NUM); emit(make_const(compiling_vm, 0.0));
         match(TK_FALSE);
     } else if (curr.type == TK_MINUS) {
         match(TK_MINUS);
         if (curr.type == TK_NUM) {
             int idx = make_const(compiling_vm, -curr.val_float);
-            emit(OP_PSH_NUM); emit(idx);
+            emit_op(OP_PSH_NUM); emit(idx);
             match(TK_NUM);
         } else {
-            emit(OP_PSH_NUM); emit(make_const(compiling_vm, 0.0));
+            emit_op(OP_PSH_NUM); emit(make_const(compiling_vm, 0.0));
             factor();
-            emit(OP_SUB);
+            emit_op(OP_SUB);
         }
     } else if (curr.type == TK_LBRACKET) {
         match(TK_LBRACKET);
@@ -904,7 +1077,7 @@ void factor() {
             while (curr.type == TK_COMMA) { match(TK_COMMA); expression(); count++; }
         }
         match(TK_RBRACKET);
-        emit(OP_ARR); emit(count);
+        emit_op(OP_ARR); emit(count);
     } else if (curr.type == TK_LBRACE) {
         char *safe_src = src; Token safe_curr = curr; int safe_line = line;
         match(TK_LBRACE);
@@ -989,15 +1162,15 @@ void factor() {
         ffi_blocks[ffi_idx].code_body[len] = '\0';
         src = end + 1;
         next_token();
-        emit(OP_NATIVE);
+        emit_op(OP_NATIVE);
         int std_count = 0;
         while (std_library[std_count].name != NULL) std_count++;
         emit(std_count + ffi_idx);
     }     
     
     else if (curr.type == TK_FSTR) {
-        int empty_id = make_string(compiling_vm, "");
-        emit(OP_PSH_STR); emit(empty_id);
+        int empty_id = intern_literal(compiling_vm, "");
+        emit_op(OP_PSH_STR); emit(empty_id);
         
         // --- THE FIX: Isolate the string so recursive tokenization doesn't corrupt it ---
         char safe_fstr[MAX_STRING_LENGTH];
@@ -1015,7 +1188,7 @@ void factor() {
                     char chunk[MAX_STRING_LENGTH]; int len = (int) (ptr - start);
                     if (len >= MAX_STRING_LENGTH) len = MAX_STRING_LENGTH - 1;
                     strncpy(chunk, start, len); chunk[len] = '\0';
-                    int id = make_string(compiling_vm, chunk); emit(OP_PSH_STR); emit(id); emit(OP_CAT);
+                    int id = intern_literal(compiling_vm, chunk); emit_op(OP_PSH_STR); emit(id); emit_op(OP_CAT);
                 }
                 ptr++; char *expr_start = ptr;
                 while (*ptr && *ptr != '}') ptr++;
@@ -1028,7 +1201,7 @@ void factor() {
                     src = expr_code; next_token(); expression();
                     
                     src = old_src; curr = old_token; line = old_line;
-                    emit(OP_CAT);
+                    emit_op(OP_CAT);
                     ptr++; start = ptr;
                 }
             } else ptr++;
@@ -1037,13 +1210,13 @@ void factor() {
             char chunk[MAX_STRING_LENGTH]; int len = (int) (ptr - start);
             if (len >= MAX_STRING_LENGTH) len = MAX_STRING_LENGTH - 1;
             strncpy(chunk, start, len); chunk[len] = '\0';
-            int id = make_string(compiling_vm, chunk); emit(OP_PSH_STR); emit(id); emit(OP_CAT);
+            int id = intern_literal(compiling_vm, chunk); emit_op(OP_PSH_STR); emit(id); emit_op(OP_CAT);
         }
         match(TK_FSTR);
 
     } else if (curr.type == TK_BSTR) {
-        int id = make_string(compiling_vm, curr.text);
-        emit(OP_PSH_STR); emit(id); emit(OP_MK_BYTES);
+        int id = intern_literal(compiling_vm, curr.text);
+        emit_op(OP_PSH_STR); emit(id); emit_op(OP_MK_BYTES);
         match(TK_BSTR);
     } else if (curr.type == TK_ID) {
         Token start_token = curr;
@@ -1069,8 +1242,8 @@ void factor() {
             }
 
             // Get String IDs for both
-            int type_str_id = make_string(compiling_vm, type_name);
-            int member_str_id = make_string(compiling_vm, short_name);
+            int type_str_id = intern_literal(compiling_vm, type_name);
+            int member_str_id = intern_literal(compiling_vm, short_name);
 
             // Pack the Type ID, Member ID, and Integer value into a single 64-bit unsigned long long (using 48 bits)
             unsigned long long packed = ((unsigned long long)type_str_id << 32) |
@@ -1078,7 +1251,7 @@ void factor() {
                                         (enum_val & 0xFFFF);
 
             int idx = make_const(compiling_vm, (double)packed);
-            emit(OP_PSH_ENUM);
+            emit_op(OP_PSH_ENUM);
             emit(idx);
             return;
         }
@@ -1091,11 +1264,11 @@ void factor() {
             }
             match(TK_RPAREN);
             int faddr = find_func(name);
-            if (faddr != -1) { emit(OP_CALL); emit(faddr); emit(arg_count); return; }
+            if (faddr != -1) { emit_op(OP_CALL); emit(faddr); emit(arg_count); return; }
             int std_idx = find_stdlib_func(name);
             if (std_idx != -1) {
                 if (std_library[std_idx].arg_count != arg_count) error("StdLib function '%s' expects %d args", name, std_library[std_idx].arg_count);
-                emit(OP_NATIVE); emit(std_idx); return;
+                emit_op(OP_NATIVE); emit(std_idx); return;
             }
 
             int cfn_idx = find_cfn(name);
@@ -1103,22 +1276,22 @@ void factor() {
                 if (ffi_blocks[cfn_idx].arg_count != arg_count) error("CFN function '%s' expects %d args", name, ffi_blocks[cfn_idx].arg_count);
                 int std_count = 0;
                 while (std_library[std_count].name != NULL) std_count++;
-                emit(OP_NATIVE); emit(std_count + cfn_idx); return;
+                emit_op(OP_NATIVE); emit(std_count + cfn_idx); return;
             }
 
             char m[MAX_IDENTIFIER * 2]; get_mangled_name(m, name);
             faddr = find_func(m);
-            if (faddr != -1) { emit(OP_CALL); emit(faddr); emit(arg_count); return; }
+            if (faddr != -1) { emit_op(OP_CALL); emit(faddr); emit(arg_count); return; }
             curr = start_token; error("Undefined function '%s'", name);
         } else {
             int loc = find_local(name); int type_id = -1; bool is_array = false;
             if (loc != -1) {
-                emit(OP_LVAR); emit(locals[loc].offset); type_id = locals[loc].type_id; is_array = locals[loc].is_array;
+                emit_op(OP_LVAR); emit(locals[loc].offset); type_id = locals[loc].type_id; is_array = locals[loc].is_array;
             } else {
                 int glob = find_global(name);
                 if (glob == -1) { char m[MAX_IDENTIFIER * 2]; get_mangled_name(m, name); glob = find_global(m); }
                 if (glob == -1) error("Undefined var '%s'", name);
-                emit(OP_GET); emit(globals[glob].addr); type_id = globals[glob].type_id; is_array = globals[glob].is_array;
+                emit_op(OP_GET); emit(globals[glob].addr); type_id = globals[glob].type_id; is_array = globals[glob].is_array;
             }
             while (curr.type == TK_DOT || curr.type == TK_LBRACKET) {
                 if (curr.type == TK_DOT) {
@@ -1128,14 +1301,14 @@ void factor() {
 
                     int offset = find_field(type_id, f);
                     if (offset == -1) error("Struct '%s' has no field '%s'", struct_defs[type_id].name, f);
-                    //emit(OP_HGET); emit(offset); emit(type_id); type_id = -1;
+                    //emit_op(OP_HGET); emit(offset); emit(type_id); type_id = -1;
                     int field_type = struct_defs[type_id].field_types[offset];
-                    emit(OP_HGET); emit(offset); emit(type_id);
+                    emit_op(OP_HGET); emit(offset); emit(type_id);
                     type_id = field_type; // Propagate the type of the field to the next iteration
                 } else if (curr.type == TK_LBRACKET) {
                     match(TK_LBRACKET); expression();
-                    if (curr.type == TK_COLON) { match(TK_COLON); expression(); match(TK_RBRACKET); emit(OP_SLICE); }
-                    else { match(TK_RBRACKET); emit(OP_AGET); if (is_array) is_array = false; else type_id = -1; }
+                    if (curr.type == TK_COLON) { match(TK_COLON); expression(); match(TK_RBRACKET); emit_op(OP_SLICE); }
+                    else { match(TK_RBRACKET); emit_op(OP_AGET); if (is_array) is_array = false; else type_id = -1; }
                 }
             }
         }
@@ -1152,11 +1325,11 @@ void term() {
         next_token();
         factor();
         switch (op) {
-            case TK_MUL: emit(OP_MUL);
+            case TK_MUL: emit_op(OP_MUL);
                 break;
-            case TK_DIV: emit(OP_DIV);
+            case TK_DIV: emit_op(OP_DIV);
                 break;
-            case TK_MOD_OP: emit(OP_MOD);
+            case TK_MOD_OP: emit_op(OP_MOD);
                 break;
             default: break;
         }
@@ -1173,10 +1346,10 @@ void additive_expr() {
             case TK_PLUS:
                 // The VM's exec_math_op already checks if the
                 // operands are T_STR and performs concatenation.
-                emit(OP_ADD);
+                emit_op(OP_ADD);
                 break;
             case TK_MINUS:
-                emit(OP_SUB);
+                emit_op(OP_SUB);
                 break;
             default: break;
         }
@@ -1190,17 +1363,17 @@ void relation_expr() {
         next_token();
         range_expr();
         switch (op) {
-            case TK_LT: emit(OP_LT);
+            case TK_LT: emit_op(OP_LT);
                 break;
-            case TK_GT: emit(OP_GT);
+            case TK_GT: emit_op(OP_GT);
                 break;
-            case TK_LE: emit(OP_LE);
+            case TK_LE: emit_op(OP_LE);
                 break;
-            case TK_GE: emit(OP_GE);
+            case TK_GE: emit_op(OP_GE);
                 break;
-            case TK_EQ: emit(OP_EQ);
+            case TK_EQ: emit_op(OP_EQ);
                 break;
-            case TK_NEQ: emit(OP_NEQ);
+            case TK_NEQ: emit_op(OP_NEQ);
                 break;
             default: break;
         }
@@ -1212,7 +1385,7 @@ void range_expr() {
     if (curr.type == TK_RANGE) {
         match(TK_RANGE);
         additive_expr();
-        emit(OP_RANGE);
+        emit_op(OP_RANGE);
     }
 }
 // 1. Create the AND expression parser
@@ -1221,7 +1394,7 @@ void logic_and_expr() {
     while (curr.type == TK_AND) {
         match(TK_AND);
         relation_expr();
-        emit(OP_AND);
+        emit_op(OP_AND);
     }
 }
 
@@ -1231,33 +1404,853 @@ void logic_or_expr() {
     while (curr.type == TK_OR) {
         match(TK_OR);
         logic_and_expr();
-        emit(OP_OR);
+        emit_op(OP_OR);
+    }
+}
+
+// --- Expression Trees ---
+// expression() first parses into a small tree without emitting anything, so
+// the whole expression can be optimised before it is lowered to the same
+// opcodes the direct emitters above produce:
+// * operands that are both constants are folded (numbers, string + string);
+// * an operand identical to the one just pushed (`v.x * v.x`, `f(a[i], a[i])`)
+//   is a DUP instead of a second load;
+// * locals with a fact (see Local Facts) are read as their constant or source.
+// * calls to small functions are replaced by their bodies (see Inlining).
+// Every node keeps the line of its token. Anything the tree does not model
+// (f-strings, byte strings, braces, slices, enums, C blocks) and every error
+// rewinds the tokenizer and parses the expression again with the emitters.
+typedef enum {
+    EXPR_NUM, EXPR_STR, EXPR_LOCAL, EXPR_GLOBAL, EXPR_FIELD, EXPR_INDEX,
+    EXPR_NEG, EXPR_BINARY, EXPR_CALL, EXPR_NATIVE, EXPR_ARRAY,
+    EXPR_STRUCT, EXPR_INIT, EXPR_CAST // Only built by Inlining
+} ExprKind;
+
+typedef struct {
+    ExprKind kind;
+    int line;
+    double num;      // EXPR_NUM
+    int arg;         // String id, slot, global, field offset, opcode, call target, native index, struct or type
+    int arg2;        // Struct of an EXPR_FIELD/EXPR_INIT; argument or element count; OP_CAST or OP_CHECK_TYPE
+    int left, right; // Operands; arguments and elements are `left`, chained through `next`
+    int next;
+    bool bound;      // A copy of an argument, standing for a parameter of an inlined body
+} ExprNode;
+
+#define MAX_EXPR_NODES 1024
+static ExprNode expr_nodes[MAX_EXPR_NODES];
+static int expr_node_count = 0;
+
+static int tree_or();
+
+static int tree_node(ExprKind kind, int node_line) {
+    if (expr_node_count >= MAX_EXPR_NODES) return -1;
+    ExprNode *n = &expr_nodes[expr_node_count];
+    memset(n, 0, sizeof(*n));
+    n->kind = kind;
+    n->line = node_line;
+    n->left = n->right = n->next = -1;
+    return expr_node_count++;
+}
+
+static int tree_num(double v, int node_line) {
+    int n = tree_node(EXPR_NUM, node_line);
+    if (n != -1) expr_nodes[n].num = v;
+    return n;
+}
+
+static int tree_unary(ExprKind kind, int operand, int arg, int arg2, int node_line) {
+    if (operand == -1) return -1;
+    if (kind == EXPR_NEG && expr_nodes[operand].kind == EXPR_NUM) return tree_num(0.0 - expr_nodes[operand].num, node_line);
+    int n = tree_node(kind, node_line);
+    if (n == -1) return -1;
+    expr_nodes[n].left = operand;
+    expr_nodes[n].arg = arg;
+    expr_nodes[n].arg2 = arg2;
+    return n;
+}
+
+// Folds two constants the way the VM would combine them at run time
+static bool tree_fold(int op, double a, double b, double *out) {
+    switch (op) {
+        case OP_ADD: *out = a + b; break;
+        case OP_SUB: *out = a - b; break;
+        case OP_MUL: *out = a * b; break;
+        case OP_DIV: *out = a / b; break;
+        case OP_MOD: *out = fmod(a, b); break;
+        case OP_LT: *out = a < b; break;
+        case OP_GT: *out = a > b; break;
+        case OP_LE: *out = a <= b; break;
+        case OP_GE: *out = a >= b; break;
+        case OP_EQ: *out = a == b; break;
+        case OP_NEQ: *out = a != b; break;
+        case OP_AND: *out = a != 0 && b != 0; break;
+        case OP_OR: *out = a != 0 || b != 0; break;
+        default: return false;
+    }
+    return isfinite(*out);
+}
+
+static int tree_binary(int op, int l, int r, int node_line) {
+    if (l == -1 || r == -1) return -1;
+    ExprNode *a = &expr_nodes[l];
+    ExprNode *b = &expr_nodes[r];
+    double v;
+    if (a->kind == EXPR_NUM && b->kind == EXPR_NUM && tree_fold(op, a->num, b->num, &v)) return tree_num(v, node_line);
+    if (op == OP_ADD && a->kind == EXPR_STR && b->kind == EXPR_STR) {
+        const char *sa = compiling_vm->string_pool[a->arg];
+        const char *sb = compiling_vm->string_pool[b->arg];
+        if (strlen(sa) + strlen(sb) < MAX_STRING_LENGTH) {
+            char joined[MAX_STRING_LENGTH];
+            snprintf(joined, sizeof(joined), "%s%s", sa, sb);
+            int n = tree_node(EXPR_STR, node_line);
+            if (n != -1) expr_nodes[n].arg = intern_literal(compiling_vm, joined);
+            return n;
+        }
     }
+    int n = tree_node(EXPR_BINARY, node_line);
+    if (n == -1) return -1;
+    expr_nodes[n].arg = op;
+    expr_nodes[n].left = l;
+    expr_nodes[n].right = r;
+    return n;
+}
+
+static bool tree_same(int a, int b) {
+    if (a == -1 || b == -1) return a == b;
+    ExprNode *x = &expr_nodes[a];
+    ExprNode *y = &expr_nodes[b];
+    if (x->kind != y->kind || x->arg != y->arg || x->arg2 != y->arg2) return false;
+    if (x->kind == EXPR_NUM) return x->num == y->num;
+    return tree_same(x->left, y->left) && tree_same(x->right, y->right);
+}
+
+// Reads with no side effects: variables, constants, and fields or elements of them
+static bool tree_pure_load(int n) {
+    ExprNode *e = &expr_nodes[n];
+    if (e->kind == EXPR_NUM || e->kind == EXPR_LOCAL || e->kind == EXPR_GLOBAL) return true;
+    if (e->kind == EXPR_FIELD) return tree_pure_load(e->left);
+    if (e->kind == EXPR_INDEX) return tree_pure_load(e->left) && tree_pure_load(e->right);
+    return false;
+}
+
+// True when `n` can be a DUP of `prev`, the value just pushed, and loading it costs more
+static bool tree_repeats(int prev, int n) {
+    ExprKind kind = expr_nodes[n].kind;
+    return prev != -1 && (kind == EXPR_FIELD || kind == EXPR_INDEX) && tree_pure_load(n) && tree_same(prev, n);
+}
+
+// Comma separated expressions up to `close`; the first is returned, the rest chain through next
+static int tree_list(MyloTokenType close, int *count) {
+    int first = -1, last = -1;
+    *count = 0;
+    if (curr.type != close) {
+        while (1) {
+            int item = tree_or();
+            if (item == -1) return -2;
+            if (last == -1) first = item;
+            else expr_nodes[last].next = item;
+            last = item;
+            (*count)++;
+            if (curr.type != TK_COMMA) break;
+            next_token();
+        }
+    }
+    if (curr.type != close) return -2;
+    next_token();
+    return first;
+}
+
+// --- Inlining ---
+// A function whose body is just `ret <expr>`, or `var v[: T] = <expr>` and then
+// `ret v` (the expression may be a struct literal), keeps a copy of that
+// expression's text. A call to it from an expression tree parses the text again
+// with each parameter bound to its argument's tree, so it costs no OP_CALL,
+// OP_SCOPE_ENTER, argument checks or OP_RET. A body qualifies when it reads
+// only its parameters, globals and constants, calls only numeric natives and
+// other inlined functions, allocates nothing but the struct it returns, and is
+// at most INLINE_MAX_NODES operations (`@inline` lifts the limit, `@noinline`
+// keeps every call). Each call must also be safe to rewrite:
+// * an argument read more than once is a constant, a variable or a field or
+//   element of one, or a small calculation passed as a `num`, since it is
+//   evaluated again at every read;
+// * an argument with side effects is read exactly once, the other arguments
+//   are constants or locals, and the body calls no natives and reads no
+//   globals, fields or elements, so nothing runs in a different order;
+// * a typed parameter is checked with OP_CHECK_TYPE at its first read unless
+//   the argument is a literal, cast or struct of that type.
+// Inlined nodes keep the lines of the function body, so runtime errors and
+// --profile point into the helper. Nothing is inlined for --db and --dap, where
+// stepping into the function matters more.
+#define INLINE_MAX_NODES 16
+#define INLINE_MAX_DEPTH 8
+
+typedef enum { INLINE_AUTO, INLINE_ALWAYS, INLINE_NEVER } InlineHint;
+
+typedef struct {
+    char *expr;    // Copy of the body's expression
+    int line;      // Line the expression starts on
+    int struct_id; // Struct of a struct literal expression, -1 otherwise
+    int cast_type; // Declared type of `var v: T`, TYPE_ANY otherwise
+    int param_count;
+    char params[MAX_FFI_ARGS][MAX_IDENTIFIER];
+    int param_types[MAX_FFI_ARGS];
+    bool param_is_array[MAX_FFI_ARGS];
+    char namespace_[MAX_IDENTIFIER];
+} InlineBody;
+
+static InlineBody *inline_bodies[MAX_GLOBALS]; // Parallel to funcs[], NULL when calls are kept
+static int inline_body_limit = 0;               // Entries at or above this are NULL
+
+typedef struct {
+    InlineBody *body;
+    int args[MAX_FFI_ARGS];   // Argument trees
+    int uses[MAX_FFI_ARGS];   // Reads of each parameter so far
+    bool check[MAX_FFI_ARGS]; // The first read still needs an OP_CHECK_TYPE
+} InlineFrame;
+
+static InlineFrame inline_frames[INLINE_MAX_DEPTH];
+static int inline_depth = 0; // Bodies being parsed at a call site
+
+// What a call may do with an argument, from most to least freely
+typedef enum { ARG_SIMPLE, ARG_LOAD, ARG_PURE, ARG_EFFECTS } ArgClass;
+
+// A struct literal of struct sid, fields in the order written
+static int tree_struct(int sid, int node_line) {
+    if (curr.type != TK_LBRACE) return -1;
+    next_token();
+    int n = tree_node(EXPR_STRUCT, node_line);
+    if (n == -1) return -1;
+    expr_nodes[n].arg = sid;
+    int last = -1;
+    while (curr.type != TK_RBRACE) {
+        int field_line = curr.line;
+        int offset = curr.type == TK_ID ? find_field(sid, curr.text) : -1;
+        if (offset == -1) return -1;
+        next_token();
+        if (curr.type != TK_COLON && curr.type != TK_EQ_ASSIGN) return -1;
+        next_token();
+        int item = tree_unary(EXPR_INIT, tree_or(), offset, sid, field_line);
+        if (item == -1) return -1;
+        if (last == -1) expr_nodes[n].left = item;
+        else expr_nodes[last].next = item;
+        last = item;
+        if (curr.type == TK_COMMA) next_token();
+    }
+    next_token();
+    return n;
+}
+
+static void inline_clear(int func) {
+    if (!inline_bodies[func]) return;
+    free(inline_bodies[func]->expr);
+    free(inline_bodies[func]);
+    inline_bodies[func] = NULL;
+}
+
+static void inline_reset() {
+    for (int i = 0; i < inline_body_limit; i++) inline_clear(i);
+    inline_body_limit = 0;
+    inline_depth = 0;
+}
+
+static bool inline_enabled() {
+    return !compiling_vm->cli_debug_mode && !MyloConfig.debug_mode;
+}
+
+static InlineBody *inline_body_at(int addr) {
+    for (int i = 0; i < func_count; i++) {
+        if (funcs[i].addr == addr) return inline_bodies[i];
+    }
+    return NULL;
+}
+
+static int inline_param(char *name) {
+    InlineBody *ib = inline_frames[inline_depth - 1].body;
+    for (int i = 0; i < ib->param_count; i++) if (strcmp(ib->params[i], name) == 0) return i;
+    return -1;
+}
+
+// A read of parameter i of the innermost body: a copy of the argument's node
+// (lists chain through `next`, so nodes are never shared), checked the first time
+static int tree_param_read(int i, int node_line) {
+    InlineFrame *frame = &inline_frames[inline_depth - 1];
+    int arg = frame->args[i];
+    int n = tree_node(expr_nodes[arg].kind, expr_nodes[arg].line);
+    if (n == -1) return -1;
+    expr_nodes[n] = expr_nodes[arg];
+    expr_nodes[n].next = -1;
+    expr_nodes[n].bound = true;
+    if (frame->check[i] && frame->uses[i] == 0) {
+        n = tree_unary(EXPR_CAST, n, frame->body->param_types[i], OP_CHECK_TYPE, node_line);
+    }
+    frame->uses[i]++;
+    return n;
+}
+
+// Natives that take and return numbers only, so they cannot touch what the
+// arguments read
+static bool native_is_numeric(int idx) {
+    int std_count = 0;
+    while (std_library[std_count].name != NULL) std_count++;
+    if (idx >= std_count || strcmp(std_library[idx].ret_type, "num") != 0) return false;
+    for (int i = 0; i < std_library[idx].arg_count; i++) {
+        if (strcmp(std_library[idx].arg_types[i], "num") != 0) return false;
+    }
+    return true;
+}
+
+// True when n holds a value of `type` without a check
+static bool tree_has_type(int n, int type) {
+    ExprNode *e = &expr_nodes[n];
+    if (e->kind == EXPR_NUM) return type == TYPE_NUM;
+    if (e->kind == EXPR_STR) return type == TYPE_STR;
+    if (e->kind == EXPR_STRUCT || e->kind == EXPR_CAST) return type == e->arg;
+    return false;
+}
+
+static bool tree_effect_free(int n) {
+    ExprNode *e = &expr_nodes[n];
+    switch (e->kind) {
+        case EXPR_NUM: case EXPR_STR: case EXPR_LOCAL: case EXPR_GLOBAL: return true;
+        case EXPR_FIELD: case EXPR_NEG: case EXPR_CAST: return tree_effect_free(e->left);
+        case EXPR_INDEX: case EXPR_BINARY: return tree_effect_free(e->left) && tree_effect_free(e->right);
+        default: return false;
+    }
+}
+
+static ArgClass tree_arg_class(int n) {
+    ExprKind kind = expr_nodes[n].kind;
+    if (kind == EXPR_NUM || kind == EXPR_STR || kind == EXPR_LOCAL) return ARG_SIMPLE;
+    if (tree_pure_load(n)) return ARG_LOAD;
+    return tree_effect_free(n) ? ARG_PURE : ARG_EFFECTS;
+}
+
+// Checks the body nodes (those from `mark` on, not the arguments) below n:
+// no calls are left and nothing is allocated but the struct at the root.
+// Counts them into *size and sets *reads when the body calls a native or reads
+// a global, field or element, any of which an argument's side effects can change.
+static bool tree_inlinable(int n, int root, int mark, int *size, bool *reads) {
+    ExprNode *e = &expr_nodes[n];
+    if (n < mark || e->bound) return true;
+    switch (e->kind) {
+        case EXPR_LOCAL: return true; // A parameter, while the function itself is checked
+        case EXPR_NUM: case EXPR_STR: break;
+        case EXPR_GLOBAL: *reads = true; break;
+        case EXPR_FIELD: case EXPR_NEG: case EXPR_CAST: case EXPR_INIT:
+            if (e->kind == EXPR_FIELD) *reads = true;
+            if (!tree_inlinable(e->left, root, mark, size, reads)) return false;
+            break;
+        case EXPR_INDEX: case EXPR_BINARY:
+            if (e->kind == EXPR_INDEX) *reads = true;
+            if (!tree_inlinable(e->left, root, mark, size, reads) ||
+                !tree_inlinable(e->right, root, mark, size, reads)) return false;
+            break;
+        case EXPR_STRUCT: case EXPR_NATIVE:
+            if (e->kind == EXPR_STRUCT ? n != root : !native_is_numeric(e->arg)) return false;
+            if (e->kind == EXPR_NATIVE) *reads = true;
+            for (int item = e->left; item != -1; item = expr_nodes[item].next) {
+                if (!tree_inlinable(item, root, mark, size, reads)) return false;
+            }
+            break;
+        default: return false; // Calls that stay calls, array literals
+    }
+    (*size)++;
+    return true;
+}
+
+static int tree_size(int n) {
+    if (n == -1) return 0;
+    return 1 + tree_size(expr_nodes[n].left) + tree_size(expr_nodes[n].right);
+}
+
+// A little arithmetic passed to a `num` parameter is cheaper to repeat than a
+// call, and once the first read is checked every repeat is the same number
+static bool inline_recomputable(InlineFrame *frame, int i) {
+    InlineBody *ib = frame->body;
+    return ib->param_types[i] == TYPE_NUM && !ib->param_is_array[i] && tree_size(frame->args[i]) <= 3;
+}
+
+static bool inline_args_ok(InlineFrame *frame, int count, bool reads) {
+    int effects = -1;
+    for (int i = 0; i < count; i++) {
+        ArgClass c = tree_arg_class(frame->args[i]);
+        if (frame->uses[i] == 0 && (c != ARG_SIMPLE || frame->check[i])) return false;
+        if (frame->uses[i] > 1 && c > ARG_LOAD && !(c == ARG_PURE && inline_recomputable(frame, i))) return false;
+        if (c == ARG_EFFECTS) {
+            if (effects != -1 || reads) return false;
+            effects = i;
+        }
+    }
+    for (int i = 0; effects != -1 && i < count; i++) {
+        if (i != effects && (tree_arg_class(frame->args[i]) != ARG_SIMPLE || frame->check[i])) return false;
+    }
+    return true;
+}
+
+// The body of ib with its parameters bound to the `count` arguments chained
+// from args, or -1 when the call has to stay a call
+static int tree_inline(InlineBody *ib, int args, int count) {
+    if (!inline_enabled() || count != ib->param_count || inline_depth >= INLINE_MAX_DEPTH) return -1;
+    if (strcmp(ib->namespace_, current_namespace) != 0) return -1;
+    for (int i = 0; i < inline_depth; i++) {
+        if (inline_frames[i].body == ib) return -1; // Recursion
+    }
+
+    InlineFrame *frame = &inline_frames[inline_depth];
+    frame->body = ib;
+    for (int i = 0, a = args; i < count; i++, a = expr_nodes[a].next) {
+        int type = ib->param_types[i];
+        frame->args[i] = a;
+        frame->uses[i] = 0;
+        frame->check[i] = type != TYPE_ANY && !ib->param_is_array[i] && !tree_has_type(a, type);
+    }
+
+    char *safe_src = src; Token safe_curr = curr; int safe_line = line;
+    int mark = expr_node_count;
+    src = ib->expr;
+    line = ib->line;
+    next_token();
+    inline_depth++;
+    int root = ib->struct_id >= 0 ? tree_struct(ib->struct_id, curr.line) : tree_or();
+    inline_depth--;
+    bool ok = root != -1 && curr.type == TK_EOF;
+    src = safe_src; curr = safe_curr; line = safe_line;
+
+    if (ok && ib->cast_type != TYPE_ANY && !tree_has_type(root, ib->cast_type)) {
+        root = tree_unary(EXPR_CAST, root, ib->cast_type, OP_CAST, expr_nodes[root].line);
+        ok = root != -1;
+    }
+    int size = 0;
+    bool reads = false;
+    if (!ok || !tree_inlinable(root, root, mark, &size, &reads) || !inline_args_ok(frame, count, reads)) {
+        expr_node_count = mark;
+        return -1;
+    }
+    return root;
+}
+
+// At the closing brace of a function body: keeps the body's expression when
+// calls to the function can be inlined. The body has already been compiled, so
+// this only re-reads its tokens; the tokenizer is left where it was.
+static void inline_record(int func, InlineHint hint, int param_count, char *body_src, Token body_curr, int body_line) {
+    inline_clear(func);
+    if (hint == INLINE_NEVER || param_count > MAX_FFI_ARGS) return;
+
+    char *end_src = src; Token end_curr = curr; int end_line = line;
+    int saved_local_count = local_count;
+    src = body_src; curr = body_curr; line = body_line;
+    local_count = param_count;
+    facts_clear();
+    expr_node_count = 0;
+
+    int struct_id = -1;
+    int cast_type = TYPE_ANY;
+    int root = -1;
+    char *expr_start = curr.start;
+    int start_line = curr.line;
+    char *expr_end = NULL;
+    if (curr.type == TK_RET) {
+        next_token();
+        expr_start = curr.start;
+        start_line = curr.line;
+        root = tree_or();
+        expr_end = curr.start;
+    } else if (curr.type == TK_VAR) {
+        next_token();
+        char var_name[MAX_IDENTIFIER];
+        strcpy(var_name, curr.text);
+        bool named = curr.type == TK_ID;
+        next_token();
+        TypeInfo ti = {TYPE_ANY, false};
+        if (named && curr.type == TK_COLON) {
+            next_token();
+            ti = parse_type_spec();
+        }
+        if (named && curr.type == TK_EQ_ASSIGN && !ti.is_array) {
+            next_token();
+            expr_start = curr.start;
+            start_line = curr.line;
+            if (curr.type != TK_LBRACE) root = tree_or();
+            else if (ti.id >= 0) {
+                root = tree_struct(ti.id, curr.line);
+                struct_id = ti.id;
+            }
+            expr_end = curr.start;
+            cast_type = ti.id;
+            if (curr.type == TK_RET) next_token();
+            else root = -1;
+            if (curr.type == TK_ID && strcmp(curr.text, var_name) == 0) next_token();
+            else root = -1;
+        }
+    }
+
+    int size = 0;
+    bool reads = false;
+    if (root != -1 && curr.start == end_curr.start && tree_inlinable(root, root, 0, &size, &reads) &&
+        (hint == INLINE_ALWAYS || size <= INLINE_MAX_NODES)) {
+        size_t len = (size_t)(expr_end - expr_start);
+        InlineBody *ib = calloc(1, sizeof(InlineBody));
+        ib->expr = malloc(len + 1);
+        memcpy(ib->expr, expr_start, len);
+        ib->expr[len] = '\0';
+        ib->line = start_line;
+        ib->struct_id = struct_id;
+        ib->cast_type = cast_type;
+        ib->param_count = param_count;
+        for (int i = 0; i < param_count; i++) {
+            strcpy(ib->params[i], locals[i].name);
+            ib->param_types[i] = locals[i].type_id;
+            ib->param_is_array[i] = locals[i].is_array;
+        }
+        strcpy(ib->namespace_, current_namespace);
+        inline_bodies[func] = ib;
+        if (func >= inline_body_limit) inline_body_limit = func + 1;
+    }
+
+    src = end_src; curr = end_curr; line = end_line;
+    local_count = saved_local_count;
+}
+
+static int tree_call(char *name, int node_line) {
+    int count;
+    int args = tree_list(TK_RPAREN, &count);
+    if (args == -2) return -1;
+
+    ExprKind kind = EXPR_CALL;
+    int target = find_func(name);
+    if (target == -1) {
+        int std_idx = find_stdlib_func(name);
+        int cfn_idx = find_cfn(name);
+        if (std_idx != -1) {
+            if (std_library[std_idx].arg_count != count) return -1;
+            kind = EXPR_NATIVE;
+            target = std_idx;
+        } else if (cfn_idx != -1) {
+            if (ffi_blocks[cfn_idx].arg_count != count) return -1;
+            int std_count = 0;
+            while (std_library[std_count].name != NULL) std_count++;
+            kind = EXPR_NATIVE;
+            target = std_count + cfn_idx;
+        } else {
+            char m[MAX_IDENTIFIER * 2]; get_mangled_name(m, name);
+            target = find_func(m);
+            if (target == -1) return -1;
+        }
+    }
+    InlineBody *ib = kind == EXPR_CALL ? inline_body_at(target) : NULL;
+    if (ib) {
+        int body = tree_inline(ib, args, count);
+        if (body != -1) return body;
+    }
+    int n = tree_node(kind, node_line);
+    if (n == -1) return -1;
+    expr_nodes[n].arg = target;
+    expr_nodes[n].arg2 = count;
+    expr_nodes[n].left = args;
+    return n;
+}
+
+static int tree_variable(char *name, int node_line) {
+    // An inlined body sees its parameters instead of the caller's locals
+    int param = inline_depth > 0 ? inline_param(name) : -1;
+    int loc = inline_depth > 0 ? -1 : find_local(name); int type_id; bool is_array; int n;
+    if (param != -1) {
+        InlineBody *ib = inline_frames[inline_depth - 1].body;
+        type_id = ib->param_types[param]; is_array = ib->param_is_array[param];
+        n = tree_param_read(param, node_line);
+    } else if (loc != -1) {
+        int slot = locals[loc].offset;
+        type_id = locals[loc].type_id; is_array = locals[loc].is_array;
+        LocalFact *fact = slot < fact_limit ? &local_facts[slot] : NULL;
+        if (fact && fact->kind == FACT_CONST) n = tree_num(fact->num, node_line);
+        else {
+            n = tree_node(EXPR_LOCAL, node_line);
+            if (n != -1) expr_nodes[n].arg = (fact && fact->kind == FACT_COPY) ? fact->slot : slot;
+        }
+    } else {
+        int glob = find_global(name);
+        if (glob == -1) { char m[MAX_IDENTIFIER * 2]; get_mangled_name(m, name); glob = find_global(m); }
+        if (glob == -1) return -1;
+        type_id = globals[glob].type_id; is_array = globals[glob].is_array;
+        n = tree_node(EXPR_GLOBAL, node_line);
+        if (n != -1) expr_nodes[n].arg = globals[glob].addr;
+    }
+
+    while (n != -1 && (curr.type == TK_DOT || curr.type == TK_LBRACKET)) {
+        int access_line = curr.line;
+        if (curr.type == TK_DOT) {
+            next_token();
+            if (curr.type != TK_ID || type_id < 0) return -1;
+            int offset = find_field(type_id, curr.text);
+            if (offset == -1) return -1;
+            next_token();
+            n = tree_unary(EXPR_FIELD, n, offset, type_id, access_line);
+            type_id = struct_defs[type_id].field_types[offset];
+        } else {
+            next_token();
+            int index = tree_or();
+            if (index == -1 || curr.type != TK_RBRACKET) return -1;
+            next_token();
+            int base = n;
+            n = tree_node(EXPR_INDEX, access_line);
+            if (n == -1) return -1;
+            expr_nodes[n].left = base;
+            expr_nodes[n].right = index;
+            if (is_array) is_array = false; else type_id = -1;
+        }
+    }
+    return n;
+}
+
+static int tree_primary() {
+    int node_line = curr.line;
+    if (curr.type == TK_NUM) {
+        int n = tree_num(curr.val_float, node_line);
+        next_token();
+        return n;
+    } else if (curr.type == TK_STR) {
+        int n = tree_node(EXPR_STR, node_line);
+        if (n != -1) expr_nodes[n].arg = intern_literal(compiling_vm, curr.text);
+        next_token();
+        return n;
+    } else if (curr.type == TK_TRUE || curr.type == TK_FALSE) {
+        int n = tree_num(curr.type == TK_TRUE ? 1.0 : 0.0, node_line);
+        next_token();
+        return n;
+    } else if (curr.type == TK_MINUS) {
+        next_token();
+        if (curr.type == TK_NUM) {
+            int n = tree_num(-curr.val_float, node_line);
+            next_token();
+            return n;
+        }
+        return tree_unary(EXPR_NEG, tree_primary(), 0, 0, node_line);
+    } else if (curr.type == TK_LBRACKET) {
+        next_token();
+        int count;
+        int items = tree_list(TK_RBRACKET, &count);
+        if (items == -2) return -1;
+        int n = tree_node(EXPR_ARRAY, node_line);
+        if (n == -1) return -1;
+        expr_nodes[n].left = items;
+        expr_nodes[n].arg2 = count;
+        return n;
+    } else if (curr.type == TK_LPAREN) {
+        next_token();
+        int n = tree_or();
+        if (n == -1 || curr.type != TK_RPAREN) return -1;
+        next_token();
+        return n;
+    } else if (curr.type == TK_ID && strcmp(curr.text, "C") != 0) {
+        char name[MAX_IDENTIFIER];
+        strcpy(name, curr.text);
+        next_token();
+        if (curr.type == TK_SCOPE) {
+            next_token();
+            if (curr.type != TK_ID) return -1;
+            char combined[MAX_IDENTIFIER * 2];
+            snprintf(combined, sizeof(combined), "%s_%s", name, curr.text);
+            if (strlen(combined) >= MAX_IDENTIFIER) return -1;
+            strcpy(name, combined);
+            next_token();
+        }
+        if (find_enum_val(name) != -1) return -1;
+        if (curr.type == TK_LPAREN) {
+            next_token();
+            return tree_call(name, node_line);
+        }
+        return tree_variable(name, node_line);
+    }
+    return -1;
+}
+
+static int tree_term() {
+    int n = tree_primary();
+    while (n != -1 && (curr.type == TK_MUL || curr.type == TK_DIV || curr.type == TK_MOD_OP)) {
+        int op = curr.type == TK_MUL ? OP_MUL : (curr.type == TK_DIV ? OP_DIV : OP_MOD);
+        int op_line = curr.line;
+        next_token();
+        n = tree_binary(op, n, tree_primary(), op_line);
+    }
+    return n;
+}
+
+static int tree_additive() {
+    int n = tree_term();
+    while (n != -1 && (curr.type == TK_PLUS || curr.type == TK_MINUS)) {
+        int op = curr.type == TK_PLUS ? OP_ADD : OP_SUB;
+        int op_line = curr.line;
+        next_token();
+        n = tree_binary(op, n, tree_term(), op_line);
+    }
+    return n;
+}
+
+static int tree_range() {
+    int n = tree_additive();
+    if (n != -1 && curr.type == TK_RANGE) {
+        int op_line = curr.line;
+        next_token();
+        n = tree_binary(OP_RANGE, n, tree_additive(), op_line);
+    }
+    return n;
+}
+
+static int tree_relation() {
+    static const int ops[] = { OP_LT, OP_GT, OP_LE, OP_GE, OP_EQ, OP_NEQ }; // TK_LT..TK_NEQ order
+    int n = tree_range();
+    while (n != -1 && curr.type >= TK_LT && curr.type <= TK_NEQ) {
+        int op = ops[curr.type - TK_LT];
+        int op_line = curr.line;
+        next_token();
+        n = tree_binary(op, n, tree_range(), op_line);
+    }
+    return n;
+}
+
+static int tree_and() {
+    int n = tree_relation();
+    while (n != -1 && curr.type == TK_AND) {
+        int op_line = curr.line;
+        next_token();
+        n = tree_binary(OP_AND, n, tree_relation(), op_line);
+    }
+    return n;
+}
+
+static int tree_or() {
+    int n = tree_and();
+    while (n != -1 && curr.type == TK_OR) {
+        int op_line = curr.line;
+        next_token();
+        n = tree_binary(OP_OR, n, tree_and(), op_line);
+    }
+    return n;
+}
+
+static void tree_emit(int n);
+
+// Pushes a list of operands, duplicating any that repeats the one before it
+static void tree_emit_list(int first, int list_line) {
+    int prev = -1;
+    for (int item = first; item != -1; item = expr_nodes[item].next) {
+        if (tree_repeats(prev, item)) {
+            expr_line = list_line;
+            emit_op(OP_DUP);
+        } else tree_emit(item);
+        prev = item;
+    }
+}
+
+static void tree_emit(int n) {
+    ExprNode *e = &expr_nodes[n];
+    expr_line = e->line;
+    switch (e->kind) {
+        case EXPR_NUM: emit_op(OP_PSH_NUM); emit(make_const(compiling_vm, e->num)); break;
+        case EXPR_STR: emit_op(OP_PSH_STR); emit(e->arg); break;
+        case EXPR_LOCAL: emit_op(OP_LVAR); emit(e->arg); break;
+        case EXPR_GLOBAL: emit_op(OP_GET); emit(e->arg); break;
+        case EXPR_FIELD:
+            tree_emit(e->left);
+            expr_line = e->line;
+            emit_op(OP_HGET); emit(e->arg); emit(e->arg2);
+            break;
+        case EXPR_INDEX:
+            tree_emit(e->left);
+            tree_emit(e->right);
+            expr_line = e->line;
+            emit_op(OP_AGET);
+            break;
+        case EXPR_NEG:
+            emit_op(OP_PSH_NUM); emit(make_const(compiling_vm, 0.0));
+            tree_emit(e->left);
+            expr_line = e->line;
+            emit_op(OP_SUB);
+            break;
+        case EXPR_BINARY:
+            tree_emit(e->left);
+            expr_line = e->line;
+            if (tree_repeats(e->left, e->right)) emit_op(OP_DUP);
+            else tree_emit(e->right);
+            expr_line = e->line;
+            emit_op(e->arg);
+            break;
+        case EXPR_CALL:
+            tree_emit_list(e->left, e->line);
+            expr_line = e->line;
+            emit_op(OP_CALL); emit(e->arg); emit(e->arg2);
+            break;
+        case EXPR_NATIVE:
+            tree_emit_list(e->left, e->line);
+            expr_line = e->line;
+            emit_op(OP_NATIVE); emit(e->arg);
+            break;
+        case EXPR_ARRAY:
+            tree_emit_list(e->left, e->line);
+            expr_line = e->line;
+            emit_op(OP_ARR); emit(e->arg2);
+            break;
+        case EXPR_STRUCT:
+            emit_op(OP_ALLOC); emit(struct_defs[e->arg].field_count); emit(e->arg);
+            for (int item = e->left; item != -1; item = expr_nodes[item].next) tree_emit(item);
+            break;
+        case EXPR_INIT: {
+            // As parse_struct_literal: typed fields other than num are cast
+            int field_type = struct_defs[e->arg2].field_types[e->arg];
+            tree_emit(e->left);
+            expr_line = e->line;
+            if (field_type != TYPE_ANY && field_type != TYPE_NUM) { emit_op(OP_CAST); emit(field_type); }
+            emit_op(OP_HSET); emit(e->arg); emit(e->arg2);
+            break;
+        }
+        case EXPR_CAST:
+            tree_emit(e->left);
+            expr_line = e->line;
+            emit_op(e->arg2); emit(e->arg);
+            break;
+    }
+}
+
+// Parses and emits one expression (without the ternary) as a tree. Returns
+// false, with the tokenizer rewound and nothing emitted, when it cannot.
+static bool expression_tree() {
+    char *safe_src = src; Token safe_curr = curr; int safe_line = line;
+    expr_node_count = 0;
+    int root = tree_or();
+    if (root == -1) {
+        src = safe_src; curr = safe_curr; line = safe_line;
+        return false;
+    }
+    tree_emit(root);
+    expr_line = 0;
+    return true;
 }
 
 void expression() {
-    logic_or_expr();
+    if (!expression_tree()) logic_or_expr();
     if (curr.type == TK_QUESTION) {
         match(TK_QUESTION);
-        emit(OP_JZ);
+        emit_op(OP_JZ);
         int p1 = compiling_vm->code_size;
         emit(0);
         expression();
-        emit(OP_JMP);
+        emit_op(OP_JMP);
         int p2 = compiling_vm->code_size;
         emit(0);
-        compiling_vm->bytecode[p1] = compiling_vm->code_size;
+        compiling_vm->bytecode[p1] = code_label();
         match(TK_ELSE);
         expression();
-        compiling_vm->bytecode[p2] = compiling_vm->code_size;
+        compiling_vm->bytecode[p2] = code_label();
     }
 }
 
-#define EMIT_SET(is_loc, addr) if(is_loc) { emit(OP_SVAR); emit(addr); } else { emit(OP_SET); emit(addr); }
-#define EMIT_GET(is_loc, addr) if(is_loc) { emit(OP_LVAR); emit(addr); } else { emit(OP_GET); emit(addr); }
+#define EMIT_SET(is_loc, addr) if(is_loc) { emit_op(OP_SVAR); emit(addr); } else { emit_op(OP_SET); emit(addr); }
+#define EMIT_GET(is_loc, addr) if(is_loc) { emit_op(OP_LVAR); emit(addr); } else { emit_op(OP_GET); emit(addr); }
 
 int alloc_var(bool is_loc, char *name, int type_id, bool is_array) {
     if (is_loc) {
+        fact_kill(local_count);
         if (name) strcpy(locals[local_count].name, name);
         locals[local_count].offset = local_count;
         locals[local_count].type_id = type_id;
@@ -1294,7 +2287,7 @@ int get_var_addr(char *n, bool is_local, int explicit_type) {
     if (is_local) {
         int loc = find_local(n);
         if (loc != -1) return loc;
-        emit(OP_PSH_NUM);
+        emit_op(OP_PSH_NUM);
         emit(make_const(compiling_vm, 0.0));
         return alloc_var(true, n, explicit_type, false);
     } else {
@@ -1311,12 +2304,12 @@ static void parse_region() {
     char name[MAX_IDENTIFIER];
     strcpy(name, curr.text);
     match(TK_ID);
-    emit(OP_NEW_ARENA);
+    emit_op(OP_NEW_ARENA);
     int var_idx = alloc_var(inside_function, name, TYPE_ANY, false);
     if (inside_function) {
-        emit(OP_SVAR); emit(locals[var_idx].offset);
+        emit_op(OP_SVAR); emit(locals[var_idx].offset);
     } else {
-        emit(OP_SET); emit(globals[var_idx].addr);
+        emit_op(OP_SET); emit(globals[var_idx].addr);
     }
 }
 
@@ -1326,7 +2319,7 @@ static void parse_print() {
     expression();
 
     match(TK_RPAREN);
-    emit(OP_PRN);
+    emit_op(OP_PRN);
 }
 
 static void parse_c_block_stmt() {
@@ -1399,11 +2392,11 @@ static void parse_c_block_stmt() {
     ffi_blocks[ffi_idx].code_body[len] = '\0';
     src = end + 1;
     next_token();
-    emit(OP_NATIVE);
+    emit_op(OP_NATIVE);
     int std_count = 0;
     while (std_library[std_count].name != NULL) std_count++;
     emit(std_count + ffi_idx);
-    emit(OP_POP);
+    emit_op(OP_POP);
 }
 static void parse_import() {
     match(TK_IMPORT);
@@ -1449,7 +2442,9 @@ static void parse_import() {
             api.get_ref = vm_get_ref;
             api.free_ref = vm_free_ref;
             api.natives_array = compiling_vm->natives;
-            api.string_pool = compiling_vm->string_pool;
+            api.get_string = vm_get_string;
+            api.push_value = vm_push_value;
+            api.pop_value = vm_pop_value;
             binder(compiling_vm, std_count + start_ffi_index, &api);
             bound_ffi_count += added_natives;
 
@@ -1526,11 +2521,11 @@ static void parse_import() {
         ffi_blocks[ffi_idx].code_body[len] = '\0';
         src = end + 1;
         next_token();
-        emit(OP_NATIVE);
+        emit_op(OP_NATIVE);
         int std_count = 0;
         while (std_library[std_count].name != NULL) std_count++;
         emit(std_count + ffi_idx);
-        emit(OP_POP);
+        emit_op(OP_POP);
     }
     else {
         char f[MAX_STRING_LENGTH];
@@ -1569,16 +2564,16 @@ static void parse_var_decl() {
 
         int reg_loc = find_local(region_var_name);
         if (reg_loc != -1) {
-            emit(OP_LVAR);
+            emit_op(OP_LVAR);
             emit(locals[reg_loc].offset);
         } else {
             int reg_glob = find_global(region_var_name);
             if (reg_glob != -1) {
-                emit(OP_GET);
+                emit_op(OP_GET);
                 emit(globals[reg_glob].addr);
             } else error("Undefined region");
         }
-        emit(OP_SET_CTX);
+        emit_op(OP_SET_CTX);
     }
 
     TypeInfo type_info = {TYPE_ANY, false};
@@ -1601,7 +2596,7 @@ static void parse_var_decl() {
             } while (curr.type != TK_RBRACKET && curr.type != TK_EOF);
         }
         match(TK_RBRACKET);
-        emit(OP_MAKE_ARR);
+        emit_op(OP_MAKE_ARR);
         emit(count);
         emit(type_info.id);
         handled = true;
@@ -1618,7 +2613,7 @@ static void parse_var_decl() {
             } while (curr.type != TK_RBRACKET && curr.type != TK_EOF);
         }
         match(TK_RBRACKET);
-        emit(OP_ARR);
+        emit_op(OP_ARR);
         emit(count);
         handled = true;
     }
@@ -1640,25 +2635,34 @@ static void parse_var_decl() {
         handled = true;
     }
 
+    int expr_start = compiling_vm->code_size;
     if (!handled) {
         expression();
     }
 
     if (type_info.id != TYPE_ANY && !type_info.is_array) {
-        emit(OP_CAST);
+        emit_op(OP_CAST);
         emit(type_info.id);
     }
 
     int var_idx = alloc_var(inside_function, name, type_info.id, type_info.is_array);
+
+    // A local that is just a number or a copy of another local is remembered
+    if (inside_function && !handled && !specific_region && type_info.id == TYPE_ANY && !type_info.is_array &&
+        compiling_vm->code_size == expr_start + 2) {
+        int *code = compiling_vm->bytecode;
+        if (code[expr_start] == OP_PSH_NUM) fact_set(var_idx, FACT_CONST, compiling_vm->constants[code[expr_start + 1]], -1);
+        else if (code[expr_start] == OP_LVAR) fact_set(var_idx, FACT_COPY, 0, code[expr_start + 1]);
+    }
     if (!inside_function) {
-        emit(OP_SET);
+        emit_op(OP_SET);
         emit(globals[var_idx].addr);
     }
 
     if (specific_region) {
-        emit(OP_PSH_NUM);
+        emit_op(OP_PSH_NUM);
         emit(make_const(compiling_vm, 0.0));
-        emit(OP_SET_CTX);
+        emit_op(OP_SET_CTX);
     }
 }
 
@@ -1669,10 +2673,10 @@ static void parse_id_statement(Token start_token, char *name) {
         int loc = find_local(name);
         if (loc != -1) {
             if (locals[loc].type_id != TYPE_ANY && !locals[loc].is_array) {
-                emit(OP_CAST);
+                emit_op(OP_CAST);
                 emit(locals[loc].type_id);
             }
-            emit(OP_SVAR);
+            emit_op(OP_SVAR);
             emit(locals[loc].offset);
         } else {
             int glob = -1;
@@ -1683,10 +2687,10 @@ static void parse_id_statement(Token start_token, char *name) {
             }
             if (glob == -1) error("Undefined var '%s'", name);
             if (globals[glob].type_id != TYPE_ANY && !globals[glob].is_array) {
-                emit(OP_CAST);
+                emit_op(OP_CAST);
                 emit(globals[glob].type_id);
             }
-            emit(OP_SET);
+            emit_op(OP_SET);
             emit(globals[glob].addr);
         }
     } else if (curr.type == TK_LPAREN) {
@@ -1704,19 +2708,19 @@ static void parse_id_statement(Token start_token, char *name) {
         match(TK_RPAREN);
         int faddr = find_func(name);
         if (faddr != -1) {
-            emit(OP_CALL);
+            emit_op(OP_CALL);
             emit(faddr);
             emit(arg_count);
-            emit(OP_POP);
+            emit_op(OP_POP);
             return;
         }
         int std_idx = find_stdlib_func(name);
         if (std_idx != -1) {
             if (std_library[std_idx].arg_count != arg_count) error("StdLib function '%s' expects %d args", name,
                                                                    std_library[std_idx].arg_count);
-            emit(OP_NATIVE);
+            emit_op(OP_NATIVE);
             emit(std_idx);
-            emit(OP_POP);
+            emit_op(OP_POP);
             return;
         }
 
@@ -1725,17 +2729,17 @@ static void parse_id_statement(Token start_token, char *name) {
             if (ffi_blocks[cfn_idx].arg_count != arg_count) error("CFN function '%s' expects %d args", name, ffi_blocks[cfn_idx].arg_count);
             int std_count = 0; 
             while (std_library[std_count].name != NULL) std_count++;
-            emit(OP_NATIVE); emit(std_count + cfn_idx); emit(OP_POP); return;
+            emit_op(OP_NATIVE); emit(std_count + cfn_idx); emit_op(OP_POP); return;
         }
 
         char m[MAX_IDENTIFIER * 2];
         get_mangled_name(m, name);
         faddr = find_func(m);
         if (faddr != -1) {
-            emit(OP_CALL);
+            emit_op(OP_CALL);
             emit(faddr);
             emit(arg_count);
-            emit(OP_POP);
+            emit_op(OP_POP);
             return;
         }
         curr = start_token;
@@ -1745,7 +2749,7 @@ static void parse_id_statement(Token start_token, char *name) {
         int type_id = -1;
         bool is_array = false;
         if (loc != -1) {
-            emit(OP_LVAR);
+            emit_op(OP_LVAR);
             emit(locals[loc].offset);
             type_id = locals[loc].type_id;
             is_array = locals[loc].is_array;
@@ -1757,7 +2761,7 @@ static void parse_id_statement(Token start_token, char *name) {
                 glob = find_global(m);
             }
             if (glob == -1) error("Undefined var '%s'", name);
-            emit(OP_GET);
+            emit_op(OP_GET);
             emit(globals[glob].addr);
             type_id = globals[glob].type_id;
             is_array = globals[glob].is_array;
@@ -1781,17 +2785,17 @@ static void parse_id_statement(Token start_token, char *name) {
 
                     // Strong Typing: If the leaf field has a specific type, cast the expression result
                     if (field_type != TYPE_ANY && field_type != TYPE_NUM) {
-                        emit(OP_CAST);
+                        emit_op(OP_CAST);
                         emit(field_type);
                     }
 
-                    emit(OP_HSET);
+                    emit_op(OP_HSET);
                     emit(offset);
                     emit(type_id);
-                    emit(OP_POP);
+                    emit_op(OP_POP);
                     break;
                 } else {
-                    emit(OP_HGET);
+                    emit_op(OP_HGET);
                     emit(offset);
                     emit(type_id);
                     type_id = field_type;
@@ -1806,21 +2810,21 @@ static void parse_id_statement(Token start_token, char *name) {
                     if (curr.type == TK_EQ_ASSIGN) {
                         match(TK_EQ_ASSIGN);
                         expression();
-                        emit(OP_SLICE_SET);
-                        emit(OP_POP);
+                        emit_op(OP_SLICE_SET);
+                        emit_op(OP_POP);
                         break;
                     }
-                    emit(OP_SLICE);
+                    emit_op(OP_SLICE);
                 } else {
                     match(TK_RBRACKET);
                     if (curr.type == TK_EQ_ASSIGN) {
                         match(TK_EQ_ASSIGN);
                         expression();
-                        emit(OP_ASET);
-                        emit(OP_POP);
+                        emit_op(OP_ASET);
+                        emit_op(OP_POP);
                         break;
                     } else {
-                        emit(OP_AGET);
+                        emit_op(OP_AGET);
                         if (is_array) is_array = false;
                         else type_id = -1;
                     }
@@ -1833,7 +2837,7 @@ static void parse_id_statement(Token start_token, char *name) {
 static void parse_if() {
     match(TK_IF);
     expression();
-    emit(OP_JZ);
+    emit_op(OP_JZ);
     int p1 = compiling_vm->code_size;
     emit(0);
     match(TK_LBRACE);
@@ -1842,18 +2846,18 @@ static void parse_if() {
     int saved_local_count_if = local_count;
     bool is_local_scope = inside_function;
 
-    emit(OP_SCOPE_ENTER);
+    emit_op(OP_SCOPE_ENTER);
     current_scope_depth++;
 
-    while (curr.type != TK_RBRACE && curr.type != TK_EOF) statement();
+    block_body();
 
     if (is_local_scope) {
         int vars_to_pop = local_count - saved_local_count_if;
-        for(int k = 0; k < vars_to_pop; k++) emit(OP_POP);
+        for(int k = 0; k < vars_to_pop; k++) emit_op(OP_POP);
         local_count = saved_local_count_if;
     }
 
-    emit(OP_SCOPE_EXIT);
+    emit_op(OP_SCOPE_EXIT);
     current_scope_depth--;
     match(TK_RBRACE);
 
@@ -1864,73 +2868,73 @@ static void parse_if() {
     // --- PARSE ELIF BLOCKS ---
     while (curr.type == TK_ELIF) {
         // Jump to the end if the previous branch succeeded
-        emit(OP_JMP);
+        emit_op(OP_JMP);
         exit_jumps[exit_jump_count++] = compiling_vm->code_size;
         emit(0);
 
         // Patch the previous OP_JZ to jump to THIS condition
-        compiling_vm->bytecode[p1] = compiling_vm->code_size;
+        compiling_vm->bytecode[p1] = code_label();
 
         match(TK_ELIF);
         expression();
-        emit(OP_JZ);
+        emit_op(OP_JZ);
         p1 = compiling_vm->code_size; // Track new OP_JZ
         emit(0);
         match(TK_LBRACE);
 
         int saved_local_count_elif = local_count;
-        emit(OP_SCOPE_ENTER);
+        emit_op(OP_SCOPE_ENTER);
         current_scope_depth++;
 
-        while (curr.type != TK_RBRACE && curr.type != TK_EOF) statement();
+        block_body();
 
         if (is_local_scope) {
             int vars_to_pop = local_count - saved_local_count_elif;
-            for(int k = 0; k < vars_to_pop; k++) emit(OP_POP);
+            for(int k = 0; k < vars_to_pop; k++) emit_op(OP_POP);
             local_count = saved_local_count_elif;
         }
 
-        emit(OP_SCOPE_EXIT);
+        emit_op(OP_SCOPE_EXIT);
         current_scope_depth--;
         match(TK_RBRACE);
     }
 
     // --- PARSE ELSE BLOCK ---
     if (curr.type == TK_ELSE) {
-        emit(OP_JMP);
+        emit_op(OP_JMP);
         exit_jumps[exit_jump_count++] = compiling_vm->code_size;
         emit(0);
 
         // Patch the last OP_JZ to jump to THIS else block
-        compiling_vm->bytecode[p1] = compiling_vm->code_size;
+        compiling_vm->bytecode[p1] = code_label();
 
         match(TK_ELSE);
         match(TK_LBRACE);
 
         int saved_local_count_else = local_count;
-        emit(OP_SCOPE_ENTER);
+        emit_op(OP_SCOPE_ENTER);
         current_scope_depth++;
 
-        while (curr.type != TK_RBRACE && curr.type != TK_EOF) statement();
+        block_body();
 
         if (is_local_scope) {
             int vars_to_pop = local_count - saved_local_count_else;
-            for(int k = 0; k < vars_to_pop; k++) emit(OP_POP);
+            for(int k = 0; k < vars_to_pop; k++) emit_op(OP_POP);
             local_count = saved_local_count_else;
         }
 
-        emit(OP_SCOPE_EXIT);
+        emit_op(OP_SCOPE_EXIT);
         current_scope_depth--;
 
         match(TK_RBRACE);
     } else {
         // If there's no 'else', the last condition's failure jumps here
-        compiling_vm->bytecode[p1] = compiling_vm->code_size;
+        compiling_vm->bytecode[p1] = code_label();
     }
 
     // Patch all successful branch exit jumps to point to the very end
     for (int i = 0; i < exit_jump_count; i++) {
-        compiling_vm->bytecode[exit_jumps[i]] = compiling_vm->code_size;
+        compiling_vm->bytecode[exit_jumps[i]] = code_label();
     }
 }
 
@@ -1962,16 +2966,16 @@ static void parse_embed() {
     unsigned char *data = malloc(fsize);
     fread(data, 1, fsize, f);
     fclose(f);
-    emit(OP_EMBED);
+    emit_op(OP_EMBED);
     emit((int) fsize);
     for (long i = 0; i < fsize; i++) emit((int) data[i]);
     free(data);
     int var_idx = alloc_var(inside_function, name, TYPE_BYTES, false);
     if (inside_function) {
-        emit(OP_SVAR);
+        emit_op(OP_SVAR);
         emit(locals[var_idx].offset);
     } else {
-        emit(OP_SET);
+        emit_op(OP_SET);
         emit(globals[var_idx].addr);
     }
 }
@@ -1985,7 +2989,7 @@ void for_statement() {
     bool is_pair = false;
     int explicit_type = -1;
 
-    emit(OP_SCOPE_ENTER); current_scope_depth++; // Outer Loop Scope
+    emit_op(OP_SCOPE_ENTER); current_scope_depth++; // Outer Loop Scope
 
     if (curr.type == TK_VAR) {
         match(TK_VAR);
@@ -2015,20 +3019,20 @@ void for_statement() {
         sprintf(arr_name, "_arr_%d", loop_depth); sprintf(idx_name, "_idx_%d", loop_depth);
 
         int a = alloc_var(is_local_scope, arr_name, TYPE_ANY, true);
-        if (!is_local_scope) { emit(OP_SET); emit(a); }
+        if (!is_local_scope) { emit_op(OP_SET); emit(a); }
 
-        int i = alloc_var(is_local_scope, idx_name, TYPE_NUM, false);   emit(OP_PSH_NUM); emit(make_const(compiling_vm, 0.0));
-        if (!is_local_scope) { emit(OP_SET); emit(i); }
+        int i = alloc_var(is_local_scope, idx_name, TYPE_NUM, false);   emit_op(OP_PSH_NUM); emit(make_const(compiling_vm, 0.0));
+        if (!is_local_scope) { emit_op(OP_SET); emit(i); }
 
-        int loop = compiling_vm->code_size;
-        EMIT_GET(is_local_scope, i); EMIT_GET(is_local_scope, a); emit(OP_ALEN); emit(OP_LT); emit(OP_JZ);
+        int loop = code_label();
+        EMIT_GET(is_local_scope, i); EMIT_GET(is_local_scope, a); emit_op(OP_ALEN); emit_op(OP_LT); emit_op(OP_JZ);
         int exit = compiling_vm->code_size; emit(0);
 
         if (is_pair) {
-            EMIT_GET(is_local_scope, a); EMIT_GET(is_local_scope, i); emit(OP_IT_KEY); EMIT_SET(is_local_scope, var1_addr);
-            EMIT_GET(is_local_scope, a); EMIT_GET(is_local_scope, i); emit(OP_IT_VAL); EMIT_SET(is_local_scope, var2_addr);
+            EMIT_GET(is_local_scope, a); EMIT_GET(is_local_scope, i); emit_op(OP_IT_KEY); EMIT_SET(is_local_scope, var1_addr);
+            EMIT_GET(is_local_scope, a); EMIT_GET(is_local_scope, i); emit_op(OP_IT_VAL); EMIT_SET(is_local_scope, var2_addr);
         } else {
-            EMIT_GET(is_local_scope, a); EMIT_GET(is_local_scope, i); emit(OP_IT_DEF); EMIT_SET(is_local_scope, var1_addr);
+            EMIT_GET(is_local_scope, a); EMIT_GET(is_local_scope, i); emit_op(OP_IT_DEF); EMIT_SET(is_local_scope, var1_addr);
         }
 
         match(TK_RPAREN); match(TK_LBRACE);
@@ -2039,82 +3043,82 @@ void for_statement() {
         // Capture State right before entering the body!
         push_loop(current_scope_depth, local_count);
 
-        emit(OP_SCOPE_ENTER); current_scope_depth++; // Inner Body Scope
+        emit_op(OP_SCOPE_ENTER); current_scope_depth++; // Inner Body Scope
 
-        while (curr.type != TK_RBRACE && curr.type != TK_EOF) statement();
+        block_body();
 
         if (body_is_local_scope) {
             int vars_to_pop = local_count - body_saved_local_count;
-            for(int k=0; k<vars_to_pop; k++) emit(OP_POP);
+            for(int k=0; k<vars_to_pop; k++) emit_op(OP_POP);
             local_count = body_saved_local_count;
         }
 
-        emit(OP_SCOPE_EXIT); current_scope_depth--; // Inner Body Scope
+        emit_op(OP_SCOPE_EXIT); current_scope_depth--; // Inner Body Scope
 
         int brace_line = curr.line;
         match(TK_RBRACE);
 
-        int continue_dest = compiling_vm->code_size;
-        EMIT_GET(is_local_scope, i); emit(OP_PSH_NUM); emit(make_const(compiling_vm, 1.0)); emit(OP_ADD); EMIT_SET(is_local_scope, i);
-        emit(OP_JMP); emit(loop);
+        int continue_dest = code_label();
+        EMIT_GET(is_local_scope, i); emit_op(OP_PSH_NUM); emit(make_const(compiling_vm, 1.0)); emit_op(OP_ADD); EMIT_SET(is_local_scope, i);
+        emit_op(OP_JMP); emit(loop);
 
         compiling_vm->lines[compiling_vm->code_size - 1] = brace_line;
-        compiling_vm->bytecode[exit] = compiling_vm->code_size;
+        compiling_vm->bytecode[exit] = code_label();
 
-        int break_dest = compiling_vm->code_size; // Break jumps HERE!
+        int break_dest = code_label(); // Break jumps HERE!
 
         // Clean up the iterator variables
         if (is_local_scope) {
             int vars_to_pop = local_count - saved_local_count;
-            for(int k=0; k<vars_to_pop; k++) emit(OP_POP);
+            for(int k=0; k<vars_to_pop; k++) emit_op(OP_POP);
             local_count = saved_local_count;
         }
 
-        emit(OP_SCOPE_EXIT); current_scope_depth--; // Outer Scope
+        emit_op(OP_SCOPE_EXIT); current_scope_depth--; // Outer Scope
         pop_loop(continue_dest, break_dest);
     } else {
-        int loop = compiling_vm->code_size;
+        int loop = code_label();
 
         // push_loop needs to happen before body!
         push_loop(current_scope_depth, local_count);
 
-        emit(OP_SCOPE_ENTER); current_scope_depth++; // Inner Scope starts BEFORE condition!
+        emit_op(OP_SCOPE_ENTER); current_scope_depth++; // Inner Scope starts BEFORE condition!
 
-        expression(); match(TK_RPAREN); emit(OP_JZ);
+        expression(); match(TK_RPAREN); emit_op(OP_JZ);
         int exit = compiling_vm->code_size; emit(0); match(TK_LBRACE);
 
         int body_saved_local_count = local_count;
         bool body_is_local_scope = inside_function;
 
-        while (curr.type != TK_RBRACE && curr.type != TK_EOF) statement();
+        block_body();
 
         if (body_is_local_scope) {
             int vars_to_pop = local_count - body_saved_local_count;
-            for(int k=0; k<vars_to_pop; k++) emit(OP_POP);
+            for(int k=0; k<vars_to_pop; k++) emit_op(OP_POP);
             local_count = body_saved_local_count;
         }
 
         int brace_line = curr.line; match(TK_RBRACE);
 
-        emit(OP_SCOPE_EXIT); current_scope_depth--; // Close inner scope normally
+        emit_op(OP_SCOPE_EXIT); current_scope_depth--; // Close inner scope normally
 
-        int continue_dest = compiling_vm->code_size; // 'continue' jumps here bypassing static exit
-        emit(OP_JMP); emit(loop);                    // Jump to next iteration
+        int continue_dest = code_label(); // 'continue' jumps here bypassing static exit
+        emit_op(OP_JMP); emit(loop);                    // Jump to next iteration
         compiling_vm->lines[compiling_vm->code_size - 1] = brace_line;
 
         // If condition failed, we land here.
-        compiling_vm->bytecode[exit] = compiling_vm->code_size;
-        emit(OP_SCOPE_EXIT); current_scope_depth--; // Close inner scope because we broke out of condition
+        compiling_vm->bytecode[exit] = code_label();
+        emit_op(OP_SCOPE_EXIT); current_scope_depth--; // Close inner scope because we broke out of condition
 
-        int break_dest = compiling_vm->code_size;
+        int break_dest = code_label();
 
         if (is_local_scope) {
             int vars_to_pop = local_count - saved_local_count;
-            for(int k=0; k<vars_to_pop; k++) emit(OP_POP);
+            for(int k=0; k<vars_to_pop; k++) emit_op(OP_POP);
             local_count = saved_local_count;
         }
 
-        emit(OP_SCOPE_EXIT); current_scope_depth--; // Outer Scope
+        emit_op(OP_SCOPE_EXIT); current_scope_depth--; // Outer Scope
         pop_loop(continue_dest, break_dest);
     }
 }
@@ -2163,7 +3167,7 @@ void enum_decl(VM* vm) {
     int member_count = 0;
 
     // 1. Register the Enum Type Name string for the 48-bit packing
-    int type_str_id = make_string(vm, enum_name);
+    int type_str_id = intern_literal(vm, enum_name);
 
     while (curr.type != TK_RBRACE && curr.type != TK_EOF) {
         // Grab the member name before we advance the token!
@@ -2179,7 +3183,7 @@ void enum_decl(VM* vm) {
         enum_entry_count++;
 
         // --- NEW: Generate Runtime Array Elements ---
-        int member_str_id = make_string(vm, member_name);
+        int member_str_id = intern_literal(vm, member_name);
 
         // 48-bit Pack: [Type ID (16)] [Member ID (16)] [Value (16)]
         unsigned long long packed = ((unsigned long long)type_str_id << 32) |
@@ -2189,7 +3193,7 @@ void enum_decl(VM* vm) {
         int const_idx = make_const(vm, (double)packed);
 
         // Emit instructions to push this enum value to the stack
-        emit(OP_PSH_ENUM);
+        emit_op(OP_PSH_ENUM);
         emit(const_idx);
 
         val++;
@@ -2202,7 +3206,7 @@ void enum_decl(VM* vm) {
 
     // --- NEW: Build Array and Assign to Global ---
     // This turns the enum declaration into a hidden array allocation!
-    emit(OP_ARR);
+    emit_op(OP_ARR);
     emit(member_count);
 
     // Find or create global variable matching the Enum's name
@@ -2220,13 +3224,13 @@ void enum_decl(VM* vm) {
         globals[global_idx].addr = global_idx;
     }
 
-    emit(OP_SET);
+    emit_op(OP_SET);
     emit(global_idx);
 }
 
 void parse_struct_literal(int struct_idx) {
     match(TK_LBRACE);
-    emit(OP_ALLOC);
+    emit_op(OP_ALLOC);
     emit(struct_defs[struct_idx].field_count);
     emit(struct_idx);
     while (curr.type != TK_RBRACE && curr.type != TK_EOF) {
@@ -2247,12 +3251,12 @@ void parse_struct_literal(int struct_idx) {
 
         // If the field has a specific type (not 'any' and not generic 'num'), enforce it
         if (field_type != TYPE_ANY && field_type != TYPE_NUM) {
-            emit(OP_CAST);
+            emit_op(OP_CAST);
             emit(field_type);
         }
         // --- NEW CODE END ---
 
-        emit(OP_HSET);
+        emit_op(OP_HSET);
         emit(offset);
         emit(struct_idx);
         if (curr.type == TK_COMMA) match(TK_COMMA);
@@ -2262,18 +3266,18 @@ void parse_struct_literal(int struct_idx) {
 
 void parse_map_literal() {
     match(TK_LBRACE);
-    emit(OP_MAP);
+    emit_op(OP_MAP);
     while (curr.type != TK_RBRACE && curr.type != TK_EOF) {
-        emit(OP_DUP);
+        emit_op(OP_DUP);
         if (curr.type != TK_STR) error("Map keys must be strings");
-        int id = make_string(compiling_vm, curr.text);
-        emit(OP_PSH_STR);
+        int id = intern_literal(compiling_vm, curr.text);
+        emit_op(OP_PSH_STR);
         emit(id);
         match(TK_STR);
         match(TK_EQ_ASSIGN);
         expression();
-        emit(OP_ASET);
-        emit(OP_POP);
+        emit_op(OP_ASET);
+        emit_op(OP_POP);
         if (curr.type == TK_COMMA) match(TK_COMMA);
     }
     match(TK_RBRACE);
@@ -2287,7 +3291,7 @@ void statement() {
         match(TK_LPAREN);
         expression();
         match(TK_RPAREN);
-        emit(OP_DEL_ARENA);
+        emit_op(OP_DEL_ARENA);
     }
     else if (curr.type == TK_CFN) {   
         parse_cfn_decl();               
@@ -2296,11 +3300,11 @@ void statement() {
         match(TK_MONITOR);
         match(TK_LPAREN);
         match(TK_RPAREN);
-        emit(OP_MONITOR);
+        emit_op(OP_MONITOR);
     }
     else if (curr.type == TK_DEBUGGER) {
         match(TK_DEBUGGER);
-        emit(OP_DEBUGGER);
+        emit_op(OP_DEBUGGER);
     }
     else if (curr.type == TK_PRINT) {
         parse_print();
@@ -2317,7 +3321,7 @@ void statement() {
         if (strlen(current_namespace) > 0) sprintf(current_namespace, "%s_%s", old, m);
         else strcpy(current_namespace, m);
         while (curr.type != TK_RBRACE && curr.type != TK_EOF) {
-            if (curr.type == TK_FN) {
+            if (curr.type == TK_FN || curr.type == TK_AT) {
                 void function();
                 function();
             } else statement();
@@ -2361,32 +3365,32 @@ void statement() {
         int saved_local_count = local_count;
         bool is_local_scope = inside_function;
 
-        int loop_start = compiling_vm->code_size;
+        int loop_start = code_label();
 
         push_loop(current_scope_depth, local_count);
 
-        emit(OP_SCOPE_ENTER); current_scope_depth++; // Body Scope
+        emit_op(OP_SCOPE_ENTER); current_scope_depth++; // Body Scope
 
-        while (curr.type != TK_RBRACE && curr.type != TK_EOF) statement();
+        block_body();
 
         if (is_local_scope) {
             int vars_to_pop = local_count - saved_local_count;
-            for(int k=0; k<vars_to_pop; k++) emit(OP_POP);
+            for(int k=0; k<vars_to_pop; k++) emit_op(OP_POP);
             local_count = saved_local_count;
         }
 
-        emit(OP_SCOPE_EXIT); current_scope_depth--; // Body Scope
+        emit_op(OP_SCOPE_EXIT); current_scope_depth--; // Body Scope
 
         int brace_line = curr.line;
         match(TK_RBRACE);
 
         int continue_dest = loop_start; // Continue loops straight back to start
-        emit(OP_JMP);
+        emit_op(OP_JMP);
         emit(loop_start);
         compiling_vm->lines[compiling_vm->code_size - 1] = brace_line;
         compiling_vm->lines[compiling_vm->code_size - 2] = brace_line;
 
-        int break_dest = compiling_vm->code_size; // Break falls after the loop
+        int break_dest = code_label(); // Break falls after the loop
 
         pop_loop(continue_dest, break_dest);
     } else if (curr.type == TK_EMBED) {
@@ -2394,14 +3398,67 @@ void statement() {
     } else if (curr.type == TK_RET) {
         match(TK_RET);
         if (curr.type == TK_RBRACE) {
-            emit(OP_PSH_NUM);
+            emit_op(OP_PSH_NUM);
             emit(make_const(compiling_vm, 0.0));
         } else expression();
-        emit(OP_RET);
+        emit_op(OP_RET);
     } else if (curr.type != TK_EOF) next_token();
 }
 
+// Statements that only emit code into the current function, so their code
+// can be dropped without leaving anything else pointing into it
+static bool dead_code_droppable() {
+    switch (curr.type) {
+        case TK_VAR: case TK_IF: case TK_FOR: case TK_FOREVER: case TK_PRINT:
+        case TK_RET: case TK_BREAK: case TK_CONTINUE:
+            return true;
+        case TK_ID:
+            return strcmp(curr.text, "C") != 0;
+        default:
+            return false;
+    }
+}
+
+// The statements of a block, up to its closing brace. Anything after an
+// unconditional ret, break or continue can never run: it is still parsed, so
+// errors are reported and its locals are counted for the block's cleanup,
+// but its code is dropped.
+void block_body() {
+    bool dead = false;
+    while (curr.type != TK_RBRACE && curr.type != TK_EOF) {
+        MyloTokenType kind = curr.type;
+        if (!dead || !dead_code_droppable()) {
+            statement();
+        } else {
+            int start = compiling_vm->code_size;
+            int symbols = debug_symbol_count;
+            int breaks[MAX_LOOP_NESTING], continues[MAX_LOOP_NESTING];
+            for (int i = 0; i < loop_depth; i++) {
+                breaks[i] = loop_stack[i].break_count;
+                continues[i] = loop_stack[i].continue_count;
+            }
+            statement();
+            for (int i = 0; i < loop_depth; i++) {
+                loop_stack[i].break_count = breaks[i];
+                loop_stack[i].continue_count = continues[i];
+            }
+            debug_symbol_count = symbols;
+            compiling_vm->code_size = start;
+            peep_reset();
+        }
+        if (kind == TK_RET || kind == TK_BREAK || kind == TK_CONTINUE) dead = true;
+    }
+}
+
 void function() {
+    InlineHint hint = INLINE_AUTO;
+    if (curr.type == TK_AT) {
+        match(TK_AT);
+        if (strcmp(curr.text, "inline") == 0) hint = INLINE_ALWAYS;
+        else if (strcmp(curr.text, "noinline") == 0) hint = INLINE_NEVER;
+        else error("Unknown annotation '@%s' (expected @inline or @noinline)", curr.text);
+        match(TK_ID);
+    }
     match(TK_FN);
     int saved_scope_depth = current_scope_depth; // <-- Save outer scope
     current_scope_depth = 0;                     // <-- Reset for new function
@@ -2409,13 +3466,14 @@ void function() {
     char name[MAX_IDENTIFIER];
     strcpy(name, curr.text);
     match(TK_ID);
-    emit(OP_JMP);
+    emit_op(OP_JMP);
     int p = compiling_vm->code_size;
     emit(0);
     char m[MAX_IDENTIFIER * 2];
     get_mangled_name(m, name);
+    int func_idx = func_count;
     strcpy(funcs[func_count].name, m);
-    funcs[func_count++].addr = compiling_vm->code_size;
+    funcs[func_count++].addr = code_label();
     vm_register_function(compiling_vm, name, compiling_vm->code_size);
     int start_debug_idx = debug_symbol_count;
     bool ps = inside_function;
@@ -2448,26 +3506,29 @@ void function() {
         if (curr.type == TK_COMMA) match(TK_COMMA);
     }
     match(TK_RPAREN);
+    int param_count = local_count;
     match(TK_LBRACE);
 
     // [NEW] Function Scope
-    emit(OP_SCOPE_ENTER); current_scope_depth++; // <-- Track the function scope
+    emit_op(OP_SCOPE_ENTER); current_scope_depth++; // <-- Track the function scope
 
     for(int i=0; i<typed_arg_count; i++) {
         if (!typed_args[i].is_arr) {
-            emit(OP_LVAR); emit(typed_args[i].offset);
-            emit(OP_CHECK_TYPE); emit(typed_args[i].type);
-            emit(OP_SVAR); emit(typed_args[i].offset);
+            emit_op(OP_LVAR); emit(typed_args[i].offset);
+            emit_op(OP_CHECK_TYPE); emit(typed_args[i].type);
+            emit_op(OP_SVAR); emit(typed_args[i].offset);
         }
     }
 
-    while (curr.type != TK_RBRACE) statement();
+    char *body_src = src; Token body_curr = curr; int body_line = line;
+    block_body();
+    inline_record(func_idx, hint, param_count, body_src, body_curr, body_line);
     match(TK_RBRACE);
-    emit(OP_PSH_NUM);
+    emit_op(OP_PSH_NUM);
     int z = make_const(compiling_vm, 0.0);
     emit(z);
-    emit(OP_RET);
-    compiling_vm->bytecode[p] = compiling_vm->code_size;
+    emit_op(OP_RET);
+    compiling_vm->bytecode[p] = code_label();
     int func_end_ip = compiling_vm->code_size;
     for (int i = start_debug_idx; i < debug_symbol_count; i++) {
         if (debug_symbols[i].end_ip == -1) debug_symbols[i].end_ip = func_end_ip;
@@ -2490,12 +3551,13 @@ void parse_internal(char *source, bool is_import) {
     current_file_start = source;
     src = source;
     next_token();
+    if (!is_import) peep_reset();
 
     while (curr.type != TK_EOF) {
-        if (curr.type == TK_FN) function();
+        if (curr.type == TK_FN || curr.type == TK_AT) function();
         else statement();
     }
-    if (!is_import) emit(OP_HLT);
+    if (!is_import) emit_op(OP_HLT);
 
     int end_ip = compiling_vm->code_size;
     for (int i = start_debug_idx; i < debug_symbol_count; i++) {
@@ -2547,7 +3609,7 @@ void generate_binding_c_source(VM* vm, const char *output_filename) {
     fprintf(fp, "double (*host_vm_pop)(VM*);\n");
     fprintf(fp, "int (*host_make_string)(VM*, const char*);\n");
     fprintf(fp, "double (*host_heap_alloc)(VM*, int);\n");
-    fprintf(fp, "double* (*host_vm_resolve_ptr)(VM*, double);\n");
+    fprintf(fp, "Value* (*host_vm_resolve_ptr)(VM*, double);\n");
     fprintf(fp, "double (*host_vm_store_copy)(VM*, void*, size_t, const char*);\n");
     fprintf(fp, "double (*host_vm_store_ptr)(VM*, void*, const char*);\n");
     fprintf(fp, "void* (*host_vm_get_ref)(VM*, int, const char*);\n");
@@ -2631,6 +3693,271 @@ void generate_binding_c_source(VM* vm, const char *output_filename) {
     setTerminalColor(MyloFgDefault, MyloBgColorDefault);
 }
 
+// --- AOT translation (--build) ---
+// Each function body becomes a C function with one label per jump target and
+// sp/fp held in locals, so there is no dispatch loop. Hot ops are inlined with
+// the same numeric fast paths as run_fast; everything else (and any fast path
+// that misses) runs that single instruction through vm_exec_op.
+
+// Returns the end of the body starting at addr (function() emits JMP-over), or
+// -1 if it cannot be translated: a jump leaving the body, a call to something
+// other than a function, or an op that does not return normally.
+static int aot_body_end(VM* vm, int addr) {
+    if (addr < 2 || vm->bytecode[addr - 2] != OP_JMP) return -1;
+    int end = vm->bytecode[addr - 1];
+    if (end <= addr || end > vm->code_size) return -1;
+    for (int ip = addr; ip < end; ip += vm_op_length(vm->bytecode, ip)) {
+        int op = vm->bytecode[ip];
+        if (op < 0 || op >= OP_COUNT || op == OP_HLT) return -1;
+        if (op == OP_JMP || op == OP_JZ || op == OP_JNZ || (op >= OP_LT_JZ && op <= OP_NEQ_JZ)) {
+            int target = vm->bytecode[ip + 1];
+            if (target < addr || target >= end) return -1;
+        }
+        if (op == OP_CALL) {
+            bool known = false;
+            for (int f = 0; f < vm->function_count; f++) {
+                if (vm->functions[f].addr == vm->bytecode[ip + 1]) known = true;
+            }
+            if (!known) return -1;
+        }
+    }
+    return end;
+}
+
+static void c_gen_aot_prelude(FILE *fp) {
+    fprintf(fp, "// --- AOT FUNCTIONS ---\n");
+    fprintf(fp, "#define AOT_SYNC() do { vm->sp = sp; vm->fp = fp; } while (0)\n");
+    fprintf(fp, "#define AOT_RELOAD() do { sp = vm->sp; fp = vm->fp; } while (0)\n");
+    fprintf(fp, "#define AOT_ERROR(at, ...) do { vm->ip = (at); AOT_SYNC(); mylo_runtime_error(vm, __VA_ARGS__); } while (0)\n");
+    fprintf(fp, "#define AOT_SLOW(at) do { vm->ip = (at); AOT_SYNC(); vm_exec_op(vm); AOT_RELOAD(); } while (0)\n");
+    fprintf(fp, "#define AOT_PUSH(at) if (sp + 1 >= STACK_SIZE) AOT_ERROR(at, \"Stack Overflow\")\n");
+    fprintf(fp, "#define AOT_NUMS() (sp >= 1 && VAL_IS_NUM(stack[sp]) && VAL_IS_NUM(stack[sp - 1]))\n");
+    fprintf(fp, "#define AOT_BINARY(at, expr) \\\n");
+    fprintf(fp, "    if (AOT_NUMS()) { double b = VAL_AS_NUM(stack[sp]), a = VAL_AS_NUM(stack[sp - 1]); double r = (expr); memcpy(&stack[sp - 1], &r, sizeof(Value)); sp--; } \\\n");
+    fprintf(fp, "    else AOT_SLOW(at);\n");
+    fprintf(fp, "#define AOT_COMPARE(at, expr) \\\n");
+    fprintf(fp, "    if (AOT_NUMS()) { double b = VAL_AS_NUM(stack[sp]), a = VAL_AS_NUM(stack[sp - 1]); stack[sp - 1] = (expr) ? VAL_TRUE : VAL_FALSE; sp--; } \\\n");
+    fprintf(fp, "    else AOT_SLOW(at);\n");
+    fprintf(fp, "#define AOT_COMPARE_JZ(at, expr, target) \\\n");
+    fprintf(fp, "    if (AOT_NUMS()) { double b = VAL_AS_NUM(stack[sp]), a = VAL_AS_NUM(stack[sp - 1]); sp -= 2; if (!(expr)) goto target; } \\\n");
+    fprintf(fp, "    else { AOT_SLOW(at); if (vm->ip != (at) + 2) goto target; }\n");
+    fprintf(fp, "#define AOT_INC(at, slot, k) \\\n");
+    fprintf(fp, "    if (VAL_IS_NUM(slot)) { double r = VAL_AS_NUM(slot) + K[k]; memcpy(&(slot), &r, sizeof(Value)); } \\\n");
+    fprintf(fp, "    else AOT_SLOW(at);\n");
+    // Smart Local Protection, as OP_SVAR does in the interpreter
+    fprintf(fp, "#define AOT_SVAR(off) do { \\\n");
+    fprintf(fp, "    int target_idx = fp + (off); Value val = stack[sp--]; stack[target_idx] = val; \\\n");
+    fprintf(fp, "    if (VAL_TYPE(val) == T_OBJ) { \\\n");
+    fprintf(fp, "        int obj_offset = UNPACK_OFFSET(val); \\\n");
+    fprintf(fp, "        for (int s = 0; s < vm->scope_sp; s++) { \\\n");
+    fprintf(fp, "            VMScope* sc = &vm->scope_stack[s]; \\\n");
+    fprintf(fp, "            if (sc->fp == fp && target_idx <= sc->sp_at_entry && sc->arena_id == vm->current_arena && obj_offset >= sc->head) \\\n");
+    fprintf(fp, "                sc->head = vm->arenas[vm->current_arena].head; \\\n");
+    fprintf(fp, "        } \\\n");
+    fprintf(fp, "    } \\\n");
+    fprintf(fp, "} while (0)\n\n");
+}
+
+static void c_gen_aot_op(FILE *fp, VM* vm, int ip, const int* aot_ids) {
+    const int* code = vm->bytecode;
+    int op = code[ip];
+    int next = ip + vm_op_length(code, ip);
+    int a1 = next - ip > 1 ? code[ip + 1] : 0;
+    int a2 = next - ip > 2 ? code[ip + 2] : 0;
+
+    switch (op) {
+        case OP_PSH_NUM: fprintf(fp, "    AOT_PUSH(%d); stack[++sp] = VAL_NUM(K[%d]);\n", ip, a1); break;
+        case OP_PSH_STR: fprintf(fp, "    AOT_PUSH(%d); stack[++sp] = VAL_STR(%d);\n", ip, a1); break;
+        case OP_PSH_ENUM: fprintf(fp, "    AOT_PUSH(%d); stack[++sp] = VAL_ENUM((unsigned long long)K[%d]);\n", ip, a1); break;
+        case OP_DUP: fprintf(fp, "    AOT_PUSH(%d); stack[sp + 1] = stack[sp]; sp++;\n", ip); break;
+        case OP_POP: fprintf(fp, "    if (sp < 0) AOT_ERROR(%d, \"Stack Underflow\"); sp--;\n", ip); break;
+
+        case OP_ADD: fprintf(fp, "    AOT_BINARY(%d, a + b)\n", ip); break;
+        case OP_SUB: fprintf(fp, "    AOT_BINARY(%d, a - b)\n", ip); break;
+        case OP_MUL: fprintf(fp, "    AOT_BINARY(%d, a * b)\n", ip); break;
+        case OP_DIV: fprintf(fp, "    AOT_BINARY(%d, a / b)\n", ip); break;
+        case OP_MOD: fprintf(fp, "    AOT_BINARY(%d, fmod(a, b))\n", ip); break;
+        case OP_LT: fprintf(fp, "    AOT_COMPARE(%d, a < b)\n", ip); break;
+        case OP_GT: fprintf(fp, "    AOT_COMPARE(%d, a > b)\n", ip); break;
+        case OP_LE: fprintf(fp, "    AOT_COMPARE(%d, a <= b)\n", ip); break;
+        case OP_GE: fprintf(fp, "    AOT_COMPARE(%d, a >= b)\n", ip); break;
+        case OP_EQ: fprintf(fp, "    AOT_COMPARE(%d, a == b)\n", ip); break;
+        case OP_NEQ: fprintf(fp, "    AOT_COMPARE(%d, a != b)\n", ip); break;
+        case OP_ADD_C:
+        case OP_SUB_C:
+            fprintf(fp, "    if (sp >= 0 && VAL_IS_NUM(stack[sp])) { double r = VAL_AS_NUM(stack[sp]) %c K[%d]; memcpy(&stack[sp], &r, sizeof(Value)); }\n",
+                    op == OP_ADD_C ? '+' : '-', a1);
+            fprintf(fp, "    else AOT_SLOW(%d);\n", ip);
+            break;
+        case OP_INC_LVAR: fprintf(fp, "    AOT_INC(%d, stack[fp + %d], %d)\n", ip, a1, a2); break;
+        case OP_INC_GVAR: fprintf(fp, "    AOT_INC(%d, globals[%d], %d)\n", ip, a1, a2); break;
+
+        case OP_SET: fprintf(fp, "    if (sp < 0) AOT_ERROR(%d, \"Stack Underflow\"); globals[%d] = stack[sp--];\n", ip, a1); break;
+        case OP_GET: fprintf(fp, "    AOT_PUSH(%d); stack[++sp] = globals[%d];\n", ip, a1); break;
+        case OP_LVAR: fprintf(fp, "    AOT_PUSH(%d); sp++; stack[sp] = stack[fp + %d];\n", ip, a1); break;
+        case OP_SVAR: fprintf(fp, "    if (sp < 0) AOT_ERROR(%d, \"Stack Underflow\"); AOT_SVAR(%d);\n", ip, a1); break;
+
+        case OP_JMP:
+            if (a1 <= ip) {
+                // Backward edge: give a pending string collection its chance
+                fprintf(fp, "    if (vm->str_gc_pending && vm->run_depth <= 1) { AOT_SYNC(); vm_collect_strings(vm); }\n");
+            }
+            fprintf(fp, "    goto L%d;\n", a1);
+            break;
+        case OP_JZ:
+        case OP_JNZ:
+            fprintf(fp, "    if (sp < 0) AOT_ERROR(%d, \"Stack Underflow\");\n", ip);
+            fprintf(fp, "    { Value c = stack[sp--]; if (%sVAL_IS_FALSY(c)) goto L%d; }\n", op == OP_JNZ ? "!" : "", a1);
+            break;
+        case OP_LT_JZ: fprintf(fp, "    AOT_COMPARE_JZ(%d, a < b, L%d)\n", ip, a1); break;
+        case OP_GT_JZ: fprintf(fp, "    AOT_COMPARE_JZ(%d, a > b, L%d)\n", ip, a1); break;
+        case OP_LE_JZ: fprintf(fp, "    AOT_COMPARE_JZ(%d, a <= b, L%d)\n", ip, a1); break;
+        case OP_GE_JZ: fprintf(fp, "    AOT_COMPARE_JZ(%d, a >= b, L%d)\n", ip, a1); break;
+        case OP_EQ_JZ: fprintf(fp, "    AOT_COMPARE_JZ(%d, a == b, L%d)\n", ip, a1); break;
+        case OP_NEQ_JZ: fprintf(fp, "    AOT_COMPARE_JZ(%d, a != b, L%d)\n", ip, a1); break;
+
+        case OP_CALL: {
+            // Same frame layout as OP_CALL. The return ip is the code_size
+            // sentinel so an interpreted callee halts back into this function.
+            fprintf(fp, "    if (sp < %d) AOT_ERROR(%d, \"Stack Underflow\");\n", a2 - 1, ip);
+            fprintf(fp, "    if (sp + 2 >= STACK_SIZE) AOT_ERROR(%d, \"Stack Overflow\");\n", ip);
+            fprintf(fp, "    {\n");
+            fprintf(fp, "        int args_start = sp - %d;\n", a2 - 1);
+            if (a2 > 0) fprintf(fp, "        memmove(&stack[args_start + 2], &stack[args_start], %d * sizeof(Value));\n", a2);
+            fprintf(fp, "        stack[args_start] = VAL_NUM(vm->code_size);\n");
+            fprintf(fp, "        stack[args_start + 1] = VAL_NUM(fp);\n");
+            fprintf(fp, "        vm->sp = sp + 2; vm->fp = args_start + 2;\n");
+            if (aot_ids[a1] >= 0) fprintf(fp, "        vm->ip = %d; mylo_aot_%d(vm);\n", a1, aot_ids[a1]);
+            else fprintf(fp, "        run_vm_from(vm, %d, false);\n", a1);
+            fprintf(fp, "        AOT_RELOAD();\n");
+            fprintf(fp, "    }\n");
+            break;
+        }
+        case OP_RET:
+            fprintf(fp, "    vm->ip = %d; AOT_SYNC(); vm_exec_op(vm); return;\n", ip);
+            break;
+
+        case OP_HGET:
+            fprintf(fp, "    {\n");
+            fprintf(fp, "        if (sp < 0) AOT_ERROR(%d, \"Stack Underflow\");\n", ip);
+            fprintf(fp, "        vm->ip = %d;\n", next);
+            fprintf(fp, "        Value* base = vm_resolve_ptr(vm, VAL_AS_PTR(stack[sp]));\n");
+            fprintf(fp, "        if ((int)base[0] != %d) AOT_ERROR(%d, \"HGET Type mismatch\");\n", a2, next);
+            fprintf(fp, "        stack[sp] = base[%d];\n", 2 + a1);
+            fprintf(fp, "    }\n");
+            break;
+        case OP_LVAR_HGET:
+            fprintf(fp, "    {\n");
+            fprintf(fp, "        AOT_PUSH(%d);\n", ip);
+            fprintf(fp, "        vm->ip = %d;\n", next);
+            fprintf(fp, "        Value* base = vm_resolve_ptr(vm, VAL_AS_PTR(stack[fp + %d]));\n", a1);
+            fprintf(fp, "        if ((int)base[0] != %d) AOT_ERROR(%d, \"HGET Type mismatch\");\n", code[ip + 3], next);
+            fprintf(fp, "        stack[++sp] = base[%d];\n", 2 + a2);
+            fprintf(fp, "    }\n");
+            break;
+        case OP_HSET:
+            fprintf(fp, "    {\n");
+            fprintf(fp, "        if (sp < 1) AOT_ERROR(%d, \"Stack Underflow\");\n", ip);
+            fprintf(fp, "        vm->ip = %d;\n", next);
+            fprintf(fp, "        Value v = stack[sp--];\n");
+            fprintf(fp, "        double ptr = VAL_AS_PTR(stack[sp]);\n");
+            fprintf(fp, "        Value* base = vm_resolve_ptr(vm, ptr);\n");
+            fprintf(fp, "        if ((int)base[0] != %d) AOT_ERROR(%d, \"HSET Type mismatch\");\n", a2, next);
+            fprintf(fp, "        if (vm->arenas[UNPACK_ARENA(ptr)].frozen) AOT_ERROR(%d, \"Cannot modify frozen Region %%d\", UNPACK_ARENA(ptr));\n", next);
+            fprintf(fp, "        base[%d] = v;\n", 2 + a1);
+            fprintf(fp, "    }\n");
+            break;
+
+        case OP_SCOPE_ENTER:
+            fprintf(fp, "    if (vm->scope_sp >= MAX_SCOPES) AOT_ERROR(%d, \"Stack Overflow (Scope)\");\n", ip);
+            fprintf(fp, "    {\n");
+            fprintf(fp, "        VMScope* scope = &vm->scope_stack[vm->scope_sp++];\n");
+            fprintf(fp, "        scope->arena_id = vm->current_arena;\n");
+            fprintf(fp, "        scope->head = vm->arenas[vm->current_arena].head;\n");
+            fprintf(fp, "        scope->fp = fp;\n");
+            fprintf(fp, "        scope->sp_at_entry = sp;\n");
+            fprintf(fp, "    }\n");
+            break;
+        case OP_SCOPE_EXIT:
+            fprintf(fp, "    if (vm->scope_sp > 0) {\n");
+            fprintf(fp, "        VMScope* scope = &vm->scope_stack[--vm->scope_sp];\n");
+            fprintf(fp, "        if (vm->current_arena == scope->arena_id) vm_rewind_heap(vm, scope->head);\n");
+            fprintf(fp, "    }\n");
+            break;
+
+        case OP_NATIVE:
+            // Natives may re-enter the VM, so the registers round-trip
+            fprintf(fp, "    vm->ip = %d; AOT_SYNC();\n", next);
+            fprintf(fp, "    if (!vm->natives[%d]) mylo_runtime_error(vm, \"Unknown Native ID %d\");\n", a1, a1);
+            fprintf(fp, "    vm->natives[%d](vm);\n", a1);
+            fprintf(fp, "    AOT_RELOAD();\n");
+            break;
+
+        default:
+            fprintf(fp, "    AOT_SLOW(%d); // %s\n", ip, OP_NAMES[op]);
+            break;
+    }
+}
+
+static void c_gen_aot_functions(FILE *fp, VM* vm) {
+    // aot_ids: function address -> index of its C translation, or -1
+    int* aot_ids = malloc(sizeof(int) * (vm->code_size + 1));
+    bool* labels = calloc(vm->code_size + 1, sizeof(bool));
+    for (int i = 0; i <= vm->code_size; i++) aot_ids[i] = -1;
+    for (int f = 0; f < vm->function_count; f++) {
+        int addr = vm->functions[f].addr;
+        if (aot_body_end(vm, addr) != -1) aot_ids[addr] = f;
+    }
+
+    c_gen_aot_prelude(fp);
+    for (int f = 0; f < vm->function_count; f++) {
+        if (aot_ids[vm->functions[f].addr] == f) fprintf(fp, "static void mylo_aot_%d(VM* vm);\n", f);
+    }
+    fprintf(fp, "\n");
+
+    int translated = 0;
+    for (int f = 0; f < vm->function_count; f++) {
+        int addr = vm->functions[f].addr;
+        if (aot_ids[addr] != f) continue;
+        int end = aot_body_end(vm, addr);
+        translated++;
+
+        for (int ip = addr; ip < end; ip += vm_op_length(vm->bytecode, ip)) {
+            int op = vm->bytecode[ip];
+            if (op == OP_JMP || op == OP_JZ || op == OP_JNZ || (op >= OP_LT_JZ && op <= OP_NEQ_JZ)) {
+                labels[vm->bytecode[ip + 1]] = true;
+            }
+        }
+
+        fprintf(fp, "// fn %s\n", vm->functions[f].name);
+        fprintf(fp, "static void mylo_aot_%d(VM* vm) {\n", f);
+        fprintf(fp, "    Value* const stack = vm->stack;\n");
+        fprintf(fp, "    Value* const globals = vm->globals;\n");
+        fprintf(fp, "    const double* const K = vm->constants;\n");
+        fprintf(fp, "    int sp = vm->sp;\n");
+        fprintf(fp, "    int fp = vm->fp;\n");
+        fprintf(fp, "    (void)globals; (void)K;\n");
+        for (int ip = addr; ip < end; ip += vm_op_length(vm->bytecode, ip)) {
+            if (labels[ip]) fprintf(fp, "L%d:;\n", ip);
+            c_gen_aot_op(fp, vm, ip, aot_ids);
+        }
+        // Bodies always end in OP_RET; this only keeps the compiler quiet
+        fprintf(fp, "    AOT_SYNC();\n");
+        fprintf(fp, "}\n\n");
+    }
+
+    fprintf(fp, "static MyloAotFunc aot_table[%d] = {\n", vm->code_size + 1);
+    for (int f = 0; f < vm->function_count; f++) {
+        int addr = vm->functions[f].addr;
+        if (aot_ids[addr] == f) fprintf(fp, "  [%d] = mylo_aot_%d,\n", addr, f);
+    }
+    if (translated == 0) fprintf(fp, "  NULL\n");
+    fprintf(fp, "};\n\n");
+
+    free(aot_ids);
+    free(labels);
+}
+
 void compile_to_c_source(VM* vm, const char *output_filename) {
     compiling_vm = vm;
     FILE *fp = fopen(output_filename, "w");
@@ -2652,23 +3979,35 @@ void compile_to_c_source(VM* vm, const char *output_filename) {
 
     fprintf(fp, "double constants[] = {\n");
     for (int i = 0; i < vm->const_count; i++) {
-        fprintf(fp, "%f,", vm->constants[i]);
+        // Round-trip exactly: the AOT code reads these directly
+        double c = vm->constants[i];
+        if (c != c) fprintf(fp, "NAN,");
+        else if (isinf(c)) fprintf(fp, "%sHUGE_VAL,", c < 0 ? "-" : "");
+        else fprintf(fp, "%.17g,", c);
         if ((i + 1) % 8 == 0) fprintf(fp, "\n");
     }
     fprintf(fp, "};\n\n");
 
-    fprintf(fp, "char string_pool[%d][%d] = {\n", MAX_STRINGS, MAX_STRING_LENGTH);
+    int str_count = vm->str_count > 0 ? vm->str_count : 1;
+    fprintf(fp, "int string_lens[%d] = {\n", str_count);
+    for (int i = 0; i < vm->str_count; i++) {
+        fprintf(fp, "%d,", vm_string_len(vm, i));
+        if ((i + 1) % 16 == 0) fprintf(fp, "\n");
+    }
+    fprintf(fp, "};\n\n");
+
+    fprintf(fp, "const char* string_pool[%d] = {\n", str_count);
     for (int i = 0; i < vm->str_count; i++) {
         fprintf(fp, "  \"");
-        for (int j = 0; j < MAX_STRING_LENGTH; j++) {
+        int len = vm_string_len(vm, i);
+        for (int j = 0; j < len; j++) {
             char c = vm->string_pool[i][j];
-            if (c == '\0') break;
             if (c == '"') fprintf(fp, "\\\"");
             else if (c == '\\') fprintf(fp, "\\\\");
             else if (c == '\n') fprintf(fp, "\\n");
             else if (c == '\r') fprintf(fp, "\\r");
             else if (c >= 32 && c <= 126) fprintf(fp, "%c", c);
-            else fprintf(fp, "\\x%02x", (unsigned char) c);
+            else fprintf(fp, "\\%03o", (unsigned char) c); // Octal stops at 3 digits, unlike \x
         }
         fprintf(fp, "\",\n");
     }
@@ -2688,6 +4027,8 @@ void compile_to_c_source(VM* vm, const char *output_filename) {
     }
     fprintf(fp, "};\n\n");
 
+    c_gen_aot_functions(fp, vm);
+
     // Main Entry Point
     fprintf(fp, "int main(int argc, char** argv) {\n");
     // Instantiate VM on stack or heap
@@ -2701,13 +4042,13 @@ void compile_to_c_source(VM* vm, const char *output_filename) {
     fprintf(fp, "    vm.const_count = %d;\n", vm->const_count);
     fprintf(fp, "    memcpy(vm.constants, constants, sizeof(constants));\n\n");
 
-    fprintf(fp, "    vm.str_count = %d;\n", vm->str_count);
-    fprintf(fp, "    memcpy(vm.string_pool, string_pool, sizeof(string_pool));\n\n");
+    fprintf(fp, "    for (int i = 0; i < %d; i++) vm_pin_string(&vm, make_string_len(&vm, string_pool[i], string_lens[i]));\n\n", vm->str_count);
     fprintf(fp, "    vm.global_symbol_count = %d;\n", vm->global_symbol_count);
     fprintf(fp, "    vm.global_symbols = malloc(sizeof(VMSymbol) * %d);\n", sym_count);
     fprintf(fp, "    memcpy(vm.global_symbols, global_symbols, sizeof(VMSymbol) * vm.global_symbol_count);\n\n");
     fprintf(fp, "    vm.function_count = %d;\n", vm->function_count);
-    fprintf(fp, "    memcpy(vm.functions, vm_functions, sizeof(VMFunction) * vm.function_count);\n\n");
+    fprintf(fp, "    memcpy(vm.functions, vm_functions, sizeof(VMFunction) * vm.function_count);\n");
+    fprintf(fp, "    vm.image->aot = aot_table;\n\n");
     fprintf(fp, "    // Register Standard Library\n");
     fprintf(fp, "    int i = 0;\n");
     fprintf(fp, "    while (std_library[i].name != NULL) {\n");
@@ -2719,6 +4060,8 @@ void compile_to_c_source(VM* vm, const char *output_filename) {
     fprintf(fp, "    // Register FFI Wrappers\n");
     for (int i = 0; i < ffi_count; i++) fprintf(fp, "    vm.natives[i + %d] = __wrapper_%d;\n", bound_ffi_count + i, i);
 
+    fprintf(fp, "\n    // The embedded bytecode is fixed: once verified it runs without per-op stack checks\n");
+    fprintf(fp, "    vm_verify(&vm, NULL, 0);\n");
     fprintf(fp, "\n    // Run\n");
     fprintf(fp, "    run_vm(&vm, false);\n");
     fprintf(fp, "    vm_cleanup(&vm);\n");
@@ -2774,11 +4117,12 @@ void compile_repl(VM* vm, char *source, int *out_start_ip) {
 
     src = source;
     next_token();
+    peep_reset();
     *out_start_ip = vm->code_size;
 
     if (curr.type == TK_EOF) return;
 
-    if (curr.type == TK_FN) function();
+    if (curr.type == TK_FN || curr.type == TK_AT) function();
     else if (curr.type == TK_STRUCT) struct_decl();
     else if (curr.type == TK_VAR || curr.type == TK_IF || curr.type == TK_FOR ||
              curr.type == TK_FOREVER || curr.type == TK_PRINT || curr.type == TK_IMPORT ||
@@ -2794,6 +4138,7 @@ void compile_repl(VM* vm, char *source, int *out_start_ip) {
 
         if (curr.type != TK_EOF) {
             vm->code_size = saved_code_size;
+            peep_reset();
             src = source;
             line = saved_line;
             next_token();
@@ -2802,7 +4147,7 @@ void compile_repl(VM* vm, char *source, int *out_start_ip) {
     } else {
         expression();
     }
-    emit(OP_HLT);
+    emit_op(OP_HLT);
 
     if (vm->global_symbols) free(vm->global_symbols);
     vm->global_symbols = malloc(sizeof(VMSymbol) * global_count);
@@ -2842,8 +4187,14 @@ void create_standalone_executable(VM* vm, const char* output_filename, const cha
     fwrite(vm->constants, sizeof(double), vm->const_count, out);
 
     // 4. Append String Pool
-    // We flatten the 2D array for simple writing
-    fwrite(vm->string_pool, MAX_STRING_LENGTH, vm->str_count, out);
+    // Each string is written as an int length followed by its bytes
+    long string_size = 0;
+    for (int i = 0; i < vm->str_count; i++) {
+        int len = vm_string_len(vm, i);
+        fwrite(&len, sizeof(int), 1, out);
+        fwrite(vm->string_pool[i], 1, len, out);
+        string_size += sizeof(int) + len;
+    }
 
     fwrite(vm->dependencies, sizeof(Dependency), vm->dependency_count, out);
     fwrite(vm->global_symbols, sizeof(VMSymbol), vm->global_symbol_count, out);
@@ -2854,7 +4205,7 @@ void create_standalone_executable(VM* vm, const char* output_filename, const cha
     strcpy(footer.magic, MYLO_MAGIC);
     footer.bytecode_size = vm->code_size * sizeof(int);
     footer.const_size = vm->const_count * sizeof(double);
-    footer.string_size = vm->str_count * MAX_STRING_LENGTH;
+    footer.string_size = string_size;
     footer.symbol_size = vm->global_symbol_count * sizeof(VMSymbol);
     footer.function_size = vm->function_count * sizeof(VMFunction);
     fwrite(&footer, sizeof(StandaloneFooter), 1, out);
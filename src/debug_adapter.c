@@ -248,8 +248,8 @@ void start_debug_adapter(VM* vm, const char* filename, char* source_content) {
                                  if (stack_idx <= vm->sp) {
                                      if (!first) strcat(json, ",");
                                      char item[512];
-                                     double val = vm->stack[stack_idx];
-                                     int type = vm->stack_types[stack_idx];
+                                     double val = VAL_AS_DOUBLE(vm->stack[stack_idx]);
+                                     int type = VAL_TYPE(vm->stack[stack_idx]);
 
                                      if (type == T_NUM) snprintf(item, 512, "{\"name\": \"%s\", \"value\": \"%g\", \"variablesReference\": 0}", sym->name, val);
                                      else if (type == T_STR) snprintf(item, 512, "{\"name\": \"%s\", \"value\": \"\\\"...\\\"\", \"variablesReference\": 0}", sym->name);
@@ -267,8 +267,8 @@ void start_debug_adapter(VM* vm, const char* filename, char* source_content) {
                          for(int i=0; i<vm->global_symbol_count; i++) {
                              if (!first) strcat(json, ",");
                              int addr = vm->global_symbols[i].addr;
-                             double val = vm->globals[addr];
-                             int type = vm->global_types[addr];
+                             double val = VAL_AS_DOUBLE(vm->globals[addr]);
+                             int type = VAL_TYPE(vm->globals[addr]);
                              char item[512];
 
                              if (type == T_NUM) snprintf(item, 512, "{\"name\": \"%s\", \"value\": \"%g\", \"variablesReference\": 0}", vm->global_symbols[i].name, val);
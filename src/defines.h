@@ -4,28 +4,41 @@
 // VM Memory Limits
 #define STACK_SIZE 2048
 #define MAX_CODE 5368709
-#define MAX_HEAP 100000000
+#define MAX_HEAP 100000000     // Slots of address space reserved per arena
+#define ARENA_COMMIT_CHUNK (64 * 1024)                  // Slots committed at a time as an arena grows
+#define ARENA_RELEASE_THRESHOLD (128 * ARENA_COMMIT_CHUNK) // Slack above head before a rewind decommits (half is kept)
 #define MAX_GLOBALS 2048
 #define MAX_CONSTANTS 1024
 #define MAX_ARENAS 64         // 6 bits
 
 // String Limits
-#define MAX_STRINGS 10000
-#define MAX_STRING_LENGTH 1024
+#define STRING_POOL_INITIAL_CAP 1024  // Grows on demand; index capacity must stay a power of two
+#define STRING_CHUNK_SIZE (64 * 1024)  // Arena chunk size; longer strings get a chunk of their own
+#define STRING_GC_THRESHOLD (1024 * 1024) // Minimum bytes of new strings between collections
+#define MAX_STRING_LENGTH 1024         // Compiler scratch buffers only, the pool itself is unbounded
 #define MAX_C_HEADERS 32
 
 // Compilation Limits
 #define MAX_IDENTIFIER 256
 #define MAX_STRUCTS 64
 #define MAX_FIELDS 16
-#define MAX_NATIVES 64
+#define MAX_NATIVES 256 // Stdlib table plus FFI bindings
 #define MAX_FFI_ARGS 16
 #define MAX_C_BLOCK_SIZE 1024
 #define MAX_LOOP_NESTING 32
+#define MAX_SCOPES 256 // Open block scopes per VM, across all active frames
 #define MAX_JUMPS_PER_LOOP 64
 #define MAX_ENUM_MEMBERS 1024
 #define MAX_SEARCH_PATHS 16
 
+// JIT (--jit)
+#define JIT_HOT_THRESHOLD 1000 // Calls or loop back-edges before an entry is compiled
+
+// Profiler (--profile)
+#define PROFILE_INTERVAL_US 1000 // --profile sampling period (CPU time)
+#define PROFILE_MAX_FRAMES 128 // Innermost frames kept per sample
+#define PROFILE_MAX_NEST 64 // Re-entrant run_vm_from levels the profiler can see through
+
 // Output
 #define OUTPUT_BUFFER_SIZE 128000
 
@@ -59,10 +72,20 @@
 #define HEAP_HEADER_MAP 4
 #define MYLO_MONITOR_DEPTH 4
 
-#define MAP_INITIAL_CAP 16
+#define MAP_INITIAL_CAP 16 // Must stay a power of two (the hash index is 2 * cap)
+#define MAP_DATA_SLOTS(cap) ((cap) * 3) // cap [key, value] entries + 2 * cap int32 index slots
 #define MAX_VM_FUNCTIONS 1024
-#define MAX_BUS_ENTRIES 2048
+#define BUS_SHARDS 16 // Must stay a power of two
 #define MAX_WORKERS 128
+#define MAX_POOL_THREADS 64 // Upper bound for MYLO_WORKER_THREADS
+#define PAR_MIN_CHUNK 2048 // Smallest slice par_map/filter/reduce hand to a worker
+#define MAX_FUTURES 16384 // spawn() futures not yet awaited
+#define MAX_TASK_THREADS 128 // Threads that may own a spawn deque
+#define TASK_DEQUE_SIZE 4096 // Per-thread spawn deque (power of two)
+#define TASK_MAX_ARGS 16
+#define TASK_MAX_NEST 32 // Stolen tasks a waiting thread will stack up
+#define MAX_CHANNELS 256 // Open at once (chan_close recycles)
+#define VALUE_PACK_MAX_DEPTH 64 // Nesting limit when copying values between VMs
 
 // FFI
 #define MAX_STD_ARGS 12
@@ -96,6 +119,36 @@
     ((int)(((unsigned long long)(ptr) >> (PTR_OFFSET_BITS + PTR_ARENA_BITS)) & 0x3FFF))
 
 
+#ifdef _WIN32
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+// Atomics shared by the worker pool, tasks, channels and refs. Every operation
+// is sequentially consistent, as the Interlocked calls are. ATOMIC_LOAD, STORE,
+// CAS and ADD take a long long; the _PTR forms take a pointer.
+#ifdef _WIN32
+#define ATOMIC_LOAD(p) InterlockedCompareExchange64((p), 0, 0)
+#define ATOMIC_STORE(p, v) InterlockedExchange64((p), (v))
+#define ATOMIC_CAS(p, expect, v) (InterlockedCompareExchange64((p), (v), (expect)) == (expect))
+#define ATOMIC_ADD(p, d) InterlockedExchangeAdd64((p), (d))
+#define ATOMIC_LOAD_PTR(p) InterlockedCompareExchangePointer((PVOID volatile*)(p), NULL, NULL)
+#define ATOMIC_CAS_PTR(p, expect, v) \
+    (InterlockedCompareExchangePointer((PVOID volatile*)(p), (PVOID)(v), (PVOID)(expect)) == (PVOID)(expect))
+#define ATOMIC_FENCE() MemoryBarrier()
+#else
+// `*(p) + 0` drops the volatile from the type of CAS's expected value
+#define ATOMIC_LOAD(p) __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define ATOMIC_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#define ATOMIC_CAS(p, expect, v) \
+    __atomic_compare_exchange_n((p), &(__typeof__(*(p) + 0)){(expect)}, (v), false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+#define ATOMIC_ADD(p, d) __atomic_fetch_add((p), (d), __ATOMIC_SEQ_CST)
+#define ATOMIC_LOAD_PTR(p) ATOMIC_LOAD(p)
+#define ATOMIC_CAS_PTR(p, expect, v) ATOMIC_CAS(p, expect, v)
+#define ATOMIC_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
 // For bundles
 
 #define MYLO_MAGIC "MYLO_EXE"
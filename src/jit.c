@@ -0,0 +1,838 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "jit.h"
+
+#if defined(__x86_64__) && !defined(_WIN32)
+    #define MYLO_JIT_X64 1
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+// A compiled region: its executable mapping and the unwind info registered
+// for it, so errors raised inside helpers can unwind through native frames.
+typedef struct JitCode {
+    struct JitCode* next;
+    void* mem;
+    size_t size;
+    uint8_t* eh_frame;
+} JitCode;
+
+typedef struct {
+    int* heat;             // Per address: ticks so far, -1 once compiled or rejected
+    MyloAotFunc* entries;  // image->aot
+    int size;              // Addresses covered (code_size + 1 at attach)
+    int threshold;
+    JitCode* code;
+} JitState;
+
+static void jit_tick(VM* vm, int entry, int end);
+
+// --- Helpers called from generated code ---
+// Each takes the VM and the address of the instruction being run.
+
+// Runs one instruction through the interpreter
+static void jit_step(VM* vm, int ip) {
+    vm->ip = ip;
+    vm_exec_op(vm);
+}
+
+// Field access and object stores, as in the interpreter's fast loop
+static void jit_lvar_hget(VM* vm, int ip) {
+    const int* code = vm->bytecode;
+    Value obj = vm->stack[vm->fp + code[ip + 1]];
+    vm->ip = ip + 4;
+    if (vm->sp + 1 >= STACK_SIZE) mylo_runtime_error(vm, "Stack Overflow");
+    Value* base = vm_resolve_ptr(vm, VAL_AS_PTR(obj));
+    if ((int)base[0] != code[ip + 3]) mylo_runtime_error(vm, "HGET Type mismatch");
+    vm->stack[++vm->sp] = base[2 + code[ip + 2]];
+}
+
+static void jit_hget(VM* vm, int ip) {
+    const int* code = vm->bytecode;
+    vm->ip = ip + 3;
+    if (vm->sp < 0) mylo_runtime_error(vm, "Stack Underflow");
+    Value* base = vm_resolve_ptr(vm, VAL_AS_PTR(vm->stack[vm->sp]));
+    if ((int)base[0] != code[ip + 2]) mylo_runtime_error(vm, "HGET Type mismatch");
+    vm->stack[vm->sp] = base[2 + code[ip + 1]];
+}
+
+static void jit_hset(VM* vm, int ip) {
+    const int* code = vm->bytecode;
+    vm->ip = ip + 3;
+    if (vm->sp < 1) mylo_runtime_error(vm, "Stack Underflow");
+    Value v = vm->stack[vm->sp--];
+    double ptr = VAL_AS_PTR(vm->stack[vm->sp]);
+    Value* base = vm_resolve_ptr(vm, ptr);
+    if ((int)base[0] != code[ip + 2]) mylo_runtime_error(vm, "HSET Type mismatch");
+    if (vm->arenas[UNPACK_ARENA(ptr)].frozen) mylo_runtime_error(vm, "Cannot modify frozen Region %d", UNPACK_ARENA(ptr));
+    base[2 + code[ip + 1]] = v;
+}
+
+// OP_SVAR of an object: Smart Local Protection (see exec_var_op)
+static void jit_svar_obj(VM* vm, int ip) {
+    int target_idx = vm->fp + vm->bytecode[ip + 1];
+    Value val = vm->stack[vm->sp--];
+    vm->stack[target_idx] = val;
+    int obj_offset = UNPACK_OFFSET(val);
+    for (int s = 0; s < vm->scope_sp; s++) {
+        VMScope* scope = &vm->scope_stack[s];
+        if (scope->fp == vm->fp && target_idx <= scope->sp_at_entry &&
+            scope->arena_id == vm->current_arena && obj_offset >= scope->head) {
+            scope->head = vm->arenas[vm->current_arena].head;
+        }
+    }
+}
+
+// OP_RET when the frame allocated nothing: drop its scopes and return.
+// Anything needing a rewind or an evacuation runs the interpreter's OP_RET.
+static void jit_ret(VM* vm, int ip) {
+    if (vm->sp < 0 || VAL_TYPE(vm->stack[vm->sp]) == T_OBJ) { jit_step(vm, ip); return; }
+    int s = vm->scope_sp;
+    while (s > 0 && vm->scope_stack[s - 1].fp == vm->fp) {
+        VMScope* scope = &vm->scope_stack[s - 1];
+        if (scope->arena_id == vm->current_arena &&
+            vm->arenas[scope->arena_id].head != scope->head) { jit_step(vm, ip); return; }
+        s--;
+    }
+    vm->scope_sp = s;
+    Value rv = vm->stack[vm->sp];
+    int old_fp = vm->fp;
+    vm->sp = old_fp - 2;
+    vm->fp = (int)VAL_AS_NUM(vm->stack[old_fp - 1]);
+    vm->ip = (int)VAL_AS_NUM(vm->stack[old_fp - 2]);
+    vm->stack[vm->sp] = rv;
+}
+
+// OP_CALL: same frame layout as the interpreter. The return ip is the
+// code_size sentinel so an interpreted callee halts back here.
+static void jit_call(VM* vm, int ip) {
+    int target = vm->bytecode[ip + 1];
+    int argc = vm->bytecode[ip + 2];
+    vm->ip = ip + 3;
+    if (vm->sp < argc - 1) mylo_runtime_error(vm, "Stack Underflow");
+    if (vm->sp + 2 >= STACK_SIZE) mylo_runtime_error(vm, "Stack Overflow");
+
+    int args_start = vm->sp - argc + 1;
+    memmove(&vm->stack[args_start + 2], &vm->stack[args_start], argc * sizeof(Value));
+    vm->stack[args_start] = VAL_NUM(vm->code_size);
+    vm->stack[args_start + 1] = VAL_NUM(vm->fp);
+    vm->sp += 2;
+    vm->fp = args_start + 2;
+
+    MyloAotFunc* aot = vm->image->aot;
+    if (!aot[target]) jit_tick(vm, target, -1);
+    if (aot[target]) {
+        vm->ip = target;
+        aot[target](vm);
+        // Handed back to the interpreter part way through the body
+        if (vm->ip < vm->code_size) run_vm_from(vm, vm->ip, false);
+    } else {
+        run_vm_from(vm, target, false);
+    }
+}
+
+// Loop back-edge with a string collection pending
+static void jit_safepoint(VM* vm, int ip) {
+    vm->ip = ip;
+    if (vm->str_gc_pending && vm->run_depth <= 1) vm_collect_strings(vm);
+}
+
+#ifdef MYLO_JIT_X64
+
+// --- x86-64 emitter ---
+// Register use inside compiled code (all callee-saved):
+//   rbx = VM*, r12 = vm->stack, r13 = sp, r14 = fp, r15 = vm->globals
+// rax, rcx, rdx and xmm0/xmm1 are scratch. sp/fp are written back to the VM
+// before every helper call and reloaded after it.
+
+typedef struct {
+    uint8_t* buf;
+    int len;
+    int cap;
+} Asm;
+
+enum { RAX = 0, RCX = 1, RDX = 2, RBX = 3, R13 = 13, R14 = 14 };
+enum { IDX_SP = 5, IDX_FP = 6 }; // r13 / r14 as a SIB index
+
+// Condition codes (low nibble of Jcc / SETcc)
+enum { CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_BE = 0x6, CC_A = 0x7,
+       CC_P = 0xA, CC_NP = 0xB, CC_L = 0xC, CC_GE = 0xD, CC_LE = 0xE, CC_G = 0xF };
+
+#define OFF(field) ((int32_t)offsetof(VM, field))
+#define JIT_TARGET_EPILOGUE -1
+
+static void emit(Asm* a, const void* bytes, int n) {
+    if (a->len + n > a->cap) {
+        a->cap = a->cap ? a->cap * 2 : 4096;
+        while (a->len + n > a->cap) a->cap *= 2;
+        a->buf = (uint8_t*)realloc(a->buf, a->cap);
+    }
+    memcpy(a->buf + a->len, bytes, n);
+    a->len += n;
+}
+
+static void emit1(Asm* a, uint8_t b) { emit(a, &b, 1); }
+static void emit32(Asm* a, int32_t v) { emit(a, &v, 4); }
+static void emit64(Asm* a, uint64_t v) { emit(a, &v, 8); }
+#define EMIT(a, ...) do { const uint8_t bytes_[] = { __VA_ARGS__ }; emit((a), bytes_, sizeof(bytes_)); } while (0)
+
+static void patch32(Asm* a, int at, int32_t v) { memcpy(a->buf + at, &v, 4); }
+
+// Forward Jcc/JMP inside a template; returns the rel32 slot to patch
+static int jcc_fwd(Asm* a, int cc) { EMIT(a, 0x0F, 0x80 | cc); emit32(a, 0); return a->len - 4; }
+static int jmp_fwd(Asm* a) { emit1(a, 0xE9); emit32(a, 0); return a->len - 4; }
+static void land(Asm* a, int slot) { patch32(a, slot, a->len - (slot + 4)); }
+
+// mov/store reg <-> [r12 + idx*8 + disp]
+static void stack_op(Asm* a, uint8_t opcode, int reg, int idx, int32_t disp) {
+    EMIT(a, 0x4B, opcode, (uint8_t)(0x84 | (reg << 3)), (uint8_t)(0xC4 | (idx << 3)));
+    emit32(a, disp);
+}
+static void load_stack(Asm* a, int reg, int idx, int slot) { stack_op(a, 0x8B, reg, idx, slot * 8); }
+static void store_stack(Asm* a, int reg, int idx, int slot) { stack_op(a, 0x89, reg, idx, slot * 8); }
+
+// mov/store reg <-> [r15 + disp]
+static void global_op(Asm* a, uint8_t opcode, int reg, int slot) {
+    EMIT(a, 0x49, opcode, (uint8_t)(0x87 | (reg << 3)));
+    emit32(a, slot * 8);
+}
+
+// op reg, [base + disp32] (w selects 64-bit operands)
+static void mem_op(Asm* a, int w, uint8_t opcode, int reg, int base, int32_t disp) {
+    emit1(a, (uint8_t)(0x40 | (w << 3) | ((reg >> 3) << 2) | (base >> 3)));
+    emit1(a, opcode);
+    emit1(a, (uint8_t)(0x80 | ((reg & 7) << 3) | (base & 7)));
+    if ((base & 7) == 4) emit1(a, 0x24);
+    emit32(a, disp);
+}
+
+// reg = vm + reg * size (reg holds a non-negative index into an array of structs)
+static void index_vm(Asm* a, int reg, int32_t size) {
+    EMIT(a, 0x69, (uint8_t)(0xC0 | (reg << 3) | reg)); emit32(a, size); // imul reg32, reg32, size
+    EMIT(a, 0x48, 0x01, (uint8_t)(0xD8 | reg));                          // add reg, rbx
+}
+
+static void mov_imm64(Asm* a, int reg, uint64_t v) { EMIT(a, 0x48, (uint8_t)(0xB8 | reg)); emit64(a, v); }
+static void inc_sp(Asm* a) { EMIT(a, 0x49, 0xFF, 0xC5); }
+static void dec_sp(Asm* a) { EMIT(a, 0x49, 0xFF, 0xCD); }
+static void cmp_sp(Asm* a, int32_t v) { EMIT(a, 0x49, 0x81, 0xFD); emit32(a, v); }
+
+static void sync_regs(Asm* a) {
+    EMIT(a, 0x44, 0x89, 0xAB); emit32(a, OFF(sp));
+    EMIT(a, 0x44, 0x89, 0xB3); emit32(a, OFF(fp));
+}
+static void reload_regs(Asm* a) {
+    EMIT(a, 0x4C, 0x63, 0xAB); emit32(a, OFF(sp));
+    EMIT(a, 0x4C, 0x63, 0xB3); emit32(a, OFF(fp));
+}
+
+static void call_helper(Asm* a, void (*fn)(VM*, int), int ip) {
+    sync_regs(a);
+    EMIT(a, 0x48, 0x89, 0xDF);               // mov rdi, rbx
+    emit1(a, 0xBE); emit32(a, ip);           // mov esi, ip
+    mov_imm64(a, RAX, (uint64_t)(uintptr_t)fn);
+    EMIT(a, 0xFF, 0xD0);                     // call rax
+    reload_regs(a);
+}
+
+static void set_vm_ip(Asm* a, int ip) { EMIT(a, 0xC7, 0x83); emit32(a, OFF(ip)); emit32(a, ip); }
+
+// Jumps to slow unless reg holds a number (VAL_IS_NUM: top 16 bits below 0xFFF9)
+static int guard_num(Asm* a, int reg) {
+    EMIT(a, 0x48, 0x89, (uint8_t)(0xC2 | (reg << 3))); // mov rdx, reg
+    EMIT(a, 0x48, 0xC1, 0xEA, 0x30);                    // shr rdx, 48
+    EMIT(a, 0x81, 0xFA); emit32(a, 0xFFF9);             // cmp edx, 0xFFF9
+    return jcc_fwd(a, CC_AE);
+}
+
+static void to_xmm(Asm* a) {
+    EMIT(a, 0x66, 0x48, 0x0F, 0x6E, 0xC0); // movq xmm0, rax
+    EMIT(a, 0x66, 0x48, 0x0F, 0x6E, 0xC9); // movq xmm1, rcx
+}
+static void from_xmm0(Asm* a) { EMIT(a, 0x66, 0x48, 0x0F, 0x7E, 0xC0); } // movq rax, xmm0
+
+// Branches to bytecode addresses (or the epilogue), resolved once the body is laid out
+typedef struct { int slot; int target; } JitFixup;
+
+typedef struct {
+    Asm a;
+    VM* vm;
+    int entry, end;
+    int* label;            // Code offset per address in [entry, end), -1 if none
+    JitFixup* fixups;
+    int fixup_count, fixup_cap;
+} JitBuild;
+
+static void branch(JitBuild* b, int cc, int target) {
+    if (cc < 0) emit1(&b->a, 0xE9);
+    else EMIT(&b->a, 0x0F, 0x80 | cc);
+    emit32(&b->a, 0);
+    if (b->fixup_count == b->fixup_cap) {
+        b->fixup_cap = b->fixup_cap ? b->fixup_cap * 2 : 64;
+        b->fixups = (JitFixup*)realloc(b->fixups, b->fixup_cap * sizeof(JitFixup));
+    }
+    b->fixups[b->fixup_count].slot = b->a.len - 4;
+    b->fixups[b->fixup_count].target = target;
+    b->fixup_count++;
+}
+
+// Leaves compiled code: the interpreter resumes at vm->ip = target
+static void exit_to(JitBuild* b, int target) {
+    set_vm_ip(&b->a, target);
+    branch(b, -1, JIT_TARGET_EPILOGUE);
+}
+
+// Ends a template: slow slots land on a single-instruction interpreter step
+static void slow_path(Asm* a, const int* slow, int n, int ip) {
+    int done = jmp_fwd(a);
+    for (int i = 0; i < n; i++) land(a, slow[i]);
+    call_helper(a, jit_step, ip);
+    land(a, done);
+}
+
+// Pops a and b (numbers) into xmm0/xmm1; fills slow[0..2]
+static void binary_operands(Asm* a, int* slow) {
+    cmp_sp(a, 1);
+    slow[0] = jcc_fwd(a, CC_L);
+    load_stack(a, RAX, IDX_SP, -1);
+    load_stack(a, RCX, IDX_SP, 0);
+    slow[1] = guard_num(a, RAX);
+    slow[2] = guard_num(a, RCX);
+    to_xmm(a);
+}
+
+// Sets al from xmm0 (a) OP xmm1 (b), false when unordered
+static void compare_flags(Asm* a, int op) {
+    switch (op) {
+        case OP_LT: EMIT(a, 0x66, 0x0F, 0x2E, 0xC8); EMIT(a, 0x0F, 0x97, 0xC0); break; // b > a
+        case OP_LE: EMIT(a, 0x66, 0x0F, 0x2E, 0xC8); EMIT(a, 0x0F, 0x93, 0xC0); break; // b >= a
+        case OP_GT: EMIT(a, 0x66, 0x0F, 0x2E, 0xC1); EMIT(a, 0x0F, 0x97, 0xC0); break;
+        case OP_GE: EMIT(a, 0x66, 0x0F, 0x2E, 0xC1); EMIT(a, 0x0F, 0x93, 0xC0); break;
+        case OP_EQ:
+            EMIT(a, 0x66, 0x0F, 0x2E, 0xC1);
+            EMIT(a, 0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC1, 0x20, 0xC8); // sete al; setnp cl; and al, cl
+            break;
+        default: // OP_NEQ
+            EMIT(a, 0x66, 0x0F, 0x2E, 0xC1);
+            EMIT(a, 0x0F, 0x95, 0xC0, 0x0F, 0x9A, 0xC1, 0x08, 0xC8); // setne al; setp cl; or al, cl
+            break;
+    }
+}
+
+// Branches to target unless xmm0 (a) OP xmm1 (b) holds
+static void compare_branch_false(JitBuild* b, int op, int target) {
+    Asm* a = &b->a;
+    switch (op) {
+        case OP_LT: EMIT(a, 0x66, 0x0F, 0x2E, 0xC8); branch(b, CC_BE, target); break;
+        case OP_LE: EMIT(a, 0x66, 0x0F, 0x2E, 0xC8); branch(b, CC_B, target); break;
+        case OP_GT: EMIT(a, 0x66, 0x0F, 0x2E, 0xC1); branch(b, CC_BE, target); break;
+        case OP_GE: EMIT(a, 0x66, 0x0F, 0x2E, 0xC1); branch(b, CC_B, target); break;
+        case OP_EQ:
+            EMIT(a, 0x66, 0x0F, 0x2E, 0xC1);
+            branch(b, CC_NE, target);
+            branch(b, CC_P, target);
+            break;
+        default: // OP_NEQ: branch when equal and ordered
+            EMIT(a, 0x66, 0x0F, 0x2E, 0xC1);
+            EMIT(a, 0x7A, 0x06); // jp over the je
+            branch(b, CC_E, target);
+            break;
+    }
+}
+
+static void push_guard(Asm* a, int* slow) {
+    cmp_sp(a, STACK_SIZE - 2);
+    *slow = jcc_fwd(a, CC_G);
+}
+
+static void emit_op(JitBuild* b, int ip) {
+    Asm* a = &b->a;
+    const int* code = b->vm->bytecode;
+    const double* constants = b->vm->constants;
+    int op = code[ip];
+    int slow[4];
+
+    switch (op) {
+        case OP_PSH_NUM:
+        case OP_PSH_STR:
+        case OP_PSH_ENUM: {
+            Value v = op == OP_PSH_NUM ? VAL_NUM(constants[code[ip + 1]])
+                    : op == OP_PSH_STR ? VAL_STR(code[ip + 1])
+                    : VAL_ENUM((unsigned long long)constants[code[ip + 1]]);
+            push_guard(a, &slow[0]);
+            mov_imm64(a, RAX, v);
+            inc_sp(a);
+            store_stack(a, RAX, IDX_SP, 0);
+            slow_path(a, slow, 1, ip);
+            break;
+        }
+        case OP_LVAR:
+        case OP_GET:
+            push_guard(a, &slow[0]);
+            if (op == OP_LVAR) load_stack(a, RAX, IDX_FP, code[ip + 1]);
+            else global_op(a, 0x8B, RAX, code[ip + 1]);
+            inc_sp(a);
+            store_stack(a, RAX, IDX_SP, 0);
+            slow_path(a, slow, 1, ip);
+            break;
+        case OP_DUP:
+            push_guard(a, &slow[0]);
+            cmp_sp(a, 0);
+            slow[1] = jcc_fwd(a, CC_L);
+            load_stack(a, RAX, IDX_SP, 0);
+            inc_sp(a);
+            store_stack(a, RAX, IDX_SP, 0);
+            slow_path(a, slow, 2, ip);
+            break;
+        case OP_POP:
+            cmp_sp(a, 0);
+            slow[0] = jcc_fwd(a, CC_L);
+            dec_sp(a);
+            slow_path(a, slow, 1, ip);
+            break;
+        case OP_SET:
+            cmp_sp(a, 0);
+            slow[0] = jcc_fwd(a, CC_L);
+            load_stack(a, RAX, IDX_SP, 0);
+            global_op(a, 0x89, RAX, code[ip + 1]);
+            dec_sp(a);
+            slow_path(a, slow, 1, ip);
+            break;
+        case OP_SVAR: {
+            // Objects take a helper for Smart Local Protection
+            cmp_sp(a, 0);
+            slow[0] = jcc_fwd(a, CC_L);
+            load_stack(a, RAX, IDX_SP, 0);
+            EMIT(a, 0x48, 0x89, 0xC2, 0x48, 0xC1, 0xEA, 0x30); // mov rdx, rax; shr rdx, 48
+            EMIT(a, 0x81, 0xFA); emit32(a, 0xFFF8 | T_OBJ);    // cmp edx, T_OBJ tag
+            int obj = jcc_fwd(a, CC_E);
+            store_stack(a, RAX, IDX_FP, code[ip + 1]);
+            dec_sp(a);
+            int done = jmp_fwd(a);
+            land(a, obj);
+            call_helper(a, jit_svar_obj, ip);
+            land(a, done);
+            slow_path(a, slow, 1, ip);
+            break;
+        }
+
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_DIV: {
+            static const uint8_t sse[] = { [OP_ADD] = 0x58, [OP_SUB] = 0x5C, [OP_MUL] = 0x59, [OP_DIV] = 0x5E };
+            binary_operands(a, slow);
+            EMIT(a, 0xF2, 0x0F, sse[op], 0xC1);
+            from_xmm0(a);
+            store_stack(a, RAX, IDX_SP, -1);
+            dec_sp(a);
+            slow_path(a, slow, 3, ip);
+            break;
+        }
+        case OP_LT: case OP_LE: case OP_GT: case OP_GE: case OP_EQ: case OP_NEQ:
+            binary_operands(a, slow);
+            compare_flags(a, op);
+            EMIT(a, 0x84, 0xC0);                   // test al, al
+            mov_imm64(a, RCX, VAL_TRUE);
+            emit1(a, 0xB8); emit32(a, 0);          // mov eax, 0 (keeps flags)
+            EMIT(a, 0x48, 0x0F, 0x45, 0xC1);       // cmovnz rax, rcx
+            store_stack(a, RAX, IDX_SP, -1);
+            dec_sp(a);
+            slow_path(a, slow, 3, ip);
+            break;
+
+        case OP_ADD_C:
+        case OP_SUB_C: {
+            double k = constants[code[ip + 1]];
+            uint64_t bits;
+            memcpy(&bits, &k, sizeof(bits));
+            cmp_sp(a, 0);
+            slow[0] = jcc_fwd(a, CC_L);
+            load_stack(a, RAX, IDX_SP, 0);
+            slow[1] = guard_num(a, RAX);
+            mov_imm64(a, RCX, bits);
+            to_xmm(a);
+            EMIT(a, 0xF2, 0x0F, op == OP_ADD_C ? 0x58 : 0x5C, 0xC1);
+            from_xmm0(a);
+            store_stack(a, RAX, IDX_SP, 0);
+            slow_path(a, slow, 2, ip);
+            break;
+        }
+        case OP_INC_LVAR:
+        case OP_INC_GVAR: {
+            double k = constants[code[ip + 2]];
+            uint64_t bits;
+            memcpy(&bits, &k, sizeof(bits));
+            if (op == OP_INC_LVAR) load_stack(a, RAX, IDX_FP, code[ip + 1]);
+            else global_op(a, 0x8B, RAX, code[ip + 1]);
+            slow[0] = guard_num(a, RAX);
+            mov_imm64(a, RCX, bits);
+            to_xmm(a);
+            EMIT(a, 0xF2, 0x0F, 0x58, 0xC1);
+            from_xmm0(a);
+            if (op == OP_INC_LVAR) store_stack(a, RAX, IDX_FP, code[ip + 1]);
+            else global_op(a, 0x89, RAX, code[ip + 1]);
+            slow_path(a, slow, 1, ip);
+            break;
+        }
+
+        case OP_JMP: {
+            int target = code[ip + 1];
+            if (target <= ip) {
+                EMIT(a, 0x80, 0xBB); emit32(a, OFF(str_gc_pending)); emit1(a, 0); // cmp byte [rbx+..], 0
+                int skip = jcc_fwd(a, CC_E);
+                call_helper(a, jit_safepoint, ip);
+                land(a, skip);
+            }
+            branch(b, -1, target);
+            break;
+        }
+        case OP_JZ:
+        case OP_JNZ: {
+            // Falsy: a number with all bits but the sign clear, or a zero payload
+            int target = code[ip + 1];
+            int cc = op == OP_JZ ? CC_E : CC_NE;
+            cmp_sp(a, 0);
+            slow[0] = jcc_fwd(a, CC_L);
+            load_stack(a, RAX, IDX_SP, 0);
+            dec_sp(a);
+            int boxed = guard_num(a, RAX);
+            EMIT(a, 0x48, 0xD1, 0xE0);         // shl rax, 1
+            branch(b, cc, target);
+            int done = jmp_fwd(a);
+            land(a, boxed);
+            EMIT(a, 0x48, 0xC1, 0xE0, 0x10);   // shl rax, 16
+            branch(b, cc, target);
+            int done2 = jmp_fwd(a);
+            land(a, slow[0]);
+            call_helper(a, jit_step, ip);
+            EMIT(a, 0x81, 0xBB); emit32(a, OFF(ip)); emit32(a, target);
+            branch(b, CC_E, target);
+            land(a, done);
+            land(a, done2);
+            break;
+        }
+        case OP_LT_JZ: case OP_LE_JZ: case OP_GT_JZ: case OP_GE_JZ: case OP_EQ_JZ: case OP_NEQ_JZ: {
+            int target = code[ip + 1];
+            binary_operands(a, slow);
+            EMIT(a, 0x49, 0x83, 0xED, 0x02);   // sub r13, 2
+            compare_branch_false(b, OP_LT + (op - OP_LT_JZ), target);
+            int done = jmp_fwd(a);
+            for (int i = 0; i < 3; i++) land(a, slow[i]);
+            call_helper(a, jit_step, ip);
+            EMIT(a, 0x81, 0xBB); emit32(a, OFF(ip)); emit32(a, target);
+            branch(b, CC_E, target);
+            land(a, done);
+            break;
+        }
+
+        case OP_SCOPE_ENTER: {
+            // Same bookkeeping as the interpreter, on the VM's scope stack
+            int32_t scope = OFF(scope_stack);
+            mem_op(a, 0, 0x8B, RAX, RBX, OFF(scope_sp));
+            emit1(a, 0x3D); emit32(a, MAX_SCOPES);                    // cmp eax, MAX_SCOPES
+            slow[0] = jcc_fwd(a, CC_GE);
+            index_vm(a, RAX, sizeof(VMScope));
+            mem_op(a, 0, 0x8B, RCX, RBX, OFF(current_arena));
+            mem_op(a, 0, 0x89, RCX, RAX, scope + offsetof(VMScope, arena_id));
+            index_vm(a, RCX, sizeof(MemoryArena));
+            mem_op(a, 0, 0x8B, RDX, RCX, OFF(arenas) + offsetof(MemoryArena, head));
+            mem_op(a, 0, 0x89, RDX, RAX, scope + offsetof(VMScope, head));
+            mem_op(a, 0, 0x89, R14, RAX, scope + offsetof(VMScope, fp));
+            mem_op(a, 0, 0x89, R13, RAX, scope + offsetof(VMScope, sp_at_entry));
+            mem_op(a, 0, 0xFF, 0, RBX, OFF(scope_sp));                 // inc dword
+            slow_path(a, slow, 1, ip);
+            break;
+        }
+        case OP_SCOPE_EXIT: {
+            // Pops inline when nothing was allocated since entry; a rewind goes slow
+            int32_t scope = OFF(scope_stack);
+            mem_op(a, 0, 0x8B, RAX, RBX, OFF(scope_sp));
+            EMIT(a, 0x85, 0xC0);                                      // test eax, eax
+            int empty = jcc_fwd(a, CC_LE);
+            EMIT(a, 0xFF, 0xC8);                                      // dec eax
+            index_vm(a, RAX, sizeof(VMScope));
+            mem_op(a, 0, 0x8B, RCX, RAX, scope + offsetof(VMScope, arena_id));
+            mem_op(a, 0, 0x3B, RCX, RBX, OFF(current_arena));
+            int other_arena = jcc_fwd(a, CC_NE);
+            index_vm(a, RCX, sizeof(MemoryArena));
+            mem_op(a, 0, 0x8B, RCX, RCX, OFF(arenas) + offsetof(MemoryArena, head));
+            mem_op(a, 0, 0x3B, RCX, RAX, scope + offsetof(VMScope, head));
+            slow[0] = jcc_fwd(a, CC_NE);
+            land(a, other_arena);
+            mem_op(a, 0, 0xFF, 1, RBX, OFF(scope_sp));                 // dec dword
+            land(a, empty);
+            slow_path(a, slow, 1, ip);
+            break;
+        }
+
+        case OP_LVAR_HGET: call_helper(a, jit_lvar_hget, ip); break;
+        case OP_HGET: call_helper(a, jit_hget, ip); break;
+        case OP_HSET: call_helper(a, jit_hset, ip); break;
+        case OP_CHECK_TYPE:
+        case OP_CAST: {
+            // Numbers and strings that already have the type pass through
+            int type = code[ip + 1];
+            if (type == TYPE_ANY) break;
+            if (type != TYPE_NUM && type != TYPE_STR) {
+                call_helper(a, jit_step, ip);
+                break;
+            }
+            cmp_sp(a, 0);
+            slow[0] = jcc_fwd(a, CC_L);
+            load_stack(a, RAX, IDX_SP, 0);
+            if (type == TYPE_NUM) {
+                slow[1] = guard_num(a, RAX);
+            } else {
+                EMIT(a, 0x48, 0xC1, 0xE8, 0x30);                  // shr rax, 48
+                emit1(a, 0x3D); emit32(a, 0xFFF8 | T_STR);        // cmp eax, T_STR tag
+                slow[1] = jcc_fwd(a, CC_NE);
+            }
+            slow_path(a, slow, 2, ip);
+            break;
+        }
+
+        case OP_CALL:
+            call_helper(a, jit_call, ip);
+            break;
+        case OP_RET:
+            // vm->ip is left at the return address
+            call_helper(a, jit_ret, ip);
+            branch(b, -1, JIT_TARGET_EPILOGUE);
+            break;
+        case OP_HLT:
+            exit_to(b, ip);
+            break;
+
+        default:
+            // OP_NATIVE, OP_SLICE, OP_HGET, scopes...: one interpreter step
+            call_helper(a, jit_step, ip);
+            break;
+    }
+}
+
+// --- Unwind info ---
+// One CIE and one FDE describing the fixed prologue: CFA = rsp + 64 with the
+// six callee-saved pushes below the return address. Helpers may raise errors
+// that unwind (C++ embedders throw from error_callback) through this frame.
+#if defined(__linux__)
+extern void __register_frame(void* begin);
+extern void __deregister_frame(void* begin);
+
+static uint8_t* jit_eh_frame(void* code, size_t size) {
+    static const uint8_t cie[] = {
+        20, 0, 0, 0,                  // length
+        0, 0, 0, 0,                   // CIE id
+        1, 'z', 'R', 0,               // version, augmentation
+        1, 0x78, 16,                  // code align 1, data align -8, return column 16
+        1, 0x00,                      // augmentation data: FDE pointers are absolute
+        0x0C, 7, 8,                   // DW_CFA_def_cfa rsp, 8
+        0x90, 1,                      // DW_CFA_offset return address, cfa-8
+        0, 0,                         // padding
+    };
+    static const uint8_t fde_tail[] = {
+        0,                            // augmentation data length
+        0x0E, 64,                     // DW_CFA_def_cfa_offset 64
+        0x86, 2, 0x83, 3,             // rbp cfa-16, rbx cfa-24
+        0x8C, 4, 0x8D, 5,             // r12 cfa-32, r13 cfa-40
+        0x8E, 6, 0x8F, 7,             // r14 cfa-48, r15 cfa-56
+        0,                            // padding
+    };
+    uint8_t* eh = (uint8_t*)calloc(1, sizeof(cie) + 4 + 4 + 16 + sizeof(fde_tail) + 4);
+    if (!eh) return NULL;
+    uint8_t* p = eh;
+    memcpy(p, cie, sizeof(cie)); p += sizeof(cie);
+    uint32_t fde_len = 4 + 16 + sizeof(fde_tail);
+    uint32_t cie_ptr = (uint32_t)(p + 4 - eh);
+    uint64_t begin = (uint64_t)(uintptr_t)code, range = size;
+    memcpy(p, &fde_len, 4); p += 4;
+    memcpy(p, &cie_ptr, 4); p += 4;
+    memcpy(p, &begin, 8); p += 8;
+    memcpy(p, &range, 8); p += 8;
+    memcpy(p, fde_tail, sizeof(fde_tail));
+    // Zero terminator left by calloc
+    __register_frame(eh);
+    return eh;
+}
+
+static void jit_eh_frame_free(uint8_t* eh) {
+    if (!eh) return;
+    __deregister_frame(eh);
+    free(eh);
+}
+#else
+static uint8_t* jit_eh_frame(void* code, size_t size) { (void)code; (void)size; return NULL; }
+static void jit_eh_frame_free(uint8_t* eh) { (void)eh; }
+#endif
+
+static MyloAotFunc jit_compile(VM* vm, JitState* js, int entry, int end) {
+    if (end == -1) {
+        // A function entry: function() emits JMP-over right before the body
+        bool is_function = false;
+        for (int f = 0; f < vm->function_count; f++) {
+            if (vm->functions[f].addr == entry) is_function = true;
+        }
+        if (!is_function || entry < 2 || vm->bytecode[entry - 2] != OP_JMP) return NULL;
+        end = vm->bytecode[entry - 1];
+    }
+    if (entry < 0 || end <= entry || end > vm->code_size) return NULL;
+
+    JitBuild b;
+    memset(&b, 0, sizeof(b));
+    b.vm = vm;
+    b.entry = entry;
+    b.end = end;
+    b.label = (int*)malloc(sizeof(int) * (end - entry));
+    for (int i = 0; i < end - entry; i++) b.label[i] = -1;
+    Asm* a = &b.a;
+
+    // Prologue: save callee-saved registers, keep rsp 16-byte aligned for calls
+    EMIT(a, 0x55, 0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57); // push rbp, rbx, r12-r15
+    EMIT(a, 0x48, 0x83, 0xEC, 0x08);                                     // sub rsp, 8
+    EMIT(a, 0x48, 0x89, 0xFB);                                           // mov rbx, rdi
+    EMIT(a, 0x4C, 0x8B, 0xA3); emit32(a, OFF(stack));                    // mov r12, [rbx+stack]
+    EMIT(a, 0x4C, 0x8B, 0xBB); emit32(a, OFF(globals));                  // mov r15, [rbx+globals]
+    reload_regs(a);
+
+    int ip = entry;
+    while (ip < end) {
+        b.label[ip - entry] = a->len;
+        emit_op(&b, ip);
+        ip += vm_op_length(vm->bytecode, ip);
+    }
+    exit_to(&b, ip);
+
+    // Branches out of the region exit to the interpreter
+    for (int i = 0; i < b.fixup_count; i++) {
+        int t = b.fixups[i].target;
+        if (t == -2 || t == JIT_TARGET_EPILOGUE || (t >= entry && t < end && b.label[t - entry] >= 0)) continue;
+        int stub = a->len;
+        exit_to(&b, t);
+        for (int j = i; j < b.fixup_count; j++) {
+            if (b.fixups[j].target == t) {
+                patch32(a, b.fixups[j].slot, stub - (b.fixups[j].slot + 4));
+                b.fixups[j].target = -2; // Resolved
+            }
+        }
+    }
+    int epilogue = a->len;
+    sync_regs(a);
+    EMIT(a, 0x48, 0x83, 0xC4, 0x08);                                     // add rsp, 8
+    EMIT(a, 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0x5D); // pop r15-r12, rbx, rbp
+    emit1(a, 0xC3);
+
+    for (int i = 0; i < b.fixup_count; i++) {
+        int t = b.fixups[i].target;
+        if (t == -2) continue;
+        int dest = t == JIT_TARGET_EPILOGUE ? epilogue : b.label[t - entry];
+        patch32(a, b.fixups[i].slot, dest - (b.fixups[i].slot + 4));
+    }
+
+    // Copy into its own mapping and flip it to read + execute
+    MyloAotFunc fn = NULL;
+    long page = sysconf(_SC_PAGESIZE);
+    size_t size = ((size_t)a->len + page - 1) & ~(size_t)(page - 1);
+    void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem != MAP_FAILED) {
+        memcpy(mem, a->buf, a->len);
+        JitCode* jc = (JitCode*)malloc(sizeof(JitCode));
+        if (jc && mprotect(mem, size, PROT_READ | PROT_EXEC) == 0) {
+            jc->mem = mem;
+            jc->size = size;
+            jc->eh_frame = jit_eh_frame(mem, a->len);
+            do {
+                jc->next = __atomic_load_n(&js->code, __ATOMIC_ACQUIRE);
+            } while (!__atomic_compare_exchange_n(&js->code, &jc->next, jc, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+            fn = (MyloAotFunc)mem;
+        } else {
+            free(jc);
+            munmap(mem, size);
+        }
+    }
+
+    free(a->buf);
+    free(b.label);
+    free(b.fixups);
+    return fn;
+}
+
+bool jit_supported(void) {
+    return true;
+}
+
+#else
+
+static MyloAotFunc jit_compile(VM* vm, JitState* js, int entry, int end) {
+    (void)vm; (void)js; (void)entry; (void)end;
+    return NULL;
+}
+
+bool jit_supported(void) {
+    return false;
+}
+
+#endif
+
+// Called by the interpreter on calls and back-edges into an entry that has
+// no native code yet. The thread that takes it past the threshold compiles.
+static void jit_tick(VM* vm, int entry, int end) {
+    JitState* js = (JitState*)vm->image->jit;
+    if (entry < 0 || entry >= js->size) return;
+    int heat = __atomic_load_n(&js->heat[entry], __ATOMIC_RELAXED);
+    if (heat < 0) return;
+    if (heat + 1 < js->threshold) {
+        // Lost updates between workers only delay compiling
+        __atomic_store_n(&js->heat[entry], heat + 1, __ATOMIC_RELAXED);
+        return;
+    }
+    if (!__atomic_compare_exchange_n(&js->heat[entry], &heat, -1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) return;
+    MyloAotFunc fn = jit_compile(vm, js, entry, end);
+    if (fn) __atomic_store_n(&js->entries[entry], fn, __ATOMIC_RELEASE);
+}
+
+static void jit_release(ProgramImage* img) {
+    JitState* js = (JitState*)img->jit;
+    if (!js) return;
+#ifdef MYLO_JIT_X64
+    JitCode* jc = js->code;
+    while (jc) {
+        JitCode* next = jc->next;
+        jit_eh_frame_free(jc->eh_frame);
+        munmap(jc->mem, jc->size);
+        free(jc);
+        jc = next;
+    }
+#endif
+    if (img->aot == js->entries) img->aot = NULL;
+    free(js->entries);
+    free(js->heat);
+    free(js);
+    img->jit = NULL;
+    img->jit_tick = NULL;
+    img->jit_release = NULL;
+}
+
+void jit_attach(VM* vm, int threshold) {
+    ProgramImage* img = vm->image;
+    if (!jit_supported() || !img || img->jit || img->aot) return;
+    JitState* js = (JitState*)calloc(1, sizeof(JitState));
+    if (!js) return;
+    js->size = vm->code_size + 1;
+    js->threshold = threshold > 0 ? threshold : 1;
+    js->heat = (int*)calloc(js->size, sizeof(int));
+    js->entries = (MyloAotFunc*)calloc(js->size, sizeof(MyloAotFunc));
+    if (!js->heat || !js->entries) {
+        free(js->heat);
+        free(js->entries);
+        free(js);
+        return;
+    }
+    img->jit = js;
+    img->aot = js->entries;
+    img->jit_tick = jit_tick;
+    img->jit_release = jit_release;
+}
@@ -0,0 +1,20 @@
+#ifndef MYLO_JIT_H
+#define MYLO_JIT_H
+
+#include <stdbool.h>
+#include "vm.h"
+
+// --- Baseline JIT (--jit) ---
+// The interpreter counts calls into each function and loop back-edges. Once
+// an entry is hot, its bytecode is stitched from per-opcode x86-64 templates
+// into executable memory and registered in image->aot, the same table --build
+// fills. Ops without a template run through the interpreter one at a time.
+
+// True when this build can generate native code (x86-64, not Windows)
+bool jit_supported(void);
+
+// Turns the JIT on for vm's program image (shared with its workers). Entries
+// compile after `threshold` calls or back-edges. Call after parsing.
+void jit_attach(VM* vm, int threshold);
+
+#endif
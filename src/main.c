@@ -10,6 +10,8 @@
 #include "utils.h"
 #include "debug_adapter.h"
 #include "compiler.h"
+#include "jit.h"
+#include "profiler.h"
 // Defined in compiler.c
 // Note: Signatures updated to take VM*
 void parse(VM* vm, char* source);
@@ -29,8 +31,7 @@ void disassemble(VM* vm) {
     while (i < vm->code_size) {
         int op = vm->bytecode[i];
 
-        // Updated range check to include OP_EMBED
-        if (op < 0 || op > OP_DEBUGGER) {
+        if (op < 0 || op >= OP_COUNT) {
             printf("%04d UNKNOWN %d\n", i, op);
             i++;
             continue;
@@ -40,9 +41,22 @@ void disassemble(VM* vm) {
         i++;
 
         switch (op) {
+            case OP_PSH_NUM:
+            case OP_ADD_C:
+            case OP_SUB_C: {
+                int idx = vm->bytecode[i++];
+                printf("[%d] (%g)", idx, vm->constants[idx]);
+                break;
+            }
             case OP_JMP:
             case OP_JZ:
-            case OP_JNZ: {
+            case OP_JNZ:
+            case OP_LT_JZ:
+            case OP_EQ_JZ:
+            case OP_GT_JZ:
+            case OP_GE_JZ:
+            case OP_LE_JZ:
+            case OP_NEQ_JZ: {
                 int addr = vm->bytecode[i++];
                 printf("-> %04d", addr);
                 break;
@@ -59,6 +73,20 @@ void disassemble(VM* vm) {
                 printf("FP[%d]", off);
                 break;
             }
+            case OP_INC_LVAR:
+            case OP_INC_GVAR: {
+                int slot = vm->bytecode[i++];
+                int idx = vm->bytecode[i++];
+                printf("%s[%d] += %g", op == OP_INC_LVAR ? "FP" : "G", slot, vm->constants[idx]);
+                break;
+            }
+            case OP_LVAR_HGET: {
+                int slot = vm->bytecode[i++];
+                int off = vm->bytecode[i++];
+                int type_id = vm->bytecode[i++];
+                printf("FP[%d] (offset: %d, type_id: %d)", slot, off, type_id);
+                break;
+            }
             case OP_CALL: {
                 int target = vm->bytecode[i++];
                 int args = vm->bytecode[i++];
@@ -88,6 +116,18 @@ void disassemble(VM* vm) {
                 printf("(count: %d)", count);
                 break;
             }
+            case OP_MAKE_ARR: {
+                int count = vm->bytecode[i++];
+                int type_id = vm->bytecode[i++];
+                printf("(count: %d, type_id: %d)", count, type_id);
+                break;
+            }
+            case OP_CAST:
+            case OP_CHECK_TYPE: {
+                int type_id = vm->bytecode[i++];
+                printf("(type_id: %d)", type_id);
+                break;
+            }
             case OP_EMBED: {
                 int len = vm->bytecode[i++];
                 printf("(len: %d) <embedded data>", len);
@@ -113,6 +153,45 @@ void disassemble(VM* vm) {
     printf("-------------------\n\n");
 }
 
+// --stats: what the main VM did, printed after the program ends
+static int stats_op_cmp(const void* a, const void* b) {
+    const uint64_t* x = a;
+    const uint64_t* y = b;
+    return x[0] < y[0] ? 1 : (x[0] > y[0] ? -1 : 0);
+}
+
+void print_stats(VM* vm) {
+    MyloStats stats;
+    if (!vm_get_stats(vm, &stats)) {
+        printf("Note: this build has no statistics (configure with -DMYLO_STATS=ON).\n");
+        return;
+    }
+    printf("\n--- Statistics ---\n");
+
+    uint64_t total = 0;
+    uint64_t ops[OP_COUNT][2];
+    for (int i = 0; i < OP_COUNT; i++) {
+        ops[i][0] = stats.ops[i];
+        ops[i][1] = i;
+        total += stats.ops[i];
+    }
+    qsort(ops, OP_COUNT, sizeof(ops[0]), stats_op_cmp);
+    printf("Instructions: %llu\n", (unsigned long long)total);
+    for (int i = 0; i < OP_COUNT && ops[i][0]; i++) {
+        printf("  %-12s %14llu  %5.1f%%\n", OP_NAMES[ops[i][1]], (unsigned long long)ops[i][0], 100.0 * ops[i][0] / total);
+    }
+
+    printf("Heap allocations:\n");
+    for (int i = 0; i < MAX_ARENAS; i++) {
+        if (!stats.heap_allocs[i]) continue;
+        printf("  Region %-5d %14llu  %llu bytes\n", i, (unsigned long long)stats.heap_allocs[i], (unsigned long long)stats.heap_alloc_bytes[i]);
+    }
+    printf("Strings:      %14llu  made, %llu hits, %llu new\n",
+           (unsigned long long)stats.string_makes, (unsigned long long)stats.string_hits, (unsigned long long)stats.string_misses);
+    printf("Evacuations:  %14llu  %llu bytes copied\n", (unsigned long long)stats.evacuations, (unsigned long long)stats.evacuated_bytes);
+    printf("Rewinds:      %14llu  %llu bytes reclaimed\n", (unsigned long long)stats.rewinds, (unsigned long long)stats.rewound_bytes);
+}
+
 void print_greeting() {
     setTerminalColor(MyloFgMagenta, MyloBgColorDefault);
     printf("Mylo REPL v%s\n", VERSION_INFO);
@@ -148,6 +227,7 @@ void start_repl() {
         if (setjmp(repl_env) != 0) {
             // We just crashed! Reset state to survive.
             vm.sp = -1;       // Clear Stack
+            vm.run_depth = 0; // The longjmp skipped run_vm_from's unwind
             open_braces = 0;  // Reset multiline parsing
             buffer[0] = '\0'; // Clear input buffer
 
@@ -198,8 +278,8 @@ void start_repl() {
             run_vm_from(&vm, start_ip, false);
 
             if (vm.sp > stack_start) {
-                double val = vm.stack[vm.sp];
-                int type = vm.stack_types[vm.sp];
+                double val = VAL_AS_DOUBLE(vm.stack[vm.sp]);
+                int type = VAL_TYPE(vm.stack[vm.sp]);
 
                 // Simple printer
                 setTerminalColor(MyloFgCyan, MyloBgColorDefault);
@@ -270,6 +350,11 @@ void print_help() {
     PRINT_ARG("--dap",        "Enable DAP debugging interface (see VSCode Extension).");
     PRINT_ARG("--db",         "Debug mode, load the code and jump into an interactive debugger.");
     PRINT_ARG("--trace",      "Run as normal but print every VM state change.");
+    PRINT_ARG("--checked",    "Keep per-instruction stack checks even when the bytecode verifies.");
+    PRINT_ARG("--profile",    "Sample the running program, print its hottest functions and lines, write profile.folded.");
+    PRINT_ARG("--perf-counters", "Count time, ops, allocations and CPU events per function, write perf_counters.json.");
+    PRINT_ARG("--stats",      "Print opcode, allocation and string pool counts at exit (MYLO_STATS builds).");
+    PRINT_ARG("--jit",        "Compile hot functions and loops to native code while running (x86-64).");
     PRINT_ARG("--build",      "Build and generate a .c bootstrapping source file.");
     PRINT_ARG("--bind",       "Generate a .c source file binding for later interpreted or compiled dynamic linking.");
     PRINT_ARG("--bundle",     "Compile Mylo application and output mylo_exe (bundle bytecode and VM interpreter).");
@@ -333,6 +418,8 @@ int main(int argc, char** argv) {
 
     // 1. Check if WE are the program
     if (load_self_contained(&vm, argv[0])) {
+        // Bundled bytecode is fixed: verify it once and run it unchecked
+        vm_verify(&vm, NULL, 0);
         run_vm(&vm, false);
         vm_cleanup(&vm);
         return 0;
@@ -351,6 +438,11 @@ int main(int argc, char** argv) {
     bool repl_mode = false;
     bool cli_debug_mode = false; // Capture flag locally
     bool bundle_mode = false;
+    bool jit = false;
+    bool checked = false;
+    bool profile = false;
+    bool perf_counters = false;
+    bool stats = false;
 
     char* fn = NULL;
 
@@ -361,6 +453,11 @@ int main(int argc, char** argv) {
         else if (strcmp(argv[i], "--run") == 0) build_mode = false;
         else if (strcmp(argv[i], "--dump") == 0) dump = true;
         else if (strcmp(argv[i], "--trace") == 0) trace = true;
+        else if (strcmp(argv[i], "--jit") == 0) jit = true;
+        else if (strcmp(argv[i], "--checked") == 0) checked = true;
+        else if (strcmp(argv[i], "--profile") == 0) profile = true;
+        else if (strcmp(argv[i], "--perf-counters") == 0) perf_counters = true;
+        else if (strcmp(argv[i], "--stats") == 0) stats = true;
         else if (strcmp(argv[i], "--dap") == 0) debug_mode = true;
         else if (strcmp(argv[i], "--db") == 0) cli_debug_mode = true;
         else if (strcmp(argv[i], "--version") == 0) version = true;
@@ -384,6 +481,7 @@ int main(int argc, char** argv) {
     }
 
     MyloConfig.build_mode = build_mode;
+    MyloConfig.debug_mode = debug_mode;
     if(!fn) {
         printf("No input file provided.\n");
         return 1;
@@ -446,15 +544,53 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    if (dump) disassemble(&vm);
+    // Verified bytecode runs without per-instruction stack checks
+    char verify_error[256] = "";
+    bool verified = !checked && vm_verify(&vm, verify_error, sizeof(verify_error));
+
+    if (dump) {
+        disassemble(&vm);
+        if (verified) printf("Verifier: ok, unchecked execution\n");
+        else if (!checked) printf("Verifier: %s, running with stack checks\n", verify_error);
+    }
 
     // Start debugger immediately if flag is set
     if (vm.cli_debug_mode) {
         enter_debugger(&vm);
     }
 
+    // The profiler watches the interpreter, so it wins over --jit
+    if (profile && !profiler_supported()) {
+        printf("Note: --profile is not supported on this platform.\n");
+        profile = false;
+    }
+    if (profile || perf_counters) profiler_start(&vm, profile ? PROFILE_INTERVAL_US : 0);
+    if (perf_counters && !profiler_enable_counters(&vm)) {
+        printf("Note: hardware counters are unavailable, counting time, ops and allocations only.\n");
+    }
+
+    // Tracing and the debugger step the interpreter, so they win over --jit
+    if (jit && !trace && !vm.cli_debug_mode && !vm.profile) {
+        if (jit_supported()) jit_attach(&vm, JIT_HOT_THRESHOLD);
+        else printf("Note: --jit is not supported on this platform, interpreting.\n");
+    }
+
     run_vm(&vm, trace);
 
+    if (vm.profile) {
+        profiler_stop(&vm);
+        if (profile) {
+            profiler_report(&vm, stdout, 15);
+            if (profiler_write_folded(&vm, "profile.folded")) printf("\nFolded stacks written to profile.folded\n");
+        }
+        if (perf_counters) {
+            profiler_report_counters(&vm, stdout, 15);
+            if (profiler_write_counters_json(&vm, "perf_counters.json")) printf("\nCounters written to perf_counters.json\n");
+        }
+        profiler_free(&vm);
+    }
+    if (stats) print_stats(&vm);
+
     free(content);
     vm_cleanup(&vm);
     return 0;
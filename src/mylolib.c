@@ -22,6 +22,7 @@
 #include <fcntl.h>
 #include <pthread.h>
 #include <termios.h>
+#include <time.h>
 #include <unistd.h>
 #define STRDUP strdup
 
@@ -41,48 +42,103 @@
 #endif
 
 // --- Worker Structure ---
+typedef struct ParJob ParJob;
+
 typedef struct {
   bool active;
-  bool complete;
+  volatile long long complete; // Set by the pool thread, read atomically
   bool error;
   char error_msg[256];
-#ifdef _WIN32
-  HANDLE thread;
-  unsigned threadID;
-#else
-  pthread_t thread;
-#endif
-  VM vm;             // The Worker's Isolated VM
+  VM vm;             // The Worker's Isolated VM (kept warm between jobs)
   int region_id;     // The Region ID this worker owns
   MemoryArena arena; // The actual memory of that region
   char entry_func[64];
+  ParJob *par;       // Set for par_* chunks instead of a region job
+  int par_chunk;
+  int par_begin;
+  int par_end;
 } MyloWorker;
 
 static MyloWorker workers[MAX_WORKERS];
 static bool workers_initialized = false;
 
-// A simple global key-value store protected by a mutex
+// --- Worker Pool ---
+// A fixed set of threads, started on the first create_worker, that run
+// queued worker slots. Sized to the core count unless MYLO_WORKER_THREADS
+// is set.
+#ifdef _WIN32
+static HANDLE pool_threads[MAX_POOL_THREADS];
+static CRITICAL_SECTION pool_lock;
+static CONDITION_VARIABLE pool_wake; // Job queued
+static CONDITION_VARIABLE pool_done; // Job finished
+static CONDITION_VARIABLE task_done; // spawn() future completed
+#define LOCK_POOL EnterCriticalSection(&pool_lock)
+#define UNLOCK_POOL LeaveCriticalSection(&pool_lock)
+#define POOL_WAIT(cv) SleepConditionVariableCS(&(cv), &pool_lock, INFINITE)
+#define POOL_SIGNAL(cv) WakeConditionVariable(&(cv))
+#define POOL_BROADCAST(cv) WakeAllConditionVariable(&(cv))
+#else
+static pthread_t pool_threads[MAX_POOL_THREADS];
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_wake = PTHREAD_COND_INITIALIZER; // Job queued
+static pthread_cond_t pool_done = PTHREAD_COND_INITIALIZER; // Job finished
+static pthread_cond_t task_done = PTHREAD_COND_INITIALIZER; // spawn() future completed
+#define LOCK_POOL pthread_mutex_lock(&pool_lock)
+#define UNLOCK_POOL pthread_mutex_unlock(&pool_lock)
+#define POOL_WAIT(cv) pthread_cond_wait(&(cv), &pool_lock)
+#define POOL_SIGNAL(cv) pthread_cond_signal(&(cv))
+#define POOL_BROADCAST(cv) pthread_cond_broadcast(&(cv))
+#endif
+
+// par_* called from a worker runs inline rather than waiting on the pool
+static THREAD_LOCAL bool on_pool_thread = false;
+
+static int pool_size = 0;
+static int pool_queue[MAX_WORKERS]; // Ring of worker slots waiting to run
+static int pool_head = 0;
+static int pool_count = 0;
+// spawn() tasks sitting in the deques, and pool threads asleep on pool_wake.
+// Both are read without the lock: a spawner only takes it to wake someone.
+static volatile long long task_queued = 0;
+static volatile long long pool_idle = 0;
+
+// --- Universal Bus ---
+// A process-wide key-value store split into BUS_SHARDS shards by key hash,
+// so unrelated keys don't contend. Each shard is an open-addressing table
+// behind a reader-writer lock. Values are stored like channel messages:
+// numbers and enums by value, strings and objects packed (vm_pack_value)
+// and rebuilt in the reader's arena.
 typedef struct {
-  char *key;
-  int type;
-  double num_val;
-  char *str_val;
+  char *key; // NULL marks an empty slot
+  unsigned long hash;
+  Value val;
+  void *blob;
 } BusEntry;
 
-static BusEntry global_bus[MAX_BUS_ENTRIES];
-static int bus_count = 0;
-static bool bus_initialized = false;
+typedef struct {
+  BusEntry *entries;
+  int cap; // Power of two, kept at most half full
+  int count;
+#ifdef _WIN32
+  SRWLOCK lock;
+#else
+  pthread_rwlock_t lock;
+#endif
+} BusShard;
+
+static BusShard bus_shards[BUS_SHARDS];
 
 #ifdef _WIN32
-static CRITICAL_SECTION bus_lock;
-#define LOCK_BUS EnterCriticalSection(&bus_lock)
-#define UNLOCK_BUS LeaveCriticalSection(&bus_lock)
-#define INIT_BUS_LOCK InitializeCriticalSection(&bus_lock)
+#define BUS_READ_LOCK(s) AcquireSRWLockShared(&(s)->lock)
+#define BUS_READ_UNLOCK(s) ReleaseSRWLockShared(&(s)->lock)
+#define BUS_WRITE_LOCK(s) AcquireSRWLockExclusive(&(s)->lock)
+#define BUS_WRITE_UNLOCK(s) ReleaseSRWLockExclusive(&(s)->lock)
 #else
-static pthread_mutex_t bus_lock = PTHREAD_MUTEX_INITIALIZER;
-#define LOCK_BUS pthread_mutex_lock(&bus_lock)
-#define UNLOCK_BUS pthread_mutex_unlock(&bus_lock)
-#define INIT_BUS_LOCK // Static init is enough for pthreads
+static pthread_once_t bus_once = PTHREAD_ONCE_INIT;
+#define BUS_READ_LOCK(s) pthread_rwlock_rdlock(&(s)->lock)
+#define BUS_READ_UNLOCK(s) pthread_rwlock_unlock(&(s)->lock)
+#define BUS_WRITE_LOCK(s) pthread_rwlock_wrlock(&(s)->lock)
+#define BUS_WRITE_UNLOCK(s) pthread_rwlock_unlock(&(s)->lock)
 #endif
 
 void std_create_region(VM *vm) {
@@ -140,9 +196,29 @@ void std_clear_region(VM *vm) {
     printf("Cannot clear main region or invalid region\n");
     exit(1);
   }
+  if (id < MAX_ARENAS && vm->arenas[id].frozen) {
+    printf("Cannot clear frozen Region %d\n", id);
+    exit(1);
+  }
   free_arena(vm, id);
   vm_push(vm, 0, T_NUM);
 }
+
+// Makes a region read-only for the rest of the program. Workers, par_* chunks
+// and tasks started afterwards all read it in place instead of copying it.
+void std_freeze(VM *vm) {
+  int id = (int)vm_pop(vm);
+  if (id <= 0 || id >= MAX_ARENAS) {
+    printf("Cannot freeze main region or invalid region\n");
+    exit(1);
+  }
+  if (!vm->arenas[id].active || !vm->arenas[id].memory) {
+    printf("Region %d is not active or is owned by a worker\n", id);
+    exit(1);
+  }
+  vm->arenas[id].frozen = true;
+  vm_push(vm, 0, T_NUM);
+}
 // Implementation of std_copy (Deep Copy)
 void std_copy(VM *vm) {
   if (vm->sp < 0) {
@@ -151,11 +227,10 @@ void std_copy(VM *vm) {
     exit(1);
   }
 
-  double val = vm->stack[vm->sp];
-  int type = vm->stack_types[vm->sp];
-  vm->sp--; // Pop argument
+  Value v = vm_pop_value(vm);
+  double val = VAL_AS_DOUBLE(v);
 
-  if (type == T_OBJ) {
+  if (VAL_TYPE(v) == T_OBJ) {
     // Force a deep copy by pretending the object is in a "danger zone"
     // (target_head = 0) This copies it to the end of the current arena.
     double new_val = vm_evacuate_object(vm, val, 99999999);
@@ -166,58 +241,229 @@ void std_copy(VM *vm) {
     vm_push(vm, res, T_OBJ);
   } else {
     // Primitives copy by value
-    vm_push(vm, val, type);
+    vm_push_value(vm, v);
   }
 }
-// Helper to init the lock lazily
+// SRWLOCKs are valid zero-initialized; pthread rwlocks need an init call
+#ifndef _WIN32
+static void bus_init_locks() {
+  for (int i = 0; i < BUS_SHARDS; i++)
+    pthread_rwlock_init(&bus_shards[i].lock, NULL);
+}
+#endif
+
 static void init_bus() {
-  if (!bus_initialized) {
+#ifndef _WIN32
+  pthread_once(&bus_once, bus_init_locks);
+#endif
+}
+
+// Workers - Threading
+#ifdef _WIN32
+static unsigned __stdcall mylo_pool_entry(void *arg);
+#else
+static void *mylo_pool_entry(void *arg);
+#endif
+static bool task_run_next();
+
+static int pool_default_size() {
+  const char *env = getenv("MYLO_WORKER_THREADS");
+  int n = env ? atoi(env) : 0;
+  if (n <= 0) {
 #ifdef _WIN32
-    INIT_BUS_LOCK;
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    n = (int)info.dwNumberOfProcessors;
+#else
+    n = (int)sysconf(_SC_NPROCESSORS_ONLN);
 #endif
-    memset(global_bus, 0, sizeof(global_bus));
-    bus_initialized = true;
   }
+  if (n < 1)
+    n = 1;
+  if (n > MAX_POOL_THREADS)
+    n = MAX_POOL_THREADS;
+  return n;
 }
 
-// Workers - Threading
 static void init_workers() {
   if (!workers_initialized) {
     memset(workers, 0, sizeof(workers));
+#ifdef _WIN32
+    InitializeCriticalSection(&pool_lock);
+    InitializeConditionVariable(&pool_wake);
+    InitializeConditionVariable(&pool_done);
+    InitializeConditionVariable(&task_done);
+#endif
+    // Pool threads live for the rest of the process, blocked on the queue
+    pool_size = pool_default_size();
+    for (int i = 0; i < pool_size; i++) {
+#ifdef _WIN32
+      pool_threads[i] =
+          (HANDLE)_beginthreadex(NULL, 0, &mylo_pool_entry, NULL, 0, NULL);
+#else
+      pthread_create(&pool_threads[i], NULL, &mylo_pool_entry, NULL);
+      pthread_detach(pool_threads[i]);
+#endif
+    }
     workers_initialized = true;
   }
 }
 
 static const char *get_str(VM *vm, double val) {
   int id = (int)val;
-  if (id < 0 || id >= vm->str_count)
+  if (id < 0 || id >= vm->str_count || !vm->string_pool[id])
     return "";
   return vm->string_pool[id];
 }
 
-void trim_newline(char *str) {
-  int len = strlen(str);
-  if (len > 0 && str[len - 1] == '\n')
-    str[len - 1] = '\0';
-  if (len > 1 && str[len - 2] == '\r')
-    str[len - 2] = '\0';
+// Queues a prepared worker slot on the pool
+static void pool_submit(int slot) {
+  LOCK_POOL;
+  pool_queue[(pool_head + pool_count) % MAX_WORKERS] = slot;
+  pool_count++;
+  POOL_SIGNAL(pool_wake);
+  // A pool thread blocked in wait_workers may be the only one free to run it
+  POOL_BROADCAST(pool_done);
+  UNLOCK_POOL;
+}
+
+// Marks up to `want` free worker slots active and writes them to `slots`.
+// Workers create workers too, so the scan and the claim share pool_lock.
+static int pool_claim_slots(int *slots, int want) {
+  int got = 0;
+  LOCK_POOL;
+  for (int i = 0; i < MAX_WORKERS && got < want; i++) {
+    if (!workers[i].active) {
+      workers[i].active = true;
+      slots[got++] = i;
+    }
+  }
+  UNLOCK_POOL;
+  return got;
+}
+
+static void pool_release_slot(int slot) {
+  LOCK_POOL;
+  workers[slot].active = false;
+  UNLOCK_POOL;
+}
+
+// Takes the oldest queued slot (pool_lock held, pool_count > 0)
+static int pool_take() {
+  int slot = pool_queue[pool_head];
+  pool_head = (pool_head + 1) % MAX_WORKERS;
+  pool_count--;
+  return slot;
+}
+
+// --- List Callbacks ---
+// for_list, filter and the par_* builtins accept either a stdlib native or
+// a compiled Mylo function by name.
+static bool find_list_callback(VM *vm, const char *name, NativeFunc *native,
+                               int *addr) {
+  *native = NULL;
+  *addr = -1;
+  for (int i = 0; std_library[i].name != NULL; i++) {
+    if (strcmp(std_library[i].name, name) == 0) {
+      *native = std_library[i].func;
+      return true;
+    }
+  }
+  *addr = vm_find_function(vm, name);
+  return *addr != -1;
+}
+
+// Calls the callback with `argc` arguments and returns its result. The
+// caller restores vm->ip afterwards.
+static Value invoke_list_callback(VM *vm, NativeFunc native, int addr,
+                                  const Value *args, int argc) {
+  if (native) {
+    for (int i = 0; i < argc; i++)
+      vm_push_value(vm, args[i]);
+    native(vm);
+  } else {
+    vm_push(vm, (double)vm->code_size, T_NUM); // Return IP
+    vm_push(vm, (double)vm->fp, T_NUM);        // Return FP
+    for (int i = 0; i < argc; i++)
+      vm_push_value(vm, args[i]);
+    vm->fp = vm->sp - argc + 1;
+    run_vm_from(vm, addr, false);
+  }
+  return vm_pop_value(vm);
+}
+
+// --- Parallel List Jobs ---
+enum { PAR_MAP, PAR_FILTER, PAR_REDUCE };
+
+struct ParJob {
+  int mode;
+  NativeFunc native;
+  int addr;
+  const Value *items;  // The caller's array elements (read-only while running)
+  void **item_blobs;   // Packed copies of object items for other VMs
+  Value *results;      // Map/filter: one per item. Reduce: one per chunk
+  void **result_blobs; // Strings/objects produced on another VM, packed
+};
+
+static void par_store(VM *vm, ParJob *job, int idx, Value v, bool remote) {
+  int type = VAL_TYPE(v);
+  if (remote && (type == T_STR || type == T_OBJ)) {
+    job->result_blobs[idx] = vm_pack_value(vm, v, NULL);
+    v = VAL_NUM(0);
+  }
+  job->results[idx] = v;
+}
+
+// Applies the job's callback to items [begin, end). `remote` is set when
+// running on a worker VM: object items arrive packed, and string/object
+// results leave packed.
+static void par_apply(VM *vm, ParJob *job, int chunk, int begin, int end,
+                      bool remote) {
+  Value acc = VAL_NUM(0);
+  for (int i = begin; i < end; i++) {
+    Value x = job->items[i];
+    if (remote && job->item_blobs && job->item_blobs[i])
+      x = vm_unpack_value(vm, job->item_blobs[i]);
+    else if (remote && VAL_TYPE(x) == T_STR)
+      vm_pin_string(vm, VAL_AS_STR(x)); // Not rooted anywhere in this VM
+
+    if (job->mode == PAR_REDUCE) {
+      if (i == begin) {
+        acc = x;
+      } else {
+        Value args[2] = {acc, x};
+        acc = invoke_list_callback(vm, job->native, job->addr, args, 2);
+      }
+      continue;
+    }
+
+    Value r = invoke_list_callback(vm, job->native, job->addr, &x, 1);
+    if (job->mode == PAR_FILTER)
+      r = (VAL_IS_NUM(r) && VAL_AS_NUM(r) != 0.0) ? VAL_TRUE : VAL_FALSE;
+    par_store(vm, job, i, r, remote);
+  }
+  if (job->mode == PAR_REDUCE && end > begin)
+    par_store(vm, job, chunk, acc, remote);
 }
 
 // --- Thread Worker Function ---
 
-#ifdef _WIN32
-unsigned __stdcall mylo_worker_entry(void *arg) {
-#else
-void *mylo_worker_entry(void *arg) {
-#endif
-  MyloWorker *worker = (MyloWorker *)arg;
+// Runs one queued job on a pool thread
+static void mylo_worker_run(MyloWorker *worker) {
   VM *vm = &worker->vm;
 
   // 1. Inject the Region
   // We place the arena into the SAME slot ID it had in the parent.
   // This ensures pointers (which encode the Arena ID) remain valid.
-  vm->arenas[worker->region_id] = worker->arena;
-  vm->current_arena = worker->region_id;
+  // A frozen region is already mapped by vm_init_worker and can't take
+  // allocations, so those go to the worker's own main heap.
+  bool shared = worker->arena.frozen;
+  if (shared) {
+    vm->current_arena = 0;
+  } else {
+    vm->arenas[worker->region_id] = worker->arena;
+    vm->current_arena = worker->region_id;
+  }
 
   // 2. Locate Entry Point
   int func_addr = vm_find_function(vm, worker->entry_func);
@@ -246,21 +492,66 @@ void *mylo_worker_entry(void *arg) {
     run_vm_from(vm, func_addr, false);
   }
 
-  // 5. Extract Region State (Move Semantics: Take it back)
-  // The VM state might have updated the head/generation of the arena.
-  worker->arena = vm->arenas[worker->region_id];
+  if (!shared) {
+    // 5. Extract Region State (Move Semantics: Take it back)
+    // The VM state might have updated the head/generation of the arena.
+    worker->arena = vm->arenas[worker->region_id];
+
+    // 6. Protect Memory from Reuse
+    // We nullify the pointer in the VM so the next job's reset doesn't free
+    // the memory we want to return to the main thread.
+    vm->arenas[worker->region_id].memory = NULL;
+  }
+
+  // 7. Park the Worker VM (Drops the program image, keeps its allocations)
+  vm_park_worker(vm);
+}
 
-  // 6. Protect Memory from Cleanup
-  // We nullify the pointer in the VM so vm_cleanup doesn't free the memory
-  // we want to return to the main thread.
-  vm->arenas[worker->region_id].memory = NULL;
-  vm->arenas[worker->region_id].types = NULL;
+// Runs one par_* chunk on a pool thread
+static void mylo_chunk_run(MyloWorker *worker) {
+  VM *vm = &worker->vm;
+  par_apply(vm, worker->par, worker->par_chunk, worker->par_begin,
+            worker->par_end, true);
+  vm_park_worker(vm);
+}
 
-  // 7. Cleanup Worker VM (Frees code, stack, constants, etc.)
-  vm_cleanup(vm);
+// Runs a slot taken off the queue and marks it complete
+static void pool_run(int slot) {
+  if (workers[slot].par)
+    mylo_chunk_run(&workers[slot]);
+  else
+    mylo_worker_run(&workers[slot]);
 
-  worker->complete = true;
+  LOCK_POOL;
+  ATOMIC_STORE(&workers[slot].complete, 1);
+  POOL_BROADCAST(pool_done);
+  UNLOCK_POOL;
+}
 
+#ifdef _WIN32
+static unsigned __stdcall mylo_pool_entry(void *arg) {
+#else
+static void *mylo_pool_entry(void *arg) {
+#endif
+  (void)arg;
+  on_pool_thread = true;
+  for (;;) {
+    LOCK_POOL;
+    ATOMIC_ADD(&pool_idle, 1);
+    while (pool_count == 0 && ATOMIC_LOAD(&task_queued) <= 0)
+      POOL_WAIT(pool_wake);
+    ATOMIC_ADD(&pool_idle, -1);
+    if (pool_count == 0) {
+      // Woken for spawn() tasks: run them until the deques look empty
+      UNLOCK_POOL;
+      while (task_run_next())
+        ;
+      continue;
+    }
+    int slot = pool_take();
+    UNLOCK_POOL;
+    pool_run(slot);
+  }
 #ifdef _WIN32
   return 0;
 #else
@@ -268,6 +559,105 @@ void *mylo_worker_entry(void *arg) {
 #endif
 }
 
+
+// --- Completion Waits ---
+
+static double pool_now_ms() {
+#ifdef _WIN32
+  return (double)GetTickCount64();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
+
+// Sleeps on pool_done (pool_lock held) for at most `ms` milliseconds
+static void pool_wait_done_for(double ms) {
+#ifdef _WIN32
+  SleepConditionVariableCS(&pool_done, &pool_lock, (DWORD)ceil(ms));
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  long long ns = (long long)ts.tv_nsec + (long long)(ms * 1e6);
+  ts.tv_sec += (time_t)(ns / 1000000000LL);
+  ts.tv_nsec = (long)(ns % 1000000000LL);
+  pthread_cond_timedwait(&pool_done, &pool_lock, &ts);
+#endif
+}
+
+// Blocks until any (or, with `all`, every) listed slot has completed.
+// A negative timeout waits forever. Returns the index into `slots` of the
+// first completed worker (any), `count` (all) or -1 on timeout.
+// On a pool thread (a worker docking its own workers) queued jobs are run
+// inline while waiting, the way await() runs tasks: every pool thread may be
+// blocked here, leaving none to run them. A job run this way can overrun
+// the timeout.
+static int wait_workers(const int *slots, int count, bool all,
+                        double timeout_ms) {
+  double deadline = timeout_ms < 0 ? -1 : pool_now_ms() + timeout_ms;
+  int found = -1;
+  LOCK_POOL;
+  for (;;) {
+    int done = 0;
+    found = -1;
+    for (int i = 0; i < count; i++) {
+      if (ATOMIC_LOAD(&workers[slots[i]].complete)) {
+        done++;
+        if (found < 0)
+          found = i;
+      }
+    }
+    if (all ? done == count : found >= 0) {
+      if (all)
+        found = count;
+      break;
+    }
+    if (on_pool_thread && pool_count > 0) {
+      int slot = pool_take();
+      UNLOCK_POOL;
+      pool_run(slot);
+      LOCK_POOL;
+      continue;
+    }
+    if (deadline < 0) {
+      POOL_WAIT(pool_done);
+      continue;
+    }
+    double left = deadline - pool_now_ms();
+    if (left <= 0) {
+      found = -1;
+      break;
+    }
+    pool_wait_done_for(left);
+  }
+  UNLOCK_POOL;
+  return found;
+}
+
+// Collects the active worker ids from a Mylo array, skipping invalid and
+// repeated entries. Returns the number of slots written.
+static int collect_worker_slots(VM *vm, double list_ref, int type,
+                                const char *fname, int *slots) {
+  Value *base = type == T_OBJ ? vm_resolve_ptr(vm, list_ref) : NULL;
+  if (!base || (int)base[HEAP_OFFSET_TYPE] != TYPE_ARRAY) {
+    printf("Runtime Error: %s() expects an array of worker ids.\n", fname);
+    exit(1);
+  }
+  bool seen[MAX_WORKERS] = {false};
+  int len = (int)base[HEAP_OFFSET_LEN];
+  int count = 0;
+  for (int i = 0; i < len; i++) {
+    int slot = (int)VAL_AS_DOUBLE(base[HEAP_HEADER_ARRAY + i]);
+    if (slot < 0 || slot >= MAX_WORKERS || !workers[slot].active ||
+        seen[slot])
+      continue;
+    seen[slot] = true;
+    slots[count++] = slot;
+  }
+  return count;
+}
+
 // --- Standard Library Functions ---
 
 // std_create_worker(region, "function_name") -> worker_id
@@ -290,86 +680,40 @@ void std_create_worker(VM *vm) {
     exit(1);
   }
 
-  // 2. Find Slot
-  int slot = -1;
-  for (int i = 0; i < MAX_WORKERS; i++) {
-    if (!workers[i].active) {
-      slot = i;
-      break;
-    }
-  }
-
-  if (slot == -1) {
+  // 2. Claim a Slot
+  int slot;
+  if (pool_claim_slots(&slot, 1) == 0) {
     vm_push(vm, -1.0, T_NUM); // No free workers
     return;
   }
 
   MyloWorker *w = &workers[slot];
-  w->active = true;
-  w->complete = false;
+  ATOMIC_STORE(&w->complete, 0);
   w->error = false;
   w->region_id = region_id;
   strncpy(w->entry_func, func_name, 63);
 
   // 3. Move Semantics: Steal Arena from Main VM
+  // A frozen region stays with the main VM; any number of workers read it.
   w->arena = vm->arenas[region_id];
 
   // Disable in Main VM (It is now owned by the worker)
   // vm->arenas[region_id].active = false;
-  vm->arenas[region_id].memory =
-      NULL; // Prevent main VM from freeing it if it crashes
-  vm->arenas[region_id].types = NULL;
+  if (!w->arena.frozen)
+    vm->arenas[region_id].memory =
+        NULL; // Prevent main VM from freeing it if it crashes
 
   // 4. Initialize Worker VM
-  // We must clone the "Read-Only" parts of the VM (Code, Constants, Strings)
-  // so the worker has the same program definition.
-  VM *child = &w->vm;
-  vm_init(child);
-
-  // Copy Code
-  child->code_size = vm->code_size;
-  memcpy(child->bytecode, vm->bytecode, vm->code_size * sizeof(int));
-  memcpy(child->lines, vm->lines, vm->code_size * sizeof(int));
-
-  // Copy Constants
-  child->const_count = vm->const_count;
-  memcpy(child->constants, vm->constants, vm->const_count * sizeof(double));
-
-  // Copy Strings
-  child->str_count = vm->str_count;
-  memcpy(child->string_pool, vm->string_pool,
-         vm->str_count * MAX_STRING_LENGTH);
-
-  // Copy Function Table
-  child->function_count = vm->function_count;
-  memcpy(child->functions, vm->functions,
-         vm->function_count * sizeof(VMFunction));
-
-  // Copy Globals (Optional, but often needed for constants/config)
+  // The child shares the parent's program image (code, constants, function
+  // table) and gets its own stack, string pool and a copy of the globals.
+  // A slot reused from an earlier job keeps those allocations.
   // NOTE: Globals are copied by value. Workers do NOT share global state
   // updates.
-  child->global_symbol_count = vm->global_symbol_count;
-  // We don't have direct access to symbol names here easily without re-parsing,
-  // but the VM struct has global_symbols if debug info was generated.
-  // For runtime execution, we just need the values.
-  memcpy(child->globals, vm->globals, MAX_GLOBALS * sizeof(double));
-  memcpy(child->global_types, vm->global_types, MAX_GLOBALS * sizeof(int));
-
-  // Register Native Functions (Standard Library)
-  // We iterate the std_library array to re-bind pointers
-  int li = 0;
-  while (std_library[li].name != NULL) {
-    child->natives[li] = std_library[li].func;
-    li++;
-  }
-
-  // 5. Spawn Thread
-#ifdef _WIN32
-  w->thread =
-      (HANDLE)_beginthreadex(NULL, 0, &mylo_worker_entry, w, 0, &w->threadID);
-#else
-  pthread_create(&w->thread, NULL, &mylo_worker_entry, w);
-#endif
+  VM *child = &w->vm;
+  vm_init_worker(child, vm);
+
+  // 5. Queue on the Pool
+  pool_submit(slot);
 
   vm_push(vm, (double)slot, T_NUM);
 }
@@ -387,27 +731,26 @@ void std_dock_worker(VM *vm) {
 
   MyloWorker *w = &workers[slot];
 
-  // 1. Join Thread (Block)
-#ifdef _WIN32
-  WaitForSingleObject(w->thread, INFINITE);
-  CloseHandle(w->thread);
-#else
-  pthread_join(w->thread, NULL);
-#endif
+  // 1. Wait for the Job (Block)
+  wait_workers(&slot, 1, true, -1);
 
   if (w->error) {
     printf("Worker Error: %s\n", w->error_msg);
   }
 
   // 2. Restore Arena to Main VM
-  // We put it back in the exact same slot.
+  // We put it back in the exact same slot. Frozen regions never left.
   int rid = w->region_id;
-  vm->arenas[rid] = w->arena;
-  // Ensure it is marked active in Main
-  vm->arenas[rid].active = true;
+  if (!w->arena.frozen) {
+    vm->arenas[rid] = w->arena;
+    // Ensure it is marked active in Main
+    vm->arenas[rid].active = true;
+    // Strings the job stored in the region are ids in the worker's pool
+    vm_adopt_strings(vm, &w->vm, rid);
+  }
 
   // 3. Free Worker Slot
-  w->active = false;
+  pool_release_slot(slot);
 
   vm_push(vm, 0.0, T_NUM);
 }
@@ -423,13 +766,897 @@ void std_check_worker(VM *vm) {
     return;
   }
 
-  if (workers[slot].complete) {
+  if (ATOMIC_LOAD(&workers[slot].complete)) {
     vm_push(vm, 1.0, T_NUM);
   } else {
     vm_push(vm, 0.0, T_NUM);
   }
 }
 
+// std_wait_worker(worker_id, timeout_ms) -> status code
+// 1: Complete, 0: Timed out, -1: Invalid. A negative timeout waits forever.
+void std_wait_worker(VM *vm) {
+  double timeout_ms = vm_pop(vm);
+  int slot = (int)vm_pop(vm);
+
+  if (slot < 0 || slot >= MAX_WORKERS || !workers[slot].active) {
+    vm_push(vm, -1.0, T_NUM);
+    return;
+  }
+
+  int res = wait_workers(&slot, 1, true, timeout_ms);
+  vm_push(vm, res < 0 ? 0.0 : 1.0, T_NUM);
+}
+
+// std_wait_any([worker_ids]) -> worker_id
+// Blocks until one of the workers completes and returns its id (-1 if none
+// of the ids are active). The worker still needs to be docked.
+void std_wait_any(VM *vm) {
+  double list_ref = vm_pop(vm);
+  int type = VAL_TYPE(vm->stack[vm->sp + 1]);
+  int slots[MAX_WORKERS];
+  int count = collect_worker_slots(vm, list_ref, type, "wait_any", slots);
+
+  if (count == 0) {
+    vm_push(vm, -1.0, T_NUM);
+    return;
+  }
+
+  int idx = wait_workers(slots, count, false, -1);
+  vm_push(vm, (double)slots[idx], T_NUM);
+}
+
+// std_wait_all([worker_ids]) -> count
+// Blocks until every listed worker completes. Returns how many active
+// workers were waited on.
+void std_wait_all(VM *vm) {
+  double list_ref = vm_pop(vm);
+  int type = VAL_TYPE(vm->stack[vm->sp + 1]);
+  int slots[MAX_WORKERS];
+  int count = collect_worker_slots(vm, list_ref, type, "wait_all", slots);
+
+  if (count > 0)
+    wait_workers(slots, count, true, -1);
+  vm_push(vm, (double)count, T_NUM);
+}
+
+// --- Parallel List Builtins ---
+
+// Splits the job's items into chunks on the worker pool, or runs them inline
+// when the list is small, no slots are free or we are already on a worker.
+// Returns the number of chunks (reduce leaves one partial per chunk).
+static int par_execute(VM *vm, ParJob *job, int len) {
+  int chunks = 1;
+  int slots[MAX_POOL_THREADS];
+  if (!on_pool_thread && len >= 2 * PAR_MIN_CHUNK) {
+    init_workers();
+    int want = len / PAR_MIN_CHUNK;
+    if (want > pool_size)
+      want = pool_size;
+    chunks = pool_claim_slots(slots, want);
+    if (chunks == 1)
+      pool_release_slot(slots[0]);
+  }
+
+  int saved_ip = vm->ip;
+  if (chunks <= 1) {
+    par_apply(vm, job, 0, 0, len, false);
+    vm->ip = saved_ip;
+    return 1;
+  }
+
+  // Object items can't be resolved from another VM's arenas
+  for (int i = 0; i < len; i++) {
+    if (VAL_TYPE(job->items[i]) != T_OBJ)
+      continue;
+    if (!job->item_blobs)
+      job->item_blobs = (void **)calloc(len, sizeof(void *));
+    job->item_blobs[i] = vm_pack_value(vm, job->items[i], NULL);
+  }
+  job->result_blobs = (void **)calloc(len, sizeof(void *));
+
+  for (int c = 0; c < chunks; c++) {
+    MyloWorker *w = &workers[slots[c]];
+    w->error = false;
+    ATOMIC_STORE(&w->complete, 0);
+    w->par = job;
+    w->par_chunk = c;
+    w->par_begin = (int)((long long)len * c / chunks);
+    w->par_end = (int)((long long)len * (c + 1) / chunks);
+    vm_init_worker(&w->vm, vm);
+    pool_submit(slots[c]);
+  }
+  wait_workers(slots, chunks, true, -1);
+
+  for (int c = 0; c < chunks; c++) {
+    workers[slots[c]].par = NULL;
+    pool_release_slot(slots[c]);
+  }
+  if (job->item_blobs) {
+    for (int i = 0; i < len; i++)
+      free(job->item_blobs[i]);
+    free(job->item_blobs);
+  }
+  vm->ip = saved_ip;
+  return chunks;
+}
+
+// Returns a result in the caller's VM, rebuilding it if it was packed
+static Value par_take_result(VM *vm, ParJob *job, int idx) {
+  if (job->result_blobs && job->result_blobs[idx]) {
+    Value v = vm_unpack_value(vm, job->result_blobs[idx]);
+    free(job->result_blobs[idx]);
+    return v;
+  }
+  return job->results[idx];
+}
+
+// Pops (list, "fn") and prepares a job over the list's elements
+static int par_begin(VM *vm, ParJob *job, int mode, const char *fname) {
+  double func_val = vm_pop(vm);
+  int func_type = VAL_TYPE(vm->stack[vm->sp + 1]);
+  double list_ref = vm_pop(vm);
+  int list_type = VAL_TYPE(vm->stack[vm->sp + 1]);
+
+  Value *base = list_type == T_OBJ ? vm_resolve_ptr(vm, list_ref) : NULL;
+  if (!base || (int)base[HEAP_OFFSET_TYPE] != TYPE_ARRAY) {
+    printf("Runtime Error: %s() expects an array.\n", fname);
+    exit(1);
+  }
+  if (func_type != T_STR) {
+    printf("Runtime Error: %s() expects a function name.\n", fname);
+    exit(1);
+  }
+
+  memset(job, 0, sizeof(*job));
+  job->mode = mode;
+  const char *func_name = get_str(vm, func_val);
+  if (!find_list_callback(vm, func_name, &job->native, &job->addr)) {
+    printf("Runtime Error: %s() could not find function '%s'\n", fname,
+           func_name);
+    exit(1);
+  }
+  job->items = &base[HEAP_HEADER_ARRAY];
+  return (int)base[HEAP_OFFSET_LEN];
+}
+
+// std_par_map(list, "fn") -> array of fn(x), computed across the worker pool
+void std_par_map(VM *vm) {
+  ParJob job;
+  int len = par_begin(vm, &job, PAR_MAP, "par_map");
+  job.results = (Value *)malloc((len > 0 ? len : 1) * sizeof(Value));
+  par_execute(vm, &job, len);
+
+  double res_ptr = heap_alloc(vm, len + HEAP_HEADER_ARRAY);
+  Value *res_base = vm_resolve_ptr(vm, res_ptr);
+  res_base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
+  res_base[HEAP_OFFSET_LEN] = len;
+  for (int i = 0; i < len; i++)
+    res_base[HEAP_HEADER_ARRAY + i] = par_take_result(vm, &job, i);
+
+  free(job.results);
+  free(job.result_blobs);
+  vm_push(vm, res_ptr, T_OBJ);
+}
+
+// std_par_filter(list, "fn") -> elements where fn(x) is non-zero
+void std_par_filter(VM *vm) {
+  ParJob job;
+  int len = par_begin(vm, &job, PAR_FILTER, "par_filter");
+  job.results = (Value *)malloc((len > 0 ? len : 1) * sizeof(Value));
+  par_execute(vm, &job, len);
+
+  double res_ptr = heap_alloc(vm, len + HEAP_HEADER_ARRAY);
+  Value *res_base = vm_resolve_ptr(vm, res_ptr);
+  res_base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
+  int kept_count = 0;
+  for (int i = 0; i < len; i++) {
+    if (job.results[i] == VAL_TRUE)
+      res_base[HEAP_HEADER_ARRAY + kept_count++] = job.items[i];
+  }
+  res_base[HEAP_OFFSET_LEN] = kept_count;
+
+  free(job.results);
+  free(job.result_blobs);
+  vm_push(vm, res_ptr, T_OBJ);
+}
+
+// std_par_reduce(list, "fn", init) -> fn(...fn(fn(init, a), b)..., z)
+// Each chunk is folded separately and the partials are then folded onto
+// `init`, so fn must be associative.
+void std_par_reduce(VM *vm) {
+  Value acc = vm_pop_value(vm);
+  ParJob job;
+  int len = par_begin(vm, &job, PAR_REDUCE, "par_reduce");
+  if (len == 0) {
+    vm_push_value(vm, acc);
+    return;
+  }
+
+  job.results = (Value *)malloc(MAX_POOL_THREADS * sizeof(Value));
+  int chunks = par_execute(vm, &job, len);
+  int saved_ip = vm->ip;
+  for (int c = 0; c < chunks; c++) {
+    Value args[2] = {acc, par_take_result(vm, &job, c)};
+    acc = invoke_list_callback(vm, job.native, job.addr, args, 2);
+  }
+  vm->ip = saved_ip;
+
+  free(job.results);
+  free(job.result_blobs);
+  vm_push_value(vm, acc);
+}
+
+// --- Tasks ---
+// spawn() queues a call and returns a future; await() returns its value.
+// Every thread that runs tasks (pool threads, and any thread that waits in
+// await) owns a Chase-Lev deque and a task VM on the shared program image.
+// The owner pushes and pops at the bottom, other threads steal from the top.
+// A thread waiting in await runs queued tasks meanwhile, so recursive
+// divide-and-conquer doesn't need a thread per level.
+enum { FUTURE_FREE, FUTURE_PENDING, FUTURE_DONE };
+
+typedef struct {
+  volatile long long state;
+  long long gen; // Bumped on every reuse so stale ids are rejected
+  long long next_free;
+  NativeFunc native;
+  int addr;
+  int argc;
+  Value args[TASK_MAX_ARGS]; // Numbers and enums travel by value
+  void *arg_blob;            // Otherwise the argument array travels packed
+  Value result;
+  void *result_blob;
+} TaskFuture;
+
+typedef struct {
+  volatile long long top; // Next slot to steal
+  char pad0[64];
+  volatile long long bottom; // Next slot to push (owner only)
+  char pad1[64];
+  volatile long long items[TASK_DEQUE_SIZE];
+} TaskDeque;
+
+typedef struct {
+  TaskDeque deque;
+  VM *vm;          // Runs this thread's tasks, apart from any VM it hosts
+  long long epoch; // task_epoch the VM was last started from
+  int depth;       // Tasks currently running on this thread
+  unsigned int seed;
+} TaskThread;
+
+static TaskFuture futures[MAX_FUTURES];
+static volatile long long future_free = 0; // Tag << 32 | (index + 1)
+static volatile long long future_top = 0;  // Slots handed out so far
+
+static TaskThread *task_threads[MAX_TASK_THREADS];
+static volatile long long task_thread_count = 0;
+static THREAD_LOCAL TaskThread *task_self = NULL;
+static THREAD_LOCAL bool task_self_failed = false;
+
+// Task VMs start from task_template, a copy of the VM that spawned the
+// current batch. It is only rebuilt while no task is outstanding.
+static VM task_template;
+static VM *task_root = NULL;
+static long long task_epoch = 0;
+static volatile long long task_outstanding = 0;
+static volatile long long task_sleepers = 0; // Threads blocked in await
+
+static int future_alloc() {
+  for (;;) {
+    long long head = ATOMIC_LOAD(&future_free);
+    int idx = (int)(head & 0xFFFFFFFF) - 1;
+    if (idx < 0) {
+      long long top = ATOMIC_ADD(&future_top, 1);
+      return top < MAX_FUTURES ? (int)top : -1;
+    }
+    long long tag = ((head >> 32) + 1) & 0x7FFFFFFF;
+    if (ATOMIC_CAS(&future_free, head, (tag << 32) | futures[idx].next_free))
+      return idx;
+  }
+}
+
+static void future_release(int idx) {
+  TaskFuture *f = &futures[idx];
+  f->gen = (f->gen + 1) & 0xFFFFFFF;
+  ATOMIC_STORE(&f->state, FUTURE_FREE);
+  for (;;) {
+    long long head = ATOMIC_LOAD(&future_free);
+    f->next_free = head & 0xFFFFFFFF;
+    long long tag = ((head >> 32) + 1) & 0x7FFFFFFF;
+    if (ATOMIC_CAS(&future_free, head, (tag << 32) | (idx + 1)))
+      return;
+  }
+}
+
+static bool deque_push(TaskDeque *d, int idx) {
+  long long b = d->bottom;
+  if (b - ATOMIC_LOAD(&d->top) >= TASK_DEQUE_SIZE)
+    return false;
+  d->items[b & (TASK_DEQUE_SIZE - 1)] = idx;
+  ATOMIC_STORE(&d->bottom, b + 1);
+  return true;
+}
+
+// Owner end. Only races with thieves over the last item.
+static int deque_pop(TaskDeque *d) {
+  long long b = d->bottom - 1;
+  ATOMIC_STORE(&d->bottom, b);
+  ATOMIC_FENCE();
+  long long t = ATOMIC_LOAD(&d->top);
+  if (t > b) {
+    ATOMIC_STORE(&d->bottom, b + 1);
+    return -1;
+  }
+  int idx = (int)d->items[b & (TASK_DEQUE_SIZE - 1)];
+  if (t == b) {
+    if (!ATOMIC_CAS(&d->top, t, t + 1))
+      idx = -1;
+    ATOMIC_STORE(&d->bottom, b + 1);
+  }
+  return idx;
+}
+
+static int deque_steal(TaskDeque *d) {
+  long long t = ATOMIC_LOAD(&d->top);
+  ATOMIC_FENCE();
+  long long b = ATOMIC_LOAD(&d->bottom);
+  if (t >= b)
+    return -1;
+  int idx = (int)d->items[t & (TASK_DEQUE_SIZE - 1)];
+  if (!ATOMIC_CAS(&d->top, t, t + 1))
+    return -1;
+  return idx;
+}
+
+// The calling thread's deque and task VM, registered on first use. NULL once
+// MAX_TASK_THREADS threads have registered; such threads only run inline.
+static TaskThread *task_thread() {
+  if (task_self || task_self_failed)
+    return task_self;
+  long long n = ATOMIC_ADD(&task_thread_count, 1);
+  if (n >= MAX_TASK_THREADS) {
+    task_self_failed = true;
+    return NULL;
+  }
+  TaskThread *tt = (TaskThread *)calloc(1, sizeof(TaskThread));
+  tt->vm = (VM *)calloc(1, sizeof(VM));
+  tt->epoch = -1;
+  tt->seed = (unsigned int)n * 2654435761u + 1;
+  ATOMIC_FENCE();
+  task_threads[n] = tt;
+  task_self = tt;
+  return tt;
+}
+
+static int task_steal(TaskThread *tt) {
+  int n = (int)ATOMIC_LOAD(&task_thread_count);
+  if (n > MAX_TASK_THREADS)
+    n = MAX_TASK_THREADS;
+  tt->seed ^= tt->seed << 13;
+  tt->seed ^= tt->seed >> 17;
+  tt->seed ^= tt->seed << 5;
+  int start = (int)(tt->seed % (unsigned int)n);
+  for (int i = 0; i < n; i++) {
+    TaskThread *victim = task_threads[(start + i) % n];
+    if (!victim || victim == tt)
+      continue;
+    int idx = deque_steal(&victim->deque);
+    if (idx >= 0)
+      return idx;
+  }
+  return -1;
+}
+
+// Calls the future's function on `vm` and returns the result
+static Value task_call(VM *vm, TaskFuture *f) {
+  Value unpacked[TASK_MAX_ARGS];
+  const Value *args = f->args;
+  if (f->arg_blob) {
+    Value arr = vm_unpack_value(vm, f->arg_blob);
+    free(f->arg_blob);
+    f->arg_blob = NULL;
+    Value *base = vm_resolve_ptr(vm, VAL_AS_DOUBLE(arr));
+    memcpy(unpacked, &base[HEAP_HEADER_ARRAY], f->argc * sizeof(Value));
+    args = unpacked;
+  }
+  int saved_ip = vm->ip;
+  Value r = invoke_list_callback(vm, f->native, f->addr, args, f->argc);
+  vm->ip = saved_ip;
+  return r;
+}
+
+// Publishes the result (packed if it lives in `vm`'s heap) and wakes awaiters
+static void task_finish(TaskFuture *f, VM *vm, Value r) {
+  int type = VAL_TYPE(r);
+  if (type == T_STR || type == T_OBJ) {
+    f->result_blob = vm_pack_value(vm, r, NULL);
+    r = VAL_NUM(0);
+  }
+  f->result = r;
+  ATOMIC_STORE(&f->state, FUTURE_DONE);
+  if (ATOMIC_LOAD(&task_sleepers) > 0) {
+    LOCK_POOL;
+    POOL_BROADCAST(task_done);
+    UNLOCK_POOL;
+  }
+}
+
+// Runs a queued task on this thread's task VM. At the outermost level the VM
+// is brought up to the current epoch first and its heap is rewound after.
+static void task_run(TaskThread *tt, int idx) {
+  TaskFuture *f = &futures[idx];
+  VM *vm = tt->vm;
+  int mark = 0;
+  if (tt->depth == 0) {
+    if (tt->epoch != task_epoch) {
+      vm_init_worker(vm, &task_template);
+      tt->epoch = task_epoch;
+    }
+    vm->sp = -1;
+    vm->fp = 0;
+    mark = vm->arenas[vm->current_arena].head;
+  }
+  tt->depth++;
+  Value r = task_call(vm, f);
+  tt->depth--;
+  task_finish(f, vm, r);
+  ATOMIC_ADD(&task_outstanding, -1);
+  if (tt->depth == 0) {
+    vm_rewind_heap(vm, mark);
+    vm->sp = -1;
+  }
+}
+
+// A stolen task runs on top of whatever this thread is awaiting in, so only
+// steal while the task VM has room left for a deep call chain.
+static bool task_can_steal(TaskThread *tt) {
+  if (tt->depth == 0)
+    return true;
+  return tt->depth < TASK_MAX_NEST && tt->vm->scope_sp < MAX_SCOPES / 2 &&
+         tt->vm->sp < STACK_SIZE / 2;
+}
+
+// Runs one task from our own deque, or stolen from another thread. Returns
+// false when nothing could be taken.
+static bool task_run_next() {
+  TaskThread *tt = task_thread();
+  if (!tt)
+    return false;
+  int idx = deque_pop(&tt->deque);
+  if (idx < 0 && task_can_steal(tt))
+    idx = task_steal(tt);
+  if (idx < 0)
+    return false;
+  ATOMIC_ADD(&task_queued, -1);
+  task_run(tt, idx);
+  return true;
+}
+
+// Points task_template at `vm` for a new batch (pool lock held, nothing
+// outstanding). Skipped when nothing changed since the last batch.
+static void task_rebase(VM *vm) {
+  bool same = task_root == vm && task_template.image == vm->image &&
+              memcmp(task_template.globals, vm->globals,
+                     MAX_GLOBALS * sizeof(Value)) == 0;
+  for (int i = 1; same && i < MAX_ARENAS; i++)
+    same = task_template.arenas[i].frozen == vm->arenas[i].frozen;
+  if (same)
+    return;
+  vm_init_worker(&task_template, vm);
+  task_root = vm;
+  task_epoch++;
+}
+
+// Queues the future on this thread's deque. Fails when the deque is full, or
+// when `vm` can't start a batch because another one is still outstanding.
+static bool task_queue(VM *vm, int idx) {
+  TaskThread *tt = task_thread();
+  if (!tt)
+    return false;
+  bool queued = false;
+  if (vm == tt->vm) {
+    // Spawned from inside a task: the batch is already running
+    ATOMIC_ADD(&task_outstanding, 1);
+    queued = deque_push(&tt->deque, idx);
+    if (!queued)
+      ATOMIC_ADD(&task_outstanding, -1);
+  } else {
+    LOCK_POOL;
+    if (ATOMIC_LOAD(&task_outstanding) == 0)
+      task_rebase(vm);
+    if (task_root == vm && task_template.image == vm->image) {
+      ATOMIC_ADD(&task_outstanding, 1);
+      queued = deque_push(&tt->deque, idx);
+      if (!queued)
+        ATOMIC_ADD(&task_outstanding, -1);
+    }
+    UNLOCK_POOL;
+  }
+  if (!queued)
+    return false;
+
+  ATOMIC_ADD(&task_queued, 1);
+  if (ATOMIC_LOAD(&pool_idle) > 0) {
+    LOCK_POOL;
+    POOL_SIGNAL(pool_wake);
+    UNLOCK_POOL;
+  }
+  return true;
+}
+
+// std_spawn("fn", [args]) -> future
+void std_spawn(VM *vm) {
+  init_workers();
+  Value args_val = vm_pop_value(vm);
+  double func_val = vm_pop(vm);
+  int func_type = VAL_TYPE(vm->stack[vm->sp + 1]);
+
+  Value *base = VAL_TYPE(args_val) == T_OBJ
+                    ? vm_resolve_ptr(vm, VAL_AS_DOUBLE(args_val))
+                    : NULL;
+  if (!base || (int)base[HEAP_OFFSET_TYPE] != TYPE_ARRAY) {
+    printf("Runtime Error: spawn() expects an array of arguments.\n");
+    exit(1);
+  }
+  if (func_type != T_STR) {
+    printf("Runtime Error: spawn() expects a function name.\n");
+    exit(1);
+  }
+  int argc = (int)base[HEAP_OFFSET_LEN];
+  if (argc > TASK_MAX_ARGS) {
+    printf("Runtime Error: spawn() takes at most %d arguments.\n",
+           TASK_MAX_ARGS);
+    exit(1);
+  }
+
+  NativeFunc native;
+  int addr;
+  const char *func_name = get_str(vm, func_val);
+  if (!find_list_callback(vm, func_name, &native, &addr)) {
+    printf("Runtime Error: spawn() could not find function '%s'\n",
+           func_name);
+    exit(1);
+  }
+
+  int idx = future_alloc();
+  if (idx < 0) {
+    printf("Runtime Error: Too many pending futures (max %d).\n",
+           MAX_FUTURES);
+    exit(1);
+  }
+  TaskFuture *f = &futures[idx];
+  f->native = native;
+  f->addr = addr;
+  f->argc = argc;
+  f->arg_blob = NULL;
+  f->result_blob = NULL;
+  for (int i = 0; i < argc; i++) {
+    Value a = base[HEAP_HEADER_ARRAY + i];
+    if (VAL_TYPE(a) == T_STR || VAL_TYPE(a) == T_OBJ) {
+      f->arg_blob = vm_pack_value(vm, args_val, NULL);
+      break;
+    }
+    f->args[i] = a;
+  }
+  ATOMIC_STORE(&f->state, FUTURE_PENDING);
+  double id = (double)f->gen * MAX_FUTURES + idx;
+
+  if (!task_queue(vm, idx))
+    task_finish(f, vm, task_call(vm, f)); // Run it now instead
+
+  vm_push(vm, id, T_NUM);
+}
+
+// std_await(future) -> the spawned function's return value
+// Runs other queued tasks while the future is still pending.
+void std_await(VM *vm) {
+  double id_val = vm_pop(vm);
+  long long id = (long long)id_val;
+  int idx = (int)(id % MAX_FUTURES);
+  if (id < 0 || futures[idx].gen != id / MAX_FUTURES ||
+      ATOMIC_LOAD(&futures[idx].state) == FUTURE_FREE) {
+    printf("Runtime Error: await() on an invalid future %lld\n", id);
+    exit(1);
+  }
+
+  TaskFuture *f = &futures[idx];
+  TaskThread *tt = task_thread();
+  while (ATOMIC_LOAD(&f->state) != FUTURE_DONE) {
+    if (task_run_next())
+      continue;
+    bool can_steal = tt && task_can_steal(tt);
+    LOCK_POOL;
+    ATOMIC_ADD(&task_sleepers, 1);
+    if (ATOMIC_LOAD(&f->state) != FUTURE_DONE &&
+        !(can_steal && ATOMIC_LOAD(&task_queued) > 0))
+      POOL_WAIT(task_done);
+    ATOMIC_ADD(&task_sleepers, -1);
+    UNLOCK_POOL;
+  }
+
+  Value r = f->result;
+  if (f->result_blob) {
+    r = vm_unpack_value(vm, f->result_blob);
+    free(f->result_blob);
+    f->result_blob = NULL;
+  }
+  future_release(idx);
+  vm_push_value(vm, r);
+}
+
+// --- Channels ---
+// Bounded multi-producer/multi-consumer queues shared by every VM in the
+// process. The ring is lock-free (per-cell sequence numbers); the mutex and
+// condition variable are only touched when a sender finds it full or a
+// receiver finds it empty.
+// chan_close frees the ring and puts the slot on a free list. The struct
+// itself is kept for the next chan_create, and ids carry the slot's
+// generation (gen * MAX_CHANNELS + slot) so a closed id stays invalid.
+typedef struct {
+  volatile long long seq;
+  Value val;  // Numbers and enums travel by value
+  void *blob; // Strings and objects travel packed (vm_pack_value)
+} ChanCell;
+
+typedef struct {
+  ChanCell *cells;
+  long long mask;
+  char pad0[64];
+  volatile long long send_pos;
+  char pad1[64];
+  volatile long long recv_pos;
+  char pad2[64];
+  volatile long long waiters; // Threads sleeping in send/recv
+  int gen;                    // Bumped by chan_close
+  long long next_free;        // Free list link (slot + 1), 0 = end
+#ifdef _WIN32
+  CRITICAL_SECTION lock;
+  CONDITION_VARIABLE cond;
+#else
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+#endif
+} MyloChannel;
+
+#ifdef _WIN32
+#define CHAN_LOCK(c) EnterCriticalSection(&(c)->lock)
+#define CHAN_UNLOCK(c) LeaveCriticalSection(&(c)->lock)
+#define CHAN_WAIT(c) SleepConditionVariableCS(&(c)->cond, &(c)->lock, INFINITE)
+#define CHAN_WAKE(c) WakeAllConditionVariable(&(c)->cond)
+#else
+#define CHAN_LOCK(c) pthread_mutex_lock(&(c)->lock)
+#define CHAN_UNLOCK(c) pthread_mutex_unlock(&(c)->lock)
+#define CHAN_WAIT(c) pthread_cond_wait(&(c)->cond, &(c)->lock)
+#define CHAN_WAKE(c) pthread_cond_broadcast(&(c)->cond)
+#endif
+
+static MyloChannel *channels[MAX_CHANNELS];
+static volatile long long channel_free = 0; // Tag << 32 | (slot + 1)
+static volatile long long channel_top = 0;  // Slots handed out so far
+
+static int chan_slot_alloc() {
+  for (;;) {
+    long long head = ATOMIC_LOAD(&channel_free);
+    int idx = (int)(head & 0xFFFFFFFF) - 1;
+    if (idx < 0) {
+      long long top = ATOMIC_ADD(&channel_top, 1);
+      return top < MAX_CHANNELS ? (int)top : -1;
+    }
+    long long tag = ((head >> 32) + 1) & 0x7FFFFFFF;
+    if (ATOMIC_CAS(&channel_free, head, (tag << 32) | channels[idx]->next_free))
+      return idx;
+  }
+}
+
+static void chan_slot_release(int idx) {
+  for (;;) {
+    long long head = ATOMIC_LOAD(&channel_free);
+    channels[idx]->next_free = head & 0xFFFFFFFF;
+    long long tag = ((head >> 32) + 1) & 0x7FFFFFFF;
+    if (ATOMIC_CAS(&channel_free, head, (tag << 32) | (idx + 1)))
+      return;
+  }
+}
+
+static bool chan_try_send(MyloChannel *c, Value val, void *blob) {
+  long long pos = ATOMIC_LOAD(&c->send_pos);
+  ChanCell *cell;
+  for (;;) {
+    cell = &c->cells[pos & c->mask];
+    long long diff = ATOMIC_LOAD(&cell->seq) - pos;
+    if (diff == 0 && ATOMIC_CAS(&c->send_pos, pos, pos + 1))
+      break;
+    if (diff < 0)
+      return false; // Full
+    pos = ATOMIC_LOAD(&c->send_pos);
+  }
+  cell->val = val;
+  cell->blob = blob;
+  ATOMIC_STORE(&cell->seq, pos + 1);
+  return true;
+}
+
+static bool chan_try_take(MyloChannel *c, Value *val, void **blob) {
+  long long pos = ATOMIC_LOAD(&c->recv_pos);
+  ChanCell *cell;
+  for (;;) {
+    cell = &c->cells[pos & c->mask];
+    long long diff = ATOMIC_LOAD(&cell->seq) - (pos + 1);
+    if (diff == 0 && ATOMIC_CAS(&c->recv_pos, pos, pos + 1))
+      break;
+    if (diff < 0)
+      return false; // Empty
+    pos = ATOMIC_LOAD(&c->recv_pos);
+  }
+  *val = cell->val;
+  *blob = cell->blob;
+  ATOMIC_STORE(&cell->seq, pos + c->mask + 1);
+  return true;
+}
+
+// Wakes sleepers after a send or receive changed the ring. The fence pairs
+// with the one in the sleeper so either it sees our change or we see it.
+static void chan_notify(MyloChannel *c) {
+  ATOMIC_FENCE();
+  if (ATOMIC_LOAD(&c->waiters) > 0) {
+    CHAN_LOCK(c);
+    CHAN_WAKE(c);
+    CHAN_UNLOCK(c);
+  }
+}
+
+static void chan_send_blocking(MyloChannel *c, Value val, void *blob) {
+  while (!chan_try_send(c, val, blob)) {
+    CHAN_LOCK(c);
+    ATOMIC_ADD(&c->waiters, 1);
+    ATOMIC_FENCE();
+    bool sent = chan_try_send(c, val, blob);
+    if (!sent)
+      CHAN_WAIT(c);
+    ATOMIC_ADD(&c->waiters, -1);
+    CHAN_UNLOCK(c);
+    if (sent)
+      break;
+  }
+  chan_notify(c);
+}
+
+static void chan_take_blocking(MyloChannel *c, Value *val, void **blob) {
+  while (!chan_try_take(c, val, blob)) {
+    CHAN_LOCK(c);
+    ATOMIC_ADD(&c->waiters, 1);
+    ATOMIC_FENCE();
+    bool taken = chan_try_take(c, val, blob);
+    if (!taken)
+      CHAN_WAIT(c);
+    ATOMIC_ADD(&c->waiters, -1);
+    CHAN_UNLOCK(c);
+    if (taken)
+      break;
+  }
+  chan_notify(c);
+}
+
+static MyloChannel *get_channel(double id_val, const char *fname) {
+  long long id = (long long)id_val;
+  int idx = (int)(id % MAX_CHANNELS);
+  MyloChannel *c = id < 0 ? NULL : channels[idx];
+  if (!c || !c->cells || c->gen != id / MAX_CHANNELS) {
+    printf("Runtime Error: %s() on invalid channel %lld.\n", fname, id);
+    exit(1);
+  }
+  return c;
+}
+
+// Materializes a received message in the receiving VM's current arena
+static void chan_push_message(VM *vm, Value val, void *blob) {
+  if (blob) {
+    val = vm_unpack_value(vm, blob);
+    free(blob);
+  }
+  vm_push_value(vm, val);
+}
+
+// std_chan_create(capacity) -> channel_id (-1 if none are left)
+// Capacity is rounded up to a power of two.
+void std_chan_create(VM *vm) {
+  int want = (int)vm_pop(vm);
+  long long cap = 1;
+  while (cap < want && cap < (1 << 20))
+    cap <<= 1;
+
+  int idx = chan_slot_alloc();
+  if (idx < 0) {
+    vm_push(vm, -1.0, T_NUM);
+    return;
+  }
+
+  MyloChannel *c = channels[idx];
+  if (!c) {
+    c = (MyloChannel *)calloc(1, sizeof(MyloChannel));
+#ifdef _WIN32
+    InitializeCriticalSection(&c->lock);
+    InitializeConditionVariable(&c->cond);
+#else
+    pthread_mutex_init(&c->lock, NULL);
+    pthread_cond_init(&c->cond, NULL);
+#endif
+  }
+  c->mask = cap - 1;
+  c->send_pos = 0;
+  c->recv_pos = 0;
+  c->cells = (ChanCell *)calloc((size_t)cap, sizeof(ChanCell));
+  for (long long i = 0; i < cap; i++)
+    c->cells[i].seq = i;
+  channels[idx] = c;
+  vm_push(vm, (double)c->gen * MAX_CHANNELS + idx, T_NUM);
+}
+
+// std_chan_close(channel) -> void
+// Frees the ring, and any messages still in it, and recycles the id. The
+// caller must be the last user: closing a channel that a thread is blocked
+// on is an error.
+void std_chan_close(VM *vm) {
+  double id_val = vm_pop(vm);
+  MyloChannel *c = get_channel(id_val, "chan_close");
+  if (ATOMIC_LOAD(&c->waiters) > 0) {
+    printf("Runtime Error: chan_close() on channel %lld while a thread is "
+           "waiting on it.\n",
+           (long long)id_val);
+    exit(1);
+  }
+  Value val;
+  void *blob;
+  while (chan_try_take(c, &val, &blob))
+    free(blob);
+  free(c->cells);
+  c->cells = NULL;
+  c->gen = (c->gen + 1) & 0xFFFFFF;
+  chan_slot_release((int)((long long)id_val % MAX_CHANNELS));
+  vm_push(vm, 0, T_NUM);
+}
+
+// std_chan_send(channel, value) -> 1
+// Blocks while the channel is full. Strings and objects are deep-copied.
+void std_chan_send(VM *vm) {
+  Value v = vm_pop_value(vm);
+  MyloChannel *c = get_channel(vm_pop(vm), "chan_send");
+
+  int type = VAL_TYPE(v);
+  void *blob = NULL;
+  if (type == T_STR || type == T_OBJ)
+    blob = vm_pack_value(vm, v, NULL);
+
+  chan_send_blocking(c, v, blob);
+  vm_push(vm, 1.0, T_NUM);
+}
+
+// std_chan_recv(channel) -> value
+// Blocks until a message arrives.
+void std_chan_recv(VM *vm) {
+  MyloChannel *c = get_channel(vm_pop(vm), "chan_recv");
+  Value val;
+  void *blob;
+  chan_take_blocking(c, &val, &blob);
+  chan_push_message(vm, val, blob);
+}
+
+// std_chan_try_recv(channel, fallback) -> value
+// Returns `fallback` straight away if the channel is empty.
+void std_chan_try_recv(VM *vm) {
+  Value fallback = vm_pop_value(vm);
+  MyloChannel *c = get_channel(vm_pop(vm), "chan_try_recv");
+  Value val;
+  void *blob;
+  if (!chan_try_take(c, &val, &blob)) {
+    vm_push_value(vm, fallback);
+    return;
+  }
+  chan_notify(c);
+  chan_push_message(vm, val, blob);
+}
+
 // --- Previous Standard Lib Functions (unchanged) ---
 
 void std_sqrt(VM *vm) { vm_push(vm, sqrt(vm_pop(vm)), T_NUM); }
@@ -441,7 +1668,7 @@ void std_ceil(VM *vm) { vm_push(vm, ceil(vm_pop(vm)), T_NUM); }
 
 void std_type(VM *vm) {
   double val = vm_pop(vm);
-  int type = vm->stack_types[vm->sp + 1];
+  int type = VAL_TYPE(vm->stack[vm->sp + 1]);
 
   int str_id = -1;
   if (type == T_NUM) {
@@ -454,7 +1681,7 @@ void std_type(VM *vm) {
     int type_str_id = (packed >> 32) & 0xFFFF;
     str_id = type_str_id;
   } else if (type == T_OBJ) {
-    double *base = vm_resolve_ptr_safe(vm, val);
+    Value *base = vm_resolve_ptr_safe(vm, val);
     if (base) {
       int obj_type = (int)base[0];
       if (obj_type == TYPE_ARRAY)
@@ -485,8 +1712,8 @@ void std_type(VM *vm) {
 void std_len(VM *vm) {
   double val = vm_pop(vm);
 
-  if (vm->stack_types[vm->sp + 1] == T_OBJ) {
-    double *base = vm_resolve_ptr(vm, val);
+  if (VAL_TYPE(vm->stack[vm->sp + 1]) == T_OBJ) {
+    Value *base = vm_resolve_ptr(vm, val);
     if (!base) {
       vm_push(vm, 0, T_NUM);
       return;
@@ -503,7 +1730,7 @@ void std_len(VM *vm) {
       printf("Runtime Error: len() expects array, string, map, or bytes.\n");
       exit(1);
     }
-  } else if (vm->stack_types[vm->sp + 1] == T_STR) {
+  } else if (VAL_TYPE(vm->stack[vm->sp + 1]) == T_STR) {
     const char *s = get_str(vm, val);
     vm_push(vm, (double)strlen(s), T_NUM);
   } else {
@@ -513,9 +1740,9 @@ void std_len(VM *vm) {
 }
 void std_contains(VM *vm) {
   double needle_val = vm_pop(vm);
-  int needle_type = vm->stack_types[vm->sp + 1];
+  int needle_type = VAL_TYPE(vm->stack[vm->sp + 1]);
   double haystack_val = vm_pop(vm);
-  int haystack_type = vm->stack_types[vm->sp + 1];
+  int haystack_type = VAL_TYPE(vm->stack[vm->sp + 1]);
 
   if (haystack_type == T_STR) {
     if (needle_type != T_STR) {
@@ -530,8 +1757,7 @@ void std_contains(VM *vm) {
   }
 
   if (haystack_type == T_OBJ) {
-    double *base = vm_resolve_ptr(vm, haystack_val);
-    int *types = vm_resolve_type(vm, haystack_val);
+    Value *base = vm_resolve_ptr(vm, haystack_val);
     if (!base) {
       vm_push(vm, 0.0, T_NUM);
       return;
@@ -543,8 +1769,8 @@ void std_contains(VM *vm) {
       int len = (int)base[HEAP_OFFSET_LEN];
       int found = 0;
       for (int i = 0; i < len; i++) {
-        if (types[HEAP_HEADER_ARRAY + i] == needle_type &&
-            base[HEAP_HEADER_ARRAY + i] == needle_val) {
+        if (VAL_TYPE(base[HEAP_HEADER_ARRAY + i]) == needle_type &&
+            VAL_AS_DOUBLE(base[HEAP_HEADER_ARRAY + i]) == needle_val) {
           found = 1;
           break;
         }
@@ -556,19 +1782,7 @@ void std_contains(VM *vm) {
         printf("Runtime Error: contains() map check requires string key\n");
         exit(1);
       }
-      int count = (int)base[HEAP_OFFSET_COUNT];
-      double dataPtrVal = base[HEAP_OFFSET_DATA];
-      double *data = vm_resolve_ptr(vm, dataPtrVal);
-
-      int found = 0;
-      if (data) {
-        for (int i = 0; i < count; i++) {
-          if (data[i * 2] == needle_val) {
-            found = 1;
-            break;
-          }
-        }
-      }
+      int found = vm_map_find(vm, base, VAL_STR((int)needle_val)) != -1;
       vm_push(vm, found ? 1.0 : 0.0, T_NUM);
       return;
     }
@@ -579,7 +1793,7 @@ void std_contains(VM *vm) {
 
 void std_to_string(VM *vm) {
   double val = vm_pop(vm);
-  int type = vm->stack_types[vm->sp + 1];
+  int type = VAL_TYPE(vm->stack[vm->sp + 1]);
 
   if (type == T_NUM) {
     char buf[64];
@@ -605,7 +1819,7 @@ void std_to_string(VM *vm) {
 
 void std_to_num(VM *vm) {
   double val = vm_pop(vm);
-  int type = vm->stack_types[vm->sp + 1];
+  int type = VAL_TYPE(vm->stack[vm->sp + 1]);
 
   if (type == T_NUM) {
     vm_push(vm, val, T_NUM);
@@ -626,7 +1840,7 @@ void std_read_lines(VM *vm) {
   FILE *f = fopen(path, "r");
   if (!f) {
     double addr = heap_alloc(vm, HEAP_HEADER_ARRAY);
-    double *base = vm_resolve_ptr(vm, addr);
+    Value *base = vm_resolve_ptr(vm, addr);
     base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
     base[HEAP_OFFSET_LEN] = 0;
     vm_push(vm, addr, T_OBJ);
@@ -646,22 +1860,36 @@ void std_read_lines(VM *vm) {
     lines++;
 
   double arr_addr = heap_alloc(vm, lines + HEAP_HEADER_ARRAY);
-  double *base = vm_resolve_ptr(vm, arr_addr);
-  int *types = vm_resolve_type(vm, arr_addr);
+  Value *base = vm_resolve_ptr(vm, arr_addr);
 
   base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
-  base[HEAP_OFFSET_LEN] = (double)lines;
+  base[HEAP_OFFSET_LEN] = lines;
 
+  // Lines can be any length, so collect each one in a growable buffer
   rewind(f);
-  char buffer[4096];
+  size_t cap = 256, len = 0;
+  char *line = malloc(cap);
   int i = 0;
-  while (i < lines && fgets(buffer, sizeof(buffer), f)) {
-    trim_newline(buffer);
-    int str_id = make_string(vm, buffer);
-    base[HEAP_HEADER_ARRAY + i] = (double)str_id;
-    types[HEAP_HEADER_ARRAY + i] = T_STR;
-    i++;
+  while (i < lines) {
+    ch = fgetc(f);
+    if (ch == EOF || ch == '\n') {
+      if (len > 0 && line[len - 1] == '\r')
+        len--;
+      int str_id = make_string_len(vm, line, (int)len);
+      base[HEAP_HEADER_ARRAY + i] = VAL_STR(str_id);
+      i++;
+      len = 0;
+      if (ch == EOF)
+        break;
+      continue;
+    }
+    if (len + 1 >= cap) {
+      cap *= 2;
+      line = realloc(line, cap);
+    }
+    line[len++] = (char)ch;
   }
+  free(line);
   fclose(f);
 
   vm_push(vm, arr_addr, T_OBJ);
@@ -692,6 +1920,12 @@ void std_write_file(VM *vm) {
   vm_push(vm, 1.0, T_NUM);
 }
 
+void std_delete_file(VM *vm) {
+  double path_id = vm_pop(vm);
+  const char *path = get_str(vm, path_id);
+  vm_push(vm, remove(path) == 0 ? 1.0 : 0.0, T_NUM);
+}
+
 void std_read_bytes(VM *vm) {
   double stride_val = vm_pop(vm);
   double path_id = vm_pop(vm);
@@ -706,7 +1940,7 @@ void std_read_bytes(VM *vm) {
   FILE *f = fopen(path, "rb");
   if (!f) {
     double addr = heap_alloc(vm, HEAP_HEADER_ARRAY);
-    double *base = vm_resolve_ptr(vm, addr);
+    Value *base = vm_resolve_ptr(vm, addr);
     base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
     base[HEAP_OFFSET_LEN] = 0;
     vm_push(vm, addr, T_OBJ);
@@ -724,10 +1958,10 @@ void std_read_bytes(VM *vm) {
   int element_count = file_len;
   int doubles_needed = (element_count + 7) / 8;
   double addr = heap_alloc(vm, doubles_needed + HEAP_HEADER_ARRAY);
-  double *base = vm_resolve_ptr(vm, addr);
+  Value *base = vm_resolve_ptr(vm, addr);
 
   base[HEAP_OFFSET_TYPE] = TYPE_BYTES;
-  base[HEAP_OFFSET_LEN] = (double)element_count;
+  base[HEAP_OFFSET_LEN] = element_count;
 
   char *heap_bytes = (char *)&base[HEAP_HEADER_ARRAY];
   memcpy(heap_bytes, buf, element_count);
@@ -740,7 +1974,7 @@ void std_write_bytes(VM *vm) {
   double arr_ref = vm_pop(vm);
   double path_id = vm_pop(vm);
 
-  double *base = vm_resolve_ptr(vm, arr_ref);
+  Value *base = vm_resolve_ptr(vm, arr_ref);
   if (!base || (int)base[HEAP_OFFSET_TYPE] != TYPE_ARRAY) {
     printf("Runtime Error: write_bytes expects array\n");
     exit(1);
@@ -756,7 +1990,7 @@ void std_write_bytes(VM *vm) {
   }
 
   for (int i = 0; i < len; i++) {
-    unsigned char b = (unsigned char)base[HEAP_HEADER_ARRAY + i];
+    unsigned char b = (unsigned char)VAL_AS_DOUBLE(base[HEAP_HEADER_ARRAY + i]);
     fputc(b, f);
   }
 
@@ -774,32 +2008,35 @@ void std_list(VM *vm) {
   }
 
   double ptr = heap_alloc(vm, size + HEAP_HEADER_ARRAY);
-  double *base = vm_resolve_ptr(vm, ptr);
-  int *types = vm_resolve_type(vm, ptr);
+  Value *base = vm_resolve_ptr(vm, ptr);
 
   base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
-  base[HEAP_OFFSET_LEN] = (double)size;
+  base[HEAP_OFFSET_LEN] = size;
 
   for (int i = 0; i < size; i++) {
-    base[HEAP_HEADER_ARRAY + i] = 0.0;
-    types[HEAP_HEADER_ARRAY + i] = T_NUM;
+    base[HEAP_HEADER_ARRAY + i] = VAL_NUM(0);
   }
 
   vm_push(vm, ptr, T_OBJ);
 }
 
 void std_remove(VM *vm) {
-  double key_val = vm_pop(vm);
-  int key_type = vm->stack_types[vm->sp + 1];
+  Value key = vm_pop_value(vm);
+  double key_val = VAL_AS_DOUBLE(key);
   double obj_val = vm_pop(vm);
 
-  if (vm->stack_types[vm->sp + 1] != T_OBJ) {
+  if (VAL_TYPE(vm->stack[vm->sp + 1]) != T_OBJ) {
     printf("Runtime Error: remove() expects an object\n");
     exit(1);
   }
 
-  double *base = vm_resolve_ptr(vm, obj_val);
-  int *types = vm_resolve_type(vm, obj_val);
+  // The only native that edits its argument in place (the rest build new
+  // objects), so it makes the same check as OP_ASET / OP_HSET
+  if (vm->arenas[UNPACK_ARENA(obj_val)].frozen)
+    mylo_runtime_error(vm, "Cannot modify frozen Region %d",
+                       UNPACK_ARENA(obj_val));
+
+  Value *base = vm_resolve_ptr(vm, obj_val);
   int type = (int)base[HEAP_OFFSET_TYPE];
 
   if (type == TYPE_ARRAY) {
@@ -812,51 +2049,26 @@ void std_remove(VM *vm) {
     if (index >= 0 && index < len) {
       for (int i = index; i < len - 1; i++) {
         base[HEAP_HEADER_ARRAY + i] = base[HEAP_HEADER_ARRAY + i + 1];
-        types[HEAP_HEADER_ARRAY + i] = types[HEAP_HEADER_ARRAY + i + 1];
       }
-      base[HEAP_OFFSET_LEN] = (double)(len - 1);
+      base[HEAP_OFFSET_LEN] = len - 1;
     }
   } else if (type == TYPE_MAP) {
-    int count = (int)base[HEAP_OFFSET_COUNT];
-    double data_ptr_val = base[HEAP_OFFSET_DATA];
-    double *data = vm_resolve_ptr(vm, data_ptr_val);
-    int *data_types = vm_resolve_type(vm, data_ptr_val);
-
-    if (data) {
-      for (int i = 0; i < count; i++) {
-        double k = data[i * 2];
-        int kt = data_types[i * 2];
-
-        if (k == key_val && kt == key_type) {
-          int pairs_to_move = count - 1 - i;
-          if (pairs_to_move > 0) {
-            for (int j = 0; j < pairs_to_move * 2; j++) {
-              data[i * 2 + j] = data[(i + 1) * 2 + j];
-              data_types[i * 2 + j] = data_types[(i + 1) * 2 + j];
-            }
-          }
-          base[HEAP_OFFSET_COUNT] = (double)(count - 1);
-          break;
-        }
-      }
-    }
+    vm_map_remove(vm, base, key);
   }
   vm_push(vm, obj_val, T_OBJ);
 }
 
 void std_add(VM *vm) {
-  double val = vm_pop(vm);
-  int val_type = vm->stack_types[vm->sp + 1];
+  Value val = vm_pop_value(vm);
 
   double idx_val = vm_pop(vm);
   int idx = (int)idx_val;
 
   double arr_val = vm_pop(vm);
 
-  double *base = vm_resolve_ptr(vm, arr_val);
-  int *types = vm_resolve_type(vm, arr_val);
+  Value *base = vm_resolve_ptr(vm, arr_val);
 
-  if (vm->stack_types[vm->sp + 1] != T_OBJ || (int)base[0] != TYPE_ARRAY) {
+  if (VAL_TYPE(vm->stack[vm->sp + 1]) != T_OBJ || (int)base[0] != TYPE_ARRAY) {
     printf("Runtime Error: add() expects an array\n");
     exit(1);
   }
@@ -871,26 +2083,22 @@ void std_add(VM *vm) {
     idx = len;
 
   double new_ptr = heap_alloc(vm, len + 1 + HEAP_HEADER_ARRAY);
-  double *new_base = vm_resolve_ptr(vm, new_ptr);
-  int *new_types = vm_resolve_type(vm, new_ptr);
+  Value *new_base = vm_resolve_ptr(vm, new_ptr);
 
   new_base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
-  new_base[HEAP_OFFSET_LEN] = (double)(len + 1);
+  new_base[HEAP_OFFSET_LEN] = len + 1;
 
   int src_base_idx = HEAP_HEADER_ARRAY;
   int dst_base_idx = HEAP_HEADER_ARRAY;
 
   for (int i = 0; i < idx; i++) {
     new_base[dst_base_idx + i] = base[src_base_idx + i];
-    new_types[dst_base_idx + i] = types[src_base_idx + i];
   }
 
   new_base[dst_base_idx + idx] = val;
-  new_types[dst_base_idx + idx] = val_type;
 
   for (int i = idx; i < len; i++) {
     new_base[dst_base_idx + i + 1] = base[src_base_idx + i];
-    new_types[dst_base_idx + i + 1] = types[src_base_idx + i];
   }
 
   vm_push(vm, new_ptr, T_OBJ);
@@ -907,17 +2115,15 @@ void std_split(VM *vm) {
   if (del_len == 0) {
     int len = strlen(str);
     double ptr = heap_alloc(vm, len + HEAP_HEADER_ARRAY);
-    double *base = vm_resolve_ptr(vm, ptr);
-    int *types = vm_resolve_type(vm, ptr);
+    Value *base = vm_resolve_ptr(vm, ptr);
 
     base[0] = TYPE_ARRAY;
-    base[1] = (double)len;
+    base[1] = len;
 
     for (int i = 0; i < len; i++) {
       char tmp[2] = {str[i], '\0'};
       int id = make_string(vm, tmp);
-      base[2 + i] = (double)id;
-      types[2 + i] = T_STR;
+      base[2 + i] = VAL_STR(id);
     }
     vm_push(vm, ptr, T_OBJ);
     return;
@@ -931,11 +2137,10 @@ void std_split(VM *vm) {
   }
 
   double ptr = heap_alloc(vm, count + HEAP_HEADER_ARRAY);
-  double *base = vm_resolve_ptr(vm, ptr);
-  int *types = vm_resolve_type(vm, ptr);
+  Value *base = vm_resolve_ptr(vm, ptr);
 
   base[0] = TYPE_ARRAY;
-  base[1] = (double)count;
+  base[1] = count;
 
   int idx = 0;
   p = str;
@@ -949,24 +2154,22 @@ void std_split(VM *vm) {
     int id = make_string(vm, buf);
     free(buf);
 
-    base[2 + idx] = (double)id;
-    types[2 + idx] = T_STR;
+    base[2 + idx] = VAL_STR(id);
     idx++;
     p = next + del_len;
   }
 
   int id = make_string(vm, p);
-  base[2 + idx] = (double)id;
-  types[2 + idx] = T_STR;
+  base[2 + idx] = VAL_STR(id);
 
   vm_push(vm, ptr, T_OBJ);
 }
 
 void std_where(VM *vm) {
   double item_val = vm_pop(vm);
-  int item_type = vm->stack_types[vm->sp + 1];
+  int item_type = VAL_TYPE(vm->stack[vm->sp + 1]);
   double col_val = vm_pop(vm);
-  int col_type = vm->stack_types[vm->sp + 1];
+  int col_type = VAL_TYPE(vm->stack[vm->sp + 1]);
 
   if (col_type == T_STR) {
     if (item_type != T_STR) {
@@ -981,8 +2184,7 @@ void std_where(VM *vm) {
     else
       vm_push(vm, -1.0, T_NUM);
   } else if (col_type == T_OBJ) {
-    double *base = vm_resolve_ptr(vm, col_val);
-    int *types = vm_resolve_type(vm, col_val);
+    Value *base = vm_resolve_ptr(vm, col_val);
     if (!base) {
       vm_push(vm, -1.0, T_NUM);
       return;
@@ -993,9 +2195,8 @@ void std_where(VM *vm) {
     if (type == TYPE_ARRAY) {
       int len = (int)base[1];
       for (int i = 0; i < len; i++) {
-        double el = base[2 + i];
-        int et = types[2 + i];
-        if (el == item_val && et == item_type) {
+        Value el = base[2 + i];
+        if (VAL_AS_DOUBLE(el) == item_val && VAL_TYPE(el) == item_type) {
           vm_push(vm, (double)i, T_NUM);
           return;
         }
@@ -1036,18 +2237,16 @@ void std_range(VM *vm) {
     count = 0;
 
   double ptr = heap_alloc(vm, count + HEAP_HEADER_ARRAY);
-  double *base = vm_resolve_ptr(vm, ptr);
-  int *types = vm_resolve_type(vm, ptr);
+  Value *base = vm_resolve_ptr(vm, ptr);
 
   base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
-  base[HEAP_OFFSET_LEN] = (double)count;
+  base[HEAP_OFFSET_LEN] = count;
 
   double current = start_val;
   bool ascending = (start_val <= stop_val);
 
   for (int i = 0; i < count; i++) {
-    base[HEAP_HEADER_ARRAY + i] = current;
-    types[HEAP_HEADER_ARRAY + i] = T_NUM;
+    base[HEAP_HEADER_ARRAY + i] = VAL_NUM(current);
     if (ascending)
       current += abs_step;
     else
@@ -1061,14 +2260,13 @@ void std_for_list(VM *vm) {
   double list_ref = vm_pop(vm);
   double func_val = vm_pop(vm);
 
-  double *base = vm_resolve_ptr(vm, list_ref);
-  int *types = vm_resolve_type(vm, list_ref);
+  Value *base = vm_resolve_ptr(vm, list_ref);
 
-  if (vm->stack_types[vm->sp + 2] != T_OBJ || (int)base[0] != TYPE_ARRAY) {
+  if (VAL_TYPE(vm->stack[vm->sp + 2]) != T_OBJ || (int)base[0] != TYPE_ARRAY) {
     printf("Runtime Error: for_list expects an array.\n");
     exit(1);
   }
-  if (vm->stack_types[vm->sp + 1] != T_STR) {
+  if (VAL_TYPE(vm->stack[vm->sp + 1]) != T_STR) {
     printf("Runtime Error: for_list expects a function name.\n");
     exit(1);
   }
@@ -1097,33 +2295,27 @@ void std_for_list(VM *vm) {
   int saved_ip = vm->ip;
 
   double res_ptr = heap_alloc(vm, len + HEAP_HEADER_ARRAY);
-  double *res_base = vm_resolve_ptr(vm, res_ptr);
-  int *res_types = vm_resolve_type(vm, res_ptr);
+  Value *res_base = vm_resolve_ptr(vm, res_ptr);
 
   res_base[0] = TYPE_ARRAY;
-  res_base[1] = (double)len;
+  res_base[1] = len;
 
   for (int i = 0; i < len; i++) {
-    double val = base[HEAP_HEADER_ARRAY + i];
-    int type = types[HEAP_HEADER_ARRAY + i];
+    Value val = base[HEAP_HEADER_ARRAY + i];
 
     if (native_target) {
-      vm_push(vm, val, type);
+      vm_push_value(vm, val);
       native_target(vm);
     } else {
       vm_push(vm, (double)vm->code_size, T_NUM);
       vm_push(vm, (double)vm->fp, T_NUM);
-      vm_push(vm, val, type);
+      vm_push_value(vm, val);
       vm->fp = vm->sp;
 
       run_vm_from(vm, user_func_addr, false);
     }
 
-    double res = vm_pop(vm);
-    int res_type = vm->stack_types[vm->sp + 1];
-
-    res_base[HEAP_HEADER_ARRAY + i] = res;
-    res_types[HEAP_HEADER_ARRAY + i] = res_type;
+    res_base[HEAP_HEADER_ARRAY + i] = vm_pop_value(vm);
   }
 
   vm->ip = saved_ip;
@@ -1189,9 +2381,9 @@ void std_dist(VM *vm) {
 
 void std_list_min(VM *vm) {
   double list_ref = vm_pop(vm);
-  double *base = vm_resolve_ptr(vm, list_ref);
+  Value *base = vm_resolve_ptr(vm, list_ref);
 
-  if (vm->stack_types[vm->sp + 1] != T_OBJ || (int)base[0] != TYPE_ARRAY) {
+  if (VAL_TYPE(vm->stack[vm->sp + 1]) != T_OBJ || (int)base[0] != TYPE_ARRAY) {
     printf("Runtime Error: list_min() expects an array.\n");
     exit(1);
   }
@@ -1202,9 +2394,9 @@ void std_list_min(VM *vm) {
     exit(1);
   }
 
-  double min_val = base[HEAP_HEADER_ARRAY + 0];
+  double min_val = VAL_AS_DOUBLE(base[HEAP_HEADER_ARRAY + 0]);
   for (int i = 1; i < len; i++) {
-    double val = base[HEAP_HEADER_ARRAY + i];
+    double val = VAL_AS_DOUBLE(base[HEAP_HEADER_ARRAY + i]);
     if (val < min_val)
       min_val = val;
   }
@@ -1213,9 +2405,9 @@ void std_list_min(VM *vm) {
 
 void std_list_max(VM *vm) {
   double list_ref = vm_pop(vm);
-  double *base = vm_resolve_ptr(vm, list_ref);
+  Value *base = vm_resolve_ptr(vm, list_ref);
 
-  if (vm->stack_types[vm->sp + 1] != T_OBJ || (int)base[0] != TYPE_ARRAY) {
+  if (VAL_TYPE(vm->stack[vm->sp + 1]) != T_OBJ || (int)base[0] != TYPE_ARRAY) {
     printf("Runtime Error: list_max() expects an array.\n");
     exit(1);
   }
@@ -1226,9 +2418,9 @@ void std_list_max(VM *vm) {
     exit(1);
   }
 
-  double max_val = base[HEAP_HEADER_ARRAY + 0];
+  double max_val = VAL_AS_DOUBLE(base[HEAP_HEADER_ARRAY + 0]);
   for (int i = 1; i < len; i++) {
-    double val = base[HEAP_HEADER_ARRAY + i];
+    double val = VAL_AS_DOUBLE(base[HEAP_HEADER_ARRAY + i]);
     if (val > max_val)
       max_val = val;
   }
@@ -1392,16 +2584,14 @@ void std_list_dir(VM *vm) {
 
   // Push the results to the Mylo Heap
   double arr_addr = heap_alloc(vm, count + HEAP_HEADER_ARRAY);
-  double *base = vm_resolve_ptr(vm, arr_addr);
-  int *types = vm_resolve_type(vm, arr_addr);
+  Value *base = vm_resolve_ptr(vm, arr_addr);
 
   base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
-  base[HEAP_OFFSET_LEN] = (double)count;
+  base[HEAP_OFFSET_LEN] = count;
 
   for (int i = 0; i < count; i++) {
     int id = make_string(vm, filenames[i]);
-    base[HEAP_HEADER_ARRAY + i] = (double)id;
-    types[HEAP_HEADER_ARRAY + i] = T_STR;
+    base[HEAP_HEADER_ARRAY + i] = VAL_STR(id);
     free(filenames[i]);
   }
   free(filenames);
@@ -1429,7 +2619,8 @@ static char *read_whole_file(const char *path) {
 // Platform agnostic execution logic
 void internal_exec_command(const char *cmd, char **out_str, char **err_str) {
   char stderr_path[256];
-  char actual_cmd[4096];
+  size_t cmd_cap = strlen(cmd) + sizeof(stderr_path) + 16;
+  char *actual_cmd = malloc(cmd_cap);
 
   // 1. Generate unique temp file for stderr
   // Using a random ID to avoid collisions
@@ -1437,14 +2628,15 @@ void internal_exec_command(const char *cmd, char **out_str, char **err_str) {
 #ifdef _WIN32
   sprintf(stderr_path, "%s\\mylo_err_%d.tmp", getenv("TEMP"), rnd);
   // cmd 2> temp_file
-  snprintf(actual_cmd, sizeof(actual_cmd), "%s 2> \"%s\"", cmd, stderr_path);
+  snprintf(actual_cmd, cmd_cap, "%s 2> \"%s\"", cmd, stderr_path);
 #else
   sprintf(stderr_path, "/tmp/mylo_err_%d.tmp", rnd);
-  snprintf(actual_cmd, sizeof(actual_cmd), "%s 2> %s", cmd, stderr_path);
+  snprintf(actual_cmd, cmd_cap, "%s 2> %s", cmd, stderr_path);
 #endif
 
   // 2. Run with popen to capture stdout directly
   FILE *fp = popen(actual_cmd, "r");
+  free(actual_cmd);
 
   // 3. Read stdout
   size_t out_cap = 1024;
@@ -1512,20 +2704,16 @@ void std_system(VM *vm) {
 
   // Create Mylo Array [stdout, stderr]
   double arr_ptr = heap_alloc(vm, 2 + HEAP_HEADER_ARRAY);
-  double *base = vm_resolve_ptr(vm, arr_ptr);
-  int *types = vm_resolve_type(vm, arr_ptr);
+  Value *base = vm_resolve_ptr(vm, arr_ptr);
 
   base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
-  base[HEAP_OFFSET_LEN] = 2.0;
+  base[HEAP_OFFSET_LEN] = 2;
 
   int id_out = make_string(vm, out_str ? out_str : "");
   int id_err = make_string(vm, err_str ? err_str : "");
 
-  base[HEAP_HEADER_ARRAY + 0] = (double)id_out;
-  types[HEAP_HEADER_ARRAY + 0] = T_STR;
-
-  base[HEAP_HEADER_ARRAY + 1] = (double)id_err;
-  types[HEAP_HEADER_ARRAY + 1] = T_STR;
+  base[HEAP_HEADER_ARRAY + 0] = VAL_STR(id_out);
+  base[HEAP_HEADER_ARRAY + 1] = VAL_STR(id_err);
 
   if (out_str)
     free(out_str);
@@ -1631,20 +2819,16 @@ void std_get_job(VM *vm) {
 
   // Now safe to alloc on VM Heap
   double arr_ptr = heap_alloc(vm, 2 + HEAP_HEADER_ARRAY);
-  double *base = vm_resolve_ptr(vm, arr_ptr);
-  int *types = vm_resolve_type(vm, arr_ptr);
+  Value *base = vm_resolve_ptr(vm, arr_ptr);
 
   base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
-  base[HEAP_OFFSET_LEN] = 2.0;
+  base[HEAP_OFFSET_LEN] = 2;
 
   int id_out = make_string(vm, safe_o);
   int id_err = make_string(vm, safe_e);
 
-  base[HEAP_HEADER_ARRAY + 0] = (double)id_out;
-  types[HEAP_HEADER_ARRAY + 0] = T_STR;
-
-  base[HEAP_HEADER_ARRAY + 1] = (double)id_err;
-  types[HEAP_HEADER_ARRAY + 1] = T_STR;
+  base[HEAP_HEADER_ARRAY + 0] = VAL_STR(id_out);
+  base[HEAP_HEADER_ARRAY + 1] = VAL_STR(id_err);
 
   free(safe_o);
   free(safe_e);
@@ -1653,69 +2837,74 @@ void std_get_job(VM *vm) {
 }
 
 // Bus commands
+
+// Returns the slot holding `key`, or the empty slot where it would go
+static BusEntry *bus_find(BusShard *shard, const char *key,
+                          unsigned long hash) {
+  int mask = shard->cap - 1;
+  int i = (int)(hash >> 4) & mask; // The low bits already picked the shard
+  while (shard->entries[i].key) {
+    if (shard->entries[i].hash == hash &&
+        strcmp(shard->entries[i].key, key) == 0)
+      break;
+    i = (i + 1) & mask;
+  }
+  return &shard->entries[i];
+}
+
+static void bus_grow(BusShard *shard) {
+  BusEntry *old = shard->entries;
+  int old_cap = shard->cap;
+  shard->cap = old_cap ? old_cap * 2 : 16;
+  shard->entries = (BusEntry *)calloc(shard->cap, sizeof(BusEntry));
+  for (int i = 0; i < old_cap; i++) {
+    if (old[i].key)
+      *bus_find(shard, old[i].key, old[i].hash) = old[i];
+  }
+  free(old);
+}
+
 // bus_set(key, value)
 void std_bus_set(VM *vm) {
   init_bus();
 
   // 1. Pop arguments
-  double val = vm_pop(vm);
-  int val_type = vm->stack_types[vm->sp + 1];
+  Value v = vm_pop_value(vm);
 
   double key_val = vm_pop(vm);
   // Ensure key is a string
-  if (vm->stack_types[vm->sp + 1] != T_STR) {
+  if (VAL_TYPE(vm->stack[vm->sp + 1]) != T_STR) {
     printf("Bus Error: Key must be a string.\n");
     vm_push(vm, 0.0, T_NUM);
     return;
   }
   const char *key = get_str(vm, key_val);
-
-  LOCK_BUS;
-
-  // 2. Find existing entry
-  int idx = -1;
-  for (int i = 0; i < bus_count; i++) {
-    if (global_bus[i].key && strcmp(global_bus[i].key, key) == 0) {
-      idx = i;
-      break;
-    }
-  }
-
-  // 3. Create new entry if needed
-  if (idx == -1) {
-    if (bus_count >= MAX_BUS_ENTRIES) {
-      UNLOCK_BUS;
-      // Bus full
-      vm_push(vm, 0.0, T_NUM);
-      return;
-    }
-    idx = bus_count++;
-    global_bus[idx].key = strdup(key);
-  } else {
-    // Free old string value if overwriting
-    if (global_bus[idx].type == T_STR && global_bus[idx].str_val) {
-      free(global_bus[idx].str_val);
-      global_bus[idx].str_val = NULL;
-    }
-  }
-
-  // 4. Store Value
-  // NOTE: We only support Primitives and Strings.
-  // Objects cannot be safely shared across VMs without deep serialization.
-  if (val_type == T_OBJ) {
-    // Fallback for objects: store as string representation
-    global_bus[idx].type = T_OBJ;
-    global_bus[idx].num_val = val;
-  } else if (val_type == T_STR) {
-    global_bus[idx].type = T_STR;
-    // Must copy string because the source VM might GC the original
-    global_bus[idx].str_val = strdup(get_str(vm, val));
-  } else {
-    global_bus[idx].type = T_NUM;
-    global_bus[idx].num_val = val;
-  }
-
-  UNLOCK_BUS;
+  unsigned long hash = vm_hash_str(key);
+  BusShard *shard = &bus_shards[hash & (BUS_SHARDS - 1)];
+
+  // 2. Serialize outside the lock. Strings and objects are deep-copied,
+  // since the source VM may collect or rewind the originals.
+  int type = VAL_TYPE(v);
+  void *blob = NULL;
+  if (type == T_STR || type == T_OBJ)
+    blob = vm_pack_value(vm, v, NULL);
+
+  // 3. Insert or overwrite
+  BUS_WRITE_LOCK(shard);
+  if ((shard->count + 1) * 2 > shard->cap)
+    bus_grow(shard);
+  BusEntry *e = bus_find(shard, key, hash);
+  void *old_blob = e->blob;
+  if (!e->key) {
+    e->key = strdup(key);
+    e->hash = hash;
+    shard->count++;
+  }
+  e->val = v;
+  e->blob = blob;
+  BUS_WRITE_UNLOCK(shard);
+
+  free(old_blob);
   vm_push(vm, 1.0, T_NUM); // Success
 }
 
@@ -1725,33 +2914,22 @@ void std_bus_get(VM *vm) {
 
   double key_val = vm_pop(vm);
   const char *key = get_str(vm, key_val);
-
-  LOCK_BUS;
-
-  for (int i = 0; i < bus_count; i++) {
-    if (global_bus[i].key && strcmp(global_bus[i].key, key) == 0) {
-      int type = global_bus[i].type;
-
-      if (type == T_NUM) {
-        vm_push(vm, global_bus[i].num_val, T_NUM);
-      } else if (type == T_STR) {
-        // Create a new string in the CALLING VM's heap
-        int id = make_string(vm, global_bus[i].str_val);
-        vm_push(vm, (double)id, T_STR);
-      } else if (type == T_OBJ) {
-        vm_push(vm, global_bus[i].num_val, T_OBJ);
-      } else {
-        vm_push(vm, 0.0, T_NUM);
-      }
-
-      UNLOCK_BUS;
-      return;
-    }
+  unsigned long hash = vm_hash_str(key);
+  BusShard *shard = &bus_shards[hash & (BUS_SHARDS - 1)];
+
+  BUS_READ_LOCK(shard);
+  BusEntry *e = shard->cap ? bus_find(shard, key, hash) : NULL;
+  if (!e || !e->key) {
+    BUS_READ_UNLOCK(shard);
+    // Not found return 0 (or null equivalent)
+    vm_push(vm, 0.0, T_NUM);
+    return;
   }
 
-  UNLOCK_BUS;
-  // Not found return 0 (or null equivalent)
-  vm_push(vm, 0.0, T_NUM);
+  // Materialize in the CALLING VM's current arena and string pool
+  Value v = e->blob ? vm_unpack_value(vm, e->blob) : e->val;
+  BUS_READ_UNLOCK(shard);
+  vm_push_value(vm, v);
 }
 
 // Terminal control
@@ -2001,16 +3179,14 @@ void std_get_keys(VM *vm) {
 
   // Construct Mylo Array
   double ptr = heap_alloc(vm, count + HEAP_HEADER_ARRAY);
-  double *base = vm_resolve_ptr(vm, ptr);
-  int *types = vm_resolve_type(vm, ptr);
+  Value *base = vm_resolve_ptr(vm, ptr);
 
   base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
-  base[HEAP_OFFSET_LEN] = (double)count;
+  base[HEAP_OFFSET_LEN] = count;
 
   for (int i = 0; i < count; i++) {
     int id = make_string(vm, collected_keys[i]);
-    base[HEAP_HEADER_ARRAY + i] = (double)id;
-    types[HEAP_HEADER_ARRAY + i] = T_STR;
+    base[HEAP_HEADER_ARRAY + i] = VAL_STR(id);
     free(collected_keys[i]); // Free the C-string temp copy
   }
 
@@ -2294,10 +3470,10 @@ void std_web_triangle(VM *vm) {
 void std_call(VM *vm) {
   // 1. Pop arguments: call("func_name", [args])
   double arr_val = vm_pop(vm);
-  int arr_type = vm->stack_types[vm->sp + 1];
+  int arr_type = VAL_TYPE(vm->stack[vm->sp + 1]);
 
   double name_val = vm_pop(vm);
-  int name_type = vm->stack_types[vm->sp + 1];
+  int name_type = VAL_TYPE(vm->stack[vm->sp + 1]);
 
   if (name_type != T_STR || arr_type != T_OBJ) {
     RUNTIME_ERROR("call() expects (str, array) as arguments.");
@@ -2305,8 +3481,7 @@ void std_call(VM *vm) {
 
   const char *func_name = vm->string_pool[(int)name_val];
 
-  double *base = vm_resolve_ptr_safe(vm, arr_val);
-  int *types = vm_resolve_type(vm, arr_val);
+  Value *base = vm_resolve_ptr_safe(vm, arr_val);
 
   // Verify it is a standard array
   if (!base || (int)base[HEAP_OFFSET_TYPE] != TYPE_ARRAY) {
@@ -2320,8 +3495,7 @@ void std_call(VM *vm) {
     for (int i = 0; i < argc; i++) {
       if (i > 0)
         print_raw(vm, " ");
-      print_recursive(vm, base[HEAP_HEADER_ARRAY + i],
-                      types[HEAP_HEADER_ARRAY + i], 0, -1);
+      print_recursive(vm, base[HEAP_HEADER_ARRAY + i], 0, -1);
     }
     print_raw(vm, "\n");
     vm_push(vm, 0.0, T_NUM); // print returns nothing, default to 0
@@ -2340,7 +3514,7 @@ void std_call(VM *vm) {
   if (std_idx != -1) {
     // Push arguments back to stack for the native function
     for (int i = 0; i < argc; i++) {
-      vm_push(vm, base[HEAP_HEADER_ARRAY + i], types[HEAP_HEADER_ARRAY + i]);
+      vm_push_value(vm, base[HEAP_HEADER_ARRAY + i]);
     }
     if (vm->natives[std_idx])
       vm->natives[std_idx](vm);
@@ -2352,7 +3526,7 @@ void std_call(VM *vm) {
   if (target_ip != -1) {
     // Push arguments to stack
     for (int i = 0; i < argc; i++) {
-      vm_push(vm, base[HEAP_HEADER_ARRAY + i], types[HEAP_HEADER_ARRAY + i]);
+      vm_push_value(vm, base[HEAP_HEADER_ARRAY + i]);
     }
 
     // Mimic OP_CALL stack framing
@@ -2361,19 +3535,17 @@ void std_call(VM *vm) {
     // Shift arguments up by 2 to make room for IP and FP pointers
     for (int i = 0; i < argc; i++) {
       vm->stack[vm->sp + 2 - i] = vm->stack[vm->sp - i];
-      vm->stack_types[vm->sp + 2 - i] = vm->stack_types[vm->sp - i];
     }
 
     // Insert old IP and FP below the arguments
-    vm->stack[args_start] = (double)vm->ip;
-    vm->stack[args_start + 1] = (double)vm->fp;
-    vm->stack_types[args_start] = T_NUM;
-    vm->stack_types[args_start + 1] = T_NUM;
+    vm->stack[args_start] = VAL_NUM(vm->ip);
+    vm->stack[args_start + 1] = VAL_NUM(vm->fp);
 
     // Advance pointers and jump!
     vm->sp += 2;
     vm->fp = args_start + 2;
     vm->ip = target_ip;
+    if (vm->profile && vm->profile->transition) vm->profile->transition(vm, true);
     return;
   }
 
@@ -2388,10 +3560,10 @@ void std_filter(VM *vm) {
   // Arguments are pushed left-to-right, so the string is popped first.
   // Example: filter(L, "filt") -> Pop 1: "filt", Pop 2: L
   double func_val = vm_pop(vm);
-  int func_type = vm->stack_types[vm->sp + 1];
+  int func_type = VAL_TYPE(vm->stack[vm->sp + 1]);
 
   double list_ref = vm_pop(vm);
-  int list_type = vm->stack_types[vm->sp + 1];
+  int list_type = VAL_TYPE(vm->stack[vm->sp + 1]);
 
   if (list_type != T_OBJ) {
     printf("Runtime Error: filter() expects an array as the first argument.\n");
@@ -2403,8 +3575,7 @@ void std_filter(VM *vm) {
     exit(1);
   }
 
-  double *base = vm_resolve_ptr(vm, list_ref);
-  int *types = vm_resolve_type(vm, list_ref);
+  Value *base = vm_resolve_ptr(vm, list_ref);
 
   if (!base || (int)base[HEAP_OFFSET_TYPE] != TYPE_ARRAY) {
     printf("Runtime Error: filter() expects a valid array.\n");
@@ -2437,49 +3608,45 @@ void std_filter(VM *vm) {
 
   // Pre-allocate the maximum possible size for the new array on the heap
   double res_ptr = heap_alloc(vm, len + HEAP_HEADER_ARRAY);
-  double *res_base = vm_resolve_ptr(vm, res_ptr);
-  int *res_types = vm_resolve_type(vm, res_ptr);
+  Value *res_base = vm_resolve_ptr(vm, res_ptr);
 
   res_base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
 
   int kept_count = 0;
 
   for (int i = 0; i < len; i++) {
-    double val = base[HEAP_HEADER_ARRAY + i];
-    int type = types[HEAP_HEADER_ARRAY + i];
+    Value val = base[HEAP_HEADER_ARRAY + i];
 
     if (native_target) {
-      vm_push(vm, val, type);
+      vm_push_value(vm, val);
       native_target(vm);
     } else {
       // Setup dummy stack frame for the VM function call
       vm_push(vm, (double)vm->code_size, T_NUM); // Return IP
       vm_push(vm, (double)vm->fp, T_NUM);        // Return FP
-      vm_push(vm, val, type);                    // Argument
+      vm_push_value(vm, val);                    // Argument
       vm->fp = vm->sp;
 
       run_vm_from(vm, user_func_addr, false);
     }
 
-    double res = vm_pop(vm);
-    int res_type = vm->stack_types[vm->sp + 1];
+    Value res = vm_pop_value(vm);
 
     // Filter logic: keep if the function evaluates to a truthy (non-zero)
     // number
     bool keep = false;
-    if (res_type == T_NUM && res != 0.0) {
+    if (VAL_IS_NUM(res) && VAL_AS_NUM(res) != 0.0) {
       keep = true;
     }
 
     if (keep) {
       res_base[HEAP_HEADER_ARRAY + kept_count] = val;
-      res_types[HEAP_HEADER_ARRAY + kept_count] = type;
       kept_count++;
     }
   }
 
   // Set the actual length to how many elements passed the filter
-  res_base[HEAP_OFFSET_LEN] = (double)kept_count;
+  res_base[HEAP_OFFSET_LEN] = kept_count;
 
   vm->ip = saved_ip;
   vm_push(vm, res_ptr, T_OBJ);
@@ -2487,14 +3654,13 @@ void std_filter(VM *vm) {
 
 void std_param_filter(VM *vm) {
   // Pop in reverse order: param, func_name, list
-  double param_val = vm_pop(vm);
-  int param_type = vm->stack_types[vm->sp + 1];
+  Value param = vm_pop_value(vm);
 
   double func_val = vm_pop(vm);
-  int func_type = vm->stack_types[vm->sp + 1];
+  int func_type = VAL_TYPE(vm->stack[vm->sp + 1]);
 
   double list_ref = vm_pop(vm);
-  int list_type = vm->stack_types[vm->sp + 1];
+  int list_type = VAL_TYPE(vm->stack[vm->sp + 1]);
 
   if (list_type != T_OBJ) {
     printf("Runtime Error: param_filter() expects an array as the first "
@@ -2507,8 +3673,7 @@ void std_param_filter(VM *vm) {
     exit(1);
   }
 
-  double *base = vm_resolve_ptr(vm, list_ref);
-  int *types = vm_resolve_type(vm, list_ref);
+  Value *base = vm_resolve_ptr(vm, list_ref);
 
   if (!base || (int)base[HEAP_OFFSET_TYPE] != TYPE_ARRAY) {
     printf("Runtime Error: param_filter() expects a valid array.\n");
@@ -2540,45 +3705,41 @@ void std_param_filter(VM *vm) {
   int saved_ip = vm->ip;
 
   double res_ptr = heap_alloc(vm, len + HEAP_HEADER_ARRAY);
-  double *res_base = vm_resolve_ptr(vm, res_ptr);
-  int *res_types = vm_resolve_type(vm, res_ptr);
+  Value *res_base = vm_resolve_ptr(vm, res_ptr);
 
   res_base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
   int kept_count = 0;
 
   for (int i = 0; i < len; i++) {
-    double val = base[HEAP_HEADER_ARRAY + i];
-    int type = types[HEAP_HEADER_ARRAY + i];
+    Value val = base[HEAP_HEADER_ARRAY + i];
 
     if (native_target) {
-      vm_push(vm, val, type);
-      vm_push(vm, param_val, param_type);
+      vm_push_value(vm, val);
+      vm_push_value(vm, param);
       native_target(vm);
     } else {
       // Setup stack frame for a 2-argument Mylo function
       vm_push(vm, (double)vm->code_size, T_NUM); // Return IP
       vm_push(vm, (double)vm->fp, T_NUM);        // Return FP
 
-      vm_push(vm, val, type); // Arg 1 (The element)
+      vm_push_value(vm, val); // Arg 1 (The element)
       int new_fp = vm->sp;    // FP points to the first argument
 
-      vm_push(vm, param_val, param_type); // Arg 2 (The parameter)
+      vm_push_value(vm, param); // Arg 2 (The parameter)
       vm->fp = new_fp;
 
       run_vm_from(vm, user_func_addr, false);
     }
 
-    double res = vm_pop(vm);
-    int res_type = vm->stack_types[vm->sp + 1];
+    Value res = vm_pop_value(vm);
 
-    if (res_type == T_NUM && res != 0.0) {
+    if (VAL_IS_NUM(res) && VAL_AS_NUM(res) != 0.0) {
       res_base[HEAP_HEADER_ARRAY + kept_count] = val;
-      res_types[HEAP_HEADER_ARRAY + kept_count] = type;
       kept_count++;
     }
   }
 
-  res_base[HEAP_OFFSET_LEN] = (double)kept_count;
+  res_base[HEAP_OFFSET_LEN] = kept_count;
   vm->ip = saved_ip;
   vm_push(vm, res_ptr, T_OBJ);
 }
@@ -2623,6 +3784,16 @@ const StdLibDef std_library[] = {
     {"create_worker", std_create_worker, "num", 2, {"num", "str"}},
     {"dock_worker", std_dock_worker, "void", 1, {"num"}},
     {"check_worker", std_check_worker, "num", 1, {"num"}},
+    {"wait_worker", std_wait_worker, "num", 2, {"num", "num"}},
+    {"wait_any", std_wait_any, "num", 1, {"arr"}},
+    {"wait_all", std_wait_all, "num", 1, {"arr"}},
+    {"chan_create", std_chan_create, "num", 1, {"num"}},
+    {"chan_send", std_chan_send, "num", 2, {"num", "any"}},
+    {"chan_recv", std_chan_recv, "any", 1, {"num"}},
+    {"chan_try_recv", std_chan_try_recv, "any", 2, {"num", "any"}},
+    {"chan_close", std_chan_close, "void", 1, {"num"}},
+    {"spawn", std_spawn, "num", 2, {"str", "arr"}},
+    {"await", std_await, "any", 1, {"num"}},
     {"bus_set", std_bus_set, "num", 2, {"str", "any"}},
     {"bus_get", std_bus_get, "any", 1, {"str"}},
     {"cget", std_cget, "str", 1, {"num"}},
@@ -2649,7 +3820,12 @@ const StdLibDef std_library[] = {
     {"set_region", std_set_region, "void", 1, {"num"}},
     {"get_region", std_get_region, "num", 0, {NULL}},
     {"clear_region", std_clear_region, "void", 1, {"num"}},
+    {"freeze", std_freeze, "void", 1, {"num"}},
     {"call", std_call, "any", 2, {"str", "any"}},
     {"filter", std_filter, "arr", 2, {"arr", "str"}},
+    {"par_map", std_par_map, "arr", 2, {"arr", "str"}},
+    {"par_filter", std_par_filter, "arr", 2, {"arr", "str"}},
+    {"par_reduce", std_par_reduce, "any", 3, {"arr", "str", "any"}},
     {"param_filter", std_param_filter, "arr", 3, {"arr", "str", "any"}},
+    {"delete_file", std_delete_file, "num", 1, {"str"}},
     {NULL, NULL, NULL, 0, {NULL}}};
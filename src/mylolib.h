@@ -31,6 +31,7 @@ void std_to_string(VM *vm);
 void std_to_num(VM *vm);
 void std_read_lines(VM *vm);
 void std_write_file(VM *vm);
+void std_delete_file(VM *vm);
 void std_read_bytes(VM *vm);
 void std_write_bytes(VM *vm);
 void std_list(VM *vm);
@@ -55,6 +56,19 @@ void std_noise(VM *vm);
 void std_create_worker(VM *vm);
 void std_dock_worker(VM *vm);
 void std_check_worker(VM *vm);
+void std_wait_worker(VM *vm);
+void std_wait_any(VM *vm);
+void std_wait_all(VM *vm);
+void std_par_map(VM *vm);
+void std_par_filter(VM *vm);
+void std_par_reduce(VM *vm);
+void std_chan_create(VM *vm);
+void std_chan_send(VM *vm);
+void std_chan_recv(VM *vm);
+void std_chan_try_recv(VM *vm);
+void std_chan_close(VM *vm);
+void std_spawn(VM *vm);
+void std_await(VM *vm);
 
 // Bus Functions
 void std_bus_set(VM *vm);
@@ -70,6 +84,7 @@ void std_create_region(VM *vm);
 void std_set_region(VM *vm);
 void std_get_region(VM *vm);
 void std_clear_region(VM *vm);
+void std_freeze(VM *vm);
 
 // Call via name
 void std_call(VM *vm);
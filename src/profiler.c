@@ -0,0 +1,573 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "profiler.h"
+
+#ifndef _WIN32
+    #define MYLO_PROFILER_TIMER 1
+    #include <sys/time.h>
+#endif
+
+#ifdef __linux__
+    #define MYLO_PERF_EVENTS 1
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+// Hardware events for --perf-counters, in report order
+enum { HW_CYCLES, HW_INSTRUCTIONS, HW_L1D_MISSES, HW_LLC_MISSES, HW_BRANCH_MISSES, HW_COUNTERS };
+static const char* hw_counter_names[HW_COUNTERS] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"
+};
+
+// What a function did while it was the innermost frame
+typedef struct {
+    long calls;
+    long ops;           // Bytecode instructions run
+    long alloc_slots;   // Heap slots allocated (8 bytes each)
+    uint64_t ns;
+    uint64_t hw[HW_COUNTERS];
+} ProfileCounters;
+
+// A distinct call stack (function ids, innermost first) and its ticks
+typedef struct {
+    uint32_t hash;
+    int depth;
+    int frames;     // Offset into Profiler.frames
+    long ticks;
+} ProfileStack;
+
+typedef struct {
+    VMProfileHook hook;     // First, so vm->profile can be cast back
+    int interval_us;
+    clock_t started;
+    clock_t stopped;        // 0 while the timer runs
+    int code_size;          // Addresses covered by ip_ticks / fn_of_ip
+    int fn_count;           // vm->function_count at start
+    long* ip_ticks;         // Self ticks per instruction
+    int* fn_of_ip;          // Function index per address, -1 for top-level code
+    long total;
+    ProfileStack* stacks;   // Open addressing, stack_cap is a power of two
+    int stack_count;
+    int stack_cap;
+    int* frames;
+    int frame_count;
+    int frame_cap;
+    // --perf-counters
+    ProfileCounters* counters;  // Per function + 1, [0] is top-level code
+    int current_fn;             // Function the next deltas are charged to
+    int hw_fd;                  // Event group leader, -1 without hardware counters
+    int hw_count;
+    int hw_fds[HW_COUNTERS];    // Per group read slot
+    int hw_event[HW_COUNTERS];  // Group read slot -> HW_* id
+    uint64_t last_hw[HW_COUNTERS];
+    uint64_t last_ns;
+    long last_steps;
+    long last_alloc;
+} Profiler;
+
+static volatile sig_atomic_t* active_pending = NULL;
+
+#ifdef MYLO_PROFILER_TIMER
+static struct sigaction previous_action;
+
+static void profiler_on_tick(int sig) {
+    (void)sig;
+    if (active_pending) (*active_pending)++;
+}
+#endif
+
+bool profiler_supported(void) {
+#ifdef MYLO_PROFILER_TIMER
+    return true;
+#else
+    return false;
+#endif
+}
+
+static int profiler_function_at(Profiler* p, int ip) {
+    return ip >= 0 && ip < p->code_size ? p->fn_of_ip[ip] : -1;
+}
+
+static const char* profiler_function_name(VM* vm, int fn) {
+    return fn < 0 ? "main" : vm->functions[fn].name;
+}
+
+static int* profiler_stack_frames(Profiler* p, ProfileStack* s) {
+    return p->frames + s->frames;
+}
+
+static void profiler_grow_stacks(Profiler* p) {
+    int cap = p->stack_cap ? p->stack_cap * 2 : 256;
+    ProfileStack* table = calloc(cap, sizeof(ProfileStack));
+    for (int i = 0; i < p->stack_cap; i++) {
+        ProfileStack* s = &p->stacks[i];
+        if (!s->ticks) continue;
+        int slot = s->hash & (cap - 1);
+        while (table[slot].ticks) slot = (slot + 1) & (cap - 1);
+        table[slot] = *s;
+    }
+    free(p->stacks);
+    p->stacks = table;
+    p->stack_cap = cap;
+}
+
+static void profiler_add_stack(Profiler* p, const int* ids, int depth, int ticks) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < depth; i++) hash = (hash ^ (uint32_t)(ids[i] + 1)) * 16777619u;
+
+    if ((p->stack_count + 1) * 2 > p->stack_cap) profiler_grow_stacks(p);
+    int slot = hash & (p->stack_cap - 1);
+    while (p->stacks[slot].ticks) {
+        ProfileStack* s = &p->stacks[slot];
+        if (s->hash == hash && s->depth == depth &&
+            memcmp(profiler_stack_frames(p, s), ids, depth * sizeof(int)) == 0) {
+            s->ticks += ticks;
+            return;
+        }
+        slot = (slot + 1) & (p->stack_cap - 1);
+    }
+
+    if (p->frame_count + depth > p->frame_cap) {
+        p->frame_cap = (p->frame_count + depth) * 2;
+        p->frames = realloc(p->frames, p->frame_cap * sizeof(int));
+    }
+    memcpy(p->frames + p->frame_count, ids, depth * sizeof(int));
+    ProfileStack* s = &p->stacks[slot];
+    s->hash = hash;
+    s->depth = depth;
+    s->frames = p->frame_count;
+    s->ticks = ticks;
+    p->frame_count += depth;
+    p->stack_count++;
+}
+
+// Called by run_vm_from before the instruction at vm->ip. Walks the frames
+// OP_CALL left on the stack: [return ip, caller fp] sit just below each fp.
+// A return ip of code_size marks a callback run by a native; the native's own
+// address was saved in entry_ip when it re-entered the interpreter.
+static void profiler_sample(VM* vm, int ticks) {
+    Profiler* p = (Profiler*)vm->profile;
+    int ids[PROFILE_MAX_FRAMES];
+    int depth = 0;
+    int ip = vm->ip;
+    int fp = vm->fp;
+    int nest = vm->run_depth - 1;
+
+    if (ip >= 0 && ip < p->code_size) p->ip_ticks[ip] += ticks;
+    p->total += ticks;
+
+    ids[depth++] = profiler_function_at(p, ip);
+    while (fp >= 2 && fp <= vm->sp + 1 && depth < PROFILE_MAX_FRAMES) {
+        int ret = (int)VAL_AS_NUM(vm->stack[fp - 2]);
+        int caller_fp = (int)VAL_AS_NUM(vm->stack[fp - 1]);
+        if (ret >= vm->code_size) {
+            if (nest < 1 || nest >= PROFILE_MAX_NEST) break;
+            ret = vm->profile->entry_ip[nest--];
+        }
+        ids[depth++] = profiler_function_at(p, ret);
+        if (caller_fp >= fp) break;
+        fp = caller_fp;
+    }
+    // Frames that return into top-level code already end in main
+    if (ids[depth - 1] != -1 && depth < PROFILE_MAX_FRAMES) ids[depth++] = -1;
+    profiler_add_stack(p, ids, depth, ticks);
+}
+
+// --- Hardware Counters (--perf-counters) ---
+// Counters are read whenever the innermost function changes (OP_CALL, OP_RET,
+// a native calling back into Mylo) and the difference since the last read is
+// charged to the function that was running.
+
+static uint64_t profiler_now_ns(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void profiler_read_hw(Profiler* p, uint64_t* values) {
+#ifdef MYLO_PERF_EVENTS
+    if (p->hw_fd >= 0) {
+        uint64_t buf[1 + HW_COUNTERS];
+        if (read(p->hw_fd, buf, sizeof(uint64_t) * (1 + p->hw_count)) > 0) {
+            for (int i = 0; i < p->hw_count && i < (int)buf[0]; i++) values[p->hw_event[i]] = buf[1 + i];
+        }
+    }
+#else
+    (void)p;
+    (void)values;
+#endif
+}
+
+// Charges everything since the last read to p->current_fn
+static void profiler_charge(VM* vm, Profiler* p) {
+    ProfileCounters* c = &p->counters[p->current_fn + 1];
+    uint64_t now = profiler_now_ns();
+    uint64_t hw[HW_COUNTERS];
+    memcpy(hw, p->last_hw, sizeof(hw));
+    profiler_read_hw(p, hw);
+
+    c->ns += now - p->last_ns;
+    c->ops += vm->profile->steps - p->last_steps;
+    c->alloc_slots += vm->profile->alloc_slots - p->last_alloc;
+    for (int i = 0; i < HW_COUNTERS; i++) c->hw[i] += hw[i] - p->last_hw[i];
+
+    memcpy(p->last_hw, hw, sizeof(hw));
+    p->last_ns = now;
+    p->last_steps = vm->profile->steps;
+    p->last_alloc = vm->profile->alloc_slots;
+}
+
+static void profiler_transition(VM* vm, bool call) {
+    Profiler* p = (Profiler*)vm->profile;
+    profiler_charge(vm, p);
+    int ip = vm->ip;
+    // Returned to a native that called back into Mylo: it runs as its caller
+    if (ip >= vm->code_size && vm->run_depth >= 2 && vm->run_depth - 1 < PROFILE_MAX_NEST) {
+        ip = vm->profile->entry_ip[vm->run_depth - 1];
+    }
+    p->current_fn = profiler_function_at(p, ip);
+    if (call) p->counters[p->current_fn + 1].calls++;
+}
+
+#ifdef MYLO_PERF_EVENTS
+static int profiler_open_event(uint32_t type, uint64_t config, int group) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    // This thread only, on any CPU
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+#endif
+
+bool profiler_enable_counters(VM* vm) {
+    Profiler* p = (Profiler*)vm->profile;
+    if (!p) return false;
+    if (!p->counters) p->counters = calloc(p->fn_count + 1, sizeof(ProfileCounters));
+
+#ifdef MYLO_PERF_EVENTS
+    static const struct { uint32_t type; uint64_t config; } events[HW_COUNTERS] = {
+        [HW_CYCLES]        = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        [HW_INSTRUCTIONS]  = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        [HW_L1D_MISSES]    = { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                               (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        [HW_LLC_MISSES]    = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        [HW_BRANCH_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    };
+    // Events the CPU (or a VM) does not offer are left out of the group
+    for (int i = 0; i < HW_COUNTERS && p->hw_count < HW_COUNTERS; i++) {
+        int fd = profiler_open_event(events[i].type, events[i].config, p->hw_fd);
+        if (fd < 0) continue;
+        if (p->hw_fd < 0) p->hw_fd = fd;
+        p->hw_fds[p->hw_count] = fd;
+        p->hw_event[p->hw_count++] = i;
+    }
+    if (p->hw_fd >= 0) {
+        ioctl(p->hw_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(p->hw_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+
+    p->current_fn = profiler_function_at(p, vm->ip);
+    p->last_ns = profiler_now_ns();
+    p->last_steps = vm->profile->steps;
+    p->last_alloc = vm->profile->alloc_slots;
+    memset(p->last_hw, 0, sizeof(p->last_hw));
+    profiler_read_hw(p, p->last_hw);
+    vm->profile->transition = profiler_transition;
+    return p->hw_fd >= 0;
+}
+
+void profiler_start(VM* vm, int interval_us) {
+    if (vm->profile) profiler_free(vm);
+    Profiler* p = calloc(1, sizeof(Profiler));
+    p->hook.sample = profiler_sample;
+    p->interval_us = interval_us;
+    p->hw_fd = -1;
+    p->code_size = vm->code_size;
+    p->fn_count = vm->function_count;
+    p->ip_ticks = calloc(p->code_size + 1, sizeof(long));
+    p->fn_of_ip = malloc((p->code_size + 1) * sizeof(int));
+    for (int i = 0; i <= p->code_size; i++) p->fn_of_ip[i] = -1;
+
+    // Each body sits in [addr, end) behind the JMP that skips it. Later
+    // (inner) functions overwrite the range of the one enclosing them.
+    for (int f = 0; f < vm->function_count; f++) {
+        int addr = vm->functions[f].addr;
+        if (addr < 2 || addr > p->code_size) continue;
+        int end = vm->bytecode[addr - 2] == OP_JMP ? vm->bytecode[addr - 1] : p->code_size;
+        if (end < addr || end > p->code_size) end = p->code_size;
+        for (int i = addr; i < end; i++) p->fn_of_ip[i] = f;
+    }
+
+    vm->profile = &p->hook;
+    active_pending = &p->hook.pending;
+    p->started = clock();
+
+#ifdef MYLO_PROFILER_TIMER
+    if (interval_us <= 0) return;
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = profiler_on_tick;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, &previous_action);
+
+    struct itimerval timer;
+    timer.it_interval.tv_sec = p->interval_us / 1000000;
+    timer.it_interval.tv_usec = p->interval_us % 1000000;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, NULL);
+#endif
+}
+
+void profiler_stop(VM* vm) {
+    if (!vm->profile || active_pending != &vm->profile->pending) return;
+    Profiler* p = (Profiler*)vm->profile;
+#ifdef MYLO_PROFILER_TIMER
+    if (p->interval_us > 0) {
+        struct itimerval timer;
+        memset(&timer, 0, sizeof(timer));
+        setitimer(ITIMER_PROF, &timer, NULL);
+        sigaction(SIGPROF, &previous_action, NULL);
+    }
+#endif
+    if (p->counters) {
+        profiler_charge(vm, p);
+        vm->profile->transition = NULL;
+#ifdef MYLO_PERF_EVENTS
+        if (p->hw_fd >= 0) ioctl(p->hw_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        for (int i = p->hw_count - 1; i >= 0; i--) close(p->hw_fds[i]);
+#endif
+        p->hw_fd = -1;
+    }
+    active_pending = NULL;
+    p->stopped = clock();
+}
+
+long profiler_sample_count(VM* vm) {
+    return vm->profile ? ((Profiler*)vm->profile)->total : 0;
+}
+
+typedef struct {
+    int key;        // Function index or line
+    int ip;         // Lines: one address compiled from it, to name its function
+    long self;
+    long total;
+} ProfileRow;
+
+static int profile_row_cmp(const void* a, const void* b) {
+    const ProfileRow* x = a;
+    const ProfileRow* y = b;
+    if (x->self != y->self) return x->self < y->self ? 1 : -1;
+    if (x->total != y->total) return x->total < y->total ? 1 : -1;
+    return x->key - y->key;
+}
+
+static double profile_percent(long n, long total) {
+    return total ? 100.0 * (double)n / (double)total : 0.0;
+}
+
+// Prints line `line` of the source (1-based), trimmed to fit a report row
+static void profiler_print_source_line(VM* vm, FILE* out, int line) {
+    const char* s = vm->source_code;
+    if (!s || line < 1) return;
+    for (int l = 1; l < line && *s; s++) {
+        if (*s == '\n') l++;
+    }
+    while (*s == ' ' || *s == '\t') s++;
+    int len = 0;
+    while (s[len] && s[len] != '\n' && s[len] != '\r') len++;
+    if (len > 48) fprintf(out, "  %.45s...", s);
+    else fprintf(out, "  %.*s", len, s);
+}
+
+void profiler_report(VM* vm, FILE* out, int max_rows) {
+    Profiler* p = (Profiler*)vm->profile;
+    if (!p) return;
+    // The timer may tick coarser than asked for, so time the run separately
+    clock_t end = p->stopped ? p->stopped : clock();
+    double cpu_ms = 1000.0 * (double)(end - p->started) / CLOCKS_PER_SEC;
+    fprintf(out, "\n--- Profile: %ld samples over %.1f ms of CPU time ---\n", p->total, cpu_ms);
+    if (!p->total) {
+        fprintf(out, "(the program finished before the first sample)\n");
+        return;
+    }
+
+    // Functions: self from the innermost frame, total counts a stack once
+    // per function on it (recursion does not inflate it)
+    int fn_rows = vm->function_count + 1;
+    ProfileRow* rows = calloc(fn_rows, sizeof(ProfileRow));
+    int* seen = calloc(fn_rows, sizeof(int));
+    for (int i = 0; i < fn_rows; i++) rows[i].key = i - 1;
+    for (int i = 0; i < p->stack_cap; i++) {
+        ProfileStack* s = &p->stacks[i];
+        if (!s->ticks) continue;
+        int* ids = profiler_stack_frames(p, s);
+        rows[ids[0] + 1].self += s->ticks;
+        for (int d = 0; d < s->depth; d++) {
+            if (seen[ids[d] + 1] == i + 1) continue;
+            seen[ids[d] + 1] = i + 1;
+            rows[ids[d] + 1].total += s->ticks;
+        }
+    }
+    qsort(rows, fn_rows, sizeof(ProfileRow), profile_row_cmp);
+    fprintf(out, "\n  %7s %7s %9s  %s\n", "self", "total", "samples", "function");
+    for (int i = 0; i < fn_rows && i < max_rows && rows[i].total; i++) {
+        fprintf(out, "  %6.1f%% %6.1f%% %9ld  %s\n",
+                profile_percent(rows[i].self, p->total), profile_percent(rows[i].total, p->total),
+                rows[i].self, profiler_function_name(vm, rows[i].key));
+    }
+    free(rows);
+    free(seen);
+
+    // Lines: self ticks of every instruction compiled from the line
+    int max_line = 0;
+    for (int ip = 0; ip < p->code_size; ip++) {
+        if (p->ip_ticks[ip] && vm->lines[ip] > max_line) max_line = vm->lines[ip];
+    }
+    ProfileRow* lines = calloc(max_line + 1, sizeof(ProfileRow));
+    for (int l = 0; l <= max_line; l++) lines[l].key = l;
+    for (int ip = 0; ip < p->code_size; ip++) {
+        if (!p->ip_ticks[ip]) continue;
+        ProfileRow* row = &lines[vm->lines[ip] > 0 ? vm->lines[ip] : 0];
+        row->self += p->ip_ticks[ip];
+        row->ip = ip;
+    }
+    qsort(lines, max_line + 1, sizeof(ProfileRow), profile_row_cmp);
+    fprintf(out, "\n  %7s %9s %6s  %-16s %s\n", "self", "samples", "line", "function", "source");
+    for (int i = 0; i <= max_line && i < max_rows && lines[i].self; i++) {
+        fprintf(out, "  %6.1f%% %9ld %6d  %-16s",
+                profile_percent(lines[i].self, p->total), lines[i].self, lines[i].key,
+                profiler_function_name(vm, profiler_function_at(p, lines[i].ip)));
+        profiler_print_source_line(vm, out, lines[i].key);
+        fprintf(out, "\n");
+    }
+    free(lines);
+}
+
+bool profiler_write_folded(VM* vm, const char* path) {
+    Profiler* p = (Profiler*)vm->profile;
+    if (!p) return false;
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    for (int i = 0; i < p->stack_cap; i++) {
+        ProfileStack* s = &p->stacks[i];
+        if (!s->ticks) continue;
+        int* ids = profiler_stack_frames(p, s);
+        // Outermost first
+        for (int d = s->depth - 1; d >= 0; d--) {
+            fprintf(f, "%s%s", profiler_function_name(vm, ids[d]), d ? ";" : "");
+        }
+        fprintf(f, " %ld\n", s->ticks);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool profiler_counted(Profiler* p, int event) {
+    for (int i = 0; i < p->hw_count; i++) {
+        if (p->hw_event[i] == event) return true;
+    }
+    return false;
+}
+
+static int profiler_counter_order(Profiler* p, ProfileRow* rows) {
+    int n = 0;
+    for (int f = -1; f < p->fn_count; f++) {
+        ProfileCounters* c = &p->counters[f + 1];
+        if (!c->calls && !c->ops) continue;
+        rows[n].key = f;
+        rows[n].self = (long)(c->ns / 1000);
+        rows[n].total = c->ops;
+        n++;
+    }
+    qsort(rows, n, sizeof(ProfileRow), profile_row_cmp);
+    return n;
+}
+
+// Per 1000 instructions, or -1 when either side was not counted
+static double profiler_per_kilo(Profiler* p, ProfileCounters* c, int event) {
+    if (!profiler_counted(p, event) || !profiler_counted(p, HW_INSTRUCTIONS) || !c->hw[HW_INSTRUCTIONS]) return -1;
+    return 1000.0 * (double)c->hw[event] / (double)c->hw[HW_INSTRUCTIONS];
+}
+
+void profiler_report_counters(VM* vm, FILE* out, int max_rows) {
+    Profiler* p = (Profiler*)vm->profile;
+    if (!p || !p->counters) return;
+    ProfileRow* rows = calloc(p->fn_count + 1, sizeof(ProfileRow));
+    int n = profiler_counter_order(p, rows);
+
+    fprintf(out, "\n--- Counters per function (innermost frame) ---\n");
+    if (!p->hw_count) fprintf(out, "(hardware counters unavailable: perf_event_open failed or unsupported)\n");
+    fprintf(out, "\n  %10s %10s %12s %10s %8s %6s %8s %8s %8s  %s\n",
+            "ms", "calls", "ops", "alloc KB", "cyc/op", "IPC", "L1D/ki", "LLC/ki", "br/ki", "function");
+    for (int i = 0; i < n && i < max_rows; i++) {
+        ProfileCounters* c = &p->counters[rows[i].key + 1];
+        fprintf(out, "  %10.2f %10ld %12ld %10.1f", c->ns / 1e6, c->calls, c->ops, c->alloc_slots * sizeof(Value) / 1024.0);
+        bool cycles = profiler_counted(p, HW_CYCLES) && c->hw[HW_CYCLES];
+        if (cycles && c->ops) fprintf(out, " %8.1f", (double)c->hw[HW_CYCLES] / (double)c->ops);
+        else fprintf(out, " %8s", "-");
+        if (cycles && profiler_counted(p, HW_INSTRUCTIONS)) fprintf(out, " %6.2f", (double)c->hw[HW_INSTRUCTIONS] / (double)c->hw[HW_CYCLES]);
+        else fprintf(out, " %6s", "-");
+        int per_kilo[] = { HW_L1D_MISSES, HW_LLC_MISSES, HW_BRANCH_MISSES };
+        for (int k = 0; k < 3; k++) {
+            double v = profiler_per_kilo(p, c, per_kilo[k]);
+            if (v >= 0) fprintf(out, " %8.2f", v);
+            else fprintf(out, " %8s", "-");
+        }
+        fprintf(out, "  %s\n", profiler_function_name(vm, rows[i].key));
+    }
+    free(rows);
+}
+
+bool profiler_write_counters_json(VM* vm, const char* path) {
+    Profiler* p = (Profiler*)vm->profile;
+    if (!p || !p->counters) return false;
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    ProfileRow* rows = calloc(p->fn_count + 1, sizeof(ProfileRow));
+    int n = profiler_counter_order(p, rows);
+
+    fprintf(f, "{\n  \"hardware_counters\": [");
+    for (int i = 0; i < p->hw_count; i++) fprintf(f, "%s\"%s\"", i ? ", " : "", hw_counter_names[p->hw_event[i]]);
+    fprintf(f, "],\n  \"functions\": [");
+    for (int i = 0; i < n; i++) {
+        ProfileCounters* c = &p->counters[rows[i].key + 1];
+        fprintf(f, "%s\n    {\"name\": \"%s\", \"calls\": %ld, \"ops\": %ld, \"ns\": %llu, \"alloc_bytes\": %llu",
+                i ? "," : "", profiler_function_name(vm, rows[i].key), c->calls, c->ops,
+                (unsigned long long)c->ns, (unsigned long long)(c->alloc_slots * sizeof(Value)));
+        for (int h = 0; h < p->hw_count; h++) {
+            fprintf(f, ", \"%s\": %llu", hw_counter_names[p->hw_event[h]], (unsigned long long)c->hw[p->hw_event[h]]);
+        }
+        fprintf(f, "}");
+    }
+    fprintf(f, "\n  ]\n}\n");
+    fclose(f);
+    free(rows);
+    return true;
+}
+
+void profiler_free(VM* vm) {
+    if (!vm->profile) return;
+    profiler_stop(vm);
+    Profiler* p = (Profiler*)vm->profile;
+    free(p->ip_ticks);
+    free(p->fn_of_ip);
+    free(p->stacks);
+    free(p->frames);
+    free(p->counters);
+    free(p);
+    vm->profile = NULL;
+}
@@ -0,0 +1,51 @@
+#ifndef MYLO_PROFILER_H
+#define MYLO_PROFILER_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "vm.h"
+
+// --- Sampling Profiler (--profile) ---
+// A SIGPROF interval timer counts ticks of CPU time. The interpreter, stepping
+// one op at a time while a profiler is attached, records vm->ip and the chain
+// of call frames at the next instruction boundary. Samples are mapped to
+// functions with the function table and to source lines with vm->lines.
+
+// True when this build has an interval timer to sample with (not Windows)
+bool profiler_supported(void);
+
+// Attaches a profiler to vm and, when interval_us > 0, starts the sampling
+// timer. Call after parsing. Only one profiler can run at a time; worker VMs
+// are not profiled.
+void profiler_start(VM* vm, int interval_us);
+
+// Stops the timer. The samples stay attached for the reports below.
+void profiler_stop(VM* vm);
+
+// Samples (timer ticks) recorded so far
+long profiler_sample_count(VM* vm);
+
+// Per-function (self / total) and per-line tables, hottest first
+void profiler_report(VM* vm, FILE* out, int max_rows);
+
+// One "main;caller;callee count" line per distinct stack, the folded format
+// flamegraph.pl and speedscope read
+bool profiler_write_folded(VM* vm, const char* path);
+
+// Reads time, instructions run, heap allocation and (where perf_event_open
+// allows) hardware counters on every call and return, charging them to the
+// innermost function. Call after profiler_start; false without hardware
+// counters (the rest is still counted).
+bool profiler_enable_counters(VM* vm);
+
+// Per-function counter table, slowest first, with cycles per op, IPC and
+// misses per 1000 instructions
+void profiler_report_counters(VM* vm, FILE* out, int max_rows);
+
+// The same data as JSON: {"hardware_counters": [...], "functions": [...]}
+bool profiler_write_counters_json(VM* vm, const char* path);
+
+// Detaches the profiler from vm and frees its samples
+void profiler_free(VM* vm);
+
+#endif
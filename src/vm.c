@@ -17,6 +17,7 @@
     #define EXT ".dll"
 #else
     #include <dlfcn.h>
+    #include <sys/mman.h>
     #define EXT ".so"
 #endif
 
@@ -51,7 +52,11 @@ const char *OP_NAMES[] = {
     "AND",
     "RANGE","SCOPE_ENTER", "SCOPE_EXIT",
     "DEBUGGER",
-    "PSH_ENUM"
+    "PSH_ENUM",
+    "ADD_C", "SUB_C",
+    "INC_LVAR", "INC_GVAR",
+    "LT_JZ", "EQ_JZ", "GT_JZ", "GE_JZ", "LE_JZ", "NEQ_JZ",
+    "LVAR_HGET"
 };
 
 
@@ -87,7 +92,14 @@ void mylo_runtime_error(VM* vm, const char* fmt, ...) {
 
 #define RUNTIME_ERROR(fmt, ...) mylo_runtime_error(vm, fmt, ##__VA_ARGS__)
 #define CHECK_STACK(count) if (vm->sp < (count) - 1) RUNTIME_ERROR("Stack Underflow")
-#define CHECK_OBJ(depth) if (vm->stack_types[vm->sp - (depth)] != T_OBJ) RUNTIME_ERROR("Expected Object/Array")
+#define CHECK_OBJ(depth) if (VAL_TYPE(vm->stack[vm->sp - (depth)]) != T_OBJ) RUNTIME_ERROR("Expected Object/Array")
+
+// Statistics counting, gone entirely unless built with MYLO_STATS
+#ifdef MYLO_STATS
+    #define VM_STAT(stmt) do { stmt; } while (0)
+#else
+    #define VM_STAT(stmt) do { } while (0)
+#endif
 
 // --- Helpers ---
 
@@ -114,11 +126,14 @@ unsigned long vm_hash_str(const char *str) {
 
 // --- Reference Management ---
 
+static void map_reindex(Value* data, int cap, int count);
+static void arena_ensure(MemoryArena* a, int id, int slots);
+
 // [REPLACEMENT] Recursive Deep Evacuation
 double vm_evacuate_object(VM* vm, double ptr_val, int target_head) {
     if (ptr_val == 0) return 0;
 
-    double* old_base = vm_resolve_ptr_safe(vm, ptr_val);
+    Value* old_base = vm_resolve_ptr_safe(vm, ptr_val);
     if (!old_base) return ptr_val; // Invalid or already handled
 
     int arena_id = UNPACK_ARENA(ptr_val);
@@ -161,12 +176,10 @@ double vm_evacuate_object(VM* vm, double ptr_val, int target_head) {
     // NOTE: OP_RET sets head = target_head BEFORE calling this.
     // So current_head IS target_head initially.
 
-    double* new_loc = &vm->arenas[arena_id].memory[current_head];
-    int* new_types = &vm->arenas[arena_id].types[current_head];
-    int* old_types = vm->arenas[arena_id].types + offset;
-
-    memmove(new_loc, old_base, size * sizeof(double));
-    memmove(new_types, old_types, size * sizeof(int));
+    arena_ensure(&vm->arenas[arena_id], arena_id, current_head + size);
+    Value* new_loc = &vm->arenas[arena_id].memory[current_head];
+    memmove(new_loc, old_base, size * sizeof(Value));
+    VM_STAT(vm->stats.evacuations++; vm->stats.evacuated_bytes += size * sizeof(Value));
 
     double new_ptr = PACK_PTR(vm->arenas[arena_id].generation, arena_id, current_head);
     vm->arenas[arena_id].head += size; // Advance head immediately
@@ -177,104 +190,226 @@ double vm_evacuate_object(VM* vm, double ptr_val, int target_head) {
     if (type == TYPE_ARRAY) {
         int len = (int)new_loc[1];
         for (int i = 0; i < len; i++) {
-            if (new_types[HEAP_HEADER_ARRAY + i] == T_OBJ) {
+            Value child = new_loc[HEAP_HEADER_ARRAY + i];
+            if (VAL_TYPE(child) == T_OBJ) {
                 // Recursively evacuate the child.
                 // Note: This will append the child to the end of the heap (moving head forward).
-                new_loc[HEAP_HEADER_ARRAY + i] = vm_evacuate_object(vm, new_loc[HEAP_HEADER_ARRAY + i], target_head);
+                new_loc[HEAP_HEADER_ARRAY + i] = VAL_OBJ(vm_evacuate_object(vm, VAL_AS_PTR(child), target_head));
             }
         }
     } else if (type == TYPE_MAP) {
-        // Maps have a 'data' pointer at index 3 which is a raw array.
+        // Maps have a 'data' pointer at index 3 which is a raw block (entries + hash index).
         // We must evacuate that raw block manually as it has no header.
-        int cap = (int)new_loc[1];
-        double old_data_ptr = new_loc[3];
-        double* old_data_base = vm_resolve_ptr_safe(vm, old_data_ptr);
+        int cap = (int)new_loc[HEAP_OFFSET_CAP];
+        int count = (int)new_loc[HEAP_OFFSET_COUNT];
+        double old_data_ptr = (double)new_loc[HEAP_OFFSET_DATA];
+        Value* old_data_base = vm_resolve_ptr_safe(vm, old_data_ptr);
 
         if (old_data_base && UNPACK_OFFSET(old_data_ptr) >= target_head) {
-            int data_size = cap * 2;
+            int data_size = MAP_DATA_SLOTS(cap);
             int data_head = vm->arenas[arena_id].head;
+            arena_ensure(&vm->arenas[arena_id], arena_id, data_head + data_size);
 
-            double* new_data_loc = &vm->arenas[arena_id].memory[data_head];
-            int* new_data_types = &vm->arenas[arena_id].types[data_head];
-            int* old_data_types = vm_resolve_type(vm, old_data_ptr);
-
-            memmove(new_data_loc, old_data_base, data_size * sizeof(double));
-            memmove(new_data_types, old_data_types, data_size * sizeof(int));
+            Value* new_data_loc = &vm->arenas[arena_id].memory[data_head];
+            memmove(new_data_loc, old_data_base, data_size * sizeof(Value));
+            VM_STAT(vm->stats.evacuated_bytes += data_size * sizeof(Value));
 
             double new_data_ref = PACK_PTR(vm->arenas[arena_id].generation, arena_id, data_head);
             vm->arenas[arena_id].head += data_size;
-            new_loc[3] = new_data_ref; // Update Map's data pointer
+            new_loc[3] = (Value)new_data_ref; // Update Map's data pointer
 
-            // Recurse on values inside the map
-            for(int i=0; i<data_size; i++) {
-                if (new_data_types[i] == T_OBJ) {
-                    new_data_loc[i] = vm_evacuate_object(vm, new_data_loc[i], target_head);
+            // Recurse on the live keys/values (the index and spare entries are raw)
+            for(int i=0; i<count * 2; i++) {
+                if (VAL_TYPE(new_data_loc[i]) == T_OBJ) {
+                    new_data_loc[i] = VAL_OBJ(vm_evacuate_object(vm, VAL_AS_PTR(new_data_loc[i]), target_head));
                 }
             }
+            // Object keys may have moved, which changes their hash
+            map_reindex(new_data_loc, cap, count);
         }
     } else if (type >= 0) { // Struct
         int struct_size = (int)new_loc[1];
         for (int i = 0; i < struct_size; i++) {
             // Struct fields start at index 2
-            if (new_types[2 + i] == T_OBJ) {
-                new_loc[2 + i] = vm_evacuate_object(vm, new_loc[2 + i], target_head);
+            Value field = new_loc[2 + i];
+            if (VAL_TYPE(field) == T_OBJ) {
+                new_loc[2 + i] = VAL_OBJ(vm_evacuate_object(vm, VAL_AS_PTR(field), target_head));
             }
         }
     }
 
     return new_ptr;
 }
-#define MAX_REFS 1024
+// --- FFI Reference Store ---
+// A process-wide handle table, so a handle stored on one VM still resolves
+// in the workers it spawns. An id is (gen << REF_INDEX_BITS) | slot. A
+// slot's generation is bumped on store and on free (odd while live), so a
+// stale or double-freed id never reaches whatever reuses the slot. Freed
+// slots go on a lock-free list; type names are interned to small ids once.
+#define REF_INDEX_BITS 16
+#define MAX_REFS (1 << REF_INDEX_BITS)
+#define REF_GEN_MASK 0x7FFF
+#define MAX_REF_TYPES 1024
+#define REF_TYPE_CACHE 64
+
 typedef struct {
     void* ptr;
-    unsigned long type_hash;
+    volatile long long gen;       // Odd while the slot holds a live handle
+    volatile long long type_id;   // Interned type, 0 while free
+    long long next_free;
     bool is_copy;
 } RefEntry;
 
 static RefEntry ref_store[MAX_REFS];
-static int ref_next_id = 0;
+static volatile long long ref_top = 0;   // Slots ever handed out
+static volatile long long ref_free = 0;  // (tag << 32) | (slot + 1), 0 = empty
 
-double vm_store_copy(VM* vm, void* data, size_t size, const char* type_name) {
-    if (ref_next_id >= MAX_REFS) {
+static const char* volatile ref_types[MAX_REF_TYPES];
+
+typedef struct {
+    const char* name;
+    long long id;
+} RefTypeCacheEntry;
+
+static THREAD_LOCAL RefTypeCacheEntry ref_type_cache[REF_TYPE_CACHE];
+
+// Returns the interned id for a type name (slot + 1), or 0 if it is not
+// known and create is false. Callers usually pass string literals, so the
+// name's address is cached per thread to skip hashing on the hot path.
+static long long ref_type_id(const char* name, bool create) {
+    if (!name) return 0;
+    RefTypeCacheEntry* c = &ref_type_cache[((uintptr_t)name >> 3) % REF_TYPE_CACHE];
+    if (c->name == name && strcmp(ref_types[c->id - 1], name) == 0) return c->id;
+
+    unsigned long start = vm_hash_str(name) % MAX_REF_TYPES;
+    for (int i = 0; i < MAX_REF_TYPES; i++) {
+        int slot = (int)((start + i) % MAX_REF_TYPES);
+        const char* cur = ATOMIC_LOAD_PTR(&ref_types[slot]);
+        if (!cur) {
+            if (!create) return 0;
+            char* copy = strdup(name);
+            if (!copy) return 0;
+            if (ATOMIC_CAS_PTR(&ref_types[slot], NULL, copy)) {
+                cur = copy;
+            } else {
+                free(copy);
+                cur = ATOMIC_LOAD_PTR(&ref_types[slot]);
+            }
+        }
+        if (strcmp(cur, name) == 0) {
+            c->name = name;
+            c->id = slot + 1;
+            return slot + 1;
+        }
+    }
+    return 0;
+}
+
+static int ref_alloc() {
+    for (;;) {
+        long long head = ATOMIC_LOAD(&ref_free);
+        int idx = (int)(head & 0xFFFFFFFF) - 1;
+        if (idx < 0) {
+            long long top = ATOMIC_ADD(&ref_top, 1);
+            if (top < MAX_REFS) return (int)top;
+            ATOMIC_ADD(&ref_top, -1);
+            return -1;
+        }
+        long long tag = ((head >> 32) + 1) & 0x7FFFFFFF;
+        if (ATOMIC_CAS(&ref_free, head, (tag << 32) | ref_store[idx].next_free))
+            return idx;
+    }
+}
+
+static void ref_release(int idx) {
+    for (;;) {
+        long long head = ATOMIC_LOAD(&ref_free);
+        ref_store[idx].next_free = head & 0xFFFFFFFF;
+        long long tag = ((head >> 32) + 1) & 0x7FFFFFFF;
+        if (ATOMIC_CAS(&ref_free, head, (tag << 32) | (idx + 1))) return;
+    }
+}
+
+static double ref_store_put(void* ptr, bool is_copy, const char* type_name) {
+    long long type_id = ref_type_id(type_name, true);
+    int idx = type_id ? ref_alloc() : -1;
+    if (idx < 0) {
         printf("Runtime Error: Reference limit reached\n");
         return -1.0;
     }
+    RefEntry* e = &ref_store[idx];
+    e->ptr = ptr;
+    e->is_copy = is_copy;
+    ATOMIC_STORE(&e->type_id, type_id);
+    long long gen = ATOMIC_LOAD(&e->gen) + 1;
+    ATOMIC_STORE(&e->gen, gen);
+    return (double)((((gen >> 1) & REF_GEN_MASK) << REF_INDEX_BITS) | idx);
+}
+
+// Returns the live entry for id, or NULL if it was freed or never stored
+static RefEntry* ref_lookup(int id, long long* gen_out) {
+    if (id < 0) return NULL;
+    int idx = id & (MAX_REFS - 1);
+    if (idx >= ATOMIC_LOAD(&ref_top)) return NULL;
+    long long gen = ATOMIC_LOAD(&ref_store[idx].gen);
+    if (!(gen & 1) || ((gen >> 1) & REF_GEN_MASK) != (id >> REF_INDEX_BITS)) return NULL;
+    *gen_out = gen;
+    return &ref_store[idx];
+}
+
+// Not safe against concurrent use; only called while resetting the main VM
+static void ref_store_clear() {
+    long long top = ATOMIC_LOAD(&ref_top);
+    for (long long i = 0; i < top; i++) {
+        RefEntry* e = &ref_store[i];
+        if (e->gen & 1) {
+            if (e->is_copy && e->ptr) free(e->ptr);
+            e->gen++;
+        }
+        e->ptr = NULL;
+        e->type_id = 0;
+    }
+    ATOMIC_STORE(&ref_top, 0);
+    ATOMIC_STORE(&ref_free, 0);
+}
+
+double vm_store_copy(VM* vm, void* data, size_t size, const char* type_name) {
     void* copy = malloc(size);
     if (!copy) return -1.0;
     memcpy(copy, data, size);
-
-    int id = ref_next_id++;
-    ref_store[id].ptr = copy;
-    ref_store[id].type_hash = vm_hash_str(type_name);
-    ref_store[id].is_copy = true;
-    return (double)id;
+    double id = ref_store_put(copy, true, type_name);
+    if (id < 0) free(copy);
+    return id;
 }
 
 double vm_store_ptr(VM* vm, void* ptr, const char* type_name) {
-    if (ref_next_id >= MAX_REFS) return -1.0;
-    int id = ref_next_id++;
-    ref_store[id].ptr = ptr;
-    ref_store[id].type_hash = vm_hash_str(type_name);
-    ref_store[id].is_copy = false;
-    return (double)id;
+    return ref_store_put(ptr, false, type_name);
 }
 
 void* vm_get_ref(VM* vm, int id, const char* expected_type_name) {
-    if (id < 0 || id >= ref_next_id) return NULL;
-    unsigned long expected_hash = vm_hash_str(expected_type_name);
-    if (ref_store[id].type_hash != expected_hash) return NULL;
-    return ref_store[id].ptr;
+    long long gen;
+    RefEntry* e = ref_lookup(id, &gen);
+    if (!e) return NULL;
+    long long type_id = ref_type_id(expected_type_name, false);
+    if (!type_id || ATOMIC_LOAD(&e->type_id) != type_id) return NULL;
+    void* ptr = e->ptr;
+    // Freed while we were reading
+    if (ATOMIC_LOAD(&e->gen) != gen) return NULL;
+    return ptr;
 }
 
 void vm_free_ref(VM* vm, int id) {
-    if (id >= 0 && id < ref_next_id) {
-        if (ref_store[id].is_copy && ref_store[id].ptr) free(ref_store[id].ptr);
-        ref_store[id].ptr = NULL;
-        ref_store[id].type_hash = 0;
-    }
+    long long gen;
+    RefEntry* e = ref_lookup(id, &gen);
+    // Only the caller that retires this generation frees the slot
+    if (!e || !ATOMIC_CAS(&e->gen, gen, gen + 1)) return;
+    if (e->is_copy && e->ptr) free(e->ptr);
+    e->ptr = NULL;
+    ATOMIC_STORE(&e->type_id, 0);
+    ref_release((int)(e - ref_store));
 }
 
-double* vm_resolve_ptr_safe(VM* vm, double ptr_val) {
+Value* vm_resolve_ptr_safe(VM* vm, double ptr_val) {
     int id = UNPACK_ARENA(ptr_val);
     int offset = UNPACK_OFFSET(ptr_val);
     int gen = UNPACK_GEN(ptr_val);
@@ -282,12 +417,77 @@ double* vm_resolve_ptr_safe(VM* vm, double ptr_val) {
     if (id < 0 || id >= MAX_ARENAS) return NULL;
     if (!vm->arenas[id].active) return NULL;
     if (vm->arenas[id].generation != gen) return NULL;
-    if (offset < 0 || offset >= vm->arenas[id].capacity) return NULL;
+    if (offset < 0 || offset >= vm->arenas[id].committed) return NULL;
 
     return &vm->arenas[id].memory[offset];
 }
 
 // --- Arena & Memory Management ---
+// An arena reserves MAX_HEAP slots of address space up front, so Value*
+// pointers into it never move, but only commits pages as the head reaches
+// them. Fresh pages read as zero, like the calloc this replaces.
+
+static Value* arena_reserve(size_t bytes) {
+#ifdef _WIN32
+    return (Value*)VirtualAlloc(NULL, bytes, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void* p = mmap(NULL, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return p == MAP_FAILED ? NULL : (Value*)p;
+#endif
+}
+
+static bool arena_commit(Value* p, size_t bytes) {
+#ifdef _WIN32
+    return VirtualAlloc(p, bytes, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+    return mprotect(p, bytes, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+static void arena_decommit(Value* p, size_t bytes) {
+#ifdef _WIN32
+    VirtualFree(p, bytes, MEM_DECOMMIT);
+#else
+    // Mapping fresh PROT_NONE pages over the range drops both the pages and their commit charge
+    mmap(p, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+#endif
+}
+
+static void arena_unreserve(Value* p, size_t bytes) {
+#ifdef _WIN32
+    (void)bytes;
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    munmap(p, bytes);
+#endif
+}
+
+// Makes sure the first `slots` slots of the arena are committed
+static void arena_ensure(MemoryArena* a, int id, int slots) {
+    if (slots <= a->committed) return;
+    int target = ((slots + ARENA_COMMIT_CHUNK - 1) / ARENA_COMMIT_CHUNK) * ARENA_COMMIT_CHUNK;
+    if (target > a->capacity) target = a->capacity;
+    if (!arena_commit(a->memory + a->committed, (size_t)(target - a->committed) * sizeof(Value))) {
+        fprintf(stderr, "Critical: Failed to commit memory for Arena %d\n", id);
+        mylo_exit(1);
+    }
+    a->committed = target;
+}
+
+// Moves the head back (scope exit / return). If that leaves a lot of committed
+// slack, the pages beyond half the threshold above the head go back to the OS.
+// Keeping half avoids recommitting on every iteration of a loop that allocates.
+static inline void arena_rewind(VM* vm, int id, int head) {
+    MemoryArena* a = &vm->arenas[id];
+    if (a->frozen) return;
+    VM_STAT(vm->stats.rewinds++; if (head < a->head) vm->stats.rewound_bytes += (a->head - head) * sizeof(Value));
+    a->head = head;
+    if (a->committed - head > ARENA_RELEASE_THRESHOLD) {
+        int keep = ((head + ARENA_RELEASE_THRESHOLD / 2 + ARENA_COMMIT_CHUNK - 1) / ARENA_COMMIT_CHUNK) * ARENA_COMMIT_CHUNK;
+        arena_decommit(a->memory + keep, (size_t)(a->committed - keep) * sizeof(Value));
+        a->committed = keep;
+    }
+}
 
 void init_arena(VM* vm, int id) {
     if (id < 0 || id >= MAX_ARENAS) return;
@@ -297,15 +497,14 @@ void init_arena(VM* vm, int id) {
 
     if (vm->arenas[id].memory == NULL) {
         vm->arenas[id].capacity = MAX_HEAP;
-        // Use calloc for safety (zeroed memory) on NEW allocations
-        vm->arenas[id].memory = (double*)calloc(MAX_HEAP, sizeof(double));
-        vm->arenas[id].types = (int*)calloc(MAX_HEAP, sizeof(int));
+        vm->arenas[id].committed = 0;
+        vm->arenas[id].memory = arena_reserve((size_t)MAX_HEAP * sizeof(Value));
     }
 
     vm->arenas[id].head = 0;
     vm->arenas[id].active = true;
 
-    if (!vm->arenas[id].memory || !vm->arenas[id].types) {
+    if (!vm->arenas[id].memory) {
         fprintf(stderr, "Critical: Failed to allocate Arena %d\n", id);
         mylo_exit(1);
     }
@@ -313,35 +512,67 @@ void init_arena(VM* vm, int id) {
 
 void free_arena(VM* vm, int id) {
     if (id < 0 || id >= MAX_ARENAS) return;
-    if (vm->arenas[id].memory) {
-        free(vm->arenas[id].memory);
+    if (vm->arenas[id].borrowed) {
+        // The owner still has it; just forget the view
         vm->arenas[id].memory = NULL;
+        vm->arenas[id].borrowed = false;
     }
-    if (vm->arenas[id].types) {
-        free(vm->arenas[id].types);
-        vm->arenas[id].types = NULL;
+    if (vm->arenas[id].memory) {
+        arena_unreserve(vm->arenas[id].memory, (size_t)vm->arenas[id].capacity * sizeof(Value));
+        vm->arenas[id].memory = NULL;
     }
     vm->arenas[id].active = false;
+    vm->arenas[id].frozen = false;
     vm->arenas[id].head = 0;
+    vm->arenas[id].committed = 0;
+}
+
+static void string_pool_reset(VM* vm);
+static void string_pool_free(VM* vm);
+
+// --- Program Image ---
+// Shared across threads (parent and workers), so the count is updated atomically.
+
+static ProgramImage* program_image_new(void) {
+    ProgramImage* img = (ProgramImage*)calloc(1, sizeof(ProgramImage));
+    if (!img) return NULL;
+    img->bytecode  = (int*)malloc(MAX_CODE * sizeof(int));
+    img->lines     = (int*)malloc(MAX_CODE * sizeof(int));
+    img->constants = (double*)malloc(MAX_CONSTANTS * sizeof(double));
+    img->functions = (VMFunction*)malloc(MAX_VM_FUNCTIONS * sizeof(VMFunction));
+    img->refcount = 1;
+    return img;
+}
+
+static void program_image_release(ProgramImage* img) {
+    if (ATOMIC_ADD(&img->refcount, -1) != 1) return;
+    if (img->jit_release) img->jit_release(img);
+    free(img->stack_need);
+    free(img->bytecode);
+    free(img->lines);
+    free(img->constants);
+    free(img->functions);
+    free(img);
+}
+
+static void vm_attach_image(VM* vm, ProgramImage* img) {
+    vm->image = img;
+    vm->bytecode = img ? img->bytecode : NULL;
+    vm->lines = img ? img->lines : NULL;
+    vm->constants = img ? img->constants : NULL;
+    vm->functions = img ? img->functions : NULL;
 }
 
 void vm_cleanup(VM* vm) {
-    if (vm->bytecode) { free(vm->bytecode); vm->bytecode = NULL; }
-    if (vm->lines) { free(vm->lines); vm->lines = NULL; }
+    if (vm->image) program_image_release(vm->image);
+    vm_attach_image(vm, NULL);
     if (vm->stack) { free(vm->stack); vm->stack = NULL; }
-    if (vm->stack_types) { free(vm->stack_types); vm->stack_types = NULL; }
     if (vm->globals) { free(vm->globals); vm->globals = NULL; }
-    if (vm->global_types) { free(vm->global_types); vm->global_types = NULL; }
-    if (vm->constants) { free(vm->constants); vm->constants = NULL; }
 
     for (int i = 0; i < MAX_ARENAS; i++) free_arena(vm, i);
-    if (vm->string_pool) { free(vm->string_pool); vm->string_pool = NULL; }
+    string_pool_free(vm);
 
-    for (int i = 0; i < ref_next_id; i++) {
-        if (ref_store[i].is_copy && ref_store[i].ptr) free(ref_store[i].ptr);
-        ref_store[i].ptr = NULL;
-    }
-    ref_next_id = 0;
+    ref_store_clear();
 
     vm->sp = -1; vm->ip = 0; vm->str_count = 0;
     if (vm->global_symbols) { free(vm->global_symbols); vm->global_symbols = NULL; }
@@ -354,67 +585,83 @@ void register_stdlib(VM* vm) {
         i++;
     }
 }
+static void vm_init_state(VM* vm);
+
+// Soft reset of the per-VM execution state: registers, string pool, globals
+// and arena 0 keep their allocations; extra regions are released.
+static void vm_reset_state(VM* vm) {
+    // 1. Reset Registers & Counters
+    vm->sp = -1;
+    vm->ip = 0;
+    vm->fp = 0;
+    vm->code_size = 0;
+    vm->run_depth = 0;
+    string_pool_reset(vm);
+    vm->const_count = 0;
+    vm->function_count = 0;
+    vm->output_mem_pos = 0;
+    vm->output_char_buffer[0] = '\0';
+    vm->global_symbol_count = 0;
+    vm->local_symbol_count = 0;
+    vm->cli_debug_mode = false;
+    vm->last_debug_line = -1;
+    vm->dependency_count = 0; // [NEW] Reset dependencies
+    VM_STAT(memset(&vm->stats, 0, sizeof(vm->stats)));
+
+    // 2. Clear Small Buffers
+    memset(vm->natives, 0, sizeof(vm->natives));
+    memset(vm->globals, 0, MAX_GLOBALS * sizeof(Value));
+    // Note: Stack doesn't need explicit clearing as sp=-1 protects it,
+    // but if paranoid: memset(vm->stack, 0, STACK_SIZE * sizeof(Value));
+
+    // 3. Reset Arena 0 (Main Heap) - Reuse Memory!
+    // We only zero the portion that was used (`head`), not the whole capacity.
+    if (vm->arenas[0].memory) {
+        size_t used_slots = vm->arenas[0].head;
+        if (used_slots > 0) {
+            memset(vm->arenas[0].memory, 0, used_slots * sizeof(Value));
+        }
+        // Logic from init_arena logic, manually applied for speed
+        vm->arenas[0].generation = (vm->arenas[0].generation + 1) & 0x3FFF;
+        if (vm->arenas[0].generation == 0) vm->arenas[0].generation = 1;
+        arena_rewind(vm, 0, 0);
+        vm->arenas[0].active = true;
+    } else {
+        // Fallback if Arena 0 was manually freed for some reason
+        init_arena(vm, 0);
+    }
+
+    // 4. Free Extra Regions (Tests expect a clean slate)
+    for (int i = 1; i < MAX_ARENAS; i++) {
+        free_arena(vm, i);
+    }
+    vm->current_arena = 0;
+}
+
 void vm_init(VM* vm) {
     vm->scope_sp = 0;
     // OPTIMIZATION: Soft Reset if VM is already initialized
     // Instead of freeing everything and calloc-ing (zeroing) the whole heap again,
     // we reuse the pointers and only zero-out the memory that was *used* in the last run.
     if (vm->bytecode) {
-        // 1. Reset Registers & Counters
-        vm->sp = -1;
-        vm->ip = 0;
-        vm->fp = 0;
-        vm->code_size = 0;
-        vm->str_count = 0;
-        vm->const_count = 0;
-        vm->function_count = 0;
-        vm->output_mem_pos = 0;
-        vm->output_char_buffer[0] = '\0';
-        vm->global_symbol_count = 0;
-        vm->local_symbol_count = 0;
-        vm->cli_debug_mode = false;
-        vm->last_debug_line = -1;
-        vm->dependency_count = 0; // [NEW] Reset dependencies
-
-        // 2. Clear Small Buffers
-        memset(vm->natives, 0, sizeof(vm->natives));
-        memset(vm->globals, 0, MAX_GLOBALS * sizeof(double));
-        memset(vm->global_types, 0, MAX_GLOBALS * sizeof(int));
-        // Note: Stack doesn't need explicit clearing as sp=-1 protects it,
-        // but if paranoid: memset(vm->stack, 0, STACK_SIZE * sizeof(double));
-
-        // 3. Clean up References
-        for (int i = 0; i < ref_next_id; i++) {
-            if (ref_store[i].is_copy && ref_store[i].ptr) free(ref_store[i].ptr);
-            ref_store[i].ptr = NULL;
-        }
-        ref_next_id = 0;
-
-        // 4. Reset Arena 0 (Main Heap) - Reuse Memory!
-        // We only zero the portion that was used (`head`), not the whole capacity.
-        if (vm->arenas[0].memory) {
-            size_t used_doubles = vm->arenas[0].head;
-            if (used_doubles > 0) {
-                memset(vm->arenas[0].memory, 0, used_doubles * sizeof(double));
-                memset(vm->arenas[0].types, 0, used_doubles * sizeof(int));
-            }
-            // Logic from init_arena logic, manually applied for speed
-            vm->arenas[0].generation = (vm->arenas[0].generation + 1) & 0x3FFF;
-            if (vm->arenas[0].generation == 0) vm->arenas[0].generation = 1;
-            vm->arenas[0].head = 0;
-            vm->arenas[0].active = true;
+        // 0. A worker still running on our image keeps the old one; compile into a fresh image
+        if (vm->image->refcount > 1) {
+            program_image_release(vm->image);
+            vm_attach_image(vm, program_image_new());
         } else {
-            // Fallback if Arena 0 was manually freed for some reason
-            init_arena(vm, 0);
+            // Code compiled for, and verification of, the previous program
+            if (vm->image->jit_release) vm->image->jit_release(vm->image);
+            free(vm->image->stack_need);
+            vm->image->stack_need = NULL;
         }
 
-        // 5. Free Extra Regions (Tests expect a clean slate)
-        for (int i = 1; i < MAX_ARENAS; i++) {
-            free_arena(vm, i);
-        }
-        vm->current_arena = 0;
+        // 1. Registers, string pool, globals and arenas
+        vm_reset_state(vm);
+
+        // 2. Clean up References
+        ref_store_clear();
 
-        // 6. Clear Debug Symbols (Compiler re-allocates these)
+        // 3. Clear Debug Symbols (Compiler re-allocates these)
         if (vm->global_symbols) { free(vm->global_symbols); vm->global_symbols = NULL; }
         if (vm->local_symbols) { free(vm->local_symbols); vm->local_symbols = NULL; }
 
@@ -423,17 +670,64 @@ void vm_init(VM* vm) {
     }
 
     // --- Cold Start (First Run) ---
+    vm_attach_image(vm, program_image_new());
+    vm_init_state(vm);
+}
 
-    vm->bytecode = (int*)malloc(MAX_CODE * sizeof(int));
-    vm->lines    = (int*)malloc(MAX_CODE * sizeof(int));
+// Starts a worker VM on its parent's program image. Code, constants and
+// the function table are shared rather than copied. Only per-thread state
+// is allocated: the stack, globals, string pool and arena 0 (reserved lazily).
+// A worker VM kept from an earlier job is soft-reset and reuses all of those.
+void vm_init_worker(VM* vm, VM* parent) {
+    vm->scope_sp = 0;
+    ATOMIC_ADD(&parent->image->refcount, 1);
+    if (vm->image) program_image_release(vm->image);
+    vm_attach_image(vm, parent->image);
+    if (vm->stack) vm_reset_state(vm);
+    else vm_init_state(vm);
+
+    vm->code_size = parent->code_size;
+    vm->const_count = parent->const_count;
+    vm->function_count = parent->function_count;
+    memcpy(vm->globals, parent->globals, MAX_GLOBALS * sizeof(Value));
+    memcpy(vm->natives, parent->natives, sizeof(vm->natives));
+    vm_clone_strings(vm, parent);
+
+    // Frozen regions are shared in place, under the same ids
+    for (int i = 1; i < MAX_ARENAS; i++) {
+        if (!parent->arenas[i].frozen) continue;
+        vm->arenas[i] = parent->arenas[i];
+        vm->arenas[i].borrowed = true;
+    }
+}
 
-    vm->stack       = (double*)calloc(STACK_SIZE, sizeof(double));
-    vm->stack_types = (int*)calloc(STACK_SIZE, sizeof(int));
-    vm->globals      = (double*)calloc(MAX_GLOBALS, sizeof(double));
-    vm->global_types = (int*)calloc(MAX_GLOBALS, sizeof(int));
+// Drops a finished worker's hold on the program image. Its stack, string pool
+// and arenas stay allocated for the next vm_init_worker.
+void vm_park_worker(VM* vm) {
+    if (vm->image) program_image_release(vm->image);
+    vm_attach_image(vm, NULL);
+}
 
-    vm->constants = (double*)malloc(MAX_CONSTANTS * sizeof(double));
-    vm->string_pool = malloc(MAX_STRINGS * MAX_STRING_LENGTH);
+// Drops everything allocated in the current arena above `head` (a mark taken
+// earlier from vm->arenas[vm->current_arena].head).
+void vm_rewind_heap(VM* vm, int head) {
+    arena_rewind(vm, vm->current_arena, head);
+}
+
+// Per-VM execution state for a cold start (everything outside the program image)
+static void vm_init_state(VM* vm) {
+    vm->stack   = (Value*)calloc(STACK_SIZE, sizeof(Value));
+    vm->globals = (Value*)calloc(MAX_GLOBALS, sizeof(Value));
+    VM_STAT(memset(&vm->stats, 0, sizeof(vm->stats)));
+
+    vm->string_pool = (char**)malloc(STRING_POOL_INITIAL_CAP * sizeof(char*));
+    vm->str_capacity = STRING_POOL_INITIAL_CAP;
+    vm->str_flags = (uint8_t*)malloc(STRING_POOL_INITIAL_CAP);
+    vm->str_free = (int*)malloc(STRING_POOL_INITIAL_CAP * sizeof(int));
+    vm->str_index = (int*)calloc(STRING_POOL_INITIAL_CAP * 2, sizeof(int));
+    vm->str_index_cap = STRING_POOL_INITIAL_CAP * 2;
+    vm->str_chunks = NULL;
+    string_pool_reset(vm);
     memset(vm->arenas, 0, sizeof(vm->arenas));
 
     init_arena(vm, 0);
@@ -449,7 +743,7 @@ void vm_init(VM* vm) {
     vm->ip = 0;
     vm->fp = 0;
     vm->code_size = 0;
-    vm->str_count = 0;
+    vm->run_depth = 0;
     vm->const_count = 0;
     vm->function_count = 0;
     vm->output_mem_pos = 0;
@@ -466,7 +760,7 @@ void vm_init(VM* vm) {
     register_stdlib(vm);
 }
 
-double* vm_resolve_ptr(VM* vm, double ptr_val) {
+Value* vm_resolve_ptr(VM* vm, double ptr_val) {
     int id = UNPACK_ARENA(ptr_val);
     int offset = UNPACK_OFFSET(ptr_val);
     int gen = UNPACK_GEN(ptr_val);
@@ -483,58 +777,575 @@ double* vm_resolve_ptr(VM* vm, double ptr_val) {
         RUNTIME_ERROR("Access violation: Stale pointer to recycled Region %d", id);
         return NULL;
     }
-    if (offset < 0 || offset >= vm->arenas[id].capacity) {
+    if (offset < 0 || offset >= vm->arenas[id].committed) {
         RUNTIME_ERROR("Heap overflow access");
         return NULL;
     }
     return &vm->arenas[id].memory[offset];
 }
 
-int* vm_resolve_type(VM* vm, double ptr_val) {
-    int id = UNPACK_ARENA(ptr_val);
-    int offset = UNPACK_OFFSET(ptr_val);
-    int gen = UNPACK_GEN(ptr_val);
-
-    if (id < 0 || id >= MAX_ARENAS || !vm->arenas[id].active) return NULL;
-    if (vm->arenas[id].generation != gen) return NULL;
-    return &vm->arenas[id].types[offset];
-}
-
 double heap_alloc(VM* vm, int size) {
     int id = vm->current_arena;
     if (!vm->arenas[id].active) init_arena(vm, id);
+    if (vm->arenas[id].frozen) {
+        printf("Runtime Error: Cannot allocate in frozen Region %d\n", id);
+        mylo_exit(1);
+    }
 
     if (vm->arenas[id].head + size >= vm->arenas[id].capacity) {
         printf("Error: Heap Overflow in Region %d!\n", id);
         mylo_exit(1);
 
     }
+    arena_ensure(&vm->arenas[id], id, vm->arenas[id].head + size);
     int offset = vm->arenas[id].head;
     vm->arenas[id].head += size;
+    if (vm->profile) vm->profile->alloc_slots += size;
+    VM_STAT(vm->stats.heap_allocs[id]++; vm->stats.heap_alloc_bytes[id] += size * sizeof(Value));
     return PACK_PTR(vm->arenas[id].generation, id, offset);
 }
 
-void vm_push(VM* vm, double val, int type) {
+// --- Maps ---
+// Header: [TYPE_MAP, cap, count, data]. The data block holds `cap` [key, value]
+// entries in insertion order (so iteration and printing just walk them), then
+// a hash index of 2 * cap int32 slots, each 0 (empty) or entry + 1, probed
+// linearly. Keys hash on (tag, value) to agree with mylo_val_equal.
+
+static inline int32_t* map_index(Value* data, int cap) {
+    return (int32_t*)&data[cap * 2];
+}
+
+static inline uint32_t map_hash(Value key) {
+    uint64_t h = key;
+    if (VAL_IS_NUM(key)) {
+        double d = VAL_AS_NUM(key);
+        if (d == 0) d = 0; // -0 and 0 are the same key
+        memcpy(&h, &d, sizeof(h));
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return (uint32_t)h;
+}
+
+static void map_reindex(Value* data, int cap, int count) {
+    int32_t* index = map_index(data, cap);
+    uint32_t mask = (uint32_t)(cap * 2 - 1);
+    memset(index, 0, sizeof(int32_t) * cap * 2);
+    for (int i = 0; i < count; i++) {
+        uint32_t slot = map_hash(data[i * 2]) & mask;
+        while (index[slot]) slot = (slot + 1) & mask;
+        index[slot] = i + 1;
+    }
+}
+
+double vm_map_new(VM* vm, int cap) {
+    double map = heap_alloc(vm, HEAP_HEADER_MAP);
+    double data = heap_alloc(vm, MAP_DATA_SLOTS(cap));
+    Value* base = vm_resolve_ptr(vm, map);
+    base[HEAP_OFFSET_TYPE] = TYPE_MAP;
+    base[HEAP_OFFSET_CAP] = cap;
+    base[HEAP_OFFSET_COUNT] = 0;
+    base[HEAP_OFFSET_DATA] = (Value)data;
+    map_reindex(vm_resolve_ptr(vm, data), cap, 0);
+    return map;
+}
+
+// Returns the entry index of `key`, or -1.
+int vm_map_find(VM* vm, Value* base, Value key) {
+    int cap = (int)base[HEAP_OFFSET_CAP];
+    Value* data = vm_resolve_ptr(vm, (double)base[HEAP_OFFSET_DATA]);
+    int32_t* index = map_index(data, cap);
+    uint32_t mask = (uint32_t)(cap * 2 - 1);
+    for (uint32_t slot = map_hash(key) & mask; index[slot]; slot = (slot + 1) & mask) {
+        int e = index[slot] - 1;
+        if (mylo_val_equal(data[e * 2], key)) return e;
+    }
+    return -1;
+}
+
+void vm_map_set(VM* vm, double map_ptr, Value key, Value val) {
+    Value* base = vm_resolve_ptr(vm, map_ptr);
+    int cap = (int)base[HEAP_OFFSET_CAP];
+    int count = (int)base[HEAP_OFFSET_COUNT];
+    Value* data = vm_resolve_ptr(vm, (double)base[HEAP_OFFSET_DATA]);
+
+    int e = vm_map_find(vm, base, key);
+    if (e != -1) {
+        data[e * 2 + 1] = val;
+        return;
+    }
+
+    if (count >= cap) {
+        int new_cap = cap * 2;
+        double new_data_ptr = heap_alloc(vm, MAP_DATA_SLOTS(new_cap));
+        Value* new_data = vm_resolve_ptr(vm, new_data_ptr);
+        memcpy(new_data, data, count * 2 * sizeof(Value));
+        map_reindex(new_data, new_cap, count);
+        base[HEAP_OFFSET_CAP] = new_cap;
+        base[HEAP_OFFSET_DATA] = (Value)new_data_ptr;
+        data = new_data;
+        cap = new_cap;
+
+        int map_offset = UNPACK_OFFSET(map_ptr);
+        for (int s = 0; s < vm->scope_sp; s++) {
+            // If the scope belongs to this arena AND the map is older than the scope
+            if (vm->scope_stack[s].arena_id == vm->current_arena &&
+                vm->scope_stack[s].head > map_offset) {
+
+                // Shift the scope's rewind point to protect the new allocation
+                vm->scope_stack[s].head = vm->arenas[vm->current_arena].head;
+            }
+        }
+    }
+
+    data[count * 2] = key;
+    data[count * 2 + 1] = val;
+    base[HEAP_OFFSET_COUNT] = count + 1;
+
+    int32_t* index = map_index(data, cap);
+    uint32_t mask = (uint32_t)(cap * 2 - 1);
+    uint32_t slot = map_hash(key) & mask;
+    while (index[slot]) slot = (slot + 1) & mask;
+    index[slot] = count + 1;
+}
+
+// Removes `key`, keeping the remaining entries in insertion order.
+bool vm_map_remove(VM* vm, Value* base, Value key) {
+    int e = vm_map_find(vm, base, key);
+    if (e == -1) return false;
+
+    int cap = (int)base[HEAP_OFFSET_CAP];
+    int count = (int)base[HEAP_OFFSET_COUNT];
+    Value* data = vm_resolve_ptr(vm, (double)base[HEAP_OFFSET_DATA]);
+    int pairs_to_move = count - 1 - e;
+    if (pairs_to_move > 0) {
+        memmove(&data[e * 2], &data[(e + 1) * 2], pairs_to_move * 2 * sizeof(Value));
+    }
+    base[HEAP_OFFSET_COUNT] = count - 1;
+    map_reindex(data, cap, count - 1);
+    return true;
+}
+
+// --- Value Packing ---
+// Flattens a value into a blob that does not reference any VM, so another VM
+// can rebuild it in its own arena and string pool. Numbers and enums are
+// stored as-is; strings and heap objects are deep-copied.
+enum { PACK_RAW, PACK_STR, PACK_ARRAY, PACK_MAP, PACK_STRUCT, PACK_TYPED };
+
+typedef struct {
+    uint8_t* data;
+    size_t len;
+    size_t cap;
+} PackBuf;
+
+static void pack_bytes(PackBuf* b, const void* src, size_t n) {
+    if (b->len + n > b->cap) {
+        size_t cap = b->cap ? b->cap : 64;
+        while (cap < b->len + n) cap *= 2;
+        b->data = (uint8_t*)realloc(b->data, cap);
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, src, n);
+    b->len += n;
+}
+
+static void pack_tag(PackBuf* b, uint8_t tag, int32_t n) {
+    pack_bytes(b, &tag, 1);
+    pack_bytes(b, &n, sizeof(n));
+}
+
+static void pack_value(VM* vm, PackBuf* b, Value v, int depth) {
+    if (depth > VALUE_PACK_MAX_DEPTH) RUNTIME_ERROR("Value nested too deeply to copy between VMs");
+
+    int t = VAL_TYPE(v);
+    if (t == T_STR) {
+        int id = VAL_AS_STR(v);
+        const char* s = (id >= 0 && id < vm->str_count) ? vm->string_pool[id] : NULL;
+        int len = s ? vm_string_len(vm, id) : 0;
+        pack_tag(b, PACK_STR, len);
+        if (len > 0) pack_bytes(b, s, len);
+        return;
+    }
+
+    Value* base = t == T_OBJ ? vm_resolve_ptr_safe(vm, VAL_AS_PTR(v)) : NULL;
+    if (!base) {
+        uint8_t tag = PACK_RAW;
+        pack_bytes(b, &tag, 1);
+        pack_bytes(b, &v, sizeof(v));
+        return;
+    }
+
+    int type = (int)base[HEAP_OFFSET_TYPE];
+    int len = (int)base[HEAP_OFFSET_LEN];
+    if (type == TYPE_ARRAY) {
+        pack_tag(b, PACK_ARRAY, len);
+        for (int i = 0; i < len; i++) pack_value(vm, b, base[HEAP_HEADER_ARRAY + i], depth + 1);
+    } else if (type == TYPE_MAP) {
+        int count = (int)base[HEAP_OFFSET_COUNT];
+        Value* data = vm_resolve_ptr(vm, (double)base[HEAP_OFFSET_DATA]);
+        pack_tag(b, PACK_MAP, count);
+        for (int i = 0; i < count * 2; i++) pack_value(vm, b, data[i], depth + 1);
+    } else if (type >= 0) {
+        pack_tag(b, PACK_STRUCT, type);
+        pack_bytes(b, &len, sizeof(len));
+        for (int i = 0; i < len; i++) pack_value(vm, b, base[HEAP_HEADER_STRUCT + i], depth + 1);
+    } else {
+        // Bytes and typed arrays: raw element storage after the header
+        int slots = (len * get_type_size(type) + 7) / 8;
+        pack_tag(b, PACK_TYPED, type);
+        pack_bytes(b, &len, sizeof(len));
+        pack_bytes(b, &base[HEAP_HEADER_ARRAY], slots * sizeof(Value));
+    }
+}
+
+static int32_t unpack_i32(const uint8_t** p) {
+    int32_t n;
+    memcpy(&n, *p, sizeof(n));
+    *p += sizeof(n);
+    return n;
+}
+
+static Value unpack_value(VM* vm, const uint8_t** p) {
+    uint8_t tag = *(*p)++;
+    if (tag == PACK_RAW) {
+        Value v;
+        memcpy(&v, *p, sizeof(v));
+        *p += sizeof(v);
+        return v;
+    }
+
+    int32_t n = unpack_i32(p);
+    if (tag == PACK_STR) {
+        int id = make_string_len(vm, (const char*)*p, n);
+        *p += n;
+        return VAL_STR(id);
+    }
+    if (tag == PACK_MAP) {
+        int cap = MAP_INITIAL_CAP;
+        while (cap < n) cap *= 2;
+        double map = vm_map_new(vm, cap);
+        for (int i = 0; i < n; i++) {
+            Value key = unpack_value(vm, p);
+            Value val = unpack_value(vm, p);
+            vm_map_set(vm, map, key, val);
+        }
+        return VAL_OBJ(map);
+    }
+
+    // Arrays, structs and typed arrays share the [type, len, ...] layout
+    int type = tag == PACK_ARRAY ? TYPE_ARRAY : n;
+    int len = tag == PACK_ARRAY ? n : unpack_i32(p);
+    int slots = tag == PACK_TYPED ? (len * get_type_size(type) + 7) / 8 : len;
+    double ptr = heap_alloc(vm, slots + HEAP_HEADER_ARRAY);
+    Value* base = vm_resolve_ptr(vm, ptr);
+    base[HEAP_OFFSET_TYPE] = type;
+    base[HEAP_OFFSET_LEN] = len;
+    if (tag == PACK_TYPED) {
+        memcpy(&base[HEAP_HEADER_ARRAY], *p, slots * sizeof(Value));
+        *p += slots * sizeof(Value);
+    } else {
+        for (int i = 0; i < len; i++) base[HEAP_HEADER_ARRAY + i] = unpack_value(vm, p);
+    }
+    return VAL_OBJ(ptr);
+}
+
+void* vm_pack_value(VM* vm, Value v, size_t* out_size) {
+    PackBuf b = {0};
+    pack_value(vm, &b, v, 0);
+    if (out_size) *out_size = b.len;
+    return b.data;
+}
+
+Value vm_unpack_value(VM* vm, const void* blob) {
+    const uint8_t* p = (const uint8_t*)blob;
+    return unpack_value(vm, &p);
+}
+
+void vm_push_value(VM* vm, Value v) {
     if (vm->sp >= STACK_SIZE - 1) { printf("Error: Stack Overflow\n"); mylo_exit(1);}
-    vm->sp++;
-    vm->stack[vm->sp] = val;
-    vm->stack_types[vm->sp] = type;
+    vm->stack[++vm->sp] = v;
 }
 
-double vm_pop(VM* vm) {
+Value vm_pop_value(VM* vm) {
     CHECK_STACK(1);
     return vm->stack[vm->sp--];
 }
 
-int make_string(VM* vm, const char *s) {
-    for (int j = 0; j < vm->str_count; j++) {
-        if (strcmp(vm->string_pool[j], s) == 0) return j;
+// Double-based API kept for natives and bindings: the payload travels as a
+// double and the tag is reapplied on push (read it back via VAL_TYPE).
+void vm_push(VM* vm, double val, int type) {
+    vm_push_value(vm, VAL_FROM(val, type));
+}
+
+double vm_pop(VM* vm) {
+    return VAL_AS_DOUBLE(vm_pop_value(vm));
+}
+
+// --- String Pool ---
+// Strings are interned: equal contents always share an id, so string equality
+// elsewhere in the VM is just an id compare. Lookup goes through an
+// open-addressing index keyed on a cached FNV-1a hash.
+//
+// Compile-time literals are pinned. Runtime strings are reclaimed by
+// vm_collect_strings once they are no longer reachable; freed ids are reused.
+
+#define STR_PINNED 1
+#define STR_MARKED 2
+
+static uint32_t string_hash(const char* s, int len) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static char* string_arena_alloc(VM* vm, int len) {
+    // Header + chars + NUL, rounded up so the next header stays aligned
+    size_t need = (sizeof(StringHeader) + (size_t)len + 1 + 7) & ~(size_t)7;
+    StringChunk* c = vm->str_chunks;
+    if (!c || c->used + need > c->capacity) {
+        size_t cap = need > STRING_CHUNK_SIZE ? need : STRING_CHUNK_SIZE;
+        StringChunk* fresh = malloc(sizeof(StringChunk) + cap);
+        if (!fresh) { printf("Error: String Pool Overflow\n"); mylo_exit(1); }
+        fresh->used = 0;
+        fresh->capacity = cap;
+        if (c && need > STRING_CHUNK_SIZE) {
+            // Oversized string: keep the current chunk at the head so its tail is still used
+            fresh->next = c->next;
+            c->next = fresh;
+        } else {
+            fresh->next = c;
+            vm->str_chunks = fresh;
+        }
+        c = fresh;
+    }
+    char* p = c->data + c->used;
+    c->used += need;
+    return p + sizeof(StringHeader);
+}
+
+static char* string_store(VM* vm, const char* s, int len, uint32_t hash) {
+    char* dst = string_arena_alloc(vm, len);
+    STRING_HEADER(dst)->len = len;
+    STRING_HEADER(dst)->hash = hash;
+    memcpy(dst, s, len);
+    dst[len] = '\0';
+    return dst;
+}
+
+static void string_reindex(VM* vm, int cap) {
+    free(vm->str_index);
+    vm->str_index = calloc(cap, sizeof(int));
+    vm->str_index_cap = cap;
+    for (int id = 0; id < vm->str_count; id++) {
+        if (!vm->string_pool[id]) continue;
+        int slot = STRING_HEADER(vm->string_pool[id])->hash & (cap - 1);
+        while (vm->str_index[slot]) slot = (slot + 1) & (cap - 1);
+        vm->str_index[slot] = id + 1;
+    }
+}
+
+// Returns a fresh id, reusing one freed by the collector when possible
+static int string_new_id(VM* vm) {
+    if (vm->str_free_count > 0) return vm->str_free[--vm->str_free_count];
+    if (vm->str_count >= vm->str_capacity) {
+        int cap = vm->str_capacity * 2;
+        char** grown = realloc(vm->string_pool, cap * sizeof(char*));
+        uint8_t* flags = realloc(vm->str_flags, cap);
+        int* free_ids = realloc(vm->str_free, cap * sizeof(int));
+        if (!grown || !flags || !free_ids) { printf("Error: String Pool Overflow\n"); mylo_exit(1); }
+        vm->string_pool = grown;
+        vm->str_flags = flags;
+        vm->str_free = free_ids;
+        vm->str_capacity = cap;
     }
-    if (vm->str_count >= MAX_STRINGS) { printf("Error: String Pool Overflow\n"); mylo_exit(1);}
-    strncpy(vm->string_pool[vm->str_count], s, MAX_STRING_LENGTH - 1);
     return vm->str_count++;
 }
 
+static void string_pool_reset(VM* vm) {
+    // Keep the newest chunk for reuse, release the rest
+    StringChunk* c = vm->str_chunks;
+    if (c) {
+        StringChunk* rest = c->next;
+        while (rest) { StringChunk* n = rest->next; free(rest); rest = n; }
+        c->next = NULL;
+        c->used = 0;
+    }
+    if (vm->str_index) memset(vm->str_index, 0, vm->str_index_cap * sizeof(int));
+    vm->str_count = 0;
+    vm->str_free_count = 0;
+    vm->str_bytes_since_gc = 0;
+    vm->str_gc_threshold = STRING_GC_THRESHOLD;
+    vm->str_gc_pending = false;
+}
+
+static void string_pool_free(VM* vm) {
+    while (vm->str_chunks) { StringChunk* n = vm->str_chunks->next; free(vm->str_chunks); vm->str_chunks = n; }
+    if (vm->string_pool) { free(vm->string_pool); vm->string_pool = NULL; }
+    if (vm->str_flags) { free(vm->str_flags); vm->str_flags = NULL; }
+    if (vm->str_free) { free(vm->str_free); vm->str_free = NULL; }
+    if (vm->str_index) { free(vm->str_index); vm->str_index = NULL; }
+    vm->str_capacity = 0;
+    vm->str_index_cap = 0;
+    vm->str_count = 0;
+    vm->str_free_count = 0;
+}
+
+int make_string_len(VM* vm, const char *s, int len) {
+    uint32_t h = string_hash(s, len);
+    int mask = vm->str_index_cap - 1;
+    int slot = h & mask;
+    VM_STAT(vm->stats.string_makes++);
+    while (vm->str_index[slot]) {
+        char* cand = vm->string_pool[vm->str_index[slot] - 1];
+        StringHeader* hdr = STRING_HEADER(cand);
+        if (hdr->hash == h && hdr->len == len && memcmp(cand, s, len) == 0) {
+            VM_STAT(vm->stats.string_hits++);
+            return vm->str_index[slot] - 1;
+        }
+        slot = (slot + 1) & mask;
+    }
+    VM_STAT(vm->stats.string_misses++);
+
+    int id = string_new_id(vm);
+    vm->string_pool[id] = string_store(vm, s, len, h);
+    vm->str_flags[id] = 0;
+    vm->str_index[slot] = id + 1;
+    // Keep the index at most half full so probe chains stay short
+    if ((vm->str_count - vm->str_free_count) * 2 > vm->str_index_cap) string_reindex(vm, vm->str_index_cap * 2);
+
+    vm->str_bytes_since_gc += sizeof(StringHeader) + len + 1;
+    if (vm->str_bytes_since_gc > vm->str_gc_threshold) vm->str_gc_pending = true;
+    return id;
+}
+
+int make_string(VM* vm, const char *s) {
+    return make_string_len(vm, s, (int)strlen(s));
+}
+
+// Ids that are out of range or freed read as "" (a value from another VM's
+// pool must never index past this one)
+int vm_string_len(VM* vm, int id) {
+    if (id < 0 || id >= vm->str_count || !vm->string_pool[id]) return 0;
+    return STRING_HEADER(vm->string_pool[id])->len;
+}
+
+const char* vm_get_string(VM* vm, int id) {
+    if (id < 0 || id >= vm->str_count || !vm->string_pool[id]) return "";
+    return vm->string_pool[id];
+}
+
+void vm_pin_string(VM* vm, int id) {
+    if (id >= 0 && id < vm->str_count) vm->str_flags[id] |= STR_PINNED;
+}
+
+// Re-interns the strings in an arena handed back by a worker (dock_worker),
+// so ids the worker made in its own pool name the same text in vm's. Scans
+// conservatively like vm_collect_strings.
+void vm_adopt_strings(VM* vm, VM* from, int arena_id) {
+    MemoryArena* a = &vm->arenas[arena_id];
+    if (!a->memory) return;
+    for (int i = 0; i < a->head; i++) {
+        Value v = a->memory[i];
+        if (VAL_IS_NUM(v) || VAL_TYPE(v) != T_STR) continue;
+        int id = VAL_AS_STR(v);
+        a->memory[i] = VAL_STR(make_string_len(vm, vm_get_string(from, id), vm_string_len(from, id)));
+    }
+}
+
+// Gives dst the same id -> string mapping as src (used to seed worker VMs)
+void vm_clone_strings(VM* dst, VM* src) {
+    string_pool_reset(dst);
+    for (int id = 0; id < src->str_count; id++) {
+        int dst_id = string_new_id(dst);
+        char* s = src->string_pool[id];
+        if (!s) {
+            dst->string_pool[dst_id] = NULL;
+            continue;
+        }
+        dst->string_pool[dst_id] = string_store(dst, s, vm_string_len(src, id), STRING_HEADER(s)->hash);
+        dst->str_flags[dst_id] = src->str_flags[id] & STR_PINNED;
+    }
+    // Holes become the clone's free list, handed out in the same order as src
+    for (int i = 0; i < src->str_free_count; i++) dst->str_free[i] = src->str_free[i];
+    dst->str_free_count = src->str_free_count;
+    int cap = dst->str_index_cap;
+    while (dst->str_count * 2 > cap) cap *= 2;
+    string_reindex(dst, cap);
+}
+
+static inline void string_mark_id(VM* vm, unsigned int id) {
+    if (id < (unsigned int)vm->str_count) vm->str_flags[id] |= STR_MARKED;
+}
+
+static void string_mark_values(VM* vm, const Value* vals, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        Value v = vals[i];
+        if (VAL_IS_NUM(v)) continue;
+        int t = VAL_TYPE(v);
+        if (t == T_STR) string_mark_id(vm, (unsigned int)VAL_AS_STR(v));
+        else if (t == T_ENUM) {
+            string_mark_id(vm, (unsigned int)((VAL_PAYLOAD(v) >> 16) & 0xFFFF));
+            string_mark_id(vm, (unsigned int)((VAL_PAYLOAD(v) >> 32) & 0xFFFF));
+        }
+    }
+}
+
+// Mark-and-sweep over runtime strings. Roots are the live stack, the globals
+// and every arena up to its head. Arena scanning is conservative: headers are
+// raw ints and never look like tagged strings, while dead objects below the
+// head simply keep their strings alive until the arena is reset.
+// Must only run between instructions: surviving strings are compacted, so
+// char pointers obtained from string_pool do not survive a collection.
+void vm_collect_strings(VM* vm) {
+    vm->str_gc_pending = false;
+    vm->str_bytes_since_gc = 0;
+
+    // A region lent to a worker can't be scanned from here, so wait for it to come back
+    for (int i = 0; i < MAX_ARENAS; i++) {
+        if (vm->arenas[i].active && !vm->arenas[i].memory) return;
+    }
+
+    string_mark_values(vm, vm->stack, vm->sp + 1);
+    string_mark_values(vm, vm->globals, MAX_GLOBALS);
+    for (int i = 0; i < MAX_ARENAS; i++) {
+        if (vm->arenas[i].memory) string_mark_values(vm, vm->arenas[i].memory, vm->arenas[i].head);
+    }
+
+    // Sweep, copying survivors into fresh chunks
+    StringChunk* old_chunks = vm->str_chunks;
+    vm->str_chunks = NULL;
+    size_t live_bytes = 0;
+    for (int id = 0; id < vm->str_count; id++) {
+        char* s = vm->string_pool[id];
+        if (!s) continue;
+        if (vm->str_flags[id] & (STR_PINNED | STR_MARKED)) {
+            int len = STRING_HEADER(s)->len;
+            vm->string_pool[id] = string_store(vm, s, len, STRING_HEADER(s)->hash);
+            vm->str_flags[id] &= ~STR_MARKED;
+            live_bytes += sizeof(StringHeader) + len + 1;
+        } else {
+            vm->string_pool[id] = NULL;
+            vm->str_free[vm->str_free_count++] = id;
+        }
+    }
+    while (old_chunks) { StringChunk* n = old_chunks->next; free(old_chunks); old_chunks = n; }
+    string_reindex(vm, vm->str_index_cap);
+
+    // Collect again once as many bytes as are live now have been allocated
+    vm->str_gc_threshold = live_bytes > STRING_GC_THRESHOLD ? live_bytes : STRING_GC_THRESHOLD;
+}
+
+// Only the outermost run collects: re-entrant natives (map, filter...) may be
+// holding popped values in C locals where the collector can't see them.
+#define STRING_GC_SAFEPOINT(vm) \
+    do { if ((vm)->str_gc_pending && (vm)->run_depth <= 1) vm_collect_strings(vm); } while (0)
+
 int make_const(VM* vm, double val) {
     for (int i = 0; i < vm->const_count; i++) {
         if (vm->constants[i] == val) return i;
@@ -570,9 +1381,11 @@ void print_raw(VM* vm, const char* str) {
     }
 }
 
-void print_recursive(VM* vm, double val, int type, int depth, int max_elem) {
+void print_recursive(VM* vm, Value v, int depth, int max_elem) {
     if (depth > 10) { print_raw(vm, "..."); return; }
     char buf[64];
+    int type = VAL_TYPE(v);
+    double val = VAL_AS_DOUBLE(v);
 
     if (type == T_NUM) {
         if (val == (int)val) sprintf(buf, "%d", (int)val);
@@ -580,14 +1393,14 @@ void print_recursive(VM* vm, double val, int type, int depth, int max_elem) {
         print_raw(vm, buf);
     } else if (type == T_STR) {
         if (depth > 0) print_raw(vm, "\"");
-        print_raw(vm, vm->string_pool[(int)val]);
+        print_raw(vm, vm_get_string(vm, (int)val));
         if (depth > 0) print_raw(vm, "\"");
     } 
     else if (type == T_ENUM) {
         unsigned long long packed = (unsigned long long)val;
         int str_id = (packed >> 16) & 0xFFFF;
         if (depth > 0) print_raw(vm, "\"");
-        print_raw(vm, vm->string_pool[str_id]);
+        print_raw(vm, vm_get_string(vm, str_id));
         if (depth > 0) print_raw(vm, "\"");
     }
     else if (type == T_OBJ) {
@@ -603,13 +1416,12 @@ void print_recursive(VM* vm, double val, int type, int depth, int max_elem) {
             return;
         }
 
-        double* base = vm_resolve_ptr_safe(vm, val);
+        Value* base = vm_resolve_ptr_safe(vm, val);
         if (!base) {
             if (val == 0.0) print_raw(vm, "null");
             else print_raw(vm, "[Invalid Ref]");
             return;
         }
-        int* types = vm_resolve_type(vm, val);
         int obj_type = (int)base[HEAP_OFFSET_TYPE];
 
         if (obj_type == TYPE_ARRAY) {
@@ -619,7 +1431,7 @@ void print_recursive(VM* vm, double val, int type, int depth, int max_elem) {
 
             for (int i = 0; i < limit; i++) {
                 if (i > 0) print_raw(vm, ", ");
-                print_recursive(vm, base[HEAP_HEADER_ARRAY + i], types[HEAP_HEADER_ARRAY + i], depth + 1, max_elem);
+                print_recursive(vm, base[HEAP_HEADER_ARRAY + i], depth + 1, max_elem);
             }
             if (len > limit) print_raw(vm, ", ...");
             print_raw(vm, "]");
@@ -628,16 +1440,15 @@ void print_recursive(VM* vm, double val, int type, int depth, int max_elem) {
             int count = (int)base[HEAP_OFFSET_COUNT];
             int limit = (max_elem != -1 && count > max_elem) ? max_elem : count;
 
-            double* data = vm_resolve_ptr(vm, base[HEAP_OFFSET_DATA]);
-            int* data_types = vm_resolve_type(vm, base[HEAP_OFFSET_DATA]);
+            Value* data = vm_resolve_ptr(vm, (double)base[HEAP_OFFSET_DATA]);
 
             if(data) {
                 for (int i = 0; i < limit; i++) {
                     if (i > 0) print_raw(vm, ", ");
                     // Let print_recursive handle the key dynamically
-                    print_recursive(vm, data[i * 2], data_types[i * 2], 0, max_elem);
+                    print_recursive(vm, data[i * 2], 0, max_elem);
                     print_raw(vm, ": ");
-                    print_recursive(vm, data[i * 2 + 1], data_types[i * 2 + 1], depth + 1, max_elem);
+                    print_recursive(vm, data[i * 2 + 1], depth + 1, max_elem);
                 }
                 if (count > limit) print_raw(vm, ", ...");
             }
@@ -754,7 +1565,7 @@ void dbg_print_state_window(VM* vm) {
         }
         int addr = vm->global_symbols[i].addr;
         printf(UI_BG_CONTENT UI_FG_WHITE "    %-12s: " UI_FG_ACCENT, vm->global_symbols[i].name);
-        print_recursive(vm, vm->globals[addr], vm->global_types[addr], 0, 1);
+        print_recursive(vm, vm->globals[addr], 0, 1);
         printf(EXTEND UI_RST "\n");
     }
 
@@ -768,7 +1579,7 @@ void dbg_print_state_window(VM* vm) {
                 int stack_idx = vm->fp + sym->stack_offset;
                 if (stack_idx <= vm->sp) {
                     printf(UI_BG_CONTENT UI_FG_WHITE "    %-12s: " UI_FG_ACCENT, sym->name);
-                    print_recursive(vm, vm->stack[stack_idx], vm->stack_types[stack_idx], 0, 1);
+                    print_recursive(vm, vm->stack[stack_idx], 0, 1);
                     printf(EXTEND UI_RST "\n");
                     found = true;
                 }
@@ -779,7 +1590,7 @@ void dbg_print_state_window(VM* vm) {
 }
 
 // Helpers for interactive commands
-double* find_debug_var(VM* vm, char* name, int* out_type) {
+Value* find_debug_var(VM* vm, char* name) {
     // 1. Search Locals
     if (vm->local_symbols) {
         for (int i = 0; i < vm->local_symbol_count; i++) {
@@ -788,7 +1599,6 @@ double* find_debug_var(VM* vm, char* name, int* out_type) {
             if (strcmp(sym->name, name) == 0 && (vm->ip - 1) >= sym->start_ip && (sym->end_ip == -1 || (vm->ip - 1) <= sym->end_ip)) {
                 int stack_idx = vm->fp + sym->stack_offset;
                 if (stack_idx <= vm->sp) {
-                    if (out_type) *out_type = vm->stack_types[stack_idx];
                     return &vm->stack[stack_idx];
                 }
             }
@@ -798,7 +1608,6 @@ double* find_debug_var(VM* vm, char* name, int* out_type) {
     for (int i = 0; i < vm->global_symbol_count; i++) {
         if (strcmp(vm->global_symbols[i].name, name) == 0) {
             int addr = vm->global_symbols[i].addr;
-            if (out_type) *out_type = vm->global_types[addr];
             return &vm->globals[addr];
         }
     }
@@ -855,10 +1664,9 @@ void enter_debugger(VM* vm) {
         else if (buf[0] == 'p' && buf[1] == ' ') { // Print variable
             char* var_name = buf + 2;
             while(*var_name == ' ') var_name++;
-            int type = 0;
-            double* ptr = find_debug_var(vm, var_name, &type);
+            Value* ptr = find_debug_var(vm, var_name);
             if (ptr) {
-                print_recursive(vm, *ptr, type, 0, -1);
+                print_recursive(vm, *ptr, 0, -1);
                 printf("\n");
             } else {
                 printf("Variable '%s' not found.\n", var_name);
@@ -874,20 +1682,19 @@ void enter_debugger(VM* vm) {
                 val_str++;
                 while(*val_str == ' ') val_str++; // Skip spaces
 
-                int type = 0;
-                double* val_ptr = find_debug_var(vm, var_name, &type);
+                Value* val_ptr = find_debug_var(vm, var_name);
                 if (val_ptr) {
                     if (val_str[0] == '"') {
                         // String literal
                         val_str++;
                         char* end = strrchr(val_str, '"');
                         if (end) *end = '\0';
-                        *val_ptr = (double)make_string(vm, val_str);
+                        *val_ptr = VAL_STR(make_string(vm, val_str));
                         printf("Updated %s to \"%s\"\n", var_name, val_str);
                     } else {
                         // Number
                         double v = strtod(val_str, NULL);
-                        *val_ptr = v;
+                        *val_ptr = VAL_NUM(v);
                         printf("Updated %s to %g\n", var_name, v);
                     }
                 } else {
@@ -913,19 +1720,46 @@ void enter_debugger(VM* vm) {
     }
 }
 
+// String concatenation operand: the string itself, an enum's member name, or a number via %g
+static const char* concat_operand(VM* vm, Value v, char* num_buf, int* len) {
+    int t = VAL_TYPE(v);
+    if (t == T_STR) { *len = vm_string_len(vm, VAL_AS_STR(v)); return vm_get_string(vm, VAL_AS_STR(v)); }
+    if (t == T_ENUM) {
+        int id = (int)((VAL_PAYLOAD(v) >> 16) & 0xFFFF);
+        *len = vm_string_len(vm, id);
+        return vm_get_string(vm, id);
+    }
+    *len = snprintf(num_buf, 32, "%g", VAL_AS_DOUBLE(v));
+    return num_buf;
+}
+
+static int concat_values(VM* vm, Value a, Value b) {
+    char nb1[32], nb2[32], small[256];
+    int l1, l2;
+    const char* s1 = concat_operand(vm, a, nb1, &l1);
+    const char* s2 = concat_operand(vm, b, nb2, &l2);
+    char* buf = (l1 + l2 < (int)sizeof(small)) ? small : malloc(l1 + l2 + 1);
+    memcpy(buf, s1, l1);
+    memcpy(buf + l1, s2, l2);
+    buf[l1 + l2] = '\0';
+    int id = make_string_len(vm, buf, l1 + l2);
+    if (buf != small) free(buf);
+    return id;
+}
+
 // ... Logic Implementation ... (Math, etc unchanged) ...
-static void broadcast_math(VM* vm, int op, double obj_val, double scalar_val, int scalar_type, bool obj_is_lhs) {
-    double* base = vm_resolve_ptr(vm, obj_val);
-    int* types = vm_resolve_type(vm, obj_val);
+static void broadcast_math(VM* vm, int op, double obj_val, Value scalar, bool obj_is_lhs) {
+    Value* base = vm_resolve_ptr(vm, obj_val);
     int hType = (int)base[0];
     int len = (int)base[1];
+    int scalar_type = VAL_TYPE(scalar);
+    double scalar_val = VAL_AS_DOUBLE(scalar);
 
     double newPtr = heap_alloc(vm, len + HEAP_HEADER_ARRAY);
-    double* newBase = vm_resolve_ptr(vm, newPtr);
-    int* newTypes = vm_resolve_type(vm, newPtr);
+    Value* newBase = vm_resolve_ptr(vm, newPtr);
 
     newBase[0] = TYPE_ARRAY;
-    newBase[1] = (double)len;
+    newBase[1] = len;
 
     for(int i=0; i<len; i++) {
         double el = 0;
@@ -934,8 +1768,8 @@ static void broadcast_math(VM* vm, int op, double obj_val, double scalar_val, in
             unsigned char* b = (unsigned char*)&base[HEAP_HEADER_ARRAY];
             el = (double)b[i];
         } else if (hType == TYPE_ARRAY) {
-            el = base[HEAP_HEADER_ARRAY+i];
-            elType = types[HEAP_HEADER_ARRAY+i];
+            el = VAL_AS_DOUBLE(base[HEAP_HEADER_ARRAY+i]);
+            elType = VAL_TYPE(base[HEAP_HEADER_ARRAY+i]);
         } else if (hType == TYPE_I32_ARRAY) el = (double)((int*)&base[HEAP_HEADER_ARRAY])[i];
         else if (hType == TYPE_F32_ARRAY) el = (double)((float*)&base[HEAP_HEADER_ARRAY])[i];
 
@@ -948,43 +1782,37 @@ static void broadcast_math(VM* vm, int op, double obj_val, double scalar_val, in
              else if (op == OP_MUL) res = lhs * rhs;
              else if (op == OP_DIV) res = lhs / rhs;
              else if (op == OP_MOD) res = fmod(lhs, rhs);
-             newBase[HEAP_HEADER_ARRAY+i] = res;
-             newTypes[HEAP_HEADER_ARRAY+i] = T_NUM;
+             newBase[HEAP_HEADER_ARRAY+i] = VAL_NUM(res);
         }
         // --- NEW STRING BROADCAST SUPPORT ---
         else if (op == OP_ADD && scalar_type == T_STR && elType == T_STR) {
              double lhs = obj_is_lhs ? el : scalar_val;
              double rhs = obj_is_lhs ? scalar_val : el;
-             char buf[MAX_STRING_LENGTH * 2];
-             snprintf(buf, sizeof(buf), "%s%s", vm->string_pool[(int)lhs], vm->string_pool[(int)rhs]);
-             int id = make_string(vm, buf);
-             newBase[HEAP_HEADER_ARRAY+i] = (double)id;
-             newTypes[HEAP_HEADER_ARRAY+i] = T_STR;
+             int id = concat_values(vm, VAL_STR((int)lhs), VAL_STR((int)rhs));
+             newBase[HEAP_HEADER_ARRAY+i] = VAL_STR(id);
         }
         // --- NEW BYTES BROADCAST SUPPORT ---
         else if (op == OP_ADD && scalar_type == T_OBJ && elType == T_OBJ) {
-             double* o1 = vm_resolve_ptr_safe(vm, obj_is_lhs ? el : scalar_val);
-             double* o2 = vm_resolve_ptr_safe(vm, obj_is_lhs ? scalar_val : el);
+             Value* o1 = vm_resolve_ptr_safe(vm, obj_is_lhs ? el : scalar_val);
+             Value* o2 = vm_resolve_ptr_safe(vm, obj_is_lhs ? scalar_val : el);
              if (o1 && o2 && (int)o1[0] == TYPE_BYTES && (int)o2[0] == TYPE_BYTES) {
                  int l1 = (int)o1[1];
                  int l2 = (int)o2[1];
                  double new_bytes = heap_alloc(vm, ((l1 + l2) + 7) / 8 + 2);
-                 double* nb = vm_resolve_ptr(vm, new_bytes);
+                 Value* nb = vm_resolve_ptr(vm, new_bytes);
                  nb[0] = TYPE_BYTES;
-                 nb[1] = (double)(l1 + l2);
+                 nb[1] = l1 + l2;
                  unsigned char* dst = (unsigned char*)&nb[2];
                  memcpy(dst, (unsigned char*)&o1[2], l1);
                  memcpy(dst + l1, (unsigned char*)&o2[2], l2);
 
-                 newBase[HEAP_HEADER_ARRAY+i] = new_bytes;
-                 newTypes[HEAP_HEADER_ARRAY+i] = T_OBJ;
+                 newBase[HEAP_HEADER_ARRAY+i] = VAL_OBJ(new_bytes);
              } else {
-                 newBase[HEAP_HEADER_ARRAY+i] = 0; newTypes[HEAP_HEADER_ARRAY+i] = T_NUM;
+                 newBase[HEAP_HEADER_ARRAY+i] = VAL_NUM(0);
              }
         }
         else {
-             newBase[HEAP_HEADER_ARRAY+i] = 0;
-             newTypes[HEAP_HEADER_ARRAY+i] = T_NUM;
+             newBase[HEAP_HEADER_ARRAY+i] = VAL_NUM(0);
         }
     }
     vm_push(vm, newPtr, T_OBJ);
@@ -992,9 +1820,11 @@ static void broadcast_math(VM* vm, int op, double obj_val, double scalar_val, in
 
 static void exec_math_op(VM* vm, int op) {
     CHECK_STACK(2);
-    double b = vm_pop(vm); int tb = vm->stack_types[vm->sp + 1];
-    double a = vm->stack[vm->sp]; int ta = vm->stack_types[vm->sp];
-    
+    Value vb = vm_pop_value(vm);
+    Value va = vm->stack[vm->sp];
+    int ta = VAL_TYPE(va), tb = VAL_TYPE(vb);
+    double a = VAL_AS_DOUBLE(va), b = VAL_AS_DOUBLE(vb);
+
     bool is_num_a = (ta == T_NUM || ta == T_ENUM);
     bool is_num_b = (tb == T_NUM || tb == T_ENUM);
 
@@ -1007,35 +1837,20 @@ static void exec_math_op(VM* vm, int op) {
         else if (op == OP_MUL) res = val_a * val_b;
         else if (op == OP_DIV) res = val_a / val_b;
         else if (op == OP_MOD) res = fmod(val_a, val_b);
-        vm->stack[vm->sp] = res;
-        vm->stack_types[vm->sp] = T_NUM; // Returns standard number
+        vm->stack[vm->sp] = VAL_NUM(res); // Returns standard number
         return;
     }
 
-    if (ta == T_NUM && tb == T_NUM) {
-        double res = 0;
-        if (op == OP_ADD) res = a + b;
-        else if (op == OP_SUB) res = a - b;
-        else if (op == OP_MUL) res = a * b;
-        else if (op == OP_DIV) res = a / b;
-        else if (op == OP_MOD) res = fmod(a, b);
-        vm->stack[vm->sp] = res;
-        vm->stack_types[vm->sp] = T_NUM;
-        return;
-    }
     if (op == OP_ADD && ta == T_STR && tb == T_STR) {
-        char buf[MAX_STRING_LENGTH * 2];
-        snprintf(buf, sizeof(buf), "%s%s", vm->string_pool[(int)a], vm->string_pool[(int)b]);
-        int id = make_string(vm, buf);
-        vm->stack[vm->sp] = (double)id;
-        vm->stack_types[vm->sp] = T_STR;
+        int id = concat_values(vm, va, vb);
+        vm->stack[vm->sp] = VAL_STR(id);
         return;
     }
 
     // --- ARRAY & BYTES & TYPED ARRAY CONCATENATION ---
     if (op == OP_ADD && ta == T_OBJ && tb == T_OBJ) {
-        double* pa = vm_resolve_ptr_safe(vm, a);
-        double* pb = vm_resolve_ptr_safe(vm, b);
+        Value* pa = vm_resolve_ptr_safe(vm, a);
+        Value* pb = vm_resolve_ptr_safe(vm, b);
         if (pa && pb) {
             int typeA = (int)pa[HEAP_OFFSET_TYPE];
             int typeB = (int)pb[HEAP_OFFSET_TYPE];
@@ -1044,35 +1859,24 @@ static void exec_math_op(VM* vm, int op) {
 
             // 1. Generic Arrays
             if (typeA == TYPE_ARRAY && typeB == TYPE_ARRAY) {
-                int* typesA = vm_resolve_type(vm, a);
-                int* typesB = vm_resolve_type(vm, b);
-
                 double ptr = heap_alloc(vm, lenA + lenB + HEAP_HEADER_ARRAY);
-                double* base = vm_resolve_ptr(vm, ptr);
-                int* types = vm_resolve_type(vm, ptr);
+                Value* base = vm_resolve_ptr(vm, ptr);
 
                 base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
-                base[HEAP_OFFSET_LEN] = (double)(lenA + lenB);
+                base[HEAP_OFFSET_LEN] = lenA + lenB;
 
-                for(int i=0; i<lenA; i++) {
-                    base[HEAP_HEADER_ARRAY + i] = pa[HEAP_HEADER_ARRAY + i];
-                    types[HEAP_HEADER_ARRAY + i] = typesA[HEAP_HEADER_ARRAY + i];
-                }
-                for(int i=0; i<lenB; i++) {
-                    base[HEAP_HEADER_ARRAY + lenA + i] = pb[HEAP_HEADER_ARRAY + i];
-                    types[HEAP_HEADER_ARRAY + lenA + i] = typesB[HEAP_HEADER_ARRAY + i];
-                }
-                vm->stack[vm->sp] = ptr; // overwrite 'a'
-                vm->stack_types[vm->sp] = T_OBJ;
+                memcpy(&base[HEAP_HEADER_ARRAY], &pa[HEAP_HEADER_ARRAY], lenA * sizeof(Value));
+                memcpy(&base[HEAP_HEADER_ARRAY + lenA], &pb[HEAP_HEADER_ARRAY], lenB * sizeof(Value));
+                vm->stack[vm->sp] = VAL_OBJ(ptr); // overwrite 'a'
                 return;
             }
             // 2. Byte Arrays
             else if (typeA == TYPE_BYTES && typeB == TYPE_BYTES) {
                  // TYPE_BYTES layout: [TYPE, LEN, byte0, byte1...] (Offsets: 0, 1, 2...)
                  double ptr = heap_alloc(vm, ((lenA + lenB) + 7) / 8 + 2);
-                 double* base = vm_resolve_ptr(vm, ptr);
+                 Value* base = vm_resolve_ptr(vm, ptr);
                  base[0] = TYPE_BYTES;
-                 base[1] = (double)(lenA + lenB);
+                 base[1] = lenA + lenB;
 
                  unsigned char* dst = (unsigned char*)&base[2];
                  unsigned char* srcA = (unsigned char*)&pa[2];
@@ -1081,24 +1885,23 @@ static void exec_math_op(VM* vm, int op) {
                  memcpy(dst, srcA, lenA);
                  memcpy(dst + lenA, srcB, lenB);
 
-                 vm->stack[vm->sp] = ptr;
-                 vm->stack_types[vm->sp] = T_OBJ;
+                 vm->stack[vm->sp] = VAL_OBJ(ptr);
                  return;
             }
             // 3. Typed Arrays
             else if (typeA == typeB && typeA <= TYPE_I16_ARRAY && typeA >= TYPE_BOOL_ARRAY) {
                 int elem_size = get_type_size(typeA);
                 int total_len = lenA + lenB;
-                // Calculate doubles needed: header(2) + data
+                // Calculate slots needed: header(2) + data
                 // Data size in bytes: total_len * elem_size
-                // Doubles for data: (bytes + 7) / 8
-                int doubles_needed = 2 + (total_len * elem_size + 7) / 8;
+                // Slots for data: (bytes + 7) / 8
+                int slots_needed = 2 + (total_len * elem_size + 7) / 8;
 
-                double ptr = heap_alloc(vm, doubles_needed);
-                double* base = vm_resolve_ptr(vm, ptr);
+                double ptr = heap_alloc(vm, slots_needed);
+                Value* base = vm_resolve_ptr(vm, ptr);
 
-                base[0] = (double)typeA;
-                base[1] = (double)total_len;
+                base[0] = typeA;
+                base[1] = total_len;
 
                 char* dst = (char*)&base[2];
                 char* srcA = (char*)&pa[2];
@@ -1110,8 +1913,7 @@ static void exec_math_op(VM* vm, int op) {
                 memcpy(dst, srcA, bytesA);
                 memcpy(dst + bytesA, srcB, bytesB);
 
-                vm->stack[vm->sp] = ptr;
-                vm->stack_types[vm->sp] = T_OBJ;
+                vm->stack[vm->sp] = VAL_OBJ(ptr);
                 return;
             }
         }
@@ -1120,32 +1922,16 @@ static void exec_math_op(VM* vm, int op) {
 
     if (ta == T_OBJ || tb == T_OBJ) {
         double arrVal = (ta == T_OBJ) ? a : b;
-        double scalVal = (ta == T_OBJ) ? b : a;
-        int scalType = (ta == T_OBJ) ? tb : ta;
+        Value scalar = (ta == T_OBJ) ? vb : va;
         bool objIsLhs = (ta == T_OBJ);
         vm_pop(vm);
-        broadcast_math(vm, op, arrVal, scalVal, scalType, objIsLhs);
+        broadcast_math(vm, op, arrVal, scalar, objIsLhs);
         return;
     }
-    
+
     if (op == OP_ADD && (ta == T_STR || tb == T_STR)) {
-        char s1[MAX_STRING_LENGTH], s2[MAX_STRING_LENGTH];
-
-        if (ta == T_STR) strncpy(s1, vm->string_pool[(int)a], MAX_STRING_LENGTH-1);
-        else if (ta == T_ENUM) strncpy(s1, vm->string_pool[((unsigned int)a >> 16) & 0xFFFF], MAX_STRING_LENGTH-1);
-        else snprintf(s1, MAX_STRING_LENGTH, "%g", a);
-        s1[MAX_STRING_LENGTH-1] = '\0';
-
-        if (tb == T_STR) strncpy(s2, vm->string_pool[(int)b], MAX_STRING_LENGTH-1);
-        else if (tb == T_ENUM) strncpy(s2, vm->string_pool[((unsigned int)b >> 16) & 0xFFFF], MAX_STRING_LENGTH-1);
-        else snprintf(s2, MAX_STRING_LENGTH, "%g", b);
-        s2[MAX_STRING_LENGTH-1] = '\0';
-
-        char res[MAX_STRING_LENGTH * 2];
-        snprintf(res, sizeof(res), "%s%s", s1, s2);
-        int id = make_string(vm, res);
-        vm->stack[vm->sp] = (double)id;
-        vm->stack_types[vm->sp] = T_STR;
+        int id = concat_values(vm, va, vb);
+        vm->stack[vm->sp] = VAL_STR(id);
         return;
     }
     RUNTIME_ERROR("Invalid types for math operation");
@@ -1153,14 +1939,15 @@ static void exec_math_op(VM* vm, int op) {
 
 static void exec_compare_op(VM* vm, int op) {
     CHECK_STACK(2);
-    double b = vm_pop(vm); int tb = vm->stack_types[vm->sp + 1];
-    double a = vm->stack[vm->sp]; int ta = vm->stack_types[vm->sp];
-    
+    Value vb = vm_pop_value(vm);
+    Value va = vm->stack[vm->sp];
+    double a = VAL_AS_DOUBLE(va), b = VAL_AS_DOUBLE(vb);
+
     // Extract integer if comparing enums
-    double val_a = (ta == T_ENUM) ? (double)((unsigned long long)a & 0xFFFF) : a;
-    double val_b = (tb == T_ENUM) ? (double)((unsigned long long)b & 0xFFFF) : b;
+    double val_a = (VAL_TYPE(va) == T_ENUM) ? (double)((unsigned long long)a & 0xFFFF) : a;
+    double val_b = (VAL_TYPE(vb) == T_ENUM) ? (double)((unsigned long long)b & 0xFFFF) : b;
 
-    double res = 0;
+    bool res = false;
     switch(op) {
         case OP_LT: res = (val_a < val_b); break;
         case OP_GT: res = (val_a > val_b); break;
@@ -1169,52 +1956,52 @@ static void exec_compare_op(VM* vm, int op) {
         case OP_EQ: res = (val_a == val_b); break;
         case OP_NEQ: res = (val_a != val_b); break;
     }
-    vm->stack[vm->sp] = res;
-    vm->stack_types[vm->sp] = T_NUM;
+    vm->stack[vm->sp] = res ? VAL_TRUE : VAL_FALSE;
+}
+
+static void exec_store_local(VM* vm, int arg) {
+    CHECK_STACK(1);
+    int fp = (int)vm->fp;
+    Value val = vm->stack[vm->sp];
+    int target_idx = fp + arg;
+
+    vm->stack[target_idx] = val;
+    vm->sp--;
+
+    // Smart Local Protection
+    if (VAL_TYPE(val) == T_OBJ) {
+        int obj_offset = UNPACK_OFFSET(val);
+        for (int s = 0; s < vm->scope_sp; s++) {
+            // Check if the variable (target_idx) was declared BEFORE this scope started
+            // AND ensure the scope belongs to the CURRENT function frame (fp matches)
+            if (vm->scope_stack[s].fp == vm->fp &&
+                target_idx <= vm->scope_stack[s].sp_at_entry &&
+                vm->scope_stack[s].arena_id == vm->current_arena &&
+                obj_offset >= vm->scope_stack[s].head) {
+
+                // Push the scope boundary forward to protect the new allocation
+                vm->scope_stack[s].head = vm->arenas[vm->current_arena].head;
+            }
+        }
+    }
 }
 
 static void exec_var_op(VM* vm, int op) {
     int arg = vm->bytecode[vm->ip++];
-    
+
     if (op == OP_SET) {
         CHECK_STACK(1);
         vm->globals[arg] = vm->stack[vm->sp];
-        vm->global_types[arg] = vm->stack_types[vm->sp];
         vm->sp--;
         // NO GLOBAL PROTECTION: Top-level scripts must cleanly sweep loop memory!
-        
+
     } else if (op == OP_GET) {
-        vm_push(vm, vm->globals[arg], vm->global_types[arg]);
+        vm_push_value(vm, vm->globals[arg]);
     } else if (op == OP_LVAR) {
         int fp = (int)vm->fp;
-        vm_push(vm, vm->stack[fp + arg], vm->stack_types[fp + arg]);
+        vm_push_value(vm, vm->stack[fp + arg]);
     } else if (op == OP_SVAR) {
-        CHECK_STACK(1);
-        int fp = (int)vm->fp;
-        double val = vm->stack[vm->sp];
-        int type = vm->stack_types[vm->sp];
-        int target_idx = fp + arg;
-        
-        vm->stack[target_idx] = val;
-        vm->stack_types[target_idx] = type;
-        vm->sp--;
-        
-        // Smart Local Protection
-        if (type == T_OBJ) {
-            int obj_offset = UNPACK_OFFSET(val);
-            for (int s = 0; s < vm->scope_sp; s++) {
-                // Check if the variable (target_idx) was declared BEFORE this scope started
-                // AND ensure the scope belongs to the CURRENT function frame (fp matches)
-                if (vm->scope_stack[s].fp == vm->fp &&
-                    target_idx <= vm->scope_stack[s].sp_at_entry &&
-                    vm->scope_stack[s].arena_id == vm->current_arena &&
-                    obj_offset >= vm->scope_stack[s].head) {
-                    
-                    // Push the scope boundary forward to protect the new allocation
-                    vm->scope_stack[s].head = vm->arenas[vm->current_arena].head;
-                }
-            }
-        }
+        exec_store_local(vm, arg);
     }
 }
 
@@ -1223,10 +2010,12 @@ static void exec_flow_op(VM* vm, int op) {
         vm->ip = vm->bytecode[vm->ip];
     } else if (op == OP_JZ) {
         int target = vm->bytecode[vm->ip++];
-        if (vm_pop(vm) == 0.0) vm->ip = target;
+        Value cond = vm_pop_value(vm);
+        if (VAL_IS_FALSY(cond)) vm->ip = target;
     } else if (op == OP_JNZ) {
         int target = vm->bytecode[vm->ip++];
-        if (vm_pop(vm) != 0.0) vm->ip = target;
+        Value cond = vm_pop_value(vm);
+        if (!VAL_IS_FALSY(cond)) vm->ip = target;
     } else if (op == OP_CALL) {
         int target = vm->bytecode[vm->ip++];
         int argc = vm->bytecode[vm->ip++];
@@ -1234,19 +2023,17 @@ static void exec_flow_op(VM* vm, int op) {
         int args_start = vm->sp - argc + 1;
         for(int i=0; i<argc; i++) {
             vm->stack[vm->sp + 2 - i] = vm->stack[vm->sp - i];
-            vm->stack_types[vm->sp + 2 - i] = vm->stack_types[vm->sp - i];
         }
-        vm->stack[args_start] = (double)vm->ip;
-        vm->stack[args_start+1] = (double)vm->fp;
-        vm->stack_types[args_start] = T_NUM;
-        vm->stack_types[args_start+1] = T_NUM;
+        vm->stack[args_start] = VAL_NUM(vm->ip);
+        vm->stack[args_start+1] = VAL_NUM(vm->fp);
         vm->sp += 2;
         vm->fp = args_start + 2;
         vm->ip = target;
+        if (vm->profile && vm->profile->transition) vm->profile->transition(vm, true);
     } else if (op == OP_RET) {
         CHECK_STACK(1);
-        double rv = vm->stack[vm->sp];
-        int rt = vm->stack_types[vm->sp];
+        Value rv = vm->stack[vm->sp];
+        bool is_obj = VAL_TYPE(rv) == T_OBJ;
 
         // [FIX] Loop to pop ALL scopes for the current function (fp)
         while (vm->scope_sp > 0) {
@@ -1259,13 +2046,13 @@ static void exec_flow_op(VM* vm, int op) {
 
             // Handle Heap Rewind (Arena Memory)
             if (vm->current_arena == scope->arena_id) {
-                if (rt == T_OBJ) {
+                if (is_obj) {
                     // Evacuate the return object to the parent scope/heap
-                    rv = vm_evacuate_object(vm, rv, scope->head);
+                    rv = VAL_OBJ(vm_evacuate_object(vm, VAL_AS_PTR(rv), scope->head));
                 }
                 // Reset the arena head to reclaim memory
-                if (rt != T_OBJ || UNPACK_OFFSET(rv) < scope->head) {
-                    vm->arenas[scope->arena_id].head = scope->head;
+                if (!is_obj || UNPACK_OFFSET(rv) < scope->head) {
+                    arena_rewind(vm, scope->arena_id, scope->head);
                 }
             }
         }
@@ -1273,9 +2060,10 @@ static void exec_flow_op(VM* vm, int op) {
         // Standard Return Logic
         vm->sp = vm->fp - 3;
         int fp = (int)vm->fp;
-        vm->fp = (int)vm->stack[fp-1];
-        vm->ip = (int)vm->stack[fp-2];
-        vm_push(vm, rv, rt);
+        vm->fp = (int)VAL_AS_NUM(vm->stack[fp-1]);
+        vm->ip = (int)VAL_AS_NUM(vm->stack[fp-2]);
+        vm_push_value(vm, rv);
+        if (vm->profile && vm->profile->transition) vm->profile->transition(vm, false);
     }
 }
 
@@ -1286,31 +2074,27 @@ static void exec_alloc_op(VM* vm, int op) {
         int struct_id = vm->bytecode[vm->ip++];
         // Alloc size + 2 to store (ID, SIZE, Fields...)
         double ptr = heap_alloc(vm, size + 2);
-        double* base = vm_resolve_ptr(vm, ptr);
-        base[0] = (double)struct_id;
-        base[1] = (double)size; // Store size!
+        Value* base = vm_resolve_ptr(vm, ptr);
+        base[0] = struct_id;
+        base[1] = size; // Store size!
         vm_push(vm, ptr, T_OBJ);
     } else if (op == OP_HSET) {
         int off = vm->bytecode[vm->ip++];
         int expected_id = vm->bytecode[vm->ip++];
         CHECK_STACK(2);
-        double v = vm_pop(vm); int t = vm->stack_types[vm->sp+1];
-        double p = vm->stack[vm->sp];
-        double* base = vm_resolve_ptr(vm, p);
-        int* types = vm_resolve_type(vm, p);
+        Value v = vm_pop_value(vm);
+        double ptr = VAL_AS_PTR(vm->stack[vm->sp]);
+        Value* base = vm_resolve_ptr(vm, ptr);
         if((int)base[0] != expected_id) RUNTIME_ERROR("HSET Type mismatch");
+        if (vm->arenas[UNPACK_ARENA(ptr)].frozen) RUNTIME_ERROR("Cannot modify frozen Region %d", UNPACK_ARENA(ptr));
         base[2+off] = v; // Offset by 2
-        types[2+off] = t;
     } else if (op == OP_HGET) {
         int off = vm->bytecode[vm->ip++];
         int expected_id = vm->bytecode[vm->ip++];
         CHECK_STACK(1);
-        double p = vm->stack[vm->sp];
-        double* base = vm_resolve_ptr(vm, p);
-        int* types = vm_resolve_type(vm, p);
+        Value* base = vm_resolve_ptr(vm, VAL_AS_PTR(vm->stack[vm->sp]));
         if((int)base[0] != expected_id) RUNTIME_ERROR("HGET Type mismatch");
         vm->stack[vm->sp] = base[2+off]; // Offset by 2
-        vm->stack_types[vm->sp] = types[2+off];
     }
 }
 
@@ -1319,33 +2103,30 @@ static void exec_array_op(VM* vm, int op) {
     if (op == OP_ARR) {
         int count = vm->bytecode[vm->ip++];
         double ptr = heap_alloc(vm, count+2);
-        double* base = vm_resolve_ptr(vm, ptr);
-        int* types = vm_resolve_type(vm, ptr);
+        Value* base = vm_resolve_ptr(vm, ptr);
         base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
-        base[HEAP_OFFSET_LEN] = (double)count;
+        base[HEAP_OFFSET_LEN] = count;
         for(int i=count; i>0; i--) {
             base[HEAP_HEADER_ARRAY+i-1] = vm->stack[vm->sp];
-            types[HEAP_HEADER_ARRAY+i-1] = vm->stack_types[vm->sp];
             vm->sp--;
         }
         vm_push(vm, ptr, T_OBJ);
     } else if (op == OP_AGET) {
         CHECK_STACK(2);
-        double key = vm_pop(vm); int kt = vm->stack_types[vm->sp+1];
+        Value key = vm_pop_value(vm);
         double ptr = vm_pop(vm);
 
-        double* base = vm_resolve_ptr(vm, ptr);
-        int* types = vm_resolve_type(vm, ptr);
+        Value* base = vm_resolve_ptr(vm, ptr);
         int type = (int)base[HEAP_OFFSET_TYPE];
 
         if (type <= TYPE_ARRAY && type != TYPE_MAP) {
-            int idx = (int)key;
+            int idx = (int)VAL_AS_DOUBLE(key);
             int len = (int)base[HEAP_OFFSET_LEN];
             if (idx < 0) idx += len;
             if (idx < 0 || idx >= len) RUNTIME_ERROR("Index OOB");
 
             if (type == TYPE_ARRAY) {
-                vm_push(vm, base[HEAP_HEADER_ARRAY+idx], types[HEAP_HEADER_ARRAY+idx]);
+                vm_push_value(vm, base[HEAP_HEADER_ARRAY+idx]);
             } else {
                 char* data = (char*)&base[HEAP_HEADER_ARRAY];
                 double res = 0;
@@ -1360,127 +2141,74 @@ static void exec_array_op(VM* vm, int op) {
                 vm_push(vm, res, T_NUM);
             }
         } else if (type == TYPE_MAP) {
-            int count = (int)base[HEAP_OFFSET_COUNT];
-            double* data = vm_resolve_ptr(vm, base[HEAP_OFFSET_DATA]);
-            int* data_types = vm_resolve_type(vm, base[HEAP_OFFSET_DATA]);
-            bool found = false;
-            for(int i=0; i<count; i++) {
-                // Ensure the types match
-                if(data[i*2] == key && data_types[i*2] == kt) {
-                    vm_push(vm, data[i*2 + 1], data_types[i*2 + 1]);
-                    found = true; break;
-                }
-            }
-            if (!found) {
+            int e = vm_map_find(vm, base, key);
+            if (e != -1) {
+                Value* data = vm_resolve_ptr(vm, (double)base[HEAP_OFFSET_DATA]);
+                vm_push_value(vm, data[e*2 + 1]);
+            } else {
                 int empty = make_string(vm, "");
                 vm_push(vm, (double)empty, T_STR);
             }
+        } else {
+            RUNTIME_ERROR("Cannot index type %d", type);
         }
     } else if (op == OP_ALEN) {
         CHECK_STACK(1);
         double ptr = vm_pop(vm);
-        double* base = vm_resolve_ptr(vm, ptr);
+        Value* base = vm_resolve_ptr(vm, ptr);
         int type = (int)base[HEAP_OFFSET_TYPE];
-        if (type == TYPE_MAP) vm_push(vm, base[HEAP_OFFSET_COUNT], T_NUM);
-        else vm_push(vm, base[HEAP_OFFSET_LEN], T_NUM);
+        if (type == TYPE_MAP) vm_push(vm, (double)base[HEAP_OFFSET_COUNT], T_NUM);
+        else vm_push(vm, (double)base[HEAP_OFFSET_LEN], T_NUM);
     } else if (op == OP_ASET) {
         CHECK_STACK(3);
-        double val = vm_pop(vm); int vt = vm->stack_types[vm->sp+1];
-        double key = vm_pop(vm); int kt = vm->stack_types[vm->sp+1];
-        double ptr = vm->stack[vm->sp];
-        double* base = vm_resolve_ptr(vm, ptr);
-        int* types = vm_resolve_type(vm, ptr);
+        Value val = vm_pop_value(vm);
+        Value key = vm_pop_value(vm);
+        double ptr = VAL_AS_PTR(vm->stack[vm->sp]);
+        Value* base = vm_resolve_ptr(vm, ptr);
         int type = (int)base[0];
+        if (vm->arenas[UNPACK_ARENA(ptr)].frozen) RUNTIME_ERROR("Cannot modify frozen Region %d", UNPACK_ARENA(ptr));
 
         vm_pop(vm);
 
         if (type == TYPE_ARRAY) {
-            int idx = (int)key;
-            base[2+idx] = val; types[2+idx] = vt;
+            int idx = (int)VAL_AS_DOUBLE(key);
+            base[2+idx] = val;
         } else if (type == TYPE_BYTES) {
             unsigned char* b = (unsigned char*)&base[HEAP_HEADER_ARRAY];
-            b[(int)key] = (unsigned char)val;
+            b[(int)VAL_AS_DOUBLE(key)] = (unsigned char)VAL_AS_DOUBLE(val);
         } else if (type == TYPE_MAP) {
-            int cap = (int)base[1];
-            int count = (int)base[2];
-            double data_ptr = base[3];
-            double* data = vm_resolve_ptr(vm, data_ptr);
-            int* data_types = vm_resolve_type(vm, data_ptr);
-            bool found = false;
-            for(int i=0; i<count; i++) {
-                // Add `kt` type check so numbers and strings don't collide
-                if (data[i*2] == key && data_types[i*2] == kt) {
-                    data[i*2+1] = val; data_types[i*2+1] = vt;
-                    found = true; break;
-                }
-            }
-            if(!found) {
-                if (count >= cap) {
-                    int new_cap = cap * 2;
-                    double new_data_ptr = heap_alloc(vm, new_cap*2);
-                    double* new_data = vm_resolve_ptr(vm, new_data_ptr);
-                    int* new_types = vm_resolve_type(vm, new_data_ptr);
-                    for(int i=0; i<count*2; i++) {
-                         new_data[i] = data[i]; new_types[i] = data_types[i];
-                    }
-                    base[1] = (double)new_cap;
-                    base[3] = new_data_ptr;
-                    data = new_data; data_types = new_types;
-
-                    int map_offset = UNPACK_OFFSET(ptr);
-                    for (int s = 0; s < vm->scope_sp; s++) {
-                        // If the scope belongs to this arena AND the map is older than the scope
-                        if (vm->scope_stack[s].arena_id == vm->current_arena &&
-                            vm->scope_stack[s].head > map_offset) {
-
-                            // Shift the scope's rewind point to protect the new allocation
-                            vm->scope_stack[s].head = vm->arenas[vm->current_arena].head;
-                            }
-                    }
-                }
-                data[count*2] = key;
-                data_types[count*2] = kt; // Use the actual type instead of T_STR
-                data[count*2+1] = val;
-                data_types[count*2+1] = vt;
-                base[2] = (double)(count+1);
-            }
+            // Keys compare by type and value so numbers and strings don't collide
+            vm_map_set(vm, ptr, key, val);
         }
         else {
-             int idx = (int)key;
+             int idx = (int)VAL_AS_DOUBLE(key);
+             double v = VAL_AS_DOUBLE(val);
              char* data = (char*)&base[HEAP_HEADER_ARRAY];
              switch(type) {
-                case TYPE_I32_ARRAY: ((int*)data)[idx] = (int)val; break;
-                case TYPE_F32_ARRAY: ((float*)data)[idx] = (float)val; break;
-                case TYPE_I16_ARRAY: ((short*)data)[idx] = (short)val; break;
-                case TYPE_I64_ARRAY: ((long long*)data)[idx] = (long long)val; break;
-                case TYPE_BOOL_ARRAY: ((unsigned char*)data)[idx] = (unsigned char)val; break;
+                case TYPE_I32_ARRAY: ((int*)data)[idx] = (int)v; break;
+                case TYPE_F32_ARRAY: ((float*)data)[idx] = (float)v; break;
+                case TYPE_I16_ARRAY: ((short*)data)[idx] = (short)v; break;
+                case TYPE_I64_ARRAY: ((long long*)data)[idx] = (long long)v; break;
+                case TYPE_BOOL_ARRAY: ((unsigned char*)data)[idx] = (unsigned char)v; break;
              }
         }
-        vm_push(vm, val, vt);
+        vm_push_value(vm, val);
     } else if (op == OP_MAP) {
-        int cap = MAP_INITIAL_CAP;
-        double map = heap_alloc(vm, 4);
-        double data = heap_alloc(vm, cap*2);
-        double* base = vm_resolve_ptr(vm, map);
-        base[0] = TYPE_MAP;
-        base[1] = (double)cap;
-        base[2] = 0;
-        base[3] = data;
-        vm_push(vm, map, T_OBJ);
+        vm_push(vm, vm_map_new(vm, MAP_INITIAL_CAP), T_OBJ);
     } else if (op == OP_MAKE_ARR) {
         int count = vm->bytecode[vm->ip++];
         int type_id = vm->bytecode[vm->ip++];
         int elem_size = get_type_size(type_id);
-        int doubles_needed = (count * elem_size + 7) / 8;
+        int slots_needed = (count * elem_size + 7) / 8;
 
-        double ptr = heap_alloc(vm, doubles_needed + HEAP_HEADER_ARRAY);
-        double* base = vm_resolve_ptr(vm, ptr);
-        base[0] = (double)type_id;
-        base[1] = (double)count;
+        double ptr = heap_alloc(vm, slots_needed + HEAP_HEADER_ARRAY);
+        Value* base = vm_resolve_ptr(vm, ptr);
+        base[0] = type_id;
+        base[1] = count;
         char* data_ptr = (char*)&base[HEAP_HEADER_ARRAY];
 
         for(int i = count - 1; i >= 0; i--) {
-            double val = vm->stack[vm->sp--];
+            double val = VAL_AS_DOUBLE(vm->stack[vm->sp--]);
             switch(type_id) {
                 case TYPE_BYTES:
                 case TYPE_BOOL_ARRAY: data_ptr[i] = (unsigned char)val; break;
@@ -1500,8 +2228,7 @@ static void exec_slice_op(VM* vm, int op) {
         double e = vm_pop(vm);
         double s = vm_pop(vm);
         double ptr = vm_pop(vm);
-        double* base = vm_resolve_ptr(vm, ptr);
-        int* types = vm_resolve_type(vm, ptr);
+        Value* base = vm_resolve_ptr(vm, ptr);
         int type = (int)base[HEAP_OFFSET_TYPE];
         int len = (int)base[HEAP_OFFSET_LEN];
 
@@ -1515,20 +2242,18 @@ static void exec_slice_op(VM* vm, int op) {
 
         if (type == TYPE_BYTES) {
             double newptr = heap_alloc(vm, (newlen + 7) / 8 + 2);
-            double* newbase = vm_resolve_ptr(vm, newptr);
-            newbase[0] = TYPE_BYTES; newbase[1] = (double)newlen;
+            Value* newbase = vm_resolve_ptr(vm, newptr);
+            newbase[0] = TYPE_BYTES; newbase[1] = newlen;
             char* src = (char*)&base[HEAP_HEADER_ARRAY];
             char* dst = (char*)&newbase[HEAP_HEADER_ARRAY];
             if (newlen > 0) for (int i = 0; i < newlen; i++) dst[i] = src[start + i];
             vm_push(vm, newptr, T_OBJ);
         } else {
             double newptr = heap_alloc(vm, newlen + 2);
-            double* newbase = vm_resolve_ptr(vm, newptr);
-            int* newtypes = vm_resolve_type(vm, newptr);
-            newbase[0] = TYPE_ARRAY; newbase[1] = (double)newlen;
+            Value* newbase = vm_resolve_ptr(vm, newptr);
+            newbase[0] = TYPE_ARRAY; newbase[1] = newlen;
             for (int i = 0; i < newlen; i++) {
                 newbase[2 + i] = base[2 + start + i];
-                newtypes[2 + i] = types[2 + start + i];
             }
             vm_push(vm, newptr, T_OBJ);
         }
@@ -1537,11 +2262,11 @@ static void exec_slice_op(VM* vm, int op) {
         double val = vm_pop(vm);
         double e = vm_pop(vm);
         double s = vm_pop(vm);
-        double ptr = vm->stack[vm->sp]; vm_pop(vm);
-        double* base = vm_resolve_ptr(vm, ptr);
-        int* types = vm_resolve_type(vm, ptr);
+        double ptr = vm_pop(vm);
+        Value* base = vm_resolve_ptr(vm, ptr);
         int type = (int)base[0];
         int len = (int)base[1];
+        if (vm->arenas[UNPACK_ARENA(ptr)].frozen) RUNTIME_ERROR("Cannot modify frozen Region %d", UNPACK_ARENA(ptr));
 
         int start = (int)s; int end = (int)e;
         if (start < 0) start += len; if (end < 0) end += len;
@@ -1549,7 +2274,7 @@ static void exec_slice_op(VM* vm, int op) {
         int slice_len = (end >= start) ? (end - start + 1) : 0;
 
         if (type == TYPE_BYTES) {
-            double* vbase = vm_resolve_ptr(vm, val);
+            Value* vbase = vm_resolve_ptr(vm, val);
             if ((int)vbase[0] == TYPE_BYTES) {
                 unsigned char* dst = (unsigned char*)&base[HEAP_HEADER_ARRAY];
                 unsigned char* src = (unsigned char*)&vbase[HEAP_HEADER_ARRAY];
@@ -1558,14 +2283,12 @@ static void exec_slice_op(VM* vm, int op) {
                 for(int i=0; i<copy_len; i++) dst[start+i] = src[i];
             }
         } else if (type == TYPE_ARRAY) {
-            double* vbase = vm_resolve_ptr(vm, val);
-            int* vtypes = vm_resolve_type(vm, val);
+            Value* vbase = vm_resolve_ptr(vm, val);
             if ((int)vbase[0] == TYPE_ARRAY) {
                 int vlen = (int)vbase[1];
                 int copy_len = (slice_len < vlen) ? slice_len : vlen;
                 for(int i=0; i<copy_len; i++) {
                     base[2+start+i] = vbase[2+i];
-                    types[2+start+i] = vtypes[2+i];
                 }
             }
         }
@@ -1595,7 +2318,7 @@ static void exec_monitor(VM* vm) {
         for (int i = 0; i < vm->global_symbol_count; i++) {
             int addr = vm->global_symbols[i].addr;
             printf("  %s: ", vm->global_symbols[i].name);
-            print_recursive(vm, vm->globals[addr], vm->global_types[addr], 0, MYLO_MONITOR_DEPTH);
+            print_recursive(vm, vm->globals[addr], 0, MYLO_MONITOR_DEPTH);
             printf("\n");
         }
     }
@@ -1611,7 +2334,7 @@ static void exec_monitor(VM* vm) {
                 int stack_idx = vm->fp + sym->stack_offset;
                 if (stack_idx <= vm->sp) {
                     printf("  %s: ", sym->name);
-                    print_recursive(vm, vm->stack[stack_idx], vm->stack_types[stack_idx], 0, MYLO_MONITOR_DEPTH);
+                    print_recursive(vm, vm->stack[stack_idx], 0, MYLO_MONITOR_DEPTH);
                     printf("\n");
                     found_any = true;
                 }
@@ -1625,23 +2348,21 @@ static void exec_monitor(VM* vm) {
 static void exec_cast_op(VM* vm, int target_type, bool is_check_only) {
     if (target_type == TYPE_ANY) return;
 
-    double val = vm->stack[vm->sp];
-    int current_type = vm->stack_types[vm->sp];
-    
+    double val = VAL_AS_DOUBLE(vm->stack[vm->sp]);
+    int current_type = VAL_TYPE(vm->stack[vm->sp]);
+
     if (current_type == T_ENUM) {
         if (target_type == TYPE_STR) {
             if (!is_check_only) {
                 int str_id = ((unsigned long long)val >> 16) & 0xFFFF;
-                vm->stack[vm->sp] = (double)str_id;
-                vm->stack_types[vm->sp] = T_STR;
+                vm->stack[vm->sp] = VAL_STR(str_id);
             }
             return;
         }
         // Extract raw number for integer casts (i32, byte, etc.)
         val = (double)((unsigned long long)val & 0xFFFF);
         if (!is_check_only) {
-            vm->stack[vm->sp] = val;
-            vm->stack_types[vm->sp] = T_NUM;
+            vm->stack[vm->sp] = VAL_NUM(val);
         }
         current_type = T_NUM;
     }
@@ -1660,7 +2381,7 @@ static void exec_cast_op(VM* vm, int target_type, bool is_check_only) {
                 target_type == TYPE_BOOL_ARRAY ||
                 target_type == TYPE_BYTES) {
 
-                vm->stack[vm->sp] = floor(val);
+                vm->stack[vm->sp] = VAL_NUM(floor(val));
                 }
             // f32 and num (f64) do not need truncation, they stay as floating point
         }
@@ -1670,13 +2391,15 @@ static void exec_cast_op(VM* vm, int target_type, bool is_check_only) {
     }
     else if (target_type >= 0) { // Struct ID
         if (current_type != T_OBJ) RUNTIME_ERROR("Type Mismatch: Expected Object");
-        double* base = vm_resolve_ptr(vm, val);
+        Value* base = vm_resolve_ptr(vm, val);
         if (!base || (int)base[0] != target_type) RUNTIME_ERROR("Type Mismatch: Expected Struct ID %d", target_type);
     }
 }
 
 // --- VM Execution Loop ---
 
+static int exec_instruction(VM* vm);
+
 int vm_step(VM* vm, bool debug_trace) {
     // 1. TUI Breakpoint Check
     if (vm->cli_debug_mode) {
@@ -1697,22 +2420,256 @@ int vm_step(VM* vm, bool debug_trace) {
     }
 
     if (vm->ip >= vm->code_size) return -1;
+    STRING_GC_SAFEPOINT(vm);
+
+#ifdef MYLO_STATS
+    int counted = vm->bytecode[vm->ip];
+    if (counted >= 0 && counted < OP_COUNT) vm->stats.ops[counted]++;
+#endif
 
     if (debug_trace) {
         int op = vm->bytecode[vm->ip];
-        if (op >= 0 && op <= OP_DEBUGGER) {
+        if (op >= 0 && op < OP_COUNT) {
             printf("[TRACE] IP:%04d Line:%d SP:%2d OP:%s\n", vm->ip, vm->lines[vm->ip], vm->sp, OP_NAMES[op]);
         }
     }
 
+    return exec_instruction(vm);
+}
+
+// Runs one instruction at vm->ip through the interpreter, for --build code
+// that does not translate that op. Returns -1 on OP_HLT.
+int vm_exec_op(VM* vm) {
+    int r = exec_instruction(vm);
+    STRING_GC_SAFEPOINT(vm);
+    return r;
+}
+
+// Width of the instruction at ip in ints (opcode plus operands)
+int vm_op_length(const int* code, int ip) {
+    switch (code[ip]) {
+        case OP_PSH_NUM: case OP_PSH_STR: case OP_PSH_ENUM:
+        case OP_SET: case OP_GET: case OP_LVAR: case OP_SVAR:
+        case OP_JMP: case OP_JZ: case OP_JNZ:
+        case OP_NATIVE: case OP_ARR: case OP_CAST: case OP_CHECK_TYPE:
+        case OP_ADD_C: case OP_SUB_C:
+        case OP_LT_JZ: case OP_EQ_JZ: case OP_GT_JZ: case OP_GE_JZ: case OP_LE_JZ: case OP_NEQ_JZ:
+            return 2;
+        case OP_CALL: case OP_ALLOC: case OP_HSET: case OP_HGET: case OP_MAKE_ARR:
+        case OP_INC_LVAR: case OP_INC_GVAR:
+            return 3;
+        case OP_LVAR_HGET:
+            return 4;
+        case OP_EMBED:
+            return 2 + code[ip + 1];
+        default:
+            return 1;
+    }
+}
+
+// --- Statistics ---
+
+// Copies vm's counters into out. False (and all zero) without MYLO_STATS.
+bool vm_get_stats(VM* vm, MyloStats* out) {
+#ifdef MYLO_STATS
+    *out = vm->stats;
+    return true;
+#else
+    (void)vm;
+    memset(out, 0, sizeof(*out));
+    return false;
+#endif
+}
+
+void vm_reset_stats(VM* vm) {
+    VM_STAT(memset(&vm->stats, 0, sizeof(vm->stats)));
+    (void)vm;
+}
+
+// --- Bytecode Verifier ---
+// Walks every entry point (top-level code and each function) once, tracking
+// the stack depth relative to the entry. Verified code has jump targets on
+// instruction boundaries, in-range operands, the same depth on every path
+// into an instruction and never pops below its entry. run_vm_from then uses
+// the unchecked fast loop, which drops the per-op stack checks and only
+// checks for room (image->stack_need) when a frame is entered.
+
+#define VERIFY_FAIL(...) do { if (err) snprintf(err, err_len, __VA_ARGS__); goto fail; } while (0)
+
+// Values popped and pushed by the instruction at ip; false if it has no fixed effect
+static bool verify_stack_effect(VM* vm, int std_count, int ip, int* pops, int* pushes) {
+    const int* code = vm->bytecode;
+    *pops = 0;
+    *pushes = 0;
+    switch (code[ip]) {
+        case OP_PSH_NUM: case OP_PSH_STR: case OP_PSH_ENUM:
+        case OP_GET: case OP_LVAR: case OP_LVAR_HGET:
+        case OP_ALLOC: case OP_MAP: case OP_EMBED: case OP_NEW_ARENA:
+            *pushes = 1; break;
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_MOD:
+        case OP_LT: case OP_EQ: case OP_GT: case OP_GE: case OP_LE: case OP_NEQ:
+        case OP_AND: case OP_OR: case OP_CAT: case OP_RANGE:
+        case OP_HSET: case OP_AGET: case OP_IT_KEY: case OP_IT_VAL: case OP_IT_DEF:
+            *pops = 2; *pushes = 1; break;
+        case OP_HGET: case OP_ALEN: case OP_MK_BYTES: case OP_CAST: case OP_CHECK_TYPE:
+        case OP_ADD_C: case OP_SUB_C:
+            *pops = 1; *pushes = 1; break;
+        case OP_SET: case OP_SVAR: case OP_POP: case OP_PRN: case OP_JZ: case OP_JNZ:
+        case OP_DEL_ARENA: case OP_SET_CTX:
+            *pops = 1; break;
+        case OP_DUP: *pops = 1; *pushes = 2; break;
+        case OP_SLICE: case OP_ASET: *pops = 3; *pushes = 1; break;
+        case OP_SLICE_SET: *pops = 4; *pushes = 1; break;
+        case OP_LT_JZ: case OP_EQ_JZ: case OP_GT_JZ: case OP_GE_JZ: case OP_LE_JZ: case OP_NEQ_JZ:
+            *pops = 2; break;
+        case OP_ARR: *pops = code[ip + 1]; *pushes = 1; break;
+        case OP_MAKE_ARR: *pops = code[ip + 1]; *pushes = 1; break;
+        case OP_CALL: *pops = code[ip + 2]; *pushes = 1; break;
+        case OP_RET: *pops = 1; break;
+        case OP_NATIVE:
+            // Stdlib natives pop their arguments and push one result. FFI
+            // bindings are loaded at runtime and their arity is not recorded.
+            if (code[ip + 1] >= std_count) return false;
+            *pops = std_library[code[ip + 1]].arg_count;
+            *pushes = 1;
+            break;
+        case OP_JMP: case OP_HLT: case OP_MONITOR: case OP_SCOPE_ENTER: case OP_SCOPE_EXIT:
+        case OP_DEBUGGER: case OP_INC_LVAR: case OP_INC_GVAR:
+            break;
+        default:
+            return false;
+    }
+    return *pops >= 0;
+}
+
+bool vm_verify(VM* vm, char* err, int err_len) {
+    ProgramImage* img = vm->image;
+    const int* code = vm->bytecode;
+    int n = vm->code_size;
+    if (!img || n <= 0) {
+        if (err) snprintf(err, err_len, "no code");
+        return false;
+    }
+
+    int std_count = 0;
+    while (std_library[std_count].name != NULL) std_count++;
+
+    bool* boundary = (bool*)calloc(n + 1, sizeof(bool));
+    int* depth = (int*)malloc((n + 1) * sizeof(int));
+    int* owner = (int*)malloc((n + 1) * sizeof(int));
+    int* need = (int*)malloc((n + 1) * sizeof(int));
+    int* work = (int*)malloc((4 * n + 2) * sizeof(int)); // (ip, depth) pairs, at most two per instruction
+    if (!boundary || !depth || !owner || !need || !work) VERIFY_FAIL("out of memory");
+
+    // 1. Decode linearly: every instruction must be whole and known
+    for (int ip = 0; ip < n; ) {
+        if (code[ip] < 0 || code[ip] >= OP_COUNT) VERIFY_FAIL("unknown opcode %d at %d", code[ip], ip);
+        int len = vm_op_length(code, ip);
+        if (len < 1 || ip + len > n) VERIFY_FAIL("truncated %s at %d", OP_NAMES[code[ip]], ip);
+        boundary[ip] = true;
+        ip += len;
+    }
+    boundary[n] = true; // Falling off the end halts (run_vm_from's sentinel)
+
+    for (int i = 0; i <= n; i++) { depth[i] = -1; owner[i] = -1; need[i] = -1; }
+    for (int f = 0; f < vm->function_count; f++) {
+        int addr = vm->functions[f].addr;
+        if (addr < 0 || addr >= n || !boundary[addr]) VERIFY_FAIL("function %s has a bad address", vm->functions[f].name);
+        need[addr] = 0;
+    }
+    need[0] = 0;
+
+    // 2. Depth analysis from each entry
+    for (int entry = 0; entry < n; entry++) {
+        if (need[entry] < 0 || owner[entry] != -1) continue;
+        int top = 0, max_depth = 0;
+        work[top++] = entry; work[top++] = 0;
+        while (top > 0) {
+            int d = work[--top];
+            int ip = work[--top];
+            if (ip == n) continue;
+            if (owner[ip] != -1) {
+                if (owner[ip] != entry) VERIFY_FAIL("code at %d is reachable from two entries", ip);
+                if (depth[ip] != d) VERIFY_FAIL("stack depth %d vs %d at %d", depth[ip], d, ip);
+                continue;
+            }
+            owner[ip] = entry;
+            depth[ip] = d;
+
+            int op = code[ip], pops, pushes;
+            if (!verify_stack_effect(vm, std_count, ip, &pops, &pushes)) {
+                VERIFY_FAIL("%s at %d has no fixed stack effect", OP_NAMES[op], ip);
+            }
+            if (d < pops) VERIFY_FAIL("stack underflow at %d (%s)", ip, OP_NAMES[op]);
+            int next_depth = d - pops + pushes;
+            if (d + pushes > max_depth) max_depth = d + pushes;
+
+            // Operands
+            switch (op) {
+                case OP_PSH_NUM: case OP_PSH_ENUM: case OP_ADD_C: case OP_SUB_C:
+                    if (code[ip + 1] < 0 || code[ip + 1] >= vm->const_count) VERIFY_FAIL("bad constant at %d", ip);
+                    break;
+                case OP_INC_LVAR: case OP_INC_GVAR:
+                    if (code[ip + 2] < 0 || code[ip + 2] >= vm->const_count) VERIFY_FAIL("bad constant at %d", ip);
+                    if (op == OP_INC_GVAR && (code[ip + 1] < 0 || code[ip + 1] >= MAX_GLOBALS)) VERIFY_FAIL("bad global at %d", ip);
+                    break;
+                case OP_PSH_STR:
+                    if (code[ip + 1] < 0 || code[ip + 1] >= vm->str_count) VERIFY_FAIL("bad string at %d", ip);
+                    break;
+                case OP_SET: case OP_GET:
+                    if (code[ip + 1] < 0 || code[ip + 1] >= MAX_GLOBALS) VERIFY_FAIL("bad global at %d", ip);
+                    break;
+                case OP_NATIVE:
+                    if (code[ip + 1] < 0 || !vm->natives[code[ip + 1]]) VERIFY_FAIL("unbound native %d at %d", code[ip + 1], ip);
+                    break;
+                case OP_CALL:
+                    if (code[ip + 1] < 0 || code[ip + 1] >= n || need[code[ip + 1]] < 0) VERIFY_FAIL("call to a non-function at %d", ip);
+                    break;
+                case OP_ARR: case OP_MAKE_ARR: case OP_ALLOC: case OP_EMBED:
+                    if (code[ip + 1] < 0) VERIFY_FAIL("bad size at %d", ip);
+                    break;
+                default:
+                    break;
+            }
+
+            // Successors
+            bool falls_through = op != OP_JMP && op != OP_RET && op != OP_HLT;
+            bool jumps = op == OP_JMP || op == OP_JZ || op == OP_JNZ || (op >= OP_LT_JZ && op <= OP_NEQ_JZ);
+            if (jumps) {
+                int target = code[ip + 1];
+                if (target < 0 || target > n || !boundary[target]) VERIFY_FAIL("bad jump target %d at %d", target, ip);
+                work[top++] = target; work[top++] = next_depth;
+            }
+            if (falls_through) {
+                work[top++] = ip + vm_op_length(code, ip); work[top++] = next_depth;
+            }
+        }
+        // The slow path replays superinstructions with up to two temporaries
+        need[entry] = max_depth + 2;
+    }
+
+    free(boundary); free(depth); free(owner); free(work);
+    free(img->stack_need);
+    img->stack_need = need;
+    img->verified_size = n;
+    return true;
+
+fail:
+    free(boundary); free(depth); free(owner); free(need); free(work);
+    return false;
+}
+
+// Executes the single instruction at vm->ip. Shared by vm_step (debugger/trace)
+// and by the fast loop as the slow path for ops it does not inline.
+static int exec_instruction(VM* vm) {
     int op = vm->bytecode[vm->ip++];
 
     switch (op) {
         // Stack & Constants
-        case OP_PSH_NUM: { int idx = vm->bytecode[vm->ip++]; vm_push(vm, vm->constants[idx], T_NUM); break; }
-        case OP_PSH_STR: { int idx = vm->bytecode[vm->ip++]; vm_push(vm, (double)idx, T_STR); break; }
-        case OP_DUP: CHECK_STACK(1); vm_push(vm, vm->stack[vm->sp], vm->stack_types[vm->sp]); break;
-        case OP_POP: vm_pop(vm); break;
+        case OP_PSH_NUM: { int idx = vm->bytecode[vm->ip++]; vm_push_value(vm, VAL_NUM(vm->constants[idx])); break; }
+        case OP_PSH_STR: { int idx = vm->bytecode[vm->ip++]; vm_push_value(vm, VAL_STR(idx)); break; }
+        case OP_DUP: CHECK_STACK(1); vm_push_value(vm, vm->stack[vm->sp]); break;
+        case OP_POP: vm_pop_value(vm); break;
 
         // Math & Logic
         case OP_ADD:
@@ -1759,34 +2716,18 @@ int vm_step(VM* vm, bool debug_trace) {
         case OP_SLICE_SET: exec_slice_op(vm, op); break;
 
         // Misc
-        case OP_PSH_ENUM: { int idx = vm->bytecode[vm->ip++]; vm_push(vm, vm->constants[idx], T_ENUM); break; }
+        case OP_PSH_ENUM: { int idx = vm->bytecode[vm->ip++]; vm_push_value(vm, VAL_ENUM((unsigned long long)vm->constants[idx])); break; }
         case OP_CAT: {
             CHECK_STACK(2);
-            double b = vm_pop(vm); int bt = vm->stack_types[vm->sp + 1];
-            double a = vm->stack[vm->sp]; int at = vm->stack_types[vm->sp];
-            char s1[MAX_STRING_LENGTH], s2[MAX_STRING_LENGTH];
-
-            if (at == T_STR) strncpy(s1, vm->string_pool[(int)a], MAX_STRING_LENGTH-1);
-            else if (at == T_ENUM) strncpy(s1, vm->string_pool[((unsigned long long)a >> 16) & 0xFFFF], MAX_STRING_LENGTH-1);
-            else snprintf(s1, MAX_STRING_LENGTH, "%g", a);
-            s1[MAX_STRING_LENGTH-1] = '\0';
-
-            if (bt == T_STR) strncpy(s2, vm->string_pool[(int)b], MAX_STRING_LENGTH-1);
-            else if (bt == T_ENUM) strncpy(s2, vm->string_pool[((unsigned long long)b >> 16) & 0xFFFF], MAX_STRING_LENGTH-1);
-            else snprintf(s2, MAX_STRING_LENGTH, "%g", b);
-            s2[MAX_STRING_LENGTH-1] = '\0';
-
-            char res[MAX_STRING_LENGTH * 2];
-            snprintf(res, sizeof(res), "%s%s", s1, s2);
-            int id = make_string(vm, res);
-            vm->stack[vm->sp] = (double)id;
-            vm->stack_types[vm->sp] = T_STR;
+            Value vb = vm_pop_value(vm), va = vm->stack[vm->sp];
+            int id = concat_values(vm, va, vb);
+            vm->stack[vm->sp] = VAL_STR(id);
             break;
         }
         case OP_PRN: {
             CHECK_STACK(1);
-            double v = vm->stack[vm->sp]; int t = vm->stack_types[vm->sp]; vm->sp--;
-            print_recursive(vm, v, t, 0, -1);
+            Value v = vm->stack[vm->sp]; vm->sp--;
+            print_recursive(vm, v, 0, -1);
             print_raw(vm, "\n");
             break;
         }
@@ -1799,11 +2740,11 @@ int vm_step(VM* vm, bool debug_trace) {
         case OP_MK_BYTES: {
             CHECK_STACK(1);
             double v = vm_pop(vm);
-            const char* s = vm->string_pool[(int)v];
-            int len = strlen(s);
+            const char* s = vm_get_string(vm, (int)v);
+            int len = vm_string_len(vm, (int)v);
             double ptr = heap_alloc(vm, (len+7)/8 + 2);
-            double* base = vm_resolve_ptr(vm, ptr);
-            base[0] = TYPE_BYTES; base[1] = (double)len;
+            Value* base = vm_resolve_ptr(vm, ptr);
+            base[0] = TYPE_BYTES; base[1] = len;
             char* b = (char*)&base[2];
             memcpy(b, s, len);
             vm_push(vm, ptr, T_OBJ);
@@ -1812,15 +2753,15 @@ int vm_step(VM* vm, bool debug_trace) {
         case OP_EMBED: {
             int len = vm->bytecode[vm->ip++];
             double ptr = heap_alloc(vm, (len+7)/8 + 2);
-            double* base = vm_resolve_ptr(vm, ptr);
-            base[0] = TYPE_BYTES; base[1] = (double)len;
+            Value* base = vm_resolve_ptr(vm, ptr);
+            base[0] = TYPE_BYTES; base[1] = len;
             unsigned char* dst = (unsigned char*)&base[2];
             for(int i=0; i<len; i++) dst[i] = (unsigned char)vm->bytecode[vm->ip++];
             vm_push(vm, ptr, T_OBJ);
             break;
         }
         case OP_SCOPE_ENTER: {
-            if (vm->scope_sp >= MAX_LOOP_NESTING) RUNTIME_ERROR("Stack Overflow (Scope)");
+            if (vm->scope_sp >= MAX_SCOPES) RUNTIME_ERROR("Stack Overflow (Scope)");
             vm->scope_stack[vm->scope_sp].arena_id = vm->current_arena;
             vm->scope_stack[vm->scope_sp].head = vm->arenas[vm->current_arena].head;
             vm->scope_stack[vm->scope_sp].fp = vm->fp;
@@ -1833,7 +2774,7 @@ int vm_step(VM* vm, bool debug_trace) {
                 vm->scope_sp--;
                 VMScope* scope = &vm->scope_stack[vm->scope_sp];
                 if (vm->current_arena == scope->arena_id) {
-                    vm->arenas[vm->current_arena].head = scope->head;
+                    arena_rewind(vm, vm->current_arena, scope->head);
                 }
             }
             break;
@@ -1847,8 +2788,7 @@ int vm_step(VM* vm, bool debug_trace) {
             double obj_val = vm_pop(vm);
             int idx = (int)idx_val;
 
-            double* base = vm_resolve_ptr(vm, obj_val);
-            int* types = vm_resolve_type(vm, obj_val);
+            Value* base = vm_resolve_ptr(vm, obj_val);
             int type = (int)base[0];
 
             if (type == TYPE_ARRAY || type == TYPE_BYTES) {
@@ -1857,15 +2797,16 @@ int vm_step(VM* vm, bool debug_trace) {
                 if (op == OP_IT_KEY) vm_push(vm, (double)idx, T_NUM);
                 else {
                     if (type == TYPE_BYTES) vm_push(vm, (double)((unsigned char*)&base[2])[idx], T_NUM);
-                    else vm_push(vm, base[2+idx], types[2+idx]);
+                    else vm_push_value(vm, base[2+idx]);
                 }
             } else if (type == TYPE_MAP) {
                 int count = (int)base[HEAP_OFFSET_COUNT];
                 if (idx < 0 || idx >= count) RUNTIME_ERROR("Iterator OOB");
-                double* data = vm_resolve_ptr(vm, base[HEAP_OFFSET_DATA]);
-                int* data_types = vm_resolve_type(vm, base[HEAP_OFFSET_DATA]);
-                if (op == OP_IT_VAL) vm_push(vm, data[idx*2+1], data_types[idx*2+1]);
-                else vm_push(vm, data[idx*2], data_types[idx*2]);
+                Value* data = vm_resolve_ptr(vm, (double)base[HEAP_OFFSET_DATA]);
+                if (op == OP_IT_VAL) vm_push_value(vm, data[idx*2+1]);
+                else vm_push_value(vm, data[idx*2]);
+            } else {
+                RUNTIME_ERROR("Cannot iterate type %d", type);
             }
             break;
         }
@@ -1882,6 +2823,7 @@ int vm_step(VM* vm, bool debug_trace) {
         case OP_DEL_ARENA: {
             int id = (int)vm_pop(vm);
             if(id <= 0) RUNTIME_ERROR("Cannot clear main region or invalid region");
+            if (id < MAX_ARENAS && vm->arenas[id].frozen) RUNTIME_ERROR("Cannot clear frozen Region %d", id);
             free_arena(vm, id);
             break;
         }
@@ -1906,20 +2848,18 @@ int vm_step(VM* vm, bool debug_trace) {
         }
         case OP_OR: {
             CHECK_STACK(2);
-            double b = vm_pop(vm);
-            double a = vm->stack[vm->sp]; // Peek 'a' to overwrite it
+            Value b = vm_pop_value(vm);
+            Value a = vm->stack[vm->sp]; // Peek 'a' to overwrite it
             // Logic: result is 1.0 if either a or b is non-zero, else 0.0
-            vm->stack[vm->sp] = (a != 0.0 || b != 0.0) ? 1.0 : 0.0;
-            vm->stack_types[vm->sp] = T_NUM;
+            vm->stack[vm->sp] = (!VAL_IS_FALSY(a) || !VAL_IS_FALSY(b)) ? VAL_TRUE : VAL_FALSE;
             break;
         }
         case OP_AND: {
             CHECK_STACK(2);
-            double b = vm_pop(vm);
-            double a = vm->stack[vm->sp]; // Peek 'a' to overwrite it
+            Value b = vm_pop_value(vm);
+            Value a = vm->stack[vm->sp]; // Peek 'a' to overwrite it
             // Logic: result is 1.0 if both a and b are non-zero, else 0.0
-            vm->stack[vm->sp] = (a != 0.0 && b != 0.0) ? 1.0 : 0.0;
-            vm->stack_types[vm->sp] = T_NUM;
+            vm->stack[vm->sp] = (!VAL_IS_FALSY(a) && !VAL_IS_FALSY(b)) ? VAL_TRUE : VAL_FALSE;
             break;
         }
         case OP_RANGE: {
@@ -1933,16 +2873,14 @@ int vm_step(VM* vm, bool debug_trace) {
             if (count < 0) count = 0; // Safety
 
             double ptr = heap_alloc(vm, count + HEAP_HEADER_ARRAY);
-            double* base = vm_resolve_ptr(vm, ptr);
-            int* types = vm_resolve_type(vm, ptr);
+            Value* base = vm_resolve_ptr(vm, ptr);
 
             base[HEAP_OFFSET_TYPE] = TYPE_ARRAY;
-            base[HEAP_OFFSET_LEN] = (double)count;
+            base[HEAP_OFFSET_LEN] = count;
 
             double val = start;
             for(int i=0; i<count; i++) {
-                base[HEAP_HEADER_ARRAY + i] = val;
-                types[HEAP_HEADER_ARRAY + i] = T_NUM;
+                base[HEAP_HEADER_ARRAY + i] = VAL_NUM(val);
                 val += step;
             }
 
@@ -1957,15 +2895,160 @@ int vm_step(VM* vm, bool debug_trace) {
                 enter_debugger(vm);
             }
             break;
+
+        // Superinstructions: replay the sequence they replace
+        case OP_ADD_C:
+        case OP_SUB_C: {
+            int idx = vm->bytecode[vm->ip++];
+            vm_push_value(vm, VAL_NUM(vm->constants[idx]));
+            exec_math_op(vm, op == OP_ADD_C ? OP_ADD : OP_SUB);
+            break;
+        }
+        case OP_INC_LVAR:
+        case OP_INC_GVAR: {
+            int slot = vm->bytecode[vm->ip++];
+            int idx = vm->bytecode[vm->ip++];
+            vm_push_value(vm, op == OP_INC_LVAR ? vm->stack[vm->fp + slot] : vm->globals[slot]);
+            vm_push_value(vm, VAL_NUM(vm->constants[idx]));
+            exec_math_op(vm, OP_ADD);
+            if (op == OP_INC_LVAR) exec_store_local(vm, slot);
+            else vm->globals[slot] = vm_pop_value(vm);
+            break;
+        }
+        case OP_LT_JZ:
+        case OP_EQ_JZ:
+        case OP_GT_JZ:
+        case OP_GE_JZ:
+        case OP_LE_JZ:
+        case OP_NEQ_JZ: {
+            int target = vm->bytecode[vm->ip++];
+            exec_compare_op(vm, OP_LT + (op - OP_LT_JZ));
+            Value cond = vm_pop_value(vm);
+            if (VAL_IS_FALSY(cond)) vm->ip = target;
+            break;
+        }
+        case OP_LVAR_HGET: {
+            int slot = vm->bytecode[vm->ip++];
+            vm_push_value(vm, vm->stack[vm->fp + slot]);
+            exec_alloc_op(vm, OP_HGET);
+            break;
+        }
     }
     return op;
 }
 
+// --- Fast Interpreter Loop ---
+// Threaded dispatch (computed goto where the compiler supports it) with ip/sp/fp
+// cached in locals. Hot ops are inlined here; anything else syncs the registers
+// back into the VM and runs through exec_instruction (the slow path).
+// vm_step stays the path for --db, --trace and the DAP adapter.
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define MYLO_THREADED_DISPATCH 1
+#endif
+
+#define FAST_SYNC()   do { vm->ip = ip; vm->sp = sp; vm->fp = fp; } while (0)
+#define FAST_RELOAD() do { ip = vm->ip; sp = vm->sp; fp = vm->fp; } while (0)
+#define FAST_ERROR(...) do { FAST_SYNC(); mylo_runtime_error(vm, __VA_ARGS__); } while (0)
+// Verified code (FAST_UNCHECKED) cannot underflow and had its stack room checked on entry
+#define FAST_HAS(count) (FAST_UNCHECKED || sp >= (count) - 1)
+#define FAST_CHECK_STACK(count) if (!FAST_HAS(count)) FAST_ERROR("Stack Underflow")
+#define FAST_CHECK_PUSH(count) if (!FAST_UNCHECKED && sp + (count) >= STACK_SIZE) { printf("Error: Stack Overflow\n"); mylo_exit(1); }
+
+// Numeric fast path for binary ops; mixed types (strings, enums, arrays) go slow.
+// Arithmetic on two numbers can only yield a number (hardware NaNs carry no tag),
+// so the result is stored as raw bits without canonicalising.
+#define FAST_BINARY_NUM(expr) \
+    if (FAST_HAS(2) && VAL_IS_NUM(stack[sp]) && VAL_IS_NUM(stack[sp - 1])) { \
+        double b = VAL_AS_NUM(stack[sp]), a = VAL_AS_NUM(stack[sp - 1]); \
+        double res = (expr); \
+        memcpy(&stack[sp - 1], &res, sizeof(Value)); \
+        sp--; \
+        VM_NEXT(); \
+    } \
+    goto slow_path;
+
+#define FAST_COMPARE_NUM(expr) \
+    if (FAST_HAS(2) && VAL_IS_NUM(stack[sp]) && VAL_IS_NUM(stack[sp - 1])) { \
+        double b = VAL_AS_NUM(stack[sp]), a = VAL_AS_NUM(stack[sp - 1]); \
+        stack[sp - 1] = (expr) ? VAL_TRUE : VAL_FALSE; \
+        sp--; \
+        VM_NEXT(); \
+    } \
+    goto slow_path;
+
+// Compare-and-branch: jump to the operand unless the comparison holds.
+#define FAST_COMPARE_JZ(expr) \
+    if (FAST_HAS(2) && VAL_IS_NUM(stack[sp]) && VAL_IS_NUM(stack[sp - 1])) { \
+        double b = VAL_AS_NUM(stack[sp]), a = VAL_AS_NUM(stack[sp - 1]); \
+        sp -= 2; \
+        ip = (expr) ? ip + 1 : code[ip]; \
+        VM_NEXT(); \
+    } \
+    goto slow_path;
+
+// Each dispatch counts the op it is about to run (slow path included)
+#ifdef MYLO_THREADED_DISPATCH
+    #define VM_CASE(op) L_##op:
+    #define VM_NEXT() do { VM_STAT(op_counts[code[ip]]++); goto *dispatch_table[code[ip++]]; } while (0)
+    #define VM_LABEL(op) [op] = &&L_##op
+#else
+    #define VM_CASE(op) case op:
+    #define VM_NEXT() goto dispatch
+#endif
+
+// The checked loop runs anything; the unchecked one only code vm_verify accepted
+#define FAST_UNCHECKED 0
+#define RUN_FAST_NAME run_fast
+#include "vm_fast.h"
+#undef FAST_UNCHECKED
+#undef RUN_FAST_NAME
+
+#define FAST_UNCHECKED 1
+#define RUN_FAST_NAME run_fast_unchecked
+#include "vm_fast.h"
+#undef FAST_UNCHECKED
+#undef RUN_FAST_NAME
+
 void run_vm_from(VM* vm, int start_ip, bool debug_trace) {
+    VMProfileHook* profile = vm->profile;
+    // A nested run is a callback from a native: remember where it was called.
+    // Natives running several callbacks come back with ip at the return sentinel.
+    if (profile && vm->run_depth < PROFILE_MAX_NEST && vm->ip < vm->code_size) profile->entry_ip[vm->run_depth] = vm->ip;
     vm->ip = start_ip;
-    while (vm->ip < vm->code_size) {
-        if (vm_step(vm, debug_trace) == -1) break;
+    vm->run_depth++;
+    if (profile && profile->transition) profile->transition(vm, true);
+    if (debug_trace || vm->cli_debug_mode || profile) {
+        while (vm->ip < vm->code_size) {
+            if (profile) {
+                profile->steps++;
+                if (profile->pending) {
+                    int ticks = profile->pending;
+                    profile->pending = 0;
+                    profile->sample(vm, ticks);
+                }
+            }
+            if (vm_step(vm, debug_trace) == -1) break;
+        }
+    } else if (vm->ip < vm->code_size) {
+        // Falling off the end (or returning to the code_size sentinel used by
+        // re-entrant natives and workers) behaves like OP_HLT.
+        // The image may be shared with running workers, so only write when needed.
+        if (vm->code_size < MAX_CODE && vm->bytecode[vm->code_size] != OP_HLT) vm->bytecode[vm->code_size] = OP_HLT;
+        // Callbacks from natives (map, spawn...) enter at a function address
+        ProgramImage* img = vm->image;
+        if (img->aot) {
+            if (img->jit_tick && !img->aot[vm->ip]) img->jit_tick(vm, vm->ip, -1);
+            if (img->aot[vm->ip]) img->aot[vm->ip](vm);
+        }
+        if (vm->ip < vm->code_size) {
+            // Verified code entered at a function (or the top) with room for its stack
+            int need = img->stack_need && img->verified_size == vm->code_size ? img->stack_need[vm->ip] : -1;
+            if (need >= 0 && vm->sp + need < STACK_SIZE) run_fast_unchecked(vm);
+            else run_fast(vm);
+        }
     }
+    vm->run_depth--;
 }
 
 void run_vm(VM* vm, bool debug_trace) {
@@ -1999,9 +3082,20 @@ bool load_self_contained(VM* vm, const char* exe_path) {
     vm->const_count = footer.const_size / sizeof(double);
     fread(vm->constants, sizeof(double), vm->const_count, f);
 
-    // 3. Read Strings
-    vm->str_count = footer.string_size / MAX_STRING_LENGTH;
-    fread(vm->string_pool, MAX_STRING_LENGTH, vm->str_count, f);
+    // 3. Read Strings (length-prefixed records, re-interned in id order so ids match)
+    if (footer.string_size > 0) {
+        char* strings = malloc(footer.string_size);
+        fread(strings, 1, footer.string_size, f);
+        long pos = 0;
+        while (pos + (long)sizeof(int) <= footer.string_size) {
+            int len;
+            memcpy(&len, strings + pos, sizeof(int));
+            pos += sizeof(int);
+            vm_pin_string(vm, make_string_len(vm, strings + pos, len));
+            pos += len;
+        }
+        free(strings);
+    }
 
     // 4. Read Dependencies (Store in temporary memory so we can read symbols next)
     int dep_count = footer.dependency_size / sizeof(Dependency);
@@ -2036,7 +3130,9 @@ bool load_self_contained(VM* vm, const char* exe_path) {
         api.get_ref = vm_get_ref;
         api.free_ref = vm_free_ref;
         api.natives_array = vm->natives;
-        api.string_pool = vm->string_pool;
+        api.get_string = vm_get_string;
+        api.push_value = vm_push_value;
+        api.pop_value = vm_pop_value;
 
         for (int i = 0; i < dep_count; i++) {
             printf("Loading ... %s\n", deps[i].name);
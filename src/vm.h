@@ -1,7 +1,10 @@
 #ifndef MYLO_VM_H
 #define MYLO_VM_H
 
+#include <signal.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 #include "defines.h"
 #include "stddef.h"
 
@@ -11,6 +14,78 @@
 #define T_OBJ  2
 #define T_ENUM 3
 
+// --- Values (NaN-boxed) ---
+// Every stack slot, global and heap element is a single 64-bit Value.
+// Numbers are stored as plain IEEE doubles. Everything else lives in a negative
+// quiet NaN with the type tag in bits 48-50 and a 48-bit payload:
+//   T_STR  -> string pool id
+//   T_OBJ  -> PACK_PTR(gen, arena, offset) (exactly 48 bits)
+//   T_ENUM -> type_str_id << 32 | member_str_id << 16 | value
+// NaN numbers are canonicalised so they never collide with a tagged value.
+// Heap headers (type, length, struct id...) are stored as raw integers.
+typedef uint64_t Value;
+
+#define VAL_SIGN_QNAN    0xFFF8000000000000ULL
+#define VAL_TAG_SHIFT    48
+#define VAL_TAG_MASK     (0x7ULL << VAL_TAG_SHIFT)
+#define VAL_PAYLOAD_MASK 0x0000FFFFFFFFFFFFULL
+#define VAL_CANON_NAN    0x7FF8000000000000ULL
+#define VAL_FALSE        0x0000000000000000ULL // 0.0
+#define VAL_TRUE         0x3FF0000000000000ULL // 1.0
+
+#define VAL_BOXED(tag, payload) \
+    (VAL_SIGN_QNAN | ((Value)(tag) << VAL_TAG_SHIFT) | ((Value)(payload) & VAL_PAYLOAD_MASK))
+#define VAL_IS_NUM(v)  (((v) & VAL_SIGN_QNAN) != VAL_SIGN_QNAN || ((v) & VAL_TAG_MASK) == 0)
+#define VAL_TYPE(v)    (VAL_IS_NUM(v) ? T_NUM : (int)(((v) >> VAL_TAG_SHIFT) & 0x7))
+#define VAL_PAYLOAD(v) ((v) & VAL_PAYLOAD_MASK)
+
+#define VAL_STR(id)      VAL_BOXED(T_STR, (unsigned int)(id))
+#define VAL_OBJ(ptr)     VAL_BOXED(T_OBJ, (unsigned long long)(ptr))
+#define VAL_ENUM(packed) VAL_BOXED(T_ENUM, (unsigned long long)(packed))
+#define VAL_AS_STR(v)    ((int)VAL_PAYLOAD(v))
+#define VAL_AS_PTR(v)    ((double)VAL_PAYLOAD(v))
+
+static inline Value mylo_num_val(double d) {
+    Value v;
+    if (d != d) return VAL_CANON_NAN;
+    memcpy(&v, &d, sizeof(v));
+    return v;
+}
+
+static inline double mylo_val_num(Value v) {
+    double d;
+    memcpy(&d, &v, sizeof(d));
+    return d;
+}
+
+// Payload as a double: the number itself, or the id/packed pointer/packed enum.
+// This is what the double-based push/pop API has always exchanged.
+static inline double mylo_val_double(Value v) {
+    return VAL_IS_NUM(v) ? mylo_val_num(v) : (double)VAL_PAYLOAD(v);
+}
+
+static inline Value mylo_make_val(double payload, int type) {
+    if (type == T_NUM) return mylo_num_val(payload);
+    return VAL_BOXED(type, (unsigned long long)payload);
+}
+
+// Map-key / identity equality: numbers compare numerically, tagged values by bits.
+static inline bool mylo_val_equal(Value a, Value b) {
+    if (VAL_IS_NUM(a) && VAL_IS_NUM(b)) return mylo_val_num(a) == mylo_val_num(b);
+    return a == b;
+}
+
+// 0, false and the empty string / null id
+static inline bool mylo_val_falsy(Value v) {
+    return VAL_IS_NUM(v) ? (v << 1) == 0 : VAL_PAYLOAD(v) == 0;
+}
+
+#define VAL_NUM(d)         mylo_num_val(d)
+#define VAL_AS_NUM(v)      mylo_val_num(v)
+#define VAL_AS_DOUBLE(v)   mylo_val_double(v)
+#define VAL_FROM(d, type)  mylo_make_val(d, type)
+#define VAL_IS_FALSY(v)    mylo_val_falsy(v)
+
 // Return type for C-Blocks
 typedef struct {
     double value;
@@ -64,7 +139,13 @@ typedef enum {
     OP_SCOPE_ENTER,
     OP_SCOPE_EXIT,
     OP_DEBUGGER,
-    OP_PSH_ENUM
+    OP_PSH_ENUM,
+    // Superinstructions, produced by the compiler's peephole pass
+    OP_ADD_C, OP_SUB_C,
+    OP_INC_LVAR, OP_INC_GVAR,
+    OP_LT_JZ, OP_EQ_JZ, OP_GT_JZ, OP_GE_JZ, OP_LE_JZ, OP_NEQ_JZ, // Same order as OP_LT..OP_NEQ
+    OP_LVAR_HGET,
+    OP_COUNT // Number of opcodes, keep last
 } OpCode;
 
 extern const char *OP_NAMES[];
@@ -76,12 +157,14 @@ typedef struct {
 
 // --- Arena Struct ---
 typedef struct {
-    double* memory;
-    int* types;
+    Value* memory;
     int head;
-    int capacity;
+    int capacity;   // Reserved slots (address space)
+    int committed;  // Slots backed by memory, always a multiple of ARENA_COMMIT_CHUNK
     bool active;
     int generation;
+    bool frozen;    // Read-only (freeze); workers see it without a copy
+    bool borrowed;  // A view of another VM's frozen arena, never released here
 } MemoryArena;
 
 // --- Debug Structures ---
@@ -107,6 +190,50 @@ typedef struct {
 
 // Forward declaration
 struct VM;
+
+// A function body translated to C by --build. Entered with the call frame
+// already set up (as OP_CALL leaves it); returns once it has run OP_RET.
+typedef void (*MyloAotFunc)(struct VM*);
+
+// --- Program Image ---
+// The compiled, read-only half of a program. A VM owns one and worker VMs
+// share their parent's by reference count instead of copying it. The VM keeps
+// direct pointers to the buffers (bytecode, lines...) for the interpreter loop.
+typedef struct ProgramImage {
+    int* bytecode;
+    int* lines;
+    double* constants;
+    VMFunction* functions;
+    MyloAotFunc* aot;       // Native entry per address (function or loop head), NULL if interpreted
+    // Set by jit_attach (--jit): counts a call or back-edge into entry and
+    // compiles [entry, end) once hot. end is -1 for a function entry.
+    void (*jit_tick)(struct VM* vm, int entry, int end);
+    void (*jit_release)(struct ProgramImage* img);
+    void* jit;
+    // Set by vm_verify: stack slots each entry (0 and function addresses)
+    // needs, -1 elsewhere. Only trusted while code_size == verified_size.
+    int* stack_need;
+    int verified_size;
+    volatile long long refcount;
+} ProgramImage;
+
+// --- String Pool ---
+// Interned strings live in a chain of chunks. Each one is preceded by a
+// StringHeader so length and hash never need recomputing.
+typedef struct {
+    int len;
+    uint32_t hash;
+} StringHeader;
+
+typedef struct StringChunk {
+    struct StringChunk* next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} StringChunk;
+
+#define STRING_HEADER(s) ((StringHeader*)(s) - 1)
+
 typedef void (*NativeFunc)(struct VM *);
 
 typedef struct {
@@ -114,41 +241,86 @@ typedef struct {
     int start_index; // The VM Native ID index where this library starts
 } Dependency;
 
+// --- Statistics (--stats) ---
+// Aggregate counters for one VM since it was last initialised. Only builds
+// configured with MYLO_STATS count anything; elsewhere the counting is
+// compiled out and vm_get_stats reports false with everything zero.
+typedef struct {
+    uint64_t ops[OP_COUNT];                 // Instructions run by the interpreter (not --jit / --build code)
+    uint64_t heap_allocs[MAX_ARENAS];       // heap_alloc calls per arena
+    uint64_t heap_alloc_bytes[MAX_ARENAS];
+    uint64_t string_makes;                  // make_string / make_string_len calls
+    uint64_t string_hits;                   // ... that found the string already interned
+    uint64_t string_misses;                 // ... that added it to the pool
+    uint64_t evacuations;                   // Objects vm_evacuate_object copied
+    uint64_t evacuated_bytes;
+    uint64_t rewinds;                       // Arena rewinds (scope exit, return, clear)
+    uint64_t rewound_bytes;                 // Heap they handed back
+} MyloStats;
+
+// --- Profiler Hook ---
+// Set by profiler_start (--profile, --perf-counters). While it is attached
+// run_vm_from steps the interpreter, so vm->ip is always current, and calls
+// sample() before the next instruction once the timer has bumped pending.
+typedef struct VMProfileHook {
+    volatile sig_atomic_t pending;  // Timer ticks not yet recorded
+    void (*sample)(struct VM* vm, int ticks);
+    // --perf-counters: called once a call or return has moved vm->ip
+    void (*transition)(struct VM* vm, bool call);
+    long steps;                     // Instructions run while attached
+    long alloc_slots;               // Heap slots allocated while attached
+    int entry_ip[PROFILE_MAX_NEST]; // Per run_depth: vm->ip of the native that re-entered
+} VMProfileHook;
+
 typedef struct VM {
-    double* stack;
-    double* globals;
-    double* constants;
+    Value* stack;
+    Value* globals;
+    double* constants;      // image->constants
     MemoryArena arenas[MAX_ARENAS];
     int current_arena;
-    int* bytecode;
-    int* lines;
-    int* stack_types;
-    int* global_types;
-    char (*string_pool)[MAX_STRING_LENGTH];
+    ProgramImage* image;
+    int* bytecode;          // image->bytecode
+    int* lines;             // image->lines
+    char** string_pool;     // id -> interned chars (stable, NUL terminated)
     int code_size;
     int sp;
     int fp;
     int ip;
-    int str_count;
+    int str_count;          // High-water mark of ids; freed ids sit in str_free
+    int str_capacity;
+    int* str_index;         // Open-addressing intern table: id + 1, 0 = empty
+    int str_index_cap;
+    StringChunk* str_chunks;
+    uint8_t* str_flags;     // Per id: pinned literal / marked by the collector
+    int* str_free;
+    int str_free_count;
+    size_t str_bytes_since_gc;
+    size_t str_gc_threshold;
+    bool str_gc_pending;    // Set by make_string, serviced between instructions
+    int run_depth;          // Nested run_vm_from calls (re-entrant natives such as map)
     int const_count;
     char output_char_buffer[OUTPUT_BUFFER_SIZE];
     int output_mem_pos;
-    VMFunction functions[MAX_VM_FUNCTIONS];
+    VMFunction* functions;  // image->functions
     int function_count;
     VMSymbol* global_symbols;
     int global_symbol_count;
     VMLocalInfo* local_symbols;
     int local_symbol_count;
-    VMScope scope_stack[MAX_LOOP_NESTING]; // Reuse loop constant or define MAX_SCOPES 64
+    VMScope scope_stack[MAX_SCOPES];
     int scope_sp;
     // --- Debugger Fields ---
     char* source_code;
     bool cli_debug_mode;
     int last_debug_line;
+    VMProfileHook* profile;
     // --- Native Interface ---
     NativeFunc natives[MAX_NATIVES];
     Dependency dependencies[MAX_DEPENDENCIES];
     int dependency_count;
+#ifdef MYLO_STATS
+    MyloStats stats;        // Last, so bindings built without MYLO_STATS see the same layout
+#endif
 } VM;
 
 typedef struct {
@@ -156,36 +328,67 @@ typedef struct {
     double (*pop)(VM*);
     int (*make_string)(VM*, const char*);
     double (*heap_alloc)(VM*, int);
-    double* (*resolve_ptr)(VM*, double);
+    Value* (*resolve_ptr)(VM*, double);
     double (*store_copy)(VM*, void*, size_t, const char*);
     double (*store_ptr)(VM*, void*, const char*);
     void* (*get_ref)(VM*, int, const char*);
     void (*free_ref)(VM*, int);
     NativeFunc* natives_array;
-    char (*string_pool)[MAX_STRING_LENGTH];
+    const char* (*get_string)(VM*, int); // The pool grows, so never keep the pool itself
+    void (*push_value)(VM*, Value);
+    Value (*pop_value)(VM*);
 } MyloAPI;
 
 void vm_init(VM* vm);
+void vm_init_worker(VM* vm, VM* parent);
+void vm_park_worker(VM* vm);
+void vm_rewind_heap(VM* vm, int head);
 void vm_cleanup(VM* vm);
 void vm_push(VM* vm, double val, int type);
 double vm_pop(VM* vm);
+void vm_push_value(VM* vm, Value v);
+Value vm_pop_value(VM* vm);
 int make_string(VM* vm, const char *s);
+int make_string_len(VM* vm, const char *s, int len);
+int vm_string_len(VM* vm, int id);
+const char* vm_get_string(VM* vm, int id);
+void vm_adopt_strings(VM* vm, VM* from, int arena_id);
+void vm_pin_string(VM* vm, int id);
+void vm_clone_strings(VM* dst, VM* src);
+void vm_collect_strings(VM* vm);
 int make_const(VM* vm, double val);
 double heap_alloc(VM* vm, int size);
 void run_vm_from(VM* vm, int start_ip, bool debug_trace);
 void run_vm(VM* vm, bool debug_trace);
 int vm_step(VM* vm, bool debug_trace);
-double* vm_resolve_ptr(VM* vm, double ptr_val);
-double* vm_resolve_ptr_safe(VM* vm, double ptr_val);
-int* vm_resolve_type(VM* vm, double ptr_val);
+int vm_exec_op(VM* vm);
+int vm_op_length(const int* code, int ip);
+bool vm_verify(VM* vm, char* err, int err_len);
+bool vm_get_stats(VM* vm, MyloStats* out);
+void vm_reset_stats(VM* vm);
+Value* vm_resolve_ptr(VM* vm, double ptr_val);
+Value* vm_resolve_ptr_safe(VM* vm, double ptr_val);
 double vm_store_copy(VM* vm, void* data, size_t size, const char* type_name);
 double vm_store_ptr(VM* vm, void* ptr, const char* type_name);
 void* vm_get_ref(VM* vm, int id, const char* expected_type_name);
 void vm_free_ref(VM* vm, int id);
 int vm_find_function(VM* vm, const char* name);
 void vm_register_function(VM* vm, const char* name, int addr);
-void print_recursive(VM* vm, double val, int type, int depth, int max_elem);
+void print_recursive(VM* vm, Value val, int depth, int max_elem);
 double vm_evacuate_object(VM* vm, double ptr_val, int target_head);
+unsigned long vm_hash_str(const char *str);
+
+// Maps (TYPE_MAP): insertion-ordered entries with an open-addressing hash index
+double vm_map_new(VM* vm, int cap);
+int vm_map_find(VM* vm, Value* base, Value key);
+void vm_map_set(VM* vm, double map_ptr, Value key, Value val);
+bool vm_map_remove(VM* vm, Value* base, Value key);
+
+// Deep copies between VMs: vm_pack_value flattens a value (strings and
+// objects included) into a malloc'd blob; vm_unpack_value rebuilds it in
+// the VM's current arena and string pool.
+void* vm_pack_value(VM* vm, Value v, size_t* out_size);
+Value vm_unpack_value(VM* vm, const void* blob);
 void enter_debugger(VM* vm);
 void print_raw(VM* vm, const char* str);
 
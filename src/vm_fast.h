@@ -0,0 +1,374 @@
+// The fast interpreter loop. vm.c includes this twice: as run_fast, with
+// the per-op stack checks, and with FAST_UNCHECKED set as run_fast_unchecked
+// for bytecode that passed vm_verify. Not a standalone header.
+
+static void RUN_FAST_NAME(VM* vm) {
+    const int* code = vm->bytecode;
+    const double* constants = vm->constants;
+    Value* stack = vm->stack;
+    Value* globals = vm->globals;
+    MyloAotFunc* aot = vm->image ? vm->image->aot : NULL;
+    void (*jit_tick)(VM*, int, int) = vm->image ? vm->image->jit_tick : NULL;
+#if FAST_UNCHECKED
+    const int* stack_need = vm->image->stack_need;
+#endif
+#ifdef MYLO_STATS
+    uint64_t* op_counts = vm->stats.ops;
+#endif
+    int ip = vm->ip;
+    int sp = vm->sp;
+    int fp = vm->fp;
+
+#ifdef MYLO_THREADED_DISPATCH
+    static void* dispatch_table[OP_COUNT] = {
+        [0 ... OP_COUNT - 1] = &&slow_path,
+        VM_LABEL(OP_PSH_NUM), VM_LABEL(OP_PSH_STR), VM_LABEL(OP_PSH_ENUM),
+        VM_LABEL(OP_DUP), VM_LABEL(OP_POP),
+        VM_LABEL(OP_ADD), VM_LABEL(OP_SUB), VM_LABEL(OP_MUL), VM_LABEL(OP_DIV), VM_LABEL(OP_MOD),
+        VM_LABEL(OP_LT), VM_LABEL(OP_GT), VM_LABEL(OP_LE), VM_LABEL(OP_GE), VM_LABEL(OP_EQ), VM_LABEL(OP_NEQ),
+        VM_LABEL(OP_AND), VM_LABEL(OP_OR),
+        VM_LABEL(OP_SET), VM_LABEL(OP_GET), VM_LABEL(OP_LVAR), VM_LABEL(OP_SVAR),
+        VM_LABEL(OP_JMP), VM_LABEL(OP_JZ), VM_LABEL(OP_JNZ),
+        VM_LABEL(OP_CALL), VM_LABEL(OP_RET), VM_LABEL(OP_HLT),
+        VM_LABEL(OP_HGET), VM_LABEL(OP_HSET),
+        VM_LABEL(OP_SCOPE_ENTER), VM_LABEL(OP_SCOPE_EXIT),
+        VM_LABEL(OP_NATIVE),
+        VM_LABEL(OP_ADD_C), VM_LABEL(OP_SUB_C), VM_LABEL(OP_INC_LVAR), VM_LABEL(OP_INC_GVAR),
+        VM_LABEL(OP_LT_JZ), VM_LABEL(OP_GT_JZ), VM_LABEL(OP_LE_JZ), VM_LABEL(OP_GE_JZ),
+        VM_LABEL(OP_EQ_JZ), VM_LABEL(OP_NEQ_JZ), VM_LABEL(OP_LVAR_HGET),
+    };
+    VM_NEXT();
+#else
+dispatch:
+    VM_STAT(op_counts[code[ip]]++);
+    switch (code[ip++]) {
+#endif
+
+    // Stack & Constants
+    VM_CASE(OP_PSH_NUM) {
+        FAST_CHECK_PUSH(1);
+        sp++;
+        stack[sp] = VAL_NUM(constants[code[ip++]]);
+        VM_NEXT();
+    }
+    VM_CASE(OP_PSH_STR) {
+        FAST_CHECK_PUSH(1);
+        sp++;
+        stack[sp] = VAL_STR(code[ip++]);
+        VM_NEXT();
+    }
+    VM_CASE(OP_PSH_ENUM) {
+        FAST_CHECK_PUSH(1);
+        sp++;
+        stack[sp] = VAL_ENUM((unsigned long long)constants[code[ip++]]);
+        VM_NEXT();
+    }
+    VM_CASE(OP_DUP) {
+        FAST_CHECK_STACK(1);
+        FAST_CHECK_PUSH(1);
+        stack[sp + 1] = stack[sp];
+        sp++;
+        VM_NEXT();
+    }
+    VM_CASE(OP_POP) {
+        FAST_CHECK_STACK(1);
+        sp--;
+        VM_NEXT();
+    }
+
+    // Math & Logic
+    VM_CASE(OP_ADD) { FAST_BINARY_NUM(a + b) }
+    VM_CASE(OP_SUB) { FAST_BINARY_NUM(a - b) }
+    VM_CASE(OP_MUL) { FAST_BINARY_NUM(a * b) }
+    VM_CASE(OP_DIV) { FAST_BINARY_NUM(a / b) }
+    VM_CASE(OP_MOD) { FAST_BINARY_NUM(fmod(a, b)) }
+    VM_CASE(OP_LT)  { FAST_COMPARE_NUM(a < b) }
+    VM_CASE(OP_GT)  { FAST_COMPARE_NUM(a > b) }
+    VM_CASE(OP_LE)  { FAST_COMPARE_NUM(a <= b) }
+    VM_CASE(OP_GE)  { FAST_COMPARE_NUM(a >= b) }
+    VM_CASE(OP_EQ)  { FAST_COMPARE_NUM(a == b) }
+    VM_CASE(OP_NEQ) { FAST_COMPARE_NUM(a != b) }
+    VM_CASE(OP_AND) {
+        FAST_CHECK_STACK(2);
+        Value b = stack[sp--];
+        stack[sp] = (!VAL_IS_FALSY(stack[sp]) && !VAL_IS_FALSY(b)) ? VAL_TRUE : VAL_FALSE;
+        VM_NEXT();
+    }
+    VM_CASE(OP_OR) {
+        FAST_CHECK_STACK(2);
+        Value b = stack[sp--];
+        stack[sp] = (!VAL_IS_FALSY(stack[sp]) || !VAL_IS_FALSY(b)) ? VAL_TRUE : VAL_FALSE;
+        VM_NEXT();
+    }
+
+    // Variables
+    VM_CASE(OP_SET) {
+        int arg = code[ip++];
+        FAST_CHECK_STACK(1);
+        globals[arg] = stack[sp];
+        sp--;
+        VM_NEXT();
+    }
+    VM_CASE(OP_GET) {
+        int arg = code[ip++];
+        FAST_CHECK_PUSH(1);
+        sp++;
+        stack[sp] = globals[arg];
+        VM_NEXT();
+    }
+    VM_CASE(OP_LVAR) {
+        int idx = fp + code[ip++];
+        FAST_CHECK_PUSH(1);
+        sp++;
+        stack[sp] = stack[idx];
+        VM_NEXT();
+    }
+    VM_CASE(OP_SVAR) {
+        int target_idx = fp + code[ip++];
+        FAST_CHECK_STACK(1);
+        Value val = stack[sp];
+        stack[target_idx] = val;
+        sp--;
+
+        // Smart Local Protection (see exec_var_op)
+        if (VAL_TYPE(val) == T_OBJ) {
+            int obj_offset = UNPACK_OFFSET(val);
+            for (int s = 0; s < vm->scope_sp; s++) {
+                if (vm->scope_stack[s].fp == fp &&
+                    target_idx <= vm->scope_stack[s].sp_at_entry &&
+                    vm->scope_stack[s].arena_id == vm->current_arena &&
+                    obj_offset >= vm->scope_stack[s].head) {
+                    vm->scope_stack[s].head = vm->arenas[vm->current_arena].head;
+                }
+            }
+        }
+        VM_NEXT();
+    }
+
+    // Flow Control
+    VM_CASE(OP_JMP) {
+        int target = code[ip];
+        // Back-edge: run the loop natively if it has been compiled (--jit)
+        if (aot && target < ip) {
+            if (jit_tick && !aot[target]) jit_tick(vm, target, ip + 1);
+            if (aot[target]) {
+                ip = target;
+                FAST_SYNC();
+                aot[target](vm);
+                FAST_RELOAD();
+                VM_NEXT();
+            }
+        }
+        ip = target;
+        if (vm->str_gc_pending) { FAST_SYNC(); STRING_GC_SAFEPOINT(vm); }
+        VM_NEXT();
+    }
+    VM_CASE(OP_JZ) {
+        FAST_CHECK_STACK(1);
+        ip = VAL_IS_FALSY(stack[sp]) ? code[ip] : ip + 1;
+        sp--;
+        VM_NEXT();
+    }
+    VM_CASE(OP_JNZ) {
+        FAST_CHECK_STACK(1);
+        ip = !VAL_IS_FALSY(stack[sp]) ? code[ip] : ip + 1;
+        sp--;
+        VM_NEXT();
+    }
+    VM_CASE(OP_CALL) {
+        int target = code[ip];
+        int argc = code[ip + 1];
+        ip += 2;
+        FAST_CHECK_STACK(argc);
+        FAST_CHECK_PUSH(2);
+#if FAST_UNCHECKED
+        // The one overflow check verified code needs: room for the callee's frame
+        if (sp + 2 + stack_need[target] >= STACK_SIZE) { printf("Error: Stack Overflow\n"); mylo_exit(1); }
+#endif
+        int args_start = sp - argc + 1;
+        for (int i = 0; i < argc; i++) {
+            stack[sp + 2 - i] = stack[sp - i];
+        }
+        stack[args_start] = VAL_NUM(ip);
+        stack[args_start + 1] = VAL_NUM(fp);
+        sp += 2;
+        fp = args_start + 2;
+        ip = target;
+        // Functions compiled by --build or --jit run natively and return past
+        // the call (or at the point they handed back to the interpreter)
+        if (aot) {
+            if (jit_tick && !aot[target]) jit_tick(vm, target, -1);
+            if (aot[target]) {
+                FAST_SYNC();
+                aot[target](vm);
+                FAST_RELOAD();
+            }
+        }
+        VM_NEXT();
+    }
+    VM_CASE(OP_RET) {
+        FAST_CHECK_STACK(1);
+        Value rv = stack[sp];
+        bool is_obj = VAL_TYPE(rv) == T_OBJ;
+
+        // Pop every scope owned by this frame (see exec_flow_op)
+        while (vm->scope_sp > 0) {
+            VMScope* scope = &vm->scope_stack[vm->scope_sp - 1];
+            if (scope->fp != fp) break;
+            vm->scope_sp--;
+
+            if (vm->current_arena == scope->arena_id) {
+                if (is_obj) {
+                    FAST_SYNC();
+                    rv = VAL_OBJ(vm_evacuate_object(vm, VAL_AS_PTR(rv), scope->head));
+                }
+                if (!is_obj || UNPACK_OFFSET(rv) < scope->head) {
+                    arena_rewind(vm, scope->arena_id, scope->head);
+                }
+            }
+        }
+
+        sp = fp - 3;
+        int old_fp = fp;
+        fp = (int)VAL_AS_NUM(stack[old_fp - 1]);
+        ip = (int)VAL_AS_NUM(stack[old_fp - 2]);
+        sp++;
+        stack[sp] = rv;
+        VM_NEXT();
+    }
+    VM_CASE(OP_HLT) {
+        FAST_SYNC();
+        return;
+    }
+
+    // Memory & Objects
+    VM_CASE(OP_HGET) {
+        int off = code[ip];
+        int expected_id = code[ip + 1];
+        ip += 2;
+        FAST_CHECK_STACK(1);
+        vm->ip = ip;
+        Value* base = vm_resolve_ptr(vm, VAL_AS_PTR(stack[sp]));
+        if ((int)base[0] != expected_id) FAST_ERROR("HGET Type mismatch");
+        stack[sp] = base[2 + off];
+        VM_NEXT();
+    }
+    VM_CASE(OP_HSET) {
+        int off = code[ip];
+        int expected_id = code[ip + 1];
+        ip += 2;
+        FAST_CHECK_STACK(2);
+        vm->ip = ip;
+        Value v = stack[sp];
+        sp--;
+        double ptr = VAL_AS_PTR(stack[sp]);
+        Value* base = vm_resolve_ptr(vm, ptr);
+        if ((int)base[0] != expected_id) FAST_ERROR("HSET Type mismatch");
+        if (vm->arenas[UNPACK_ARENA(ptr)].frozen) FAST_ERROR("Cannot modify frozen Region %d", UNPACK_ARENA(ptr));
+        base[2 + off] = v;
+        VM_NEXT();
+    }
+
+    // Scopes
+    VM_CASE(OP_SCOPE_ENTER) {
+        if (vm->scope_sp >= MAX_SCOPES) FAST_ERROR("Stack Overflow (Scope)");
+        VMScope* scope = &vm->scope_stack[vm->scope_sp++];
+        scope->arena_id = vm->current_arena;
+        scope->head = vm->arenas[vm->current_arena].head;
+        scope->fp = fp;
+        scope->sp_at_entry = sp;
+        VM_NEXT();
+    }
+    VM_CASE(OP_SCOPE_EXIT) {
+        if (vm->scope_sp > 0) {
+            VMScope* scope = &vm->scope_stack[--vm->scope_sp];
+            if (vm->current_arena == scope->arena_id) {
+                arena_rewind(vm, vm->current_arena, scope->head);
+            }
+        }
+        VM_NEXT();
+    }
+
+    // Natives may re-enter the VM (for_list, call, filter), so registers round-trip.
+    VM_CASE(OP_NATIVE) {
+        int id = code[ip++];
+        FAST_SYNC();
+        if (FAST_UNCHECKED || vm->natives[id]) vm->natives[id](vm);
+        else RUNTIME_ERROR("Unknown Native ID %d", id);
+        FAST_RELOAD();
+        VM_NEXT();
+    }
+
+    // Superinstructions (numeric fast paths; anything else replays via the slow path)
+    VM_CASE(OP_ADD_C) {
+        if (FAST_HAS(1) && VAL_IS_NUM(stack[sp])) {
+            double res = VAL_AS_NUM(stack[sp]) + constants[code[ip++]];
+            memcpy(&stack[sp], &res, sizeof(Value));
+            VM_NEXT();
+        }
+        goto slow_path;
+    }
+    VM_CASE(OP_SUB_C) {
+        if (FAST_HAS(1) && VAL_IS_NUM(stack[sp])) {
+            double res = VAL_AS_NUM(stack[sp]) - constants[code[ip++]];
+            memcpy(&stack[sp], &res, sizeof(Value));
+            VM_NEXT();
+        }
+        goto slow_path;
+    }
+    VM_CASE(OP_INC_LVAR) {
+        Value* slot = &stack[fp + code[ip]];
+        if (VAL_IS_NUM(*slot)) {
+            double res = VAL_AS_NUM(*slot) + constants[code[ip + 1]];
+            memcpy(slot, &res, sizeof(Value));
+            ip += 2;
+            VM_NEXT();
+        }
+        goto slow_path;
+    }
+    VM_CASE(OP_INC_GVAR) {
+        Value* slot = &globals[code[ip]];
+        if (VAL_IS_NUM(*slot)) {
+            double res = VAL_AS_NUM(*slot) + constants[code[ip + 1]];
+            memcpy(slot, &res, sizeof(Value));
+            ip += 2;
+            VM_NEXT();
+        }
+        goto slow_path;
+    }
+    VM_CASE(OP_LT_JZ)  { FAST_COMPARE_JZ(a < b) }
+    VM_CASE(OP_GT_JZ)  { FAST_COMPARE_JZ(a > b) }
+    VM_CASE(OP_LE_JZ)  { FAST_COMPARE_JZ(a <= b) }
+    VM_CASE(OP_GE_JZ)  { FAST_COMPARE_JZ(a >= b) }
+    VM_CASE(OP_EQ_JZ)  { FAST_COMPARE_JZ(a == b) }
+    VM_CASE(OP_NEQ_JZ) { FAST_COMPARE_JZ(a != b) }
+    VM_CASE(OP_LVAR_HGET) {
+        Value obj = stack[fp + code[ip]];
+        int off = code[ip + 1];
+        int expected_id = code[ip + 2];
+        ip += 3;
+        FAST_CHECK_PUSH(1);
+        vm->ip = ip;
+        Value* base = vm_resolve_ptr(vm, VAL_AS_PTR(obj));
+        if ((int)base[0] != expected_id) FAST_ERROR("HGET Type mismatch");
+        sp++;
+        stack[sp] = base[2 + off];
+        VM_NEXT();
+    }
+
+#ifndef MYLO_THREADED_DISPATCH
+    default:
+        goto slow_path;
+    }
+#endif
+
+slow_path:
+    // ip points just past the opcode; rewind so exec_instruction re-reads it.
+    vm->ip = ip - 1;
+    vm->sp = sp;
+    vm->fp = fp;
+    if (exec_instruction(vm) == -1) return;
+    STRING_GC_SAFEPOINT(vm);
+    FAST_RELOAD();
+    VM_NEXT();
+}
@@ -0,0 +1,14 @@
+# cmake -DMYLO=<mylo> -DAOT=<binary> -DPROGRAM=<file.mylo> -P aot_compare.cmake
+# Runs PROGRAM with the interpreter and the binary `mylo --build` made from
+# it, and fails unless both exit cleanly with the same output.
+execute_process(COMMAND ${MYLO} ${PROGRAM} OUTPUT_VARIABLE expected RESULT_VARIABLE expected_rc)
+execute_process(COMMAND ${AOT} OUTPUT_VARIABLE actual RESULT_VARIABLE actual_rc)
+if (NOT expected_rc EQUAL 0)
+    message(FATAL_ERROR "mylo ${PROGRAM} exited with ${expected_rc}:\n${expected}")
+endif()
+if (NOT actual_rc EQUAL 0)
+    message(FATAL_ERROR "${AOT} exited with ${actual_rc}:\n${actual}")
+endif()
+if (NOT expected STREQUAL actual)
+    message(FATAL_ERROR "Interpreter printed:\n${expected}\nAOT binary printed:\n${actual}")
+endif()
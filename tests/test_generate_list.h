@@ -7,6 +7,7 @@
 
 
 #include <cstring>
+#include <csetjmp>
 #include "test_include.h"
 
 // Toggle this define to print the source code for each test
@@ -17,6 +18,8 @@
 // Mylo includes
 extern "C" {
     #include "../src/vm.h"
+    #include "../src/jit.h"
+    #include "../src/profiler.h"
     void compiler_reset();
     // declarations from compiler.c
     void parse(VM* vm, char* src);
@@ -30,6 +33,7 @@ inline TestOutput test_test() {
 
 inline TestOutput test_hello_world() {
     VM vm;
+    memset(&vm, 0, sizeof(vm));
     vm_init(&vm);
     MyloConfig.print_to_memory = true;
 
@@ -45,8 +49,8 @@ inline TestOutput test_hello_world() {
     // Note: OP_PRN adds a newline "\n"
     TestOutput output;
     // Check string pool
-    output.result = (strcmp(vm.string_pool[(int)vm.globals[0]], "hello") == 0);
-    output.result_string = output.result ? "" : "Expected 'hello' and got '" + std::string(vm.string_pool[(int)vm.globals[0]]) + "'";
+    output.result = (strcmp(vm.string_pool[VAL_AS_STR(vm.globals[0])], "hello") == 0);
+    output.result_string = output.result ? "" : "Expected 'hello' and got '" + std::string(vm.string_pool[VAL_AS_STR(vm.globals[0])]) + "'";
     vm_cleanup(&vm);
     return output;
 }
@@ -54,6 +58,9 @@ inline TestOutput test_hello_world() {
 // The test VM, exposed here for post test hooks
 VM test_vm;
 
+// Second pass (see main): source tests run with the JIT compiling every entry on first use
+bool test_jit_mode = false;
+
 inline TestOutput run_source_test(const std::string& src, const std::string& expected, bool clean_up = true) {
     vm_init(&test_vm);
     compiler_reset();
@@ -65,6 +72,9 @@ inline TestOutput run_source_test(const std::string& src, const std::string& exp
     }
 
     parse(&test_vm, const_cast<char *>(src.c_str()));
+    // Programs that verify run in the unchecked loop, the rest stay checked
+    vm_verify(&test_vm, NULL, 0);
+    if (test_jit_mode) jit_attach(&test_vm, 1);
     run_vm(&test_vm, PRINT_MACHINE_CODE);
 
     // Reset config so other tests don't break
@@ -617,10 +627,12 @@ inline TestOutput test_file_str_io() {
     "var lines = read_lines(\"test.txt\")\n"
     "for (line in lines) {\n"
         "print(line)\n"
-    "}\n";
+    "}\n"
+    "print(delete_file(\"test.txt\"))\n"
+    "print(delete_file(\"test.txt\"))\n";
 
     std::string expected = """"
-    "Line1\nLine2\n";
+    "Line1\nLine2\n1\n0\n";
 
     return run_source_test(src, expected);
 }
@@ -892,6 +904,84 @@ inline TestOutput test_map_remove() {
     return run_source_test(src, expected);
 }
 
+inline TestOutput test_map_growth() {
+
+    std::string src = """"
+    "var m = {\"a\"=1}\n"
+    "var i = 0\n"
+    "for (i < 100) {\n"
+    "m[i] = i * 2\n"
+    "i = i + 1\n"
+    "}\n"
+    "m = remove(m, 50)\n"
+    "m = remove(m, \"a\")\n"
+    "print(len(m))\n"
+    "print(m[99])\n"
+    "print(m[-0])\n"
+    "print(contains(m, \"a\"))\n"
+    "i = 0\n"
+    "for (k, v in m) {\n"
+    "if (i < 2) { print(f\"{k}={v}\") }\n"
+    "i = i + 1\n"
+    "}";
+    std::string expected = """"
+    "99\n"
+    "198\n"
+    "0\n"
+    "0\n"
+    "0=0\n"
+    "1=2\n";
+    return run_source_test(src, expected);
+}
+
+inline TestOutput test_long_strings() {
+
+    std::string src = """"
+    "var s = \"\"\n"
+    "var i = 0\n"
+    "for (i < 2000) {\n"
+    "s = s + \"ab\"\n"
+    "i = i + 1\n"
+    "}\n"
+    "print(len(s))\n"
+    "write_file(\"test.txt\", s + \"\n\" + \"tail\n\", \"w\")\n"
+    "var lines = read_lines(\"test.txt\")\n"
+    "print(len(lines))\n"
+    "print(lines[0] == s)\n"
+    "print(lines[1])\n";
+    std::string expected = """"
+    "4000\n"
+    "2\n"
+    "1\n"
+    "tail\n";
+    return run_source_test(src, expected);
+}
+
+inline TestOutput test_string_gc() {
+
+    std::string src = """"
+    "fn build(n) {\n"
+    "var keep = [\"first\"]\n"
+    "var i = 0\n"
+    "for (i < n) {\n"
+    "var s = \"temp_string_\" + i + \"_with_some_padding\"\n"
+    "if (i % 25000 == 0) { keep = keep + [s] }\n"
+    "i = i + 1\n"
+    "}\n"
+    "ret keep\n"
+    "}\n"
+    "var m = {\"key\"=\"value\" + 1}\n"
+    "var k = build(60000)\n"
+    "print(k)\n"
+    "print(m[\"key\"])\n"
+    "print(\"literal\")\n";
+    std::string expected = """"
+    "[\"first\", \"temp_string_0_with_some_padding\", \"temp_string_25000_with_some_padding\", \"temp_string_50000_with_some_padding\"]\n"
+    "value1\n"
+    "literal\n";
+    return run_source_test(src, expected);
+}
+
 inline TestOutput test_arr_str_slice_assignment() {
 
     std::string src = """"
@@ -1249,6 +1339,21 @@ inline TestOutput test_thread() {
     return run_source_test(src, expected);
 }
 
+// Strings a worker builds get ids in its own pool; docking re-interns them
+inline TestOutput test_worker_strings() {
+    std::string src = """"
+    "region r\n"
+    "var r::x = [\"a\", \"b\"]\n"
+    "fn job() { r::x[0] = \"built\" + to_string(42)\n r::x[1] = f\"n{r::x[0]}\" }\n"
+    "var w = create_worker(r, \"job\")\n"
+    "dock_worker(w)\n"
+    "print(r::x[0] + \"!\")\n"
+    "print(r::x)";
+    std::string expected = """"
+        "built42!\n[\"built42\", \"nbuilt42\"]\n";
+    return run_source_test(src, expected);
+}
+
 inline TestOutput test_bus() {
     std::string src = """"
     "region foo\n"
@@ -1266,6 +1371,555 @@ inline TestOutput test_bus() {
     return run_source_test(src, expected);
 }
 
+inline TestOutput test_worker_pool_reuse() {
+    std::string src = """"
+    "region a\n"
+    "region b\n"
+    "var a::x = [0]\n"
+    "var b::x = [0]\n"
+    "fn bump_a() {a::x[0] = a::x[0] + 1}\n"
+    "fn bump_b() {b::x[0] = b::x[0] + 10}\n"
+    "var i = 0\n"
+    "for (i < 20) {\n"
+    "var wa = create_worker(a, \"bump_a\")\n"
+    "var wb = create_worker(b, \"bump_b\")\n"
+    "dock_worker(wb)\n"
+    "dock_worker(wa)\n"
+    "i = i + 1\n"
+    "}\n"
+    "print(a::x[0] + b::x[0])";
+    std::string expected = """"
+        "220\n";
+    return run_source_test(src, expected);
+}
+
+inline TestOutput test_worker_waits() {
+    std::string src = """"
+    "region a\n"
+    "region b\n"
+    "var a::x = [0]\n"
+    "var b::x = [0]\n"
+    "fn set_a() {a::x[0] = 1}\n"
+    "fn set_b() {b::x[0] = 10}\n"
+    "var wa = create_worker(a, \"set_a\")\n"
+    "var wb = create_worker(b, \"set_b\")\n"
+    "print(wait_any([wb]) == wb)\n"
+    "print(wait_all([wa, wb, wb, 99]))\n"
+    "print(wait_worker(wa, 0))\n"
+    "dock_worker(wa)\n"
+    "dock_worker(wb)\n"
+    "print(wait_worker(wa, -1))\n"
+    "print(wait_any([wa, wb]))\n"
+    "print(a::x[0] + b::x[0])";
+    std::string expected = """"
+        "1\n2\n1\n-1\n-1\n11\n";
+    return run_source_test(src, expected);
+}
+
+// A worker docking its own worker must not hold the only pool thread
+// (see the worker_pool_nested CTest, which forces a 1-thread pool)
+inline TestOutput test_nested_workers() {
+    std::string src = """"
+    "region outer\n"
+    "var outer::x = [0]\n"
+    "fn inner_job() { outer::x[0] = outer::x[0] + 41 }\n"
+    "fn outer_job() {\n"
+    "var w = create_worker(outer, \"inner_job\")\n"
+    "dock_worker(w)\n"
+    "outer::x[0] = outer::x[0] + 1\n"
+    "}\n"
+    "var w = create_worker(outer, \"outer_job\")\n"
+    "dock_worker(w)\n"
+    "print(outer::x[0])";
+    std::string expected = """"
+        "42\n";
+    return run_source_test(src, expected);
+}
+
+inline TestOutput test_channels() {
+    std::string src = """"
+    "region r\n"
+    "var r::x = [0]\n"
+    "var ch = chan_create(2)\n"
+    "fn producer() {\n"
+    "for (var i in 1...5) { chan_send(ch, [i, f\"item {i}\", {\"k\"=i * 10}]) }\n"
+    "chan_send(ch, \"done\")\n"
+    "}\n"
+    "print(chan_try_recv(ch, -1))\n"
+    "var w = create_worker(r, \"producer\")\n"
+    "var total = 0\n"
+    "forever {\n"
+    "var m = chan_recv(ch)\n"
+    "if (type(m) == \"str\") { print(m)\n break }\n"
+    "total = total + m[0] + m[2][\"k\"]\n"
+    "if (m[0] == 5) { print(m[1]) }\n"
+    "}\n"
+    "dock_worker(w)\n"
+    "print(total)\n"
+    "chan_send(ch, 7)\n"
+    "print(chan_try_recv(ch, -1))";
+    std::string expected = """"
+        "-1\nitem 5\ndone\n165\n7\n";
+    return run_source_test(src, expected);
+}
+
+inline TestOutput test_channel_close() {
+    std::string src = """"
+    "var total = 0\n"
+    "for (var i in 0...300) {\n"
+    "var ch = chan_create(4)\n"
+    "chan_send(ch, i)\n"
+    "chan_send(ch, f\"left {i}\")\n"
+    "total = total + chan_recv(ch)\n"
+    "chan_close(ch)\n"
+    "}\n"
+    "print(total)\n"
+    "var a = chan_create(2)\n"
+    "chan_close(a)\n"
+    "var b = chan_create(2)\n"
+    "print(a == b)\n"
+    "chan_send(b, 3)\n"
+    "print(chan_recv(b))\n"
+    "chan_close(b)";
+    std::string expected = """"
+        "45150\n0\n3\n";
+    return run_source_test(src, expected);
+}
+
+inline TestOutput test_bus_objects() {
+    std::string src = """"
+    "region r\n"
+    "var r::x = [4]\n"
+    "fn publish() {\n"
+    "bus_set(\"cfg\", {\"name\"=\"worker\", \"levels\"=[1, 2, 3]})\n"
+    "bus_set(\"msg\", f\"hello {r::x[0]}\")\n"
+    "}\n"
+    "var w = create_worker(r, \"publish\")\n"
+    "dock_worker(w)\n"
+    "var cfg = bus_get(\"cfg\")\n"
+    "print(cfg[\"name\"])\n"
+    "print(cfg[\"levels\"][2])\n"
+    "print(bus_get(\"msg\"))\n"
+    "print(bus_get(\"missing\"))\n"
+    "bus_set(\"n\", 5)\n"
+    "bus_set(\"n\", 6)\n"
+    "print(bus_get(\"n\"))";
+    std::string expected = """"
+        "worker\n3\nhello 4\n0\n6\n";
+    return run_source_test(src, expected);
+}
+
+inline TestOutput test_par_builtins() {
+    std::string src = """"
+    "fn sq(x) { ret x * x }\n"
+    "fn odd(x) { ret x % 2 }\n"
+    "fn plus(a, b) { ret a + b }\n"
+    "fn tag(x) { ret f\"n{x}\" }\n"
+    "var xs = range(0, 1, 9999)\n"
+    "var m = par_map(xs, \"sq\")\n"
+    "print(m[9999])\n"
+    "var f = par_filter(xs, \"odd\")\n"
+    "print(len(f))\n"
+    "print(par_reduce(xs, \"plus\", 0))\n"
+    "var t = par_map(xs, \"tag\")\n"
+    "print(t[1234])\n"
+    "print(par_reduce([], \"plus\", 7))";
+    std::string expected = """"
+        "99980001\n5000\n49995000\nn1234\n7\n";
+    return run_source_test(src, expected);
+}
+
+inline TestOutput test_spawn_await() {
+    std::string src = """"
+    "fn sfib(n) {\n"
+    "if (n < 2) { ret n }\n"
+    "ret sfib(n - 1) + sfib(n - 2)\n"
+    "}\n"
+    "fn pfib(n) {\n"
+    "if (n < 10) { ret sfib(n) }\n"
+    "var a = spawn(\"pfib\", [n - 1])\n"
+    "var b = pfib(n - 2)\n"
+    "ret await(a) + b\n"
+    "}\n"
+    "fn split(xs, lo) {\n"
+    "var out = []\n"
+    "var i = 1\n"
+    "for (i < len(xs)) {\n"
+    "if ((xs[i] < xs[0]) == lo) { out = out + [xs[i]] }\n"
+    "i = i + 1\n"
+    "}\n"
+    "ret out\n"
+    "}\n"
+    "fn qsort(xs) {\n"
+    "if (len(xs) < 2) { ret xs }\n"
+    "var lo = spawn(\"qsort\", [split(xs, 1)])\n"
+    "var hi = qsort(split(xs, 0))\n"
+    "ret await(lo) + [xs[0]] + hi\n"
+    "}\n"
+    "fn greet(name, n) { ret f\"{name}-{n}\" }\n"
+    "print(pfib(16))\n"
+    "print(qsort([5, 3, 9, 1, 7, 2, 8, 6, 4, 0]))\n"
+    "var g = spawn(\"greet\", [\"bob\", 3])\n"
+    "print(await(g))\n"
+    "print(await(spawn(\"sqrt\", [16])))";
+    std::string expected = """"
+        "987\n[0, 1, 2, 3, 4, 5, 6, 7, 8, 9]\nbob-3\n4\n";
+    return run_source_test(src, expected);
+}
+
+inline TestOutput test_frozen_region() {
+    std::string src = """"
+    "region table\n"
+    "var table::scores = [10, 20, 30, 40]\n"
+    "var table::names = {\"a\"=1, \"b\"=2}\n"
+    "freeze(table)\n"
+    "fn total() {\n"
+    "var t = 0\n"
+    "for (var s in table::scores) { t = t + s }\n"
+    "bus_set(\"frozen_total\", t + table::names[\"b\"])\n"
+    "}\n"
+    "var ws = []\n"
+    "for (var i in 0...3) { ws = ws + [create_worker(table, \"total\")] }\n"
+    "print(table::scores[2])\n"
+    "wait_all(ws)\n"
+    "for (var w in ws) { dock_worker(w) }\n"
+    "print(bus_get(\"frozen_total\"))\n"
+    "fn lookup(i) { ret table::scores[i] * 2 }\n"
+    "print(par_map([0, 1, 2, 3], \"lookup\"))\n"
+    "print(await(spawn(\"lookup\", [3])))";
+    std::string expected = """"
+        "30\n102\n[20, 40, 60, 80]\n80\n";
+    return run_source_test(src, expected);
+}
+
+// remove() edits in place, so it must refuse a frozen region like OP_ASET.
+// The runtime error longjmps back here, as it does to the REPL.
+inline TestOutput test_frozen_remove() {
+    std::string src = """"
+    "region lookup\n"
+    "var lookup::primes = [2, 3, 5, 7, 11]\n"
+    "freeze(lookup)\n"
+    "var mine = [2, 3, 5, 7, 11]\n"
+    "print(remove(mine, 0))\n"
+    "remove(lookup::primes, 0)\n"
+    "print(\"removed\")\n";
+    std::string expected = """"
+        "[3, 5, 7, 11]\n";
+
+    jmp_buf env;
+    MyloConfig.repl_jmp_buf = &env;
+    TestOutput output;
+    if (setjmp(env) == 0) {
+        run_source_test(src, expected);
+        output.result = false;
+        output.result_string = "Expected remove() on a frozen region to fail";
+    } else {
+        MyloConfig.print_to_memory = false;
+        output.result = strcmp(test_vm.output_char_buffer, expected.c_str()) == 0;
+        output.result_string = output.result ? "" : "Expected '" + expected + "' and got '" + std::string(test_vm.output_char_buffer) + "'";
+        vm_cleanup(&test_vm);
+    }
+    MyloConfig.repl_jmp_buf = NULL;
+    return output;
+}
+
+inline TestOutput test_ref_store() {
+    VM vm;
+    memset(&vm, 0, sizeof(vm));
+    vm_init(&vm);
+    TestOutput output;
+    output.result = true;
+
+    // Freed handles are recycled, so churn past the old 1024 limit
+    int first = -1;
+    for (int i = 0; i < 5000 && output.result; i++) {
+        int v = i;
+        int id = (int)vm_store_copy(&vm, &v, sizeof(v), "Counter");
+        int* got = (int*)vm_get_ref(&vm, id, "Counter");
+        if (id < 0 || !got || *got != i) {
+            output.result = false;
+            output.result_string = "Store/get failed at handle " + std::to_string(i);
+        }
+        if (first < 0) first = id;
+        vm_free_ref(&vm, id);
+    }
+
+    int v = 42;
+    int id = (int)vm_store_copy(&vm, &v, sizeof(v), "Counter");
+    if (output.result && vm_get_ref(&vm, first, "Counter") != NULL) {
+        output.result = false;
+        output.result_string = "Stale handle resolved after its slot was reused";
+    }
+    if (output.result && vm_get_ref(&vm, id, "Other") != NULL) {
+        output.result = false;
+        output.result_string = "Handle resolved under the wrong type";
+    }
+    vm_free_ref(&vm, id);
+    vm_free_ref(&vm, id);
+
+    int* got = (int*)vm_get_ref(&vm, (int)vm_store_ptr(&vm, &v, "Counter"), "Counter");
+    if (output.result && got != &v) {
+        output.result = false;
+        output.result_string = "Registered pointer did not round trip";
+    }
+    vm_cleanup(&vm);
+    return output;
+}
+
+inline TestOutput test_bytecode_verifier() {
+    TestOutput output = run_source_test("fn f(n) { ret n * 2 }\nprint(f(21))\n", "42\n", false);
+    if (!output.result) {
+        vm_cleanup(&test_vm);
+        return output;
+    }
+
+    char err[256] = "";
+    int addr = vm_find_function(&test_vm, "f");
+    if (!vm_verify(&test_vm, err, sizeof(err))) {
+        output.result = false;
+        output.result_string = std::string("Valid program rejected: ") + err;
+    }
+
+    // The JMP over f's body pointing past the end of the code
+    int saved = test_vm.bytecode[addr - 1];
+    test_vm.bytecode[addr - 1] = test_vm.code_size + 5;
+    if (output.result && vm_verify(&test_vm, err, sizeof(err))) {
+        output.result = false;
+        output.result_string = "Out of range jump accepted";
+    }
+    test_vm.bytecode[addr - 1] = saved;
+
+    // f's first LVAR (after SCOPE_ENTER) turned into a POP of an empty frame
+    test_vm.bytecode[addr + 1] = OP_POP;
+    test_vm.bytecode[addr + 2] = OP_SCOPE_EXIT;
+    if (output.result && (vm_verify(&test_vm, err, sizeof(err)) || !strstr(err, "underflow"))) {
+        output.result = false;
+        output.result_string = std::string("Underflow not reported: ") + err;
+    }
+    vm_cleanup(&test_vm);
+    return output;
+}
+
+inline TestOutput test_profiler() {
+    TestOutput output;
+    output.result = true;
+    if (!profiler_supported()) return output;
+
+    vm_init(&test_vm);
+    compiler_reset();
+    MyloConfig.print_to_memory = true;
+    parse(&test_vm, const_cast<char *>(
+        "fn hot(n) {\n"
+        "    var t = 0\n"
+        "    for (var i in 0...n) { t = t + i }\n"
+        "    ret t\n"
+        "}\n"
+        "fn outer() { ret hot(400000) }\n"
+        "print(outer())\n"));
+    profiler_start(&test_vm, 1000);
+    run_vm(&test_vm, false);
+    profiler_stop(&test_vm);
+    MyloConfig.print_to_memory = false;
+
+    const char* folded = "profile_test.folded";
+    char stacks[4096] = "";
+    if (profiler_write_folded(&test_vm, folded)) {
+        FILE* f = fopen(folded, "r");
+        size_t n = fread(stacks, 1, sizeof(stacks) - 1, f);
+        stacks[n] = '\0';
+        fclose(f);
+        remove(folded);
+    }
+
+    // Every sample lands in the loop, called through outer from main
+    if (strcmp(test_vm.output_char_buffer, "8.00002e+10\n") != 0) {
+        output.result = false;
+        output.result_string = std::string("Wrong output while profiling: ") + test_vm.output_char_buffer;
+    } else if (profiler_sample_count(&test_vm) == 0 || !strstr(stacks, "main;outer;hot ")) {
+        output.result = false;
+        output.result_string = std::string("Unexpected folded stacks: '") + stacks + "'";
+    }
+    profiler_free(&test_vm);
+    vm_cleanup(&test_vm);
+    return output;
+}
+
+inline TestOutput test_perf_counters() {
+    TestOutput output;
+    output.result = true;
+
+    vm_init(&test_vm);
+    compiler_reset();
+    MyloConfig.print_to_memory = true;
+    parse(&test_vm, const_cast<char *>(
+        "@noinline fn twice(x) { ret x * 2 }\n"
+        "fn each(x) { ret twice(x) > 4 }\n"
+        "var kept = filter([1, 2, 3, 4], \"each\")\n"
+        "print(len(kept))\n"));
+    profiler_start(&test_vm, 0);
+    profiler_enable_counters(&test_vm);
+    run_vm(&test_vm, false);
+    profiler_stop(&test_vm);
+    MyloConfig.print_to_memory = false;
+
+    const char* path = "perf_counters_test.json";
+    char json[4096] = "";
+    if (profiler_write_counters_json(&test_vm, path)) {
+        FILE* f = fopen(path, "r");
+        size_t n = fread(json, 1, sizeof(json) - 1, f);
+        json[n] = '\0';
+        fclose(f);
+        remove(path);
+    }
+
+    // Calls made by the filter native count like OP_CALL ones
+    if (strcmp(test_vm.output_char_buffer, "2\n") != 0) {
+        output.result = false;
+        output.result_string = std::string("Wrong output while counting: ") + test_vm.output_char_buffer;
+    } else if (!strstr(json, "{\"name\": \"each\", \"calls\": 4,") || !strstr(json, "{\"name\": \"twice\", \"calls\": 4,")) {
+        output.result = false;
+        output.result_string = std::string("Unexpected counters: '") + json + "'";
+    }
+    profiler_free(&test_vm);
+    vm_cleanup(&test_vm);
+    return output;
+}
+
+inline TestOutput test_vm_stats() {
+    std::string src = """"
+    "fn pair(a) { ret [a, a] }\n"
+    "var n = 0\n"
+    "for (var i in 0...2) { var p = pair(i)\n n = n + len(p) }\n"
+    "var s = f\"{n}\"\n"
+    "print(s)\n";
+    TestOutput output = run_source_test(src, "6\n", false);
+    if (!output.result) {
+        vm_cleanup(&test_vm);
+        return output;
+    }
+
+    MyloStats stats;
+    if (!vm_get_stats(&test_vm, &stats)) {
+        output.result = false;
+        output.result_string = "Tests are built with MYLO_STATS but vm_get_stats reported none";
+    } else if (!test_jit_mode && (stats.ops[OP_CALL] != 3 || stats.ops[OP_PRN] != 1 || stats.ops[OP_HLT] != 1)) {
+        // Compiled code (second pass) does not count instructions
+        output.result = false;
+        output.result_string = "Wrong op counts: CALL " + std::to_string(stats.ops[OP_CALL]) +
+                               ", PRN " + std::to_string(stats.ops[OP_PRN]);
+    } else if (stats.heap_allocs[0] < 3 || stats.heap_alloc_bytes[0] < 3 * 4 * sizeof(Value) ||
+               stats.string_makes != stats.string_hits + stats.string_misses || stats.string_misses == 0 ||
+               stats.evacuations < 3 || stats.rewinds == 0) {
+        output.result = false;
+        output.result_string = "Wrong allocation counts: allocs " + std::to_string(stats.heap_allocs[0]) +
+                               ", evacuations " + std::to_string(stats.evacuations) +
+                               ", rewinds " + std::to_string(stats.rewinds);
+    }
+
+    vm_reset_stats(&test_vm);
+    vm_get_stats(&test_vm, &stats);
+    if (output.result && (stats.ops[OP_PRN] || stats.heap_allocs[0])) {
+        output.result = false;
+        output.result_string = "vm_reset_stats left counts behind";
+    }
+    vm_cleanup(&test_vm);
+    return output;
+}
+
+inline TestOutput test_expression_trees() {
+    std::string src = """"
+    "struct V { var x: num var y: num }\n"
+    "fn len2(v: V) { ret v.x * v.x + v.y *\n v.y }\n"
+    "fn f(n) {\n"
+    "    var k = 4\n"
+    "    ret n * (k * 2 + 1) - 3 * 2\n"
+    "    print(\"never\")\n"
+    "}\n"
+    "fn g() {\n"
+    "    var total = 0\n"
+    "    var step = 2\n"
+    "    var i = 0\n"
+    "    for (i < 3) { total = total + step\n step = step + 1\n i = i + 1 }\n"
+    "    var kept = total\n"
+    "    total = 100\n"
+    "    ret kept + step\n"
+    "}\n"
+    "print(f(1))\n"
+    "print(g())\n"
+    "print(len2({x: 3, y: 4}))\n"
+    "print(\"a\" + \"b\")\n";
+    TestOutput output = run_source_test(src, "3\n14\n25\nab\n", false);
+    if (!output.result) {
+        vm_cleanup(&test_vm);
+        return output;
+    }
+
+    // Folded constants, a DUP per repeated field, no code after ret, and
+    // operators on the line they were written
+    int counts[OP_COUNT] = {0};
+    int mul_line = 0;
+    for (int ip = 0; ip < test_vm.code_size; ip += vm_op_length(test_vm.bytecode, ip)) {
+        int op = test_vm.bytecode[ip];
+        counts[op]++;
+        if (op == OP_MUL && ip < vm_find_function(&test_vm, "f")) mul_line = test_vm.lines[ip];
+    }
+    if (counts[OP_PRN] != 4 || counts[OP_DUP] != 2 || counts[OP_MUL] != 3 || counts[OP_CAT] != 0) {
+        output.result = false;
+        output.result_string = "Unexpected code: PRN " + std::to_string(counts[OP_PRN]) + ", DUP " +
+                               std::to_string(counts[OP_DUP]) + ", MUL " + std::to_string(counts[OP_MUL]);
+    } else if (mul_line != 2) {
+        output.result = false;
+        output.result_string = "Last MUL of len2 on line " + std::to_string(mul_line);
+    }
+    vm_cleanup(&test_vm);
+    return output;
+}
+
+inline TestOutput test_function_inlining() {
+    std::string src = """"
+    "struct V { var x: num var y: num }\n"
+    "fn add(a: V, b: V) { var r: V = {x: a.x + b.x, y: a.y + b.y}\n ret r }\n"
+    "fn dot(a: V, b: V) {\n ret a.x * b.x +\n a.y * b.y }\n"
+    "@noinline fn twice(n) { ret n * 2 }\n"
+    "fn fact(n) { ret n < 2 ? 1 else n * fact(n - 1) }\n"
+    "var g = 1\n"
+    "fn setg() { g = 10 ret 0 }\n"
+    "fn h(x) { ret g + x }\n"
+    "print(h(setg()))\n"
+    "fn go() {\n"
+    "    var p: V = {x: 1, y: 2}\n"
+    "    var q: V = add(p, p)\n"
+    "    print(dot(q, p))\n"
+    "    print(twice(q.y) + fact(4))\n"
+    "}\n"
+    "go()\n";
+    TestOutput output = run_source_test(src, "10\n10\n32\n", false);
+    if (!output.result) {
+        vm_cleanup(&test_vm);
+        return output;
+    }
+
+    // add and dot are expanded in go, twice (@noinline) and fact (recursive)
+    // stay calls, and dot's `+` keeps the line it has in dot
+    int go_start = vm_find_function(&test_vm, "go");
+    int calls = 0;
+    bool dot_line = false;
+    for (int ip = 0; ip < test_vm.code_size; ip += vm_op_length(test_vm.bytecode, ip)) {
+        if (ip < go_start) continue;
+        if (test_vm.bytecode[ip] == OP_CALL) calls++;
+        if (test_vm.bytecode[ip] == OP_ADD && test_vm.lines[ip] == 5) dot_line = true;
+    }
+    if (calls != 3) {
+        output.result = false;
+        output.result_string = "Expected 3 calls from go() on, got " + std::to_string(calls);
+    } else if (!dot_line) {
+        output.result = false;
+        output.result_string = "No ADD on line 5 in go()";
+    }
+    vm_cleanup(&test_vm);
+    return output;
+}
+
 inline TestOutput test_iterator_from_region_in_func() {
 
     std::string src = """"
@@ -1663,6 +2317,27 @@ inline void test_generate_list() {
     ADD_TEST("Test Enum String Representation", test_enum_string_repl);
     ADD_TEST("Test Enum Iteration", test_enum_iter);
     ADD_TEST("Test Type Inference (type())", test_type_infer);
+    ADD_TEST("Test Map Growth & Remove", test_map_growth);
+    ADD_TEST("Test Long Strings", test_long_strings);
+    ADD_TEST("Test String GC", test_string_gc);
+    ADD_TEST("Test Worker Pool Reuse", test_worker_pool_reuse);
+    ADD_TEST("Test Worker Waits", test_worker_waits);
+    ADD_TEST("Test Worker Strings", test_worker_strings);
+    ADD_TEST("Test Nested Workers", test_nested_workers);
+    ADD_TEST("Test Channels", test_channels);
+    ADD_TEST("Test Channel Close", test_channel_close);
+    ADD_TEST("Test Bus Objects", test_bus_objects);
+    ADD_TEST("Test Par Builtins", test_par_builtins);
+    ADD_TEST("Test Spawn Await", test_spawn_await);
+    ADD_TEST("Test Frozen Region", test_frozen_region);
+    ADD_TEST("Test Frozen Remove", test_frozen_remove);
+    ADD_TEST("Test Ref Store", test_ref_store);
+    ADD_TEST("Test Bytecode Verifier", test_bytecode_verifier);
+    ADD_TEST("Test Sampling Profiler", test_profiler);
+    ADD_TEST("Test Perf Counters", test_perf_counters);
+    ADD_TEST("Test VM Stats", test_vm_stats);
+    ADD_TEST("Test Expression Trees", test_expression_trees);
+    ADD_TEST("Test Function Inlining", test_function_inlining);
 
 }
 
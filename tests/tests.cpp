@@ -26,38 +26,44 @@ int main()
     // test the tests
     int passed = 0;
     int total = 0;
-    for (auto &test : tests)
-    {
-        std::cout << "Running..." << test.first << std::endl;
-        try {
-            if (test.second().result) {
-                ++passed;
-                setTerminalColor(MyloFgGreen, MyloBgColorDefault);
-                std::cout << "[PASS] ";
-                setTerminalColor(MyloFgDefault, MyloBgColorDefault);
-                std::cout << test.first << std::endl;
-            }
-            else {
+    // Everything runs interpreted, then again with the JIT where it is supported
+    int passes = jit_supported() ? 2 : 1;
+    for (int pass = 0; pass < passes; pass++) {
+        test_jit_mode = pass == 1;
+        if (test_jit_mode) std::cout << std::endl << "Running again with the JIT (--jit)" << std::endl;
+        for (auto &test : tests)
+        {
+            std::cout << "Running..." << test.first << std::endl;
+            try {
+                if (test.second().result) {
+                    ++passed;
+                    setTerminalColor(MyloFgGreen, MyloBgColorDefault);
+                    std::cout << "[PASS] ";
+                    setTerminalColor(MyloFgDefault, MyloBgColorDefault);
+                    std::cout << test.first << std::endl;
+                }
+                else {
+                    setTerminalColor(MyloFgRed, MyloBgColorDefault);
+                    std::cout << "[FAILED] ";
+                    setTerminalColor(MyloFgDefault, MyloBgColorDefault);
+                    std::cout << test.first << std::endl;
+                    setTerminalColor(MyloFgMagenta, MyloBgColorDefault);
+                    std::cout << " --> " << test.second().result_string << std::endl;
+                    setTerminalColor(MyloFgDefault, MyloBgColorDefault);
+                }
+                ++total;
+            } catch (std::exception &e) {
                 setTerminalColor(MyloFgRed, MyloBgColorDefault);
-                std::cout << "[FAILED] ";
-                setTerminalColor(MyloFgDefault, MyloBgColorDefault);
-                std::cout << test.first << std::endl;
-                setTerminalColor(MyloFgMagenta, MyloBgColorDefault);
-                std::cout << " --> " << test.second().result_string << std::endl;
+                std::cout << "[FAILED -- EXCEPTION] ";
+                std::cout << std::endl << test.first << " --> " << "EXCEPTION" << e.what() << std::endl;
                 setTerminalColor(MyloFgDefault, MyloBgColorDefault);
+                ++total;
             }
-            ++total;
-        } catch (std::exception &e) {
-            setTerminalColor(MyloFgRed, MyloBgColorDefault);
-            std::cout << "[FAILED -- EXCEPTION] ";
-            std::cout << std::endl << test.first << " --> " << "EXCEPTION" << e.what() << std::endl;
+            setTerminalColor(MyloFgBlue, MyloBgColorDefault);
+            std::cout << "========================================================" << std::endl;
             setTerminalColor(MyloFgDefault, MyloBgColorDefault);
-            ++total;
-        }
-        setTerminalColor(MyloFgBlue, MyloBgColorDefault);
-        std::cout << "========================================================" << std::endl;
-        setTerminalColor(MyloFgDefault, MyloBgColorDefault);
 
+        }
     }
     std::cout << std::endl;
 